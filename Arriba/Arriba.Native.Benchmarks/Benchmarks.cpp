@@ -0,0 +1,648 @@
+#include "stdafx.h"
+
+#include <intrin.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <vector>
+
+// Arriba.Native.Benchmarks times every Arriba.Native export over working sets sized for L1, L2, the last level
+// cache, and DRAM, at several selectivities and buffer alignments. The DLL is loaded by path, so two builds (or one
+// build on two machines) can be compared from the --csv output; the checksum column shows if their results differ.
+//
+// Usage: Arriba.Native.Benchmarks [--csv] [--quick] [--dll <path to Arriba.Native.dll>] [--kernel <name>]
+
+// Rows in the largest ShortSet; every kernel runs over sets this size
+const INT32 SetRows = 65536;
+const INT32 SetLength = SetRows / 64;
+const size_t SetBytes = SetLength * sizeof(UINT64);
+
+// Sets passed to AndSetsMany per call
+const INT32 ManySetCount = 8;
+
+// Candidates IntersectPostingLists keeps as values, as WordIndex passes it [WordIndex.NativeCandidateLimit]
+const INT32 PostingCandidateLimit = 2048;
+const INT32 PostingValuesLength = 3 * (PostingCandidateLimit + 8);
+
+// Distinct instances generated per run; larger working sets are filled with copies at new addresses
+const INT32 TemplateCount = 16;
+
+// Buffers start this far past a cache line boundary, plus the alignment offset being measured
+const size_t CacheLineBytes = 64;
+
+// WARNING: Layout must match PostingList in Arriba.Native PostingLists.cpp
+struct PostingList
+{
+	UINT16* values;
+	UINT64* bits;
+	INT32 length;
+};
+
+typedef int(*CallOverheadTestFn)();
+typedef bool(*IsSupportedFn)();
+typedef int(*PopulationCountFn)(UINT64* values, INT32 length);
+typedef void(*CombineSetsFn)(UINT64* result, UINT64* left, UINT64* right, INT32 length);
+typedef void(*NotSetFn)(UINT64* result, UINT64* values, INT32 length);
+typedef int(*AndCountFn)(UINT64* left, UINT64* right, INT32 length);
+typedef void(*AndSetsManyFn)(UINT64* result, UINT64** sets, INT32 setCount, INT32 length);
+typedef INT32(*CombineSortedFn)(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result);
+typedef INT32(*FilterSortedFn)(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result);
+typedef void(*SetBitsForValuesFn)(UINT16* values, INT32 length, UINT64* set, INT32 setLength);
+typedef INT32(*IntersectPostingListsFn)(PostingList* lists, INT32* termStarts, INT32 termCount, UINT16* values, INT32 valuesLength, UINT64* bits, UINT64* scratch, INT32 bitsLength, INT32* resultIsBits);
+
+// The buffers for one kernel call
+struct Instance
+{
+	UINT64* sets[ManySetCount];
+	UINT64* result;
+	UINT64* scratch;
+	UINT16* values[2];
+	INT32 valueCounts[2];
+	UINT16* resultValues;
+	INT32 resultValuesLength;
+};
+
+// What a kernel reads and writes, which decides the buffers each instance needs
+struct Kernel
+{
+	const char* name;
+	INT32 sets;
+	bool result;
+	bool scratch;
+	INT32 valueArrays;
+	bool resultValues;
+
+	// Whether the kernel's speed depends on the data, so it's measured at every selectivity
+	bool dataDependent;
+
+	// Whether cycles are per row (64 per UINT64) or per input value
+	bool perValue;
+
+	INT32(*run)(Instance& instance);
+};
+
+static HMODULE s_library;
+static CallOverheadTestFn s_callOverheadTest;
+static PopulationCountFn s_populationCount;
+static CombineSetsFn s_andSets;
+static CombineSetsFn s_orSets;
+static CombineSetsFn s_andNotSets;
+static CombineSetsFn s_orNotSets;
+static NotSetFn s_notSet;
+static AndCountFn s_andCount;
+static AndSetsManyFn s_andSetsMany;
+static CombineSortedFn s_intersectSorted;
+static CombineSortedFn s_unionSorted;
+static FilterSortedFn s_intersectSortedWithSet;
+static FilterSortedFn s_andNotSortedWithSet;
+static SetBitsForValuesFn s_setBitsForValues;
+static IntersectPostingListsFn s_intersectPostingLists;
+
+static INT32 RunCallOverheadTest(Instance& i) { return s_callOverheadTest(); }
+static INT32 RunPopulationCount(Instance& i) { return s_populationCount(i.sets[0], SetLength); }
+static INT32 RunAndSets(Instance& i) { s_andSets(i.result, i.sets[0], i.sets[1], SetLength); return 0; }
+static INT32 RunOrSets(Instance& i) { s_orSets(i.result, i.sets[0], i.sets[1], SetLength); return 0; }
+static INT32 RunAndNotSets(Instance& i) { s_andNotSets(i.result, i.sets[0], i.sets[1], SetLength); return 0; }
+static INT32 RunOrNotSets(Instance& i) { s_orNotSets(i.result, i.sets[0], i.sets[1], SetLength); return 0; }
+static INT32 RunNotSet(Instance& i) { s_notSet(i.result, i.sets[0], SetLength); return 0; }
+static INT32 RunAndCount(Instance& i) { return s_andCount(i.sets[0], i.sets[1], SetLength); }
+static INT32 RunAndSetsMany(Instance& i) { s_andSetsMany(i.result, i.sets, ManySetCount, SetLength); return 0; }
+static INT32 RunIntersectSorted(Instance& i) { return s_intersectSorted(i.values[0], i.valueCounts[0], i.values[1], i.valueCounts[1], i.resultValues); }
+static INT32 RunUnionSorted(Instance& i) { return s_unionSorted(i.values[0], i.valueCounts[0], i.values[1], i.valueCounts[1], i.resultValues); }
+static INT32 RunIntersectSortedWithSet(Instance& i) { return s_intersectSortedWithSet(i.values[0], i.valueCounts[0], i.sets[0], SetLength, i.resultValues); }
+static INT32 RunAndNotSortedWithSet(Instance& i) { return s_andNotSortedWithSet(i.values[0], i.valueCounts[0], i.sets[0], SetLength, i.resultValues); }
+static INT32 RunSetBitsForValues(Instance& i) { s_setBitsForValues(i.values[0], i.valueCounts[0], i.result, SetLength); return 0; }
+
+// Three terms, as for a three word WordIndex query: two sparse lists and one dense list
+static INT32 RunIntersectPostingLists(Instance& i)
+{
+	PostingList lists[3] = { { i.values[0], NULL, i.valueCounts[0] }, { i.values[1], NULL, i.valueCounts[1] }, { NULL, i.sets[0], SetLength } };
+	INT32 termStarts[4] = { 0, 1, 2, 3 };
+	INT32 resultIsBits;
+
+	return s_intersectPostingLists(lists, termStarts, 3, i.resultValues, i.resultValuesLength, i.result, i.scratch, SetLength, &resultIsBits);
+}
+
+// Name, input sets, writes a set, needs scratch, input value arrays, writes values, data dependent, per value, run
+static const Kernel s_kernels[] =
+{
+	{ "CallOverheadTest",         0,            false, false, 0, false, false, false, RunCallOverheadTest },
+	{ "PopulationCount",          1,            false, false, 0, false, false, false, RunPopulationCount },
+	{ "AndSets",                  2,            true,  false, 0, false, false, false, RunAndSets },
+	{ "OrSets",                   2,            true,  false, 0, false, false, false, RunOrSets },
+	{ "AndNotSets",               2,            true,  false, 0, false, false, false, RunAndNotSets },
+	{ "OrNotSets",                2,            true,  false, 0, false, false, false, RunOrNotSets },
+	{ "NotSet",                   1,            true,  false, 0, false, false, false, RunNotSet },
+	{ "AndCount",                 2,            false, false, 0, false, false, false, RunAndCount },
+	{ "AndSetsMany",              ManySetCount, true,  false, 0, false, true,  false, RunAndSetsMany },
+	{ "IntersectSorted",          0,            false, false, 2, true,  true,  true,  RunIntersectSorted },
+	{ "UnionSorted",              0,            false, false, 2, true,  true,  true,  RunUnionSorted },
+	{ "IntersectSortedWithSet",   1,            false, false, 1, true,  true,  true,  RunIntersectSortedWithSet },
+	{ "AndNotSortedWithSet",      1,            false, false, 1, true,  true,  true,  RunAndNotSortedWithSet },
+	{ "SetBitsForValues",         0,            true,  false, 1, false, true,  true,  RunSetBitsForValues },
+	{ "IntersectPostingLists",    1,            true,  true,  2, true,  true,  true,  RunIntersectPostingLists },
+};
+
+struct Level
+{
+	const char* name;
+	size_t workingSetBytes;
+};
+
+// Working sets which fit in (and somewhat fill) each level on current server parts
+static const Level s_levels[] =
+{
+	{ "L1", 24 * 1024 },
+	{ "L2", 192 * 1024 },
+	{ "LLC", 4 * 1024 * 1024 },
+	{ "DRAM", 256 * 1024 * 1024 },
+};
+
+static const double s_selectivities[] = { 0.01, 0.5, 0.99 };
+static const size_t s_alignments[] = { 0, 8 };
+
+struct Options
+{
+	bool csv;
+	bool quick;
+	const char* dllPath;
+	const char* kernel;
+};
+
+#pragma region Data
+// xorshift64*, reseeded for each kernel and selectivity, so every run (and every build compared) sees the same data
+const UINT64 RandomSeed = 0x9E3779B97F4A7C15ULL;
+static UINT64 s_random = RandomSeed;
+
+static UINT64 NextRandom()
+{
+	s_random ^= s_random >> 12;
+	s_random ^= s_random << 25;
+	s_random ^= s_random >> 27;
+	return s_random * 0x2545F4914F6CDD1DULL;
+}
+
+static bool NextBit(double probability)
+{
+	return (NextRandom() >> 11) * (1.0 / 9007199254740992.0) < probability;
+}
+
+static void FillSet(UINT64* set, double selectivity)
+{
+	for (INT32 i = 0; i < SetLength; ++i)
+	{
+		UINT64 word = 0;
+		for (INT32 bit = 0; bit < 64; ++bit)
+		{
+			if (NextBit(selectivity)) word |= (0x1ULL << 63) >> bit;
+		}
+
+		set[i] = word;
+	}
+}
+
+// Sorted, unique values, each row included with probability 'selectivity'
+static INT32 FillValues(UINT16* values, double selectivity)
+{
+	INT32 count = 0;
+	for (INT32 row = 0; row < SetRows; ++row)
+	{
+		if (NextBit(selectivity)) values[count++] = (UINT16)row;
+	}
+
+	return count;
+}
+#pragma endregion
+
+#pragma region Instances
+static size_t RoundUp(size_t bytes)
+{
+	return (bytes + CacheLineBytes - 1) & ~(CacheLineBytes - 1);
+}
+
+// Place a buffer at the next cache line past 'next', offset by 'alignment'
+static void* Place(char** next, size_t bytes, size_t alignment)
+{
+	void* buffer = *next + alignment;
+	*next += RoundUp(bytes + alignment);
+	return buffer;
+}
+
+static INT32 ResultValuesLength(const Kernel& kernel, const Instance& instance)
+{
+	if (kernel.run == RunIntersectPostingLists) return PostingValuesLength;
+	return instance.valueCounts[0] + instance.valueCounts[1] + 8;
+}
+
+static size_t InstanceBytes(const Kernel& kernel, const Instance& instance, size_t alignment)
+{
+	size_t bytes = 0;
+	bytes += kernel.sets * RoundUp(SetBytes + alignment);
+	if (kernel.result) bytes += RoundUp(SetBytes + alignment);
+	if (kernel.scratch) bytes += RoundUp(SetBytes + alignment);
+	for (INT32 v = 0; v < kernel.valueArrays; ++v) bytes += RoundUp(instance.valueCounts[v] * sizeof(UINT16) + alignment);
+	if (kernel.resultValues) bytes += RoundUp(ResultValuesLength(kernel, instance) * sizeof(UINT16) + alignment);
+	return bytes;
+}
+
+// Bytes the kernel reads, plus the bit vector it writes. Written values aren't counted; they're at most the values read.
+static size_t BytesPerCall(const Kernel& kernel, const std::vector<Instance>& instances)
+{
+	size_t bytes = kernel.sets * SetBytes;
+	if (kernel.result) bytes += SetBytes;
+
+	// Value counts vary by instance; use the average
+	size_t valueBytes = 0;
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		for (INT32 v = 0; v < kernel.valueArrays; ++v) valueBytes += instances[i].valueCounts[v] * sizeof(UINT16);
+	}
+
+	return bytes + valueBytes / instances.size();
+}
+
+static INT64 ElementsPerCall(const Kernel& kernel, const std::vector<Instance>& instances)
+{
+	if (!kernel.perValue) return (kernel.sets == 0 && !kernel.result ? 1 : SetRows);
+
+	INT64 elements = 0;
+	for (size_t i = 0; i < instances.size(); ++i)
+	{
+		for (INT32 v = 0; v < kernel.valueArrays; ++v) elements += instances[i].valueCounts[v];
+	}
+
+	elements /= (INT64)instances.size();
+	return (elements > 0 ? elements : 1);
+}
+
+// Allocate instances filling about 'workingSetBytes' (at least one instance), copying the templates round robin
+static char* BuildInstances(const Kernel& kernel, const std::vector<Instance>& templates, size_t workingSetBytes, size_t alignment, std::vector<Instance>& instances)
+{
+	size_t total = 0;
+	size_t count = 0;
+	while (count < templates.size() || total < workingSetBytes)
+	{
+		size_t bytes = InstanceBytes(kernel, templates[count % templates.size()], alignment);
+		if (count >= 1 && (bytes == 0 || total + bytes > workingSetBytes)) break;
+
+		total += bytes;
+		count++;
+	}
+
+	char* arena = (char*)_aligned_malloc(total + CacheLineBytes, CacheLineBytes);
+	if (arena == NULL) return NULL;
+	char* next = arena;
+
+	instances.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Instance& source = templates[i % templates.size()];
+		Instance instance = source;
+
+		for (INT32 s = 0; s < kernel.sets; ++s)
+		{
+			instance.sets[s] = (UINT64*)Place(&next, SetBytes, alignment);
+			memcpy(instance.sets[s], source.sets[s], SetBytes);
+		}
+
+		if (kernel.result) instance.result = (UINT64*)Place(&next, SetBytes, alignment);
+		if (kernel.scratch) instance.scratch = (UINT64*)Place(&next, SetBytes, alignment);
+
+		for (INT32 v = 0; v < kernel.valueArrays; ++v)
+		{
+			instance.values[v] = (UINT16*)Place(&next, source.valueCounts[v] * sizeof(UINT16), alignment);
+			memcpy(instance.values[v], source.values[v], source.valueCounts[v] * sizeof(UINT16));
+		}
+
+		if (kernel.resultValues) instance.resultValues = (UINT16*)Place(&next, instance.resultValuesLength * sizeof(UINT16), alignment);
+		if (kernel.result) memset(instance.result, 0, SetBytes);
+
+		instances.push_back(instance);
+	}
+
+	return arena;
+}
+
+// Generate the distinct instances for a kernel at one selectivity; they own their buffers until FreeTemplates
+static void BuildTemplates(const Kernel& kernel, double selectivity, std::vector<Instance>& templates)
+{
+	templates.clear();
+	s_random = RandomSeed;
+
+	for (INT32 t = 0; t < TemplateCount; ++t)
+	{
+		Instance instance = { 0 };
+
+		for (INT32 s = 0; s < kernel.sets; ++s)
+		{
+			instance.sets[s] = (UINT64*)malloc(SetBytes);
+			FillSet(instance.sets[s], selectivity);
+		}
+
+		for (INT32 v = 0; v < kernel.valueArrays; ++v)
+		{
+			instance.values[v] = (UINT16*)malloc(SetRows * sizeof(UINT16));
+			instance.valueCounts[v] = FillValues(instance.values[v], selectivity);
+		}
+
+		instance.resultValuesLength = ResultValuesLength(kernel, instance);
+		templates.push_back(instance);
+	}
+}
+
+static void FreeTemplates(std::vector<Instance>& templates)
+{
+	for (size_t t = 0; t < templates.size(); ++t)
+	{
+		for (INT32 s = 0; s < ManySetCount; ++s) free(templates[t].sets[s]);
+		for (INT32 v = 0; v < 2; ++v) free(templates[t].values[v]);
+	}
+
+	templates.clear();
+}
+#pragma endregion
+
+#pragma region Measurement
+struct Measurement
+{
+	double secondsPerCall;
+	double cyclesPerCall;
+	UINT32 checksum;
+};
+
+static void Hash(UINT32* hash, const void* data, size_t bytes)
+{
+	const unsigned char* current = (const unsigned char*)data;
+	for (size_t i = 0; i < bytes; ++i)
+	{
+		*hash = (*hash ^ current[i]) * 16777619U;
+	}
+}
+
+// FNV-1a of the first instance's return value and outputs, which should match across builds and CPUs
+static UINT32 Checksum(const Kernel& kernel, Instance& instance)
+{
+	UINT32 hash = 2166136261U;
+	if (kernel.result) memset(instance.result, 0, SetBytes);
+
+	INT32 returned = kernel.run(instance);
+	Hash(&hash, &returned, sizeof(returned));
+
+	if (kernel.result && kernel.run != RunIntersectPostingLists) Hash(&hash, instance.result, SetBytes);
+	if (kernel.resultValues && kernel.run != RunIntersectPostingLists && returned >= 0 && returned <= instance.resultValuesLength) Hash(&hash, instance.resultValues, returned * sizeof(UINT16));
+
+	return hash;
+}
+
+// Run the kernel over every instance in turn until 'minimumSeconds' pass; report the fastest of 'trials' runs
+static Measurement Measure(const Kernel& kernel, std::vector<Instance>& instances, double minimumSeconds, INT32 trials)
+{
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+
+	Measurement best = { 1e30, 1e30, 0 };
+	volatile INT32 sink = 0;
+
+	// Warm up: touch every instance once
+	for (size_t i = 0; i < instances.size(); ++i) sink += kernel.run(instances[i]);
+
+	for (INT32 trial = 0; trial < trials; ++trial)
+	{
+		INT64 calls = 0;
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+		UINT64 startCycles = __rdtsc();
+		double elapsed;
+
+		do
+		{
+			for (size_t i = 0; i < instances.size(); ++i) sink += kernel.run(instances[i]);
+			calls += instances.size();
+
+			QueryPerformanceCounter(&end);
+			elapsed = (double)(end.QuadPart - start.QuadPart) / frequency.QuadPart;
+		} while (elapsed < minimumSeconds);
+
+		UINT64 cycles = __rdtsc() - startCycles;
+		if (elapsed / calls < best.secondsPerCall)
+		{
+			best.secondsPerCall = elapsed / calls;
+			best.cyclesPerCall = (double)cycles / calls;
+		}
+	}
+
+	best.checksum = Checksum(kernel, instances[0]);
+	return best;
+}
+#pragma endregion
+
+#pragma region Output
+static void CpuName(char* name, size_t length)
+{
+	int info[12] = { 0 };
+	__cpuid(info, 0x80000000);
+
+	if ((unsigned int)info[0] < 0x80000004)
+	{
+		strncpy_s(name, length, "Unknown", _TRUNCATE);
+		return;
+	}
+
+	__cpuid(info, 0x80000002);
+	__cpuid(info + 4, 0x80000003);
+	__cpuid(info + 8, 0x80000004);
+
+	char brand[sizeof(info) + 1] = { 0 };
+	memcpy(brand, info, sizeof(info));
+
+	// Trim the leading spaces some parts pad the brand string with
+	char* start = brand;
+	while (*start == ' ') ++start;
+	strncpy_s(name, length, start, _TRUNCATE);
+}
+
+static bool IsSupported(const char* exportName)
+{
+	IsSupportedFn isSupported = (IsSupportedFn)GetProcAddress(s_library, exportName);
+	return (isSupported != NULL && isSupported());
+}
+
+static void WriteHeader(const Options& options)
+{
+	char cpu[64];
+	CpuName(cpu, sizeof(cpu));
+
+	const char* format = (options.csv ? "# %s: %s\n" : "%-10s %s\n");
+	printf(format, "dll", options.dllPath);
+	printf(format, "cpu", cpu);
+	printf(options.csv ? "# %s: %s%s%s\n" : "%-10s %s%s%s\n", "features", (IsSupported("IsPopulationCountSupported") ? "POPCNT " : ""), (IsSupported("IsAdvancedVectorExtensions2Supported") ? "AVX2 " : ""), (IsSupported("IsAdvancedVectorExtensions512Supported") ? "AVX-512" : ""));
+
+	if (options.csv)
+	{
+		printf("kernel,level,workingSetBytes,selectivity,alignment,elementsPerCall,bytesPerCall,nsPerCall,cyclesPerElement,gigabytesPerSecond,checksum\n");
+	}
+	else
+	{
+		printf("\n%-24s %-5s %10s %6s %5s %12s %10s %8s %9s\n", "Kernel", "Level", "WorkingSet", "Select", "Align", "ns/call", "cyc/elem", "GB/s", "Checksum");
+	}
+}
+
+static void WriteMeasurement(const Options& options, const Kernel& kernel, const Level& level, size_t workingSetBytes, double selectivity, size_t alignment, INT64 elements, size_t bytes, const Measurement& m)
+{
+	double nanoseconds = m.secondsPerCall * 1e9;
+	double cyclesPerElement = m.cyclesPerCall / elements;
+	double gigabytesPerSecond = (bytes / m.secondsPerCall) / 1e9;
+
+	if (options.csv)
+	{
+		printf("%s,%s,%llu,%.2f,%llu,%lld,%llu,%.2f,%.5f,%.3f,%08x\n", kernel.name, level.name, (unsigned long long)workingSetBytes, selectivity, (unsigned long long)alignment, (long long)elements, (unsigned long long)bytes, nanoseconds, cyclesPerElement, gigabytesPerSecond, m.checksum);
+	}
+	else
+	{
+		printf("%-24s %-5s %9lluK %6.2f %5llu %12.1f %10.4f %8.2f %9x\n", kernel.name, level.name, (unsigned long long)(workingSetBytes / 1024), selectivity, (unsigned long long)alignment, nanoseconds, cyclesPerElement, gigabytesPerSecond, m.checksum);
+	}
+
+	fflush(stdout);
+}
+#pragma endregion
+
+static bool Load(const char* dllPath)
+{
+	s_library = LoadLibraryA(dllPath);
+	if (s_library == NULL) return false;
+
+	// Kernels a build doesn't export are skipped, so older builds can still be compared
+	s_callOverheadTest = (CallOverheadTestFn)GetProcAddress(s_library, "CallOverheadTest");
+	s_populationCount = (PopulationCountFn)GetProcAddress(s_library, "PopulationCount");
+	s_andSets = (CombineSetsFn)GetProcAddress(s_library, "AndSets");
+	s_orSets = (CombineSetsFn)GetProcAddress(s_library, "OrSets");
+	s_andNotSets = (CombineSetsFn)GetProcAddress(s_library, "AndNotSets");
+	s_orNotSets = (CombineSetsFn)GetProcAddress(s_library, "OrNotSets");
+	s_notSet = (NotSetFn)GetProcAddress(s_library, "NotSet");
+	s_andCount = (AndCountFn)GetProcAddress(s_library, "AndCount");
+	s_andSetsMany = (AndSetsManyFn)GetProcAddress(s_library, "AndSetsMany");
+	s_intersectSorted = (CombineSortedFn)GetProcAddress(s_library, "IntersectSorted");
+	s_unionSorted = (CombineSortedFn)GetProcAddress(s_library, "UnionSorted");
+	s_intersectSortedWithSet = (FilterSortedFn)GetProcAddress(s_library, "IntersectSortedWithSet");
+	s_andNotSortedWithSet = (FilterSortedFn)GetProcAddress(s_library, "AndNotSortedWithSet");
+	s_setBitsForValues = (SetBitsForValuesFn)GetProcAddress(s_library, "SetBitsForValues");
+	s_intersectPostingLists = (IntersectPostingListsFn)GetProcAddress(s_library, "IntersectPostingLists");
+	return true;
+}
+
+static bool IsExported(const Kernel& kernel)
+{
+	return GetProcAddress(s_library, kernel.name) != NULL;
+}
+
+static bool ParseArguments(int argc, char* argv[], Options& options)
+{
+	options.csv = false;
+	options.quick = false;
+	options.dllPath = "Arriba.Native.dll";
+	options.kernel = NULL;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (_stricmp(argv[i], "--csv") == 0)
+		{
+			options.csv = true;
+		}
+		else if (_stricmp(argv[i], "--quick") == 0)
+		{
+			options.quick = true;
+		}
+		else if (_stricmp(argv[i], "--dll") == 0 && i + 1 < argc)
+		{
+			options.dllPath = argv[++i];
+		}
+		else if (_stricmp(argv[i], "--kernel") == 0 && i + 1 < argc)
+		{
+			options.kernel = argv[++i];
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
+	Options options;
+	if (!ParseArguments(argc, argv, options))
+	{
+		fprintf(stderr, "Usage: Arriba.Native.Benchmarks [--csv] [--quick] [--dll <path to Arriba.Native.dll>] [--kernel <name>]\n");
+		return -1;
+	}
+
+	if (!Load(options.dllPath))
+	{
+		fprintf(stderr, "Unable to load '%s' (error %lu).\n", options.dllPath, GetLastError());
+		return -2;
+	}
+
+	// Quick runs skip DRAM and take fewer, shorter trials; enough to spot a large regression
+	double minimumSeconds = (options.quick ? 0.005 : 0.02);
+	INT32 trials = (options.quick ? 3 : 5);
+	size_t levelCount = sizeof(s_levels) / sizeof(s_levels[0]) - (options.quick ? 1 : 0);
+
+	WriteHeader(options);
+
+	std::vector<Instance> templates;
+	std::vector<Instance> instances;
+
+	for (size_t k = 0; k < sizeof(s_kernels) / sizeof(s_kernels[0]); ++k)
+	{
+		const Kernel& kernel = s_kernels[k];
+		if (options.kernel != NULL && _stricmp(options.kernel, kernel.name) != 0) continue;
+
+		if (!IsExported(kernel))
+		{
+			if (!options.csv) printf("%-24s (not exported)\n", kernel.name);
+			continue;
+		}
+
+		// Call overhead doesn't depend on data; measure it once
+		bool hasData = (kernel.sets > 0 || kernel.valueArrays > 0);
+		size_t selectivityCount = (kernel.dataDependent ? sizeof(s_selectivities) / sizeof(s_selectivities[0]) : 1);
+
+		for (size_t s = 0; s < selectivityCount; ++s)
+		{
+			double selectivity = (kernel.dataDependent ? s_selectivities[s] : 0.5);
+			BuildTemplates(kernel, selectivity, templates);
+
+			for (size_t l = 0; l < (hasData ? levelCount : 1); ++l)
+			{
+				// Skip cache levels a single call's buffers don't fit in
+				if (hasData && InstanceBytes(kernel, templates[0], 0) > s_levels[l].workingSetBytes) continue;
+
+				for (size_t a = 0; a < (hasData ? sizeof(s_alignments) / sizeof(s_alignments[0]) : 1); ++a)
+				{
+					char* arena = BuildInstances(kernel, templates, s_levels[l].workingSetBytes, s_alignments[a], instances);
+					if (arena == NULL)
+					{
+						fprintf(stderr, "Unable to allocate the %s working set for %s.\n", s_levels[l].name, kernel.name);
+						continue;
+					}
+
+					size_t workingSetBytes = 0;
+					for (size_t i = 0; i < instances.size(); ++i) workingSetBytes += InstanceBytes(kernel, instances[i], s_alignments[a]);
+
+					Measurement m = Measure(kernel, instances, minimumSeconds, trials);
+					WriteMeasurement(options, kernel, s_levels[l], workingSetBytes, selectivity, s_alignments[a], ElementsPerCall(kernel, instances), BytesPerCall(kernel, instances), m);
+
+					_aligned_free(arena);
+				}
+			}
+
+			FreeTemplates(templates);
+		}
+	}
+
+	FreeLibrary(s_library);
+	return 0;
+}
@@ -1,77 +1,100 @@
 #include "stdafx.h"
 
+#include <string.h>
 #include <intrin.h>
 #include <nmmintrin.h>
+#include "SetOperations.h"
 
-void Align256(UINT64** value)
+extern "C" __declspec(dllexport) bool IsParallelAndSupported()
 {
-	int offset = (uintptr_t)(*value) % 32;
-	if (offset == 0) return;
-	*value += ((32 - offset) / 8);
+	// AndSets picks AVX2 or scalar itself; AndCount needs POPCNT
+	return Supported.Popcnt;
 }
 
-extern "C" __declspec(dllexport) bool IsParallelAndSupported()
+// AVX2 unaligned, tail-correct, falling back to scalar without AVX2 [see SetOperations.h]
+extern "C" __declspec(dllexport) void AndSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
 {
-	int cpuinfo[4];
-	__cpuid(cpuinfo, 1);
+	CombineSets<SetAnd>(result, left, right, length);
+}
+
+// Count (left & right) without writing the intersection anywhere
+extern "C" __declspec(dllexport) int AndCount(UINT64* left, UINT64* right, INT32 length)
+{
+	int total1 = 0;
+	int total2 = 0;
+
+	INT32 i = 0;
+	for (; i + 2 <= length; i += 2)
+	{
+		total1 += _mm_popcnt_u64(left[i] & right[i]);
+		total2 += _mm_popcnt_u64(left[i + 1] & right[i + 1]);
+	}
 
-	return (cpuinfo[2] & (0x1 << 23));
+	if (i < length)
+	{
+		total1 += _mm_popcnt_u64(left[i] & right[i]);
+	}
+
+	return total1 + total2;
 }
 
-//// V2: AVX 256 Attempt 2 (Hack: Force Alignment and use aligned instructions) (540 for 3M)
-//extern "C" __declspec(dllexport) void AndSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
-//{
-//	__m256i leftA;
-//	__m256i rightA;
-//	__m256i resultA;
-//
-//	// Skip any unaligned end
-//	length = length - 4;
-//
-//	// Force each array to the next aligned segment
-//	Align256(&result);
-//	Align256(&left);
-//	Align256(&right);
-//
-//	// Use AVX2 aligned load, and, store
-//	for (int i = 0; i < length; i += 4)
-//	{
-//		leftA = _mm256_load_si256((__m256i*)left);
-//		rightA = _mm256_load_si256((__m256i*)right);
-//		resultA = _mm256_and_si256(leftA, rightA);
-//		_mm256_store_si256((__m256i*)result, resultA);
-//
-//		left += 4;
-//		right += 4;
-//		result += 4;
-//	}
-//}
-
-//// V2: AVX 256 Attempt 1 (Needed unaligned load/store) (740 for 3M)
-//extern "C" __declspec(dllexport) void AndSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
-//{
-//	__m256i leftA;
-//	__m256i rightA;
-//	__m256i resultA;
-//
-//	for (int i = 0; i < length; i += 4)
-//	{
-//		leftA = _mm256_loadu_si256((__m256i*)left);
-//		rightA = _mm256_loadu_si256((__m256i*)right);
-//		resultA = _mm256_and_si256(leftA, rightA);
-//		_mm256_storeu_si256((__m256i*)result, resultA);
-//
-//		left += 4;
-//		right += 4;
-//		result += 4;
-//	}
-//}
-
-// V1: Normal C++ AND (1,125 for 3M)
-extern "C" __declspec(dllexport) void AndSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
+// AndSetsMany combines sets one block at a time, so the result block stays in L1 across every set
+const INT32 AndSetsManyBlockLength = 64;
+
+// result = left & right for one block; returns whether any bit in the result is set
+static __forceinline bool AndBlock(UINT64* result, UINT64* left, UINT64* right, INT32 length)
 {
-	for (int i = 0; i < length; ++i)
+	INT32 i = 0;
+	UINT64 any = 0;
+
+	if (Supported.Avx2)
+	{
+		__m256i anyBlock = _mm256_setzero_si256();
+		for (; i + 4 <= length; i += 4)
+		{
+			__m256i block = _mm256_and_si256(_mm256_loadu_si256((__m256i*)(left + i)), _mm256_loadu_si256((__m256i*)(right + i)));
+			_mm256_storeu_si256((__m256i*)(result + i), block);
+			anyBlock = _mm256_or_si256(anyBlock, block);
+		}
+
+		if (!_mm256_testz_si256(anyBlock, anyBlock)) any = 1;
+	}
+
+	for (; i < length; ++i)
 	{
 		result[i] = left[i] & right[i];
+		any |= result[i];
 	}
-}
\ No newline at end of file
+
+	return (any != 0);
+}
+
+// Set result to the AND of every set. Once a block of the result is empty, the remaining sets aren't read for it.
+extern "C" __declspec(dllexport) void AndSetsMany(UINT64* result, UINT64** sets, INT32 setCount, INT32 length)
+{
+	if (setCount <= 0)
+	{
+		memset(result, 0, length * sizeof(UINT64));
+		return;
+	}
+
+	if (setCount == 1)
+	{
+		memmove(result, sets[0], length * sizeof(UINT64));
+		return;
+	}
+
+	for (INT32 start = 0; start < length; start += AndSetsManyBlockLength)
+	{
+		INT32 blockLength = length - start;
+		if (blockLength > AndSetsManyBlockLength) blockLength = AndSetsManyBlockLength;
+
+		UINT64* resultBlock = result + start;
+		bool any = AndBlock(resultBlock, sets[0] + start, sets[1] + start, blockLength);
+
+		for (INT32 s = 2; s < setCount && any; ++s)
+		{
+			any = AndBlock(resultBlock, resultBlock, sets[s] + start, blockLength);
+		}
+	}
+}
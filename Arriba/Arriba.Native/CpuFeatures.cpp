@@ -0,0 +1,56 @@
+#include "stdafx.h"
+
+#include <intrin.h>
+#include <immintrin.h>
+#include "CpuFeatures.h"
+
+static CpuFeatures Detect()
+{
+	CpuFeatures features = { 0 };
+	int cpuinfo[4];
+
+	__cpuid(cpuinfo, 0);
+	int maxLeaf = cpuinfo[0];
+
+	__cpuid(cpuinfo, 1);
+	int ecx1 = cpuinfo[2];
+	features.Sse42 = (ecx1 & (0x1 << 20)) != 0;
+	features.Popcnt = (ecx1 & (0x1 << 23)) != 0;
+
+	// AVX state must be enabled by the OS: OSXSAVE, then XCR0 bits for XMM and YMM (and opmask, ZMM_Hi256, Hi16_ZMM for AVX-512)
+	bool osAvx = false;
+	bool osAvx512 = false;
+	if ((ecx1 & (0x1 << 27)) != 0 && (ecx1 & (0x1 << 28)) != 0)
+	{
+		unsigned __int64 xcr0 = _xgetbv(0);
+		osAvx = (xcr0 & 0x6) == 0x6;
+		osAvx512 = (xcr0 & 0xE6) == 0xE6;
+	}
+
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(cpuinfo, 7, 0);
+		int ebx7 = cpuinfo[1];
+		int ecx7 = cpuinfo[2];
+
+		features.Bmi2 = (ebx7 & (0x1 << 8)) != 0;
+		features.Avx2 = osAvx && (ebx7 & (0x1 << 5)) != 0;
+		features.Avx512F = osAvx512 && (ebx7 & (0x1 << 16)) != 0;
+		features.Avx512Bw = features.Avx512F && (ebx7 & (0x1 << 30)) != 0;
+		features.Avx512Vpopcntdq = features.Avx512F && (ecx7 & (0x1 << 14)) != 0;
+	}
+
+	return features;
+}
+
+extern const CpuFeatures Supported = Detect();
+
+extern "C" __declspec(dllexport) bool IsAdvancedVectorExtensions2Supported()
+{
+	return Supported.Avx2;
+}
+
+extern "C" __declspec(dllexport) bool IsAdvancedVectorExtensions512Supported()
+{
+	return Supported.Avx512F;
+}
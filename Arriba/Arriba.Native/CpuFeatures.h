@@ -0,0 +1,20 @@
+#pragma once
+
+// Instruction sets the CPU and OS support, detected once when Arriba.Native loads
+struct CpuFeatures
+{
+	bool Popcnt;
+	bool Sse42;
+	bool Avx2;
+	bool Bmi2;
+	bool Avx512F;
+	bool Avx512Bw;
+	bool Avx512Vpopcntdq;
+};
+
+extern const CpuFeatures Supported;
+
+// AVX-512 intrinsics need Visual C++ 2017 (15.3) or later; older toolsets build only the AVX2 and scalar kernels
+#if defined(_MSC_VER) && _MSC_VER >= 1911
+#define ARRIBA_AVX512
+#endif
@@ -0,0 +1,177 @@
+#include "stdafx.h"
+
+#include <string.h>
+#include <algorithm>
+#include "SetOperations.h"
+#include "SortedSets.h"
+
+// One WordIndex posting list: the rows containing one word
+struct PostingList
+{
+	// Sparse lists: row IDs, in any order. NULL for dense lists.
+	UINT16* values;
+
+	// Dense lists: a bit per row (MSB first, like ShortSet). NULL for sparse lists.
+	UINT64* bits;
+
+	// Count of values or of UINT64s in bits
+	INT32 length;
+};
+
+// Terms per call; callers with more terms combine them in managed code
+const INT32 PostingTermLimit = 64;
+
+// UINT16s IntersectSorted may write past the result count
+const INT32 SimdSlack = 8;
+
+// The rows in a term (the union of its lists), or an upper bound for sparse lists with duplicates
+static INT32 EstimateTerm(PostingList* lists, INT32 listCount, INT32 bitsLength)
+{
+	INT32 total = 0;
+
+	for (INT32 i = 0; i < listCount; ++i)
+	{
+		if (lists[i].bits != NULL)
+		{
+			total += PopulationCount(lists[i].bits, (lists[i].length < bitsLength ? lists[i].length : bitsLength));
+		}
+		else
+		{
+			total += lists[i].length;
+		}
+	}
+
+	return total;
+}
+
+// Write the rows in a term to values sorted and unique, or return -1 if it has dense lists or more than limit values
+static INT32 TermValues(PostingList* lists, INT32 listCount, UINT16* values, INT32 limit)
+{
+	INT32 total = 0;
+	for (INT32 i = 0; i < listCount; ++i)
+	{
+		if (lists[i].bits != NULL) return -1;
+		total += lists[i].length;
+	}
+
+	if (total > limit) return -1;
+
+	INT32 count = 0;
+	for (INT32 i = 0; i < listCount; ++i)
+	{
+		memcpy(values + count, lists[i].values, lists[i].length * sizeof(UINT16));
+		count += lists[i].length;
+	}
+
+	std::sort(values, values + count);
+	return (INT32)(std::unique(values, values + count) - values);
+}
+
+// Write the rows in a term to bits
+static void TermBits(PostingList* lists, INT32 listCount, UINT64* bits, INT32 bitsLength)
+{
+	memset(bits, 0, bitsLength * sizeof(UINT64));
+	INT32 end = bitsLength * 64;
+
+	for (INT32 i = 0; i < listCount; ++i)
+	{
+		PostingList& list = lists[i];
+
+		if (list.bits != NULL)
+		{
+			CombineSets<SetOr>(bits, bits, list.bits, (list.length < bitsLength ? list.length : bitsLength));
+		}
+		else
+		{
+			for (INT32 j = 0; j < list.length; ++j)
+			{
+				UINT16 value = list.values[j];
+				if (value < end) bits[value >> 6] |= (0x1ULL << 63) >> (value & 63);
+			}
+		}
+	}
+}
+
+// Find the rows in every term, where term t is the union of lists [termStarts[t], termStarts[t + 1]).
+// Terms are intersected rarest first. While the candidates are few and the terms sparse, they're kept as a sorted
+// array and intersected with sorted copies of each term (or filtered by its bits, for dense terms); otherwise the
+// terms are combined as bit vectors.
+//
+// Returns the row count. If *resultIsBits is set on return, the rows are in bits; otherwise they're sorted in values.
+// values needs room for three buffers of at least eight UINT16s; scratch and bits are bitsLength UINT64s.
+extern "C" __declspec(dllexport) INT32 IntersectPostingLists(PostingList* lists, INT32* termStarts, INT32 termCount, UINT16* values, INT32 valuesLength, UINT64* bits, UINT64* scratch, INT32 bitsLength, INT32* resultIsBits)
+{
+	*resultIsBits = 0;
+	if (termCount <= 0 || termCount > PostingTermLimit || bitsLength <= 0) return 0;
+
+	// Order terms rarest first
+	INT32 order[PostingTermLimit];
+	INT32 estimates[PostingTermLimit];
+	for (INT32 t = 0; t < termCount; ++t)
+	{
+		INT32 estimate = EstimateTerm(lists + termStarts[t], termStarts[t + 1] - termStarts[t], bitsLength);
+
+		INT32 at = t;
+		for (; at > 0 && estimates[at - 1] > estimate; --at)
+		{
+			estimates[at] = estimates[at - 1];
+			order[at] = order[at - 1];
+		}
+
+		estimates[at] = estimate;
+		order[at] = t;
+	}
+
+	// values holds the candidates, a sorted copy of the next term, and the intersection of the two
+	INT32 part = valuesLength / 3;
+	INT32 limit = part - SimdSlack;
+	UINT16* candidates = values;
+	UINT16* term = values + part;
+	UINT16* next = values + 2 * part;
+
+	INT32 first = order[0];
+	INT32 count = (limit > 0 ? TermValues(lists + termStarts[first], termStarts[first + 1] - termStarts[first], candidates, limit) : -1);
+
+	if (count >= 0)
+	{
+		for (INT32 i = 1; i < termCount && count > 0; ++i)
+		{
+			INT32 t = order[i];
+			PostingList* termLists = lists + termStarts[t];
+			INT32 termListCount = termStarts[t + 1] - termStarts[t];
+
+			INT32 termValueCount = TermValues(termLists, termListCount, term, limit);
+			if (termValueCount >= 0)
+			{
+				count = IntersectSorted(candidates, count, term, termValueCount, next);
+
+				UINT16* swap = candidates;
+				candidates = next;
+				next = swap;
+			}
+			else
+			{
+				TermBits(termLists, termListCount, scratch, bitsLength);
+				count = IntersectSortedWithSet(candidates, count, scratch, bitsLength, candidates);
+			}
+		}
+
+		if (candidates != values) memmove(values, candidates, count * sizeof(UINT16));
+		return count;
+	}
+
+	// Too many candidates: And the terms as bits, stopping once no rows are left
+	TermBits(lists + termStarts[first], termStarts[first + 1] - termStarts[first], bits, bitsLength);
+	count = PopulationCount(bits, bitsLength);
+
+	for (INT32 i = 1; i < termCount && count > 0; ++i)
+	{
+		INT32 t = order[i];
+		TermBits(lists + termStarts[t], termStarts[t + 1] - termStarts[t], scratch, bitsLength);
+		CombineSets<SetAnd>(bits, bits, scratch, bitsLength);
+		count = PopulationCount(bits, bitsLength);
+	}
+
+	*resultIsBits = 1;
+	return count;
+}
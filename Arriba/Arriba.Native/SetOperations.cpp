@@ -0,0 +1,37 @@
+#include "stdafx.h"
+
+#include "SetOperations.h"
+
+extern "C" __declspec(dllexport) void OrSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
+{
+	CombineSets<SetOr>(result, left, right, length);
+}
+
+extern "C" __declspec(dllexport) void AndNotSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
+{
+	CombineSets<SetAndNot>(result, left, right, length);
+}
+
+extern "C" __declspec(dllexport) void OrNotSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
+{
+	CombineSets<SetOrNot>(result, left, right, length);
+}
+
+extern "C" __declspec(dllexport) void NotSet(UINT64* result, UINT64* values, INT32 length)
+{
+	INT32 i = 0;
+
+	if (Supported.Avx2)
+	{
+		__m256i allBits = _mm256_set1_epi64x(-1);
+		for (; i + 4 <= length; i += 4)
+		{
+			_mm256_storeu_si256((__m256i*)(result + i), _mm256_xor_si256(_mm256_loadu_si256((__m256i*)(values + i)), allBits));
+		}
+	}
+
+	for (; i < length; ++i)
+	{
+		result[i] = ~values[i];
+	}
+}
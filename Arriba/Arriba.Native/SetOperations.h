@@ -0,0 +1,70 @@
+#pragma once
+
+#include <intrin.h>
+#include <immintrin.h>
+#include "CpuFeatures.h"
+
+// Count the bits set in values (PopulationCount.cpp)
+extern "C" __declspec(dllexport) int PopulationCount(UINT64* values, INT32 length);
+
+// Set operations combining (left, right) into result; result may be the same array as left or right
+enum SetOperation
+{
+	SetAnd,
+	SetOr,
+	SetAndNot,
+	SetOrNot
+};
+
+template<SetOperation op>
+static __forceinline UINT64 Combine(UINT64 left, UINT64 right)
+{
+	switch (op)
+	{
+	case SetAnd: return left & right;
+	case SetOr: return left | right;
+	case SetAndNot: return left & ~right;
+	default: return left | ~right;
+	}
+}
+
+template<SetOperation op>
+static __forceinline __m256i Combine(__m256i left, __m256i right)
+{
+	switch (op)
+	{
+	case SetAnd: return _mm256_and_si256(left, right);
+	case SetOr: return _mm256_or_si256(left, right);
+	case SetAndNot: return _mm256_andnot_si256(right, left);
+	default: return _mm256_or_si256(left, _mm256_xor_si256(right, _mm256_set1_epi64x(-1)));
+	}
+}
+
+// AVX2 unaligned load/store, two blocks per iteration, scalar tail (all lengths correct)
+template<SetOperation op>
+static void CombineSets(UINT64* result, UINT64* left, UINT64* right, INT32 length)
+{
+	INT32 i = 0;
+
+	if (Supported.Avx2)
+	{
+		for (; i + 8 <= length; i += 8)
+		{
+			__m256i block1 = Combine<op>(_mm256_loadu_si256((__m256i*)(left + i)), _mm256_loadu_si256((__m256i*)(right + i)));
+			__m256i block2 = Combine<op>(_mm256_loadu_si256((__m256i*)(left + i + 4)), _mm256_loadu_si256((__m256i*)(right + i + 4)));
+			_mm256_storeu_si256((__m256i*)(result + i), block1);
+			_mm256_storeu_si256((__m256i*)(result + i + 4), block2);
+		}
+
+		if (i + 4 <= length)
+		{
+			_mm256_storeu_si256((__m256i*)(result + i), Combine<op>(_mm256_loadu_si256((__m256i*)(left + i)), _mm256_loadu_si256((__m256i*)(right + i))));
+			i += 4;
+		}
+	}
+
+	for (; i < length; ++i)
+	{
+		result[i] = Combine<op>(left[i], right[i]);
+	}
+}
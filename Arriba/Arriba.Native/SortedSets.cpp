@@ -0,0 +1,266 @@
+#include "stdafx.h"
+
+#include <intrin.h>
+#include <nmmintrin.h>
+#include "CpuFeatures.h"
+#include "SortedSets.h"
+
+// Kernels for sparse ShortSets, which hold their values as a sorted, unique UINT16 array, and for
+// moving values between arrays and bit vectors. Where result may be NULL, only the count is returned.
+
+// Galloping beats a merge once one side is this many times longer than the other
+const INT32 GallopRatio = 32;
+
+// For each 8-bit mask of matching values, a pshufb mask moving those UINT16 values to the front
+static __m128i BuildShuffleMask(int match)
+{
+	char bytes[16];
+	int next = 0;
+
+	for (int k = 0; k < 8; ++k)
+	{
+		if (match & (0x1 << k))
+		{
+			bytes[next++] = (char)(2 * k);
+			bytes[next++] = (char)(2 * k + 1);
+		}
+	}
+
+	while (next < 16) bytes[next++] = (char)0x80;
+	return _mm_loadu_si128((__m128i*)bytes);
+}
+
+struct ShuffleMasks
+{
+	__m128i masks[256];
+
+	ShuffleMasks()
+	{
+		for (int i = 0; i < 256; ++i) masks[i] = BuildShuffleMask(i);
+	}
+};
+
+static const ShuffleMasks s_shuffleMasks;
+
+static INT32 IntersectMerge(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result, INT32 i, INT32 j, INT32 count)
+{
+	while (i < leftLength && j < rightLength)
+	{
+		UINT16 l = left[i];
+		UINT16 r = right[j];
+
+		if (l == r)
+		{
+			if (result) result[count] = l;
+			++count;
+		}
+
+		i += (l <= r);
+		j += (r <= l);
+	}
+
+	return count;
+}
+
+// For each value in small, exponential then binary search for it in large from where the last one was found
+static INT32 IntersectGallop(UINT16* small, INT32 smallLength, UINT16* large, INT32 largeLength, UINT16* result)
+{
+	INT32 count = 0;
+	INT32 j = 0;
+
+	for (INT32 i = 0; i < smallLength && j < largeLength; ++i)
+	{
+		UINT16 value = small[i];
+		if (large[j] < value)
+		{
+			INT32 step = 1;
+			while (j + step < largeLength && large[j + step] < value) step *= 2;
+
+			// The first value >= value is in (j + step / 2, j + step], or there isn't one
+			INT32 low = j + step / 2 + 1;
+			INT32 high = (j + step < largeLength ? j + step : largeLength);
+			while (low < high)
+			{
+				INT32 mid = (low + high) / 2;
+				if (large[mid] < value) low = mid + 1; else high = mid;
+			}
+
+			j = low;
+			if (j == largeLength) break;
+		}
+
+		if (large[j] == value)
+		{
+			if (result) result[count] = value;
+			++count;
+			++j;
+		}
+	}
+
+	return count;
+}
+
+// SSE4.2: compare eight values from each side against each other in one PCMPESTRM, storing the matches with one shuffle
+// [Schlegel, Willhalm, and Lehner, "Fast Sorted-Set Intersection using SIMD Instructions"]
+static INT32 IntersectSse42(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result)
+{
+	INT32 count = 0;
+	INT32 i = 0;
+	INT32 j = 0;
+	INT32 leftEnd = leftLength & ~7;
+	INT32 rightEnd = rightLength & ~7;
+
+	while (i < leftEnd && j < rightEnd)
+	{
+		__m128i leftBlock = _mm_loadu_si128((__m128i*)(left + i));
+		__m128i rightBlock = _mm_loadu_si128((__m128i*)(right + j));
+
+		// Bit k is set if left[i + k] is any of the right values
+		int match = _mm_cvtsi128_si32(_mm_cmpestrm(rightBlock, 8, leftBlock, 8, _SIDD_UWORD_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_BIT_MASK));
+
+		if (result) _mm_storeu_si128((__m128i*)(result + count), _mm_shuffle_epi8(leftBlock, s_shuffleMasks.masks[match]));
+		count += _mm_popcnt_u32(match);
+
+		// Advance whichever block ends first (or both)
+		UINT16 leftLast = left[i + 7];
+		UINT16 rightLast = right[j + 7];
+		i += (leftLast <= rightLast ? 8 : 0);
+		j += (rightLast <= leftLast ? 8 : 0);
+	}
+
+	return IntersectMerge(left, leftLength, right, rightLength, result, i, j, count);
+}
+
+// result = left & right; returns the count. result needs room for min(leftLength, rightLength) + 8 values.
+extern "C" __declspec(dllexport) INT32 IntersectSorted(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result)
+{
+	if (leftLength == 0 || rightLength == 0) return 0;
+
+	if (leftLength * GallopRatio < rightLength) return IntersectGallop(left, leftLength, right, rightLength, result);
+	if (rightLength * GallopRatio < leftLength) return IntersectGallop(right, rightLength, left, leftLength, result);
+
+	if (Supported.Sse42 && Supported.Popcnt) return IntersectSse42(left, leftLength, right, rightLength, result);
+	return IntersectMerge(left, leftLength, right, rightLength, result, 0, 0, 0);
+}
+
+// result = left | right, without duplicates; returns the count. result needs room for leftLength + rightLength values.
+extern "C" __declspec(dllexport) INT32 UnionSorted(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result)
+{
+	INT32 count = 0;
+	INT32 i = 0;
+	INT32 j = 0;
+
+	while (i < leftLength && j < rightLength)
+	{
+		UINT16 l = left[i];
+		UINT16 r = right[j];
+		UINT16 next = (l <= r ? l : r);
+
+		if (count == 0 || result[count - 1] != next) result[count++] = next;
+
+		i += (l <= r);
+		j += (r <= l);
+	}
+
+	for (; i < leftLength; ++i)
+	{
+		if (count == 0 || result[count - 1] != left[i]) result[count++] = left[i];
+	}
+
+	for (; j < rightLength; ++j)
+	{
+		if (count == 0 || result[count - 1] != right[j]) result[count++] = right[j];
+	}
+
+	return count;
+}
+
+// Keep the values whose bit in the dense set (MSB first, like ShortSet) is 'keepIf'. result may be values itself.
+template<UINT64 keepIf>
+static INT32 FilterBySet(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result)
+{
+	INT32 count = 0;
+	INT32 setEnd = setLength * 64;
+
+	INT32 i = 0;
+	for (; i < length && values[i] < setEnd; ++i)
+	{
+		UINT16 value = values[i];
+		UINT64 bit = (set[value >> 6] >> (63 - (value & 63))) & 0x1;
+
+		// Write every value and only advance past the ones kept, so there's no unpredictable branch
+		if (result) result[count] = value;
+		count += (INT32)(bit == keepIf);
+	}
+
+	// Values past the end of the set aren't in it
+	if (keepIf == 0)
+	{
+		for (; i < length; ++i)
+		{
+			if (result) result[count] = values[i];
+			++count;
+		}
+	}
+
+	return count;
+}
+
+// result = values & set; returns the count
+extern "C" __declspec(dllexport) INT32 IntersectSortedWithSet(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result)
+{
+	return FilterBySet<1>(values, length, set, setLength, result);
+}
+
+// result = values & ~set; returns the count
+extern "C" __declspec(dllexport) INT32 AndNotSortedWithSet(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result)
+{
+	return FilterBySet<0>(values, length, set, setLength, result);
+}
+
+// True if values are exactly [first, first + 64), so the word for them can be filled at once
+static __forceinline bool IsRun64(UINT16* values, UINT16 first)
+{
+	__m128i expected = _mm_add_epi16(_mm_set1_epi16((short)first), _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7));
+	__m128i step = _mm_set1_epi16(8);
+	__m128i differences = _mm_setzero_si128();
+
+	for (int k = 0; k < 64; k += 8)
+	{
+		differences = _mm_or_si128(differences, _mm_xor_si128(_mm_loadu_si128((__m128i*)(values + k)), expected));
+		expected = _mm_add_epi16(expected, step);
+	}
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(differences, _mm_setzero_si128())) == 0xFFFF;
+}
+
+// set |= the bit for each value (in any order, unique or not); values past the end of the set are ignored.
+// Runs of 64 consecutive values starting a word, common in the sorted IDs of columns filled in order, fill the word.
+extern "C" __declspec(dllexport) void SetBitsForValues(UINT16* values, INT32 length, UINT64* set, INT32 setLength)
+{
+	INT32 setEnd = setLength * 64;
+	INT32 i = 0;
+
+	while (i < length)
+	{
+		UINT16 value = values[i];
+
+		if ((value & 63) == 0 && i + 64 <= length && value + 64 <= setEnd && values[i + 63] == value + 63 && IsRun64(values + i, value))
+		{
+			set[value >> 6] = ~0x0ULL;
+			i += 64;
+			continue;
+		}
+
+		// Set bits one at a time for a block; if the values look consecutive, stop where the next run would start a word
+		INT32 end = i + 64;
+		if (i + 1 < length && values[i + 1] == value + 1) end -= (value & 63);
+		if (end > length) end = length;
+
+		for (; i < end; ++i)
+		{
+			value = values[i];
+			if (value < setEnd) set[value >> 6] |= (0x1ULL << 63) >> (value & 63);
+		}
+	}
+}
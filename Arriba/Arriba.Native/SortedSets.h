@@ -0,0 +1,16 @@
+#pragma once
+
+// Sorted, unique UINT16 set kernels (SortedSets.cpp); where result may be NULL, only the count is returned
+
+// result = left & right. result needs room for min(leftLength, rightLength) + 8 values and must not be left or right.
+extern "C" __declspec(dllexport) INT32 IntersectSorted(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result);
+
+// result = left | right, without duplicates. result needs room for leftLength + rightLength values.
+extern "C" __declspec(dllexport) INT32 UnionSorted(UINT16* left, INT32 leftLength, UINT16* right, INT32 rightLength, UINT16* result);
+
+// result = values with (or without) their bit set in a ShortSet-style bit vector. result may be values.
+extern "C" __declspec(dllexport) INT32 IntersectSortedWithSet(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result);
+extern "C" __declspec(dllexport) INT32 AndNotSortedWithSet(UINT16* values, INT32 length, UINT64* set, INT32 setLength, UINT16* result);
+
+// set |= the bit for each value, in any order. Values past the end of the set are ignored.
+extern "C" __declspec(dllexport) void SetBitsForValues(UINT16* values, INT32 length, UINT64* set, INT32 setLength);
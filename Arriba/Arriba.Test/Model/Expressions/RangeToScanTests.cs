@@ -245,6 +245,41 @@ namespace Arriba.Test
             Assert.AreEqual("2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17", AddMatches(Build(Operator.Equals, 3, 16, 20), sortedIDs, new ushort[] { 2, 3, 16, 17 }));
         }
 
+        [TestMethod]
+        public void RangeToScan_AddMatches_Large()
+        {
+            // Verify ranges spanning many words match for IDs in order (filled a word at a time) and out of order
+            ushort[] inOrderIDs = GetSampleSortedIDs(1000);
+            ushort[] shuffledIDs = GetSampleSortedIDs(1000);
+
+            Random r = new Random(5);
+            for (int i = shuffledIDs.Length - 1; i > 0; --i)
+            {
+                int j = r.Next(i + 1);
+                ushort swap = shuffledIDs[i];
+                shuffledIDs[i] = shuffledIDs[j];
+                shuffledIDs[j] = swap;
+            }
+
+            foreach (ushort[] sortedIDs in new ushort[][] { inOrderIDs, shuffledIDs })
+            {
+                Assert.AreEqual(ExpectedMatches(sortedIDs, 0, 701), AddMatches(Build(Operator.LessThanOrEqual, 700, 700, 1000), sortedIDs, null));
+                Assert.AreEqual(ExpectedMatches(sortedIDs, 37, 450), AddMatches(Build(Operator.Equals, 37, 449, 1000), sortedIDs, null));
+                Assert.AreEqual(ExpectedMatches(sortedIDs, 129, 1000), AddMatches(Build(Operator.GreaterThan, 128, 128, 1000), sortedIDs, null));
+            }
+        }
+
+        private static string ExpectedMatches(ushort[] sortedIDs, int start, int end)
+        {
+            ShortSet expected = new ShortSet((ushort)sortedIDs.Length);
+            for (int i = start; i < end; ++i)
+            {
+                expected.Add(sortedIDs[i]);
+            }
+
+            return String.Join(", ", expected.Values);
+        }
+
         private static RangeToScan Build(Operator op, int firstSortedIndexWithValue, int lastSortedIndexWithValue, int count)
         {
             RangeToScan r = new RangeToScan();
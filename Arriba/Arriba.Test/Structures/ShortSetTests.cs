@@ -216,6 +216,154 @@ namespace Arriba.Test
             Assert.AreEqual("1, 3", String.Join(", ", s2.Values));
         }
 
+        [TestMethod]
+        public void ShortSet_CountAndFromAndMany()
+        {
+            ShortSet s1 = new ShortSet(200);
+            ShortSet s2 = new ShortSet(150);
+            ShortSet s3 = new ShortSet(200);
+            s1.Or(new ushort[] { 1, 3, 64, 100, 149, 180 });
+            s2.Or(new ushort[] { 1, 64, 100, 149 });
+            s3.Or(new ushort[] { 1, 2, 100, 149, 180 });
+
+            // CountAnd counts only common values and doesn't change either set
+            Assert.AreEqual(4, s1.CountAnd(s2));
+            Assert.AreEqual(4, s2.CountAnd(s1));
+            Assert.AreEqual("1, 3, 64, 100, 149, 180", String.Join(", ", s1.Values));
+            Verify.Exception<ArgumentNullException>(() => s1.CountAnd(null));
+
+            // FromAnd of many sets keeps values in every set, up to the smallest capacity
+            ShortSet result = new ShortSet(200);
+            result.Or(new ushort[] { 5, 190 });
+            result.FromAnd(new ShortSet[] { s1, s2, s3 });
+            Assert.AreEqual("1, 100, 149", String.Join(", ", result.Values));
+
+            result.FromAnd(new ShortSet[] { s1, s3 });
+            Assert.AreEqual("1, 100, 149, 180", String.Join(", ", result.Values));
+
+            // Once nothing is left, later sets don't matter
+            result.FromAnd(new ShortSet[] { s1, new ShortSet(200), s3 });
+            Assert.AreEqual("", String.Join(", ", result.Values));
+
+            Verify.Exception<ArgumentException>(() => result.FromAnd(new ShortSet[0]));
+        }
+
+        [TestMethod]
+        public void ShortSet_SparseAndDense()
+        {
+            // Sets with few values are stored as sorted arrays; verify every operation for each pair of representations
+            Random r = new Random(5);
+            ushort[] capacities = { ushort.MaxValue, 20000 };
+            int[] counts = { 0, 40, 200, 3000 };
+
+            foreach (ushort leftCapacity in capacities)
+            {
+                foreach (ushort rightCapacity in capacities)
+                {
+                    foreach (int leftCount in counts)
+                    {
+                        foreach (int rightCount in counts)
+                        {
+                            ushort[] left = RandomValues(leftCapacity, leftCount, r);
+                            ushort[] right = RandomValues(rightCapacity, rightCount, r);
+                            Func<ShortSet> buildLeft = () => Build(leftCapacity, left);
+                            ShortSet rightSet = Build(rightCapacity, right);
+
+                            Assert.AreEqual(leftCount <= leftCapacity / 256, buildLeft().IsSparse);
+                            Assert.AreEqual(left.Intersect(right).Count(), buildLeft().CountAnd(rightSet));
+
+                            IEnumerable<ushort> and = left.Intersect(right);
+                            IEnumerable<ushort> or = left.Union(right.Where(v => v < leftCapacity));
+                            IEnumerable<ushort> andNot = left.Except(right);
+
+                            ShortSet result = buildLeft();
+                            result.And(rightSet);
+                            AssertValues(and, result);
+
+                            result = buildLeft();
+                            result.Or(rightSet);
+                            AssertValues(or, result);
+
+                            result = buildLeft();
+                            result.AndNot(rightSet);
+                            AssertValues(andNot, result);
+
+                            result = buildLeft();
+                            result.From(rightSet);
+                            AssertValues(right.Where(v => v < leftCapacity), result);
+
+                            result = new ShortSet(leftCapacity);
+                            result.FromAnd(buildLeft(), rightSet);
+                            AssertValues(and, result);
+
+                            result = new ShortSet(leftCapacity);
+                            result.FromAnd(new ShortSet[] { buildLeft(), rightSet, buildLeft() });
+                            AssertValues(and, result);
+
+                            unsafe
+                            {
+                                // Unsorted values, with duplicates
+                                ushort[] unsorted = right.Reverse().Concat(right).ToArray();
+                                result = buildLeft();
+                                fixed (ushort* pUnsorted = unsorted)
+                                {
+                                    if (unsorted.Length > 0) result.Or(pUnsorted, (ushort)unsorted.Length);
+                                }
+
+                                AssertValues(or, result);
+                            }
+
+                            // Operations with the set itself, and leaving the sparse form
+                            result = buildLeft();
+                            result.And(result);
+                            result.Or(result);
+                            AssertValues(left, result);
+
+                            result.Not();
+                            Assert.IsFalse(result.IsSparse);
+                            Assert.AreEqual(leftCapacity - left.Length, result.Count());
+                        }
+                    }
+                }
+            }
+        }
+
+        private static ushort[] RandomValues(ushort capacity, int count, Random r)
+        {
+            HashSet<ushort> values = new HashSet<ushort>();
+            while (values.Count < count)
+            {
+                values.Add((ushort)r.Next(capacity));
+            }
+
+            return values.OrderBy(v => v).ToArray();
+        }
+
+        private static ShortSet Build(ushort capacity, ushort[] values)
+        {
+            // Add in descending order to exercise inserts
+            ShortSet set = new ShortSet(capacity);
+            for (int i = values.Length - 1; i >= 0; --i)
+            {
+                set.Add(values[i]);
+            }
+
+            return set;
+        }
+
+        private static void AssertValues(IEnumerable<ushort> expected, ShortSet actual)
+        {
+            ushort[] expectedValues = expected.OrderBy(v => v).ToArray();
+            Assert.AreEqual(String.Join(", ", expectedValues), String.Join(", ", actual.Values));
+            Assert.AreEqual(expectedValues.Length, actual.Count());
+            Assert.AreEqual(expectedValues.Length == 0, actual.IsEmpty());
+
+            for (int i = 0; i < expectedValues.Length; ++i)
+            {
+                Assert.IsTrue(actual.Contains(expectedValues[i]));
+            }
+        }
+
 #if PERFORMANCE
         [TestMethod]
 #endif
@@ -116,6 +116,36 @@ namespace Arriba.Test.Structures
             Assert.AreEqual("", GetMatches(index, "will be split also"));
         }
 
+        [TestMethod]
+        public void WordIndex_MatchesAllWords()
+        {
+            WordIndex index = new WordIndex(new DefaultWordSplitter());
+
+            // Index words with a mix of rare, common, and dense sets
+            for (ushort i = 0; i < 20000; ++i)
+            {
+                StringBuilder value = new StringBuilder("item");
+                if (i % 2 == 0) value.Append(" even");
+                if (i % 3 == 0) value.Append(" triple");
+                if (i % 7 == 0) value.Append(" seventh");
+                if (i % 500 == 0) value.Append(" rare");
+                if (i % 1000 == 1) value.Append(" rarest");
+
+                index.Index(i, "", value.ToString());
+            }
+
+            // Verify only the items with all words match, whether the candidates are few or many
+            Assert.AreEqual(GetExpected(20000, (i) => i % 2 == 0 && i % 3 == 0), GetMatches(index, "even triple"));
+            Assert.AreEqual(GetExpected(20000, (i) => i % 42 == 0), GetMatches(index, "triple seventh even"));
+            Assert.AreEqual(GetExpected(20000, (i) => i % 1000 == 1), GetMatches(index, "item rarest"));
+            Assert.AreEqual("", GetMatches(index, "rarest even"));
+            Assert.AreEqual("", GetMatches(index, "even missing"));
+
+            // Verify prefixes match the union of the words they're a prefix of ('rare' and 'rarest')
+            Assert.AreEqual(GetExpected(20000, (i) => (i % 500 == 0 || i % 1000 == 1) && i % 7 == 0), GetMatches(index, "seventh rare item"));
+            Assert.AreEqual(GetExpected(20000, (i) => i % 500 == 0), GetMatches(index, "even rar"));
+        }
+
         [TestMethod]
         public void WordIndex_MultipleBlocks()
         {
@@ -167,6 +197,18 @@ namespace Arriba.Test.Structures
             return String.Join(", ", results.Values);
         }
 
+        private static string GetExpected(int count, Func<int, bool> matches)
+        {
+            List<int> expected = new List<int>();
+
+            for (int i = 0; i < count; ++i)
+            {
+                if (matches(i)) expected.Add(i);
+            }
+
+            return String.Join(", ", expected);
+        }
+
         private static string GetIndexData(WordIndex index)
         {
             Dictionary<string, List<ushort>> d = index.ConvertToDictionary();
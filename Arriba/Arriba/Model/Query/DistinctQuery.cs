@@ -200,10 +200,9 @@ namespace Arriba.Model.Query
                     BooleanColumn bc = (BooleanColumn)typedColumn;
                     ShortSet trueSet = new ShortSet(bc.Count);
                     bc.TryWhere(Operator.Equals, true, trueSet, null);
-                    whereSet.And(trueSet);
 
                     // Determine the count which were true and false matching the query
-                    int countWhichAreTrue = whereSet.Count();
+                    int countWhichAreTrue = whereSet.CountAnd(trueSet);
                     int countWhichAreFalse = countBefore - countWhichAreTrue;
 
                     allValuesReturned = true;
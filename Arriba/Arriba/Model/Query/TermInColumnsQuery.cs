@@ -68,9 +68,8 @@ namespace Arriba.Model.Query
                     column.TryWhere(Operator.Matches, this.Term, termMatchesForColumn, perColumnDetails);
                     succeeded |= perColumnDetails.Succeeded;
 
-                    termMatchesForColumn.And(baseQueryMatches);
-
-                    ushort matchCount = termMatchesForColumn.Count();
+                    // Count matches for the term and base query without building the intersection
+                    ushort matchCount = termMatchesForColumn.CountAnd(baseQueryMatches);
                     if (matchCount > 0)
                     {
                         matchCountPerColumn.Add(new Tuple<string, int>(column.Name, (int)matchCount));
@@ -19,17 +19,43 @@ namespace Arriba.Structures
     ///  clause or in a given set. Set operations are in the inner loop of
     ///  searches, so performance of this class is critical.
     /// </summary>
+    /// <remarks>
+    ///  Like a Roaring bitmap container, a ShortSet holds few values as a
+    ///  sorted array and switches to a bit vector once it has more than
+    ///  1/256th of capacity values, where operations on the (vectorized)
+    ///  bit vector become faster than merging the arrays. Operations pick
+    ///  a kernel for each pair of representations, so sets for rare words
+    ///  and selective clauses cost per value, not per row. Sets don't
+    ///  switch back to the array form except on Clear and when combined
+    ///  with a sparse set by And or FromAnd.
+    /// </remarks>
     public class ShortSet : IBinarySerializable
     {
         internal const ulong FirstBit = 0x1UL << 63;
         public static bool UseNativeSupport;
         private static byte[] s_setBitsTable;
 
+        // IntersectSorted may write up to eight values past the result count
+        private const int SimdSlack = 8;
+
         private ushort _capacity;
-        private ulong[] _bitVector;
+        private int _vectorLength;
         private ulong _clearAboveCapacityMask;
         private ShortSet _scratchSet;
 
+        // Dense form: _bitVector holds a bit per possible value. Null while the set is sparse.
+        private ulong[] _bitVector;
+
+        // Sparse form: _values[0, _sparseCount) holds the set values in ascending order, all below capacity.
+        private ushort[] _values;
+        private int _sparseCount;
+        private int _sparseLimit;
+
+        // Buffers kept from the other form and from the last sparse result, so switching doesn't allocate
+        private ulong[] _spareBitVector;
+        private ushort[] _spareValues;
+        private ushort[] _sortBuffer;
+
         static ShortSet()
         {
             BuildSetBitsLookupTable();
@@ -45,15 +71,31 @@ namespace Arriba.Structures
         {
             _capacity = capacity;
 
-            // Allocate enough bits to tell whether 0-(capacity-1) are in the set
+            // Compute enough bits to tell whether 0-(capacity-1) are in the set
             int vectorSize = (capacity / 64);
             int overage = (capacity % 64);
             if (overage != 0) vectorSize++;
-            _bitVector = new ulong[vectorSize];
+            _vectorLength = vectorSize;
 
             // Create a mask to clear bits in the last ulong which are above the capacity
             _clearAboveCapacityMask = ~0UL;
             if (overage != 0) _clearAboveCapacityMask = ~(_clearAboveCapacityMask >> overage);
+
+            // Start empty and sparse; the bit vector is allocated when the set outgrows the sorted array
+            _sparseLimit = capacity / 256;
+            _bitVector = null;
+            _values = null;
+            _sparseCount = 0;
+            _spareBitVector = null;
+            _spareValues = null;
+        }
+
+        /// <summary>
+        ///  Return whether the set is currently stored as a sorted array of values.
+        /// </summary>
+        internal bool IsSparse
+        {
+            get { return _bitVector == null; }
         }
 
         #region Add/Remove, Contains, Enumerate, Count
@@ -65,6 +107,8 @@ namespace Arriba.Structures
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         public bool Contains(ushort index)
         {
+            if (_bitVector == null) return _sparseCount > 0 && Array.BinarySearch(_values, 0, _sparseCount, index) >= 0;
+
             // Check the corresponding bit in the vector
             return (_bitVector[index >> 6] & (FirstBit >> (index & 63))) != 0UL;
         }
@@ -76,6 +120,12 @@ namespace Arriba.Structures
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         public void Add(ushort index)
         {
+            if (_bitVector == null)
+            {
+                AddSparse(index);
+                return;
+            }
+
             // Set the corresponding bit in the vector
             ulong bitSection = (FirstBit >> (index & 63));
             _bitVector[index >> 6] |= bitSection;
@@ -88,6 +138,12 @@ namespace Arriba.Structures
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         public void Remove(ushort index)
         {
+            if (_bitVector == null)
+            {
+                RemoveSparse(index);
+                return;
+            }
+
             // Clear the corresponding bit in the vector
             ulong bitSection = (FirstBit >> (index & 63));
             _bitVector[index >> 6] &= ~bitSection;
@@ -100,6 +156,8 @@ namespace Arriba.Structures
         [MethodImpl(MethodImplOptions.AggressiveInlining)]
         public bool IsEmpty()
         {
+            if (_bitVector == null) return _sparseCount == 0;
+
             int length = _bitVector.Length;
             for (int i = 0; i < length; ++i)
             {
@@ -116,6 +174,13 @@ namespace Arriba.Structures
         {
             get
             {
+                if (_bitVector == null)
+                {
+                    ushort[] sparseItems = new ushort[_sparseCount];
+                    if (_sparseCount > 0) Array.Copy(_values, sparseItems, _sparseCount);
+                    return sparseItems;
+                }
+
                 int count = this.Count();
                 int countFound = 0;
                 ushort[] items = new ushort[count];
@@ -163,6 +228,7 @@ namespace Arriba.Structures
         /// </summary>
         public unsafe ushort Count()
         {
+            if (_bitVector == null) return (ushort)_sparseCount;
             if (_bitVector.Length == 0) return 0;
 
             if (UseNativeSupport)
@@ -199,6 +265,59 @@ namespace Arriba.Structures
             }
         }
 
+        /// <summary>
+        ///  Return the count of items in both this set and another set, without
+        ///  changing either set.
+        /// </summary>
+        /// <param name="other">ShortSet to count the intersection with</param>
+        /// <returns>Count of items in (this AND other)</returns>
+        public unsafe ushort CountAnd(ShortSet other)
+        {
+            if (other == null) throw new ArgumentNullException("other");
+
+            // Sparse values are all below capacity, so only values in both sets are counted
+            if (_bitVector == null && other._bitVector == null) return (ushort)Intersect(_values, _sparseCount, other._values, other._sparseCount, null);
+            if (_bitVector == null) return (ushort)IntersectWithSet(_values, _sparseCount, other._bitVector, null);
+            if (other._bitVector == null) return (ushort)IntersectWithSet(other._values, other._sparseCount, _bitVector, null);
+
+            // Values above the shorter capacity are in only one set, so only common parts are counted
+            int length = Math.Min(_bitVector.Length, other._bitVector.Length);
+            if (length == 0) return 0;
+
+            if (UseNativeSupport)
+            {
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    fixed (ulong* otherA = &other._bitVector[0])
+                    {
+                        return (ushort)NativeMethods.AndCount(thisA, otherA, length);
+                    }
+                }
+            }
+            else
+            {
+                const ulong m1 = 0x5555555555555555UL;
+                const ulong m2 = 0x3333333333333333UL;
+                const ulong m4 = 0x0f0f0f0f0f0f0f0fUL;
+                const ulong h1 = 0x0101010101010101UL;
+
+                ushort count = 0;
+
+                for (int i = 0; i < length; ++i)
+                {
+                    ulong x = _bitVector[i] & other._bitVector[i];
+
+                    x -= (x >> 1) & m1;
+                    x = (x & m2) + ((x >> 2) & m2);
+                    x = (x + (x >> 4)) & m4;
+
+                    count += (ushort)((x * h1) >> 56);
+                }
+
+                return count;
+            }
+        }
+
         /// <summary>
         ///  Capacity accessor; returns the number of items possible within the set (0-limit).
         /// </summary>
@@ -212,12 +331,24 @@ namespace Arriba.Structures
         /// <summary>
         ///  Negate all items in the set.
         /// </summary>
-        public void Not()
+        public unsafe void Not()
         {
+            if (_bitVector == null) ConvertToDense();
             int length = _bitVector.Length;
-            for (int i = 0; i < length; ++i)
+
+            if (UseNativeSupport && length > 0)
             {
-                _bitVector[i] = ~_bitVector[i];
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    NativeMethods.NotSet(thisA, thisA, length);
+                }
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] = ~_bitVector[i];
+                }
             }
 
             TrimToCapacity();
@@ -228,8 +359,8 @@ namespace Arriba.Structures
         /// </summary>
         public void Clear()
         {
-            int length = _bitVector.Length;
-            Array.Clear(_bitVector, 0, _bitVector.Length);
+            // An empty set is sparse; the bit vector is kept to reuse if the set grows again
+            ClearToSparse();
         }
         #endregion
 
@@ -239,15 +370,53 @@ namespace Arriba.Structures
         ///  to our capacity.
         /// </summary>
         /// <param name="other">ShortSet with which to And</param>
-        public void And(ShortSet other)
+        public unsafe void And(ShortSet other)
         {
             if (other == null) throw new ArgumentNullException("other");
 
+            if (_bitVector == null)
+            {
+                if (other._bitVector == null)
+                {
+                    // Sparse & Sparse: Intersect the sorted values
+                    ushort[] result = Reserve(_spareValues, Math.Min(_sparseCount, other._sparseCount), 0);
+                    UseSparseValues(result, Intersect(_values, _sparseCount, other._values, other._sparseCount, result));
+                }
+                else
+                {
+                    // Sparse & Dense: Keep our values with bits set in other
+                    _sparseCount = IntersectWithSet(_values, _sparseCount, other._bitVector, _values);
+                }
+
+                return;
+            }
+            else if (other._bitVector == null)
+            {
+                // Dense & Sparse: The result is the values in other with bits set here, so this set becomes sparse
+                ushort[] result = Reserve(_spareValues, other._sparseCount, 0);
+                UseSparseValues(result, IntersectWithSet(other._values, other._sparseCount, _bitVector, result));
+                return;
+            }
+
             // And parts in both. Values above other capacity will be zero, clearing them in our set.
             int length = Math.Min(_bitVector.Length, other._bitVector.Length);
-            for (int i = 0; i < length; ++i)
+
+            if (UseNativeSupport && length > 0)
+            {
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    fixed (ulong* otherA = &other._bitVector[0])
+                    {
+                        NativeMethods.AndSets(thisA, thisA, otherA, length);
+                    }
+                }
+            }
+            else
             {
-                _bitVector[i] &= other._bitVector[i];
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] &= other._bitVector[i];
+                }
             }
 
             // Clear our values above other capacity, if any
@@ -259,15 +428,53 @@ namespace Arriba.Structures
         ///  our capacity.
         /// </summary>
         /// <param name="other">ShortSet with which to Or</param>
-        public void Or(ShortSet other)
+        public unsafe void Or(ShortSet other)
         {
             if (other == null) throw new ArgumentNullException("other");
 
+            if (other._bitVector == null)
+            {
+                // Only other values below our capacity are added
+                int otherCount = CountBelow(other._values, other._sparseCount, _capacity);
+
+                if (_bitVector == null && _sparseCount + otherCount <= _sparseLimit)
+                {
+                    // Sparse | Sparse: Merge the sorted values, if the result is sure to stay sparse
+                    ushort[] result = Reserve(_spareValues, _sparseCount + otherCount, 0);
+                    UseSparseValues(result, Union(_values, _sparseCount, other._values, otherCount, result));
+                }
+                else
+                {
+                    // Dense | Sparse: Set the bits for other values
+                    if (_bitVector == null) ConvertToDense();
+                    SetBits(_bitVector, other._values, otherCount);
+                }
+
+                return;
+            }
+
+            // Sparse | Dense: The result will be dense
+            if (_bitVector == null) ConvertToDense();
+
             // Or parts in both. This may set values above our capacity in the last ulong.
             int length = Math.Min(_bitVector.Length, other._bitVector.Length);
-            for (int i = 0; i < length; ++i)
+
+            if (UseNativeSupport && length > 0)
+            {
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    fixed (ulong* otherA = &other._bitVector[0])
+                    {
+                        NativeMethods.OrSets(thisA, thisA, otherA, length);
+                    }
+                }
+            }
+            else
             {
-                _bitVector[i] |= other._bitVector[i];
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] |= other._bitVector[i];
+                }
             }
 
             // Clear back to our capacity.
@@ -279,15 +486,33 @@ namespace Arriba.Structures
         ///  to our capacity.
         /// </summary>
         /// <param name="other">ShortSet with which to AndNot</param>
-        public void OrNot(ShortSet other)
+        public unsafe void OrNot(ShortSet other)
         {
             if (other == null) throw new ArgumentNullException("other");
 
+            // The result has most values set, so it's always dense. Sparse other sets are expanded to bits to combine.
+            if (_bitVector == null) ConvertToDense();
+            ulong[] otherVector = other.ToVector();
+
             // OrNot away values in other.
-            int length = Math.Min(_bitVector.Length, other._bitVector.Length);
-            for (int i = 0; i < length; ++i)
+            int length = Math.Min(_bitVector.Length, otherVector.Length);
+
+            if (UseNativeSupport && length > 0)
             {
-                _bitVector[i] = _bitVector[i] | ~other._bitVector[i];
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    fixed (ulong* otherA = &otherVector[0])
+                    {
+                        NativeMethods.OrNotSets(thisA, thisA, otherA, length);
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] = _bitVector[i] | ~otherVector[i];
+                }
             }
 
             // Clear back to our capacity.
@@ -299,17 +524,59 @@ namespace Arriba.Structures
         ///  to our capacity.
         /// </summary>
         /// <param name="other">ShortSet with which to AndNot</param>
-        public void AndNot(ShortSet other)
+        public unsafe void AndNot(ShortSet other)
         {
             if (other == null) throw new ArgumentNullException("other");
 
+            if (other._bitVector == null)
+            {
+                if (_bitVector == null)
+                {
+                    // Sparse & ~Sparse: Merge, keeping values only on our side
+                    ushort[] result = Reserve(_spareValues, _sparseCount, 0);
+                    UseSparseValues(result, Except(_values, _sparseCount, other._values, other._sparseCount, result));
+                }
+                else
+                {
+                    // Dense & ~Sparse: Clear the bits for other values
+                    int otherCount = CountBelow(other._values, other._sparseCount, _capacity);
+                    for (int i = 0; i < otherCount; ++i)
+                    {
+                        ushort value = other._values[i];
+                        _bitVector[value >> 6] &= ~(FirstBit >> (value & 63));
+                    }
+                }
+
+                return;
+            }
+            else if (_bitVector == null)
+            {
+                // Sparse & ~Dense: Keep our values without bits set in other
+                _sparseCount = AndNotWithSet(_values, _sparseCount, other._bitVector, _values);
+                return;
+            }
+
             // AndNot away values in other. This will not set values above our capacity,
             // since they're already 0 on our side. This will not clear values above their
             // capacity, because they are already 0 on their side.
             int length = Math.Min(_bitVector.Length, other._bitVector.Length);
-            for (int i = 0; i < length; ++i)
+
+            if (UseNativeSupport && length > 0)
             {
-                _bitVector[i] = _bitVector[i] & ~other._bitVector[i];
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    fixed (ulong* otherA = &other._bitVector[0])
+                    {
+                        NativeMethods.AndNotSets(thisA, thisA, otherA, length);
+                    }
+                }
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] = _bitVector[i] & ~other._bitVector[i];
+                }
             }
         }
         #endregion
@@ -322,16 +589,32 @@ namespace Arriba.Structures
         public void From(ShortSet other)
         {
             if (other == null) throw new ArgumentNullException("other");
+            if (other == this) return;
 
-            // Copy from other
-            int length = Math.Min(_bitVector.Length, other._bitVector.Length);
-            for (int i = 0; i < length; ++i)
+            if (other._bitVector == null)
             {
-                _bitVector[i] = other._bitVector[i];
+                // Copy the sparse values below our capacity
+                int count = CountBelow(other._values, other._sparseCount, _capacity);
+                ushort[] result = Reserve(_spareValues, count, 0);
+                if (count > 0) Array.Copy(other._values, result, count);
+                UseSparseValues(result, count);
+                return;
             }
 
-            // Clear our values above other capacity, if any
+            // Switch to an empty dense set to copy into
+            if (_bitVector == null)
+            {
+                ClearToSparse();
+                ConvertToDense();
+            }
+
+            // Copy from other (Array.Copy is a native block copy; no Arriba.Native call is needed)
+            int length = Math.Min(_bitVector.Length, other._bitVector.Length);
+            Array.Copy(other._bitVector, _bitVector, length);
+
+            // Clear our values above other capacity, if any, and other values above ours
             ClearAboveLength(length);
+            TrimToCapacity();
         }
 
         /// <summary>
@@ -344,9 +627,22 @@ namespace Arriba.Structures
             if (left == null) throw new ArgumentNullException("left");
             if (right == null) throw new ArgumentNullException("right");
 
+            if (left._bitVector == null || right._bitVector == null)
+            {
+                FromAndSparse(left, right);
+                return;
+            }
+
+            // Switch to an empty dense set to write into (this can't be left or right, which are dense)
+            if (_bitVector == null)
+            {
+                ClearToSparse();
+                ConvertToDense();
+            }
+
             int length = Math.Min(_bitVector.Length, Math.Min(left._bitVector.Length, right._bitVector.Length));
 
-            if (UseNativeSupport)
+            if (UseNativeSupport && length > 0)
             {
                 fixed (ulong* thisA = &_bitVector[0])
                 {
@@ -368,8 +664,102 @@ namespace Arriba.Structures
                 }
             }
 
-            // Clear our values above other capacity, if any
+            // Clear our values above other capacity, if any, and other values above ours
+            ClearAboveLength(length);
+            TrimToCapacity();
+        }
+
+        /// <summary>
+        ///  Set this set equal to the AND of all of the given sets, overwriting current values.
+        ///  The native version combines every set in one pass and stops reading sets for ranges
+        ///  already empty.
+        /// </summary>
+        /// <param name="sets">ShortSets to And</param>
+        public unsafe void FromAnd(IList<ShortSet> sets)
+        {
+            if (sets == null) throw new ArgumentNullException("sets");
+            if (sets.Count == 0) throw new ArgumentException("At least one set is required.", "sets");
+
+            int length = _vectorLength;
+            int sparsest = -1;
+            for (int i = 0; i < sets.Count; ++i)
+            {
+                if (sets[i] == null) throw new ArgumentNullException("sets");
+                length = Math.Min(length, sets[i]._vectorLength);
+
+                if (sets[i]._bitVector == null && (sparsest == -1 || sets[i]._sparseCount < sets[sparsest]._sparseCount)) sparsest = i;
+            }
+
+            if (sparsest != -1)
+            {
+                FromAndSparse(sets, sparsest);
+                return;
+            }
+
+            // Switch to an empty dense set to write into (this isn't in sets, which are all dense)
+            if (_bitVector == null)
+            {
+                ClearToSparse();
+                ConvertToDense();
+            }
+
+            if (UseNativeSupport && length > 0)
+            {
+                // Pin every set for the duration of the call
+                GCHandle[] handles = new GCHandle[sets.Count];
+                ulong*[] pointers = new ulong*[sets.Count];
+
+                try
+                {
+                    for (int i = 0; i < sets.Count; ++i)
+                    {
+                        handles[i] = GCHandle.Alloc(sets[i]._bitVector, GCHandleType.Pinned);
+                        pointers[i] = (ulong*)handles[i].AddrOfPinnedObject();
+                    }
+
+                    fixed (ulong* thisA = &_bitVector[0])
+                    {
+                        fixed (ulong** setsA = &pointers[0])
+                        {
+                            NativeMethods.AndSetsMany(thisA, setsA, sets.Count, length);
+                        }
+                    }
+                }
+                finally
+                {
+                    for (int i = 0; i < handles.Length; ++i)
+                    {
+                        if (handles[i].IsAllocated) handles[i].Free();
+                    }
+                }
+            }
+            else
+            {
+                // Copy the first set, then And the others until nothing is left
+                ulong[] first = sets[0]._bitVector;
+                for (int i = 0; i < length; ++i)
+                {
+                    _bitVector[i] = first[i];
+                }
+
+                for (int j = 1; j < sets.Count; ++j)
+                {
+                    ulong[] other = sets[j]._bitVector;
+                    ulong any = 0;
+
+                    for (int i = 0; i < length; ++i)
+                    {
+                        _bitVector[i] &= other[i];
+                        any |= _bitVector[i];
+                    }
+
+                    if (any == 0) break;
+                }
+            }
+
+            // Clear our values above other capacity, if any, and other values above ours
             ClearAboveLength(length);
+            TrimToCapacity();
         }
         #endregion
 
@@ -410,10 +800,8 @@ namespace Arriba.Structures
             // And with this
             _scratchSet.And(this);
 
-            // Swap bitVectors with the scratchSet
-            ulong[] thisVector = _bitVector;
-            _bitVector = _scratchSet._bitVector;
-            _scratchSet._bitVector = _bitVector;
+            // Swap contents with the scratchSet
+            SwapContents(_scratchSet);
         }
 
         /// <summary>
@@ -458,10 +846,44 @@ namespace Arriba.Structures
                 throw new ArgumentNullException("values");
             }
 
-            for (int i = 0; i < length; ++i)
+            if (_bitVector == null && _sparseCount + length <= _sparseLimit)
             {
-                ushort value = values[i];
-                if (value < _capacity) this.Add(values[i]);
+                // Sort the values (which may be in any order) and merge them in, if the result is sure to stay sparse
+                _sortBuffer = Reserve(_sortBuffer, length, 0);
+
+                int count = 0;
+                for (int i = 0; i < length; ++i)
+                {
+                    ushort value = values[i];
+                    if (value < _capacity) _sortBuffer[count++] = value;
+                }
+
+                Array.Sort(_sortBuffer, 0, count);
+
+                ushort[] result = Reserve(_spareValues, _sparseCount + count, 0);
+                UseSparseValues(result, Union(_values, _sparseCount, _sortBuffer, count, result));
+                return;
+            }
+
+            if (_bitVector == null) ConvertToDense();
+
+            if (UseNativeSupport && _bitVector.Length > 0)
+            {
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    NativeMethods.SetBitsForValues(values, length, thisA, _bitVector.Length);
+                }
+
+                // Clear any values past our capacity in the last block
+                TrimToCapacity();
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    ushort value = values[i];
+                    if (value < _capacity) this.Add(values[i]);
+                }
             }
         }
 
@@ -477,10 +899,22 @@ namespace Arriba.Structures
                 throw new ArgumentNullException("values");
             }
 
+            if (_bitVector == null) ConvertToDense();
             int commonLength = Math.Min(_bitVector.Length, length);
-            for (int i = 0; i < commonLength; ++i)
+
+            if (UseNativeSupport && commonLength > 0)
+            {
+                fixed (ulong* thisA = &_bitVector[0])
+                {
+                    NativeMethods.OrSets(thisA, thisA, values, commonLength);
+                }
+            }
+            else
             {
-                _bitVector[i] |= values[i];
+                for (int i = 0; i < commonLength; ++i)
+                {
+                    _bitVector[i] |= values[i];
+                }
             }
 
             TrimToCapacity();
@@ -502,8 +936,9 @@ namespace Arriba.Structures
         {
             if (context == null) throw new ArgumentNullException("context");
 
+            // Sets are always written as bits, so the format doesn't depend on the representation
             context.Writer.Write(_capacity);
-            BinaryBlockSerializer.WriteArray(context, _bitVector);
+            BinaryBlockSerializer.WriteArray(context, ToVector());
         }
         #endregion
 
@@ -639,6 +1074,376 @@ namespace Arriba.Structures
         }
         #endregion
 
+        #region Sparse Representation
+        private void AddSparse(ushort index)
+        {
+            // Values are usually added in ascending order; otherwise, find where index goes
+            int at = _sparseCount;
+            if (at > 0 && _values[at - 1] >= index)
+            {
+                at = Array.BinarySearch(_values, 0, _sparseCount, index);
+                if (at >= 0) return;
+                at = ~at;
+            }
+
+            // Switch to bits once the array would be larger
+            if (_sparseCount >= _sparseLimit)
+            {
+                ConvertToDense();
+                _bitVector[index >> 6] |= (FirstBit >> (index & 63));
+                return;
+            }
+
+            _values = Reserve(_values, _sparseCount + 1, _sparseCount);
+            if (at < _sparseCount) Array.Copy(_values, at, _values, at + 1, _sparseCount - at);
+            _values[at] = index;
+            _sparseCount++;
+        }
+
+        private void RemoveSparse(ushort index)
+        {
+            if (_sparseCount == 0) return;
+
+            int at = Array.BinarySearch(_values, 0, _sparseCount, index);
+            if (at < 0) return;
+
+            Array.Copy(_values, at + 1, _values, at, _sparseCount - at - 1);
+            _sparseCount--;
+        }
+
+        private void ConvertToDense()
+        {
+            // Reuse the last bit vector, if there is one
+            ulong[] vector = _spareBitVector;
+            if (vector == null)
+            {
+                vector = new ulong[_vectorLength];
+            }
+            else
+            {
+                Array.Clear(vector, 0, vector.Length);
+            }
+
+            SetBits(vector, _values, _sparseCount);
+
+            _spareBitVector = null;
+            _bitVector = vector;
+            _sparseCount = 0;
+        }
+
+        private void ClearToSparse()
+        {
+            if (_bitVector != null)
+            {
+                _spareBitVector = _bitVector;
+                _bitVector = null;
+            }
+
+            _sparseCount = 0;
+        }
+
+        // Make result (a buffer from Reserve(_spareValues)) the set values, keeping the current array as the spare
+        private void UseSparseValues(ushort[] result, int count)
+        {
+            ClearToSparse();
+
+            _spareValues = _values;
+            _values = result;
+            _sparseCount = count;
+
+            // Results from larger sets may have more values than our limit
+            if (_sparseCount > _sparseLimit) ConvertToDense();
+        }
+
+        private void SwapContents(ShortSet other)
+        {
+            ulong[] bitVector = _bitVector;
+            _bitVector = other._bitVector;
+            other._bitVector = bitVector;
+
+            ulong[] spareBitVector = _spareBitVector;
+            _spareBitVector = other._spareBitVector;
+            other._spareBitVector = spareBitVector;
+
+            ushort[] values = _values;
+            _values = other._values;
+            other._values = values;
+
+            ushort[] spareValues = _spareValues;
+            _spareValues = other._spareValues;
+            other._spareValues = spareValues;
+
+            int sparseCount = _sparseCount;
+            _sparseCount = other._sparseCount;
+            other._sparseCount = sparseCount;
+        }
+
+        // Return the bits for this set; sparse sets build a new vector
+        private ulong[] ToVector()
+        {
+            if (_bitVector != null) return _bitVector;
+
+            ulong[] vector = new ulong[_vectorLength];
+            SetBits(vector, _values, _sparseCount);
+            return vector;
+        }
+
+        // Return array if there's room for length values (and SimdSlack), or a larger array with the first keepCount values copied
+        private ushort[] Reserve(ushort[] array, int length, int keepCount)
+        {
+            if (array != null && array.Length >= length + SimdSlack) return array;
+
+            // Grow by doubling, up to the sparse limit
+            int newLength = (array == null ? 0 : Math.Min(2 * array.Length, _sparseLimit));
+            if (newLength < length) newLength = length;
+
+            ushort[] larger = new ushort[newLength + SimdSlack];
+            if (keepCount > 0) Array.Copy(array, larger, keepCount);
+            return larger;
+        }
+
+        private static void SetBits(ulong[] vector, ushort[] values, int count)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                ushort value = values[i];
+                vector[value >> 6] |= (FirstBit >> (value & 63));
+            }
+        }
+
+        // Return the number of the (sorted) values below limit
+        private static int CountBelow(ushort[] values, int count, ushort limit)
+        {
+            if (count == 0 || values[count - 1] < limit) return count;
+
+            int at = Array.BinarySearch(values, 0, count, limit);
+            return (at < 0 ? ~at : at);
+        }
+
+        private void FromAndSparse(ShortSet left, ShortSet right)
+        {
+            // Start from the sparse set (the smaller, if both are)
+            ShortSet sparse = left;
+            ShortSet other = right;
+            if (left._bitVector != null || (right._bitVector == null && right._sparseCount < left._sparseCount))
+            {
+                sparse = right;
+                other = left;
+            }
+
+            // Write to the spare buffer, which is safe even if this is left or right
+            ushort[] result = Reserve(_spareValues, sparse._sparseCount, 0);
+
+            int count;
+            if (other._bitVector == null)
+            {
+                count = Intersect(sparse._values, sparse._sparseCount, other._values, other._sparseCount, result);
+            }
+            else
+            {
+                count = IntersectWithSet(sparse._values, sparse._sparseCount, other._bitVector, result);
+            }
+
+            UseSparseValues(result, CountBelow(result, count, _capacity));
+        }
+
+        private void FromAndSparse(IList<ShortSet> sets, int sparsest)
+        {
+            // If this set is one of the sets, its values are already in the result. Otherwise, start from the sparsest set.
+            if (sets.Contains(this))
+            {
+                this.And(sets[sparsest]);
+            }
+            else
+            {
+                this.From(sets[sparsest]);
+            }
+
+            // And the others in until nothing is left
+            for (int i = 0; i < sets.Count && !this.IsEmpty(); ++i)
+            {
+                if (i != sparsest && sets[i] != this) this.And(sets[i]);
+            }
+        }
+
+        // Sparse set kernels: each takes sorted, unique values and writes the result values to result, if not null,
+        // returning the result count. result must not be left or right, except where noted.
+
+        private static unsafe int Intersect(ushort[] left, int leftCount, ushort[] right, int rightCount, ushort[] result)
+        {
+            if (leftCount == 0 || rightCount == 0) return 0;
+
+            if (UseNativeSupport)
+            {
+                // SSE4.2 block compare for similar lengths, galloping search for very different lengths
+                fixed (ushort* leftA = &left[0])
+                {
+                    fixed (ushort* rightA = &right[0])
+                    {
+                        fixed (ushort* resultA = result)
+                        {
+                            return NativeMethods.IntersectSorted(leftA, leftCount, rightA, rightCount, resultA);
+                        }
+                    }
+                }
+            }
+
+            int count = 0;
+            int i = 0;
+            int j = 0;
+            while (i < leftCount && j < rightCount)
+            {
+                ushort l = left[i];
+                ushort r = right[j];
+
+                // Advance past the smaller value (or both), avoiding an unpredictable branch
+                if (l == r)
+                {
+                    if (result != null) result[count] = l;
+                    ++count;
+                }
+
+                i += (l <= r ? 1 : 0);
+                j += (r <= l ? 1 : 0);
+            }
+
+            return count;
+        }
+
+        // Union also removes duplicates within left or right, so the values to add needn't be unique
+        private static unsafe int Union(ushort[] left, int leftCount, ushort[] right, int rightCount, ushort[] result)
+        {
+            if (UseNativeSupport && leftCount > 0 && rightCount > 0)
+            {
+                fixed (ushort* leftA = &left[0])
+                {
+                    fixed (ushort* rightA = &right[0])
+                    {
+                        fixed (ushort* resultA = &result[0])
+                        {
+                            return NativeMethods.UnionSorted(leftA, leftCount, rightA, rightCount, resultA);
+                        }
+                    }
+                }
+            }
+
+            int count = 0;
+            int i = 0;
+            int j = 0;
+            while (i < leftCount || j < rightCount)
+            {
+                ushort next;
+                if (j == rightCount || (i < leftCount && left[i] <= right[j]))
+                {
+                    next = left[i++];
+                }
+                else
+                {
+                    next = right[j++];
+                }
+
+                if (count == 0 || result[count - 1] != next) result[count++] = next;
+            }
+
+            return count;
+        }
+
+        private static int Except(ushort[] left, int leftCount, ushort[] right, int rightCount, ushort[] result)
+        {
+            int count = 0;
+            int i = 0;
+            int j = 0;
+            while (i < leftCount)
+            {
+                if (j == rightCount || left[i] < right[j])
+                {
+                    result[count++] = left[i++];
+                }
+                else if (left[i] == right[j])
+                {
+                    ++i;
+                    ++j;
+                }
+                else
+                {
+                    ++j;
+                }
+            }
+
+            return count;
+        }
+
+        // Keep the values with bits set in vector. result may be values.
+        private static unsafe int IntersectWithSet(ushort[] values, int count, ulong[] vector, ushort[] result)
+        {
+            if (count == 0) return 0;
+
+            if (UseNativeSupport && vector.Length > 0)
+            {
+                fixed (ushort* valuesA = &values[0])
+                {
+                    fixed (ulong* vectorA = &vector[0])
+                    {
+                        fixed (ushort* resultA = result)
+                        {
+                            return NativeMethods.IntersectSortedWithSet(valuesA, count, vectorA, vector.Length, resultA);
+                        }
+                    }
+                }
+            }
+
+            int end = vector.Length * 64;
+            int found = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                ushort value = values[i];
+                if (value >= end) break;
+
+                if ((vector[value >> 6] & (FirstBit >> (value & 63))) != 0UL)
+                {
+                    if (result != null) result[found] = value;
+                    ++found;
+                }
+            }
+
+            return found;
+        }
+
+        // Keep the values without bits set in vector. result may be values.
+        private static unsafe int AndNotWithSet(ushort[] values, int count, ulong[] vector, ushort[] result)
+        {
+            if (count == 0) return 0;
+
+            if (UseNativeSupport && vector.Length > 0)
+            {
+                fixed (ushort* valuesA = &values[0])
+                {
+                    fixed (ulong* vectorA = &vector[0])
+                    {
+                        fixed (ushort* resultA = result)
+                        {
+                            return NativeMethods.AndNotSortedWithSet(valuesA, count, vectorA, vector.Length, resultA);
+                        }
+                    }
+                }
+            }
+
+            int end = vector.Length * 64;
+            int found = 0;
+            for (int i = 0; i < count; ++i)
+            {
+                ushort value = values[i];
+                if (value >= end || (vector[value >> 6] & (FirstBit >> (value & 63))) == 0UL)
+                {
+                    if (result != null) result[found] = value;
+                    ++found;
+                }
+            }
+
+            return found;
+        }
+        #endregion
+
         #region Arriba.Native Imports
         private class NativeMethods
         {
@@ -650,6 +1455,39 @@ namespace Arriba.Structures
 
             [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
             public unsafe static extern void AndSets(ulong* result, ulong* left, ulong* right, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void OrSets(ulong* result, ulong* left, ulong* right, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void AndNotSets(ulong* result, ulong* left, ulong* right, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void OrNotSets(ulong* result, ulong* left, ulong* right, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void NotSet(ulong* result, ulong* values, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int AndCount(ulong* left, ulong* right, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void AndSetsMany(ulong* result, ulong** sets, int setCount, int length);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int IntersectSorted(ushort* left, int leftLength, ushort* right, int rightLength, ushort* result);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int UnionSorted(ushort* left, int leftLength, ushort* right, int rightLength, ushort* result);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int IntersectSortedWithSet(ushort* values, int length, ulong* set, int setLength, ushort* result);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int AndNotSortedWithSet(ushort* values, int length, ulong* set, int setLength, ushort* result);
+
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern void SetBitsForValues(ushort* values, int length, ulong* set, int setLength);
         }
         #endregion
     }
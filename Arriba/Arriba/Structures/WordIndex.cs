@@ -3,6 +3,8 @@
 
 using System;
 using System.Collections.Generic;
+using System.Runtime.InteropServices;
+using System.Security;
 
 using Arriba.Extensions;
 using Arriba.Indexing;
@@ -19,6 +21,12 @@ namespace Arriba.Structures
     {
         public const int MinimumPrefixExpandLength = 3;
 
+        // Words per IntersectPostingLists call [Arriba.Native PostingTermLimit]
+        private const int NativeTermLimit = 64;
+
+        // Matches IntersectPostingLists keeps as a sorted array before switching to bits
+        private const int NativeCandidateLimit = 2048;
+
         private IWordSplitter _splitter;
         private List<WordIndexBlock> _blocks;
 
@@ -72,6 +80,11 @@ namespace Arriba.Structures
                     block.WhereMatches(prefix, result);
                 }
             }
+            else if (ShortSet.UseNativeSupport && prefixWords.Count <= NativeTermLimit)
+            {
+                // Intersect the sets for every word in one native call
+                WhereMatchesAllNative(prefix, prefixWords, result);
+            }
             else
             {
                 // We need to add (OR) the items which match all words (AND) in the split prefix
@@ -108,6 +121,88 @@ namespace Arriba.Structures
                 if (matchesForAllWords != null) result.Or(matchesForAllWords);
             }
         }
+
+        /// <summary>
+        ///  Add the items which match all of the words in the split prefix
+        ///  to the result set passed, intersecting the sets for each word
+        ///  (the union of the sets for words it's a prefix of) rarest first
+        ///  in Arriba.Native.
+        /// </summary>
+        private unsafe void WhereMatchesAllNative(ByteBlock prefix, RangeSet prefixWords, ShortSet result)
+        {
+            int bitsLength = (result.Capacity + 63) / 64;
+            if (bitsLength == 0 || prefixWords.Count == 0) return;
+
+            // Find the sets for the words matching each word in the prefix
+            List<ByteBlock> sets = new List<ByteBlock>();
+            int[] termStarts = new int[prefixWords.Count + 1];
+
+            for (int i = 0; i < prefixWords.Count; ++i)
+            {
+                Range word = prefixWords.Ranges[i];
+                ByteBlock wordBlock = new ByteBlock(prefix.Array, word.Index, word.Length);
+
+                termStarts[i] = sets.Count;
+                foreach (WordIndexBlock block in _blocks)
+                {
+                    block.AddSetsMatching(wordBlock, sets);
+                }
+            }
+
+            termStarts[prefixWords.Count] = sets.Count;
+
+            PostingList[] lists = new PostingList[Math.Max(1, sets.Count)];
+            GCHandle[] handles = new GCHandle[sets.Count];
+            ushort[] values = new ushort[3 * (NativeCandidateLimit + 8)];
+            ulong[] bits = new ulong[bitsLength];
+            ulong[] scratch = new ulong[bitsLength];
+
+            try
+            {
+                // Pin every set for the duration of the call
+                for (int i = 0; i < sets.Count; ++i)
+                {
+                    handles[i] = GCHandle.Alloc(sets[i].Array, GCHandleType.Pinned);
+                    lists[i] = WordIndexBlock.ToPostingList((byte*)handles[i].AddrOfPinnedObject() + sets[i].Index, sets[i].Length);
+                }
+
+                fixed (PostingList* listsA = &lists[0])
+                {
+                    fixed (int* termStartsA = &termStarts[0])
+                    {
+                        fixed (ushort* valuesA = &values[0])
+                        {
+                            fixed (ulong* bitsA = &bits[0])
+                            {
+                                fixed (ulong* scratchA = &scratch[0])
+                                {
+                                    int resultIsBits;
+                                    int count = NativeMethods.IntersectPostingLists(listsA, termStartsA, prefixWords.Count, valuesA, values.Length, bitsA, scratchA, bitsLength, &resultIsBits);
+                                    if (count == 0) return;
+
+                                    // Few matches come back as sorted values, which keep a sparse result sparse
+                                    if (resultIsBits != 0)
+                                    {
+                                        result.Or(bitsA, (ushort)bitsLength);
+                                    }
+                                    else
+                                    {
+                                        result.Or(valuesA, (ushort)count);
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+            finally
+            {
+                for (int i = 0; i < handles.Length; ++i)
+                {
+                    if (handles[i].IsAllocated) handles[i].Free();
+                }
+            }
+        }
         #endregion
 
         #region Add/Remove
@@ -317,6 +412,45 @@ namespace Arriba.Structures
                 }
             }
 
+            /// <summary>
+            ///  Add the sets for all words starting with the provided prefix
+            ///  (or equal to it, below the prefix length minimum) to a list.
+            /// </summary>
+            /// <param name="prefix">Prefix for which to find sets</param>
+            /// <param name="sets">List to add the non-empty sets to</param>
+            public void AddSetsMatching(ByteBlock prefix, List<ByteBlock> sets)
+            {
+                if (prefix.Length < MinimumPrefixExpandLength)
+                {
+                    ushort index;
+                    _words.TryGetIndexOf(prefix, out index);
+                    if (index != ushort.MaxValue) AddSet(index, sets);
+                    return;
+                }
+
+                IComparable<ByteBlock> isPrefixOf = prefix.GetExtendedIComparable(ByteBlock.Comparison.IsPrefixOf);
+
+                int firstIndex = _words.FindFirstWhere(isPrefixOf);
+                if (firstIndex < 0) return;
+
+                int lastIndex = _words.FindLastWhere(isPrefixOf);
+
+                IList<ushort> sortedIndexes;
+                int sortedIndexescount;
+                _words.TryGetSortedIndexes(out sortedIndexes, out sortedIndexescount);
+
+                for (int i = firstIndex; i <= lastIndex; ++i)
+                {
+                    AddSet(sortedIndexes[i], sets);
+                }
+            }
+
+            private void AddSet(ushort setId, List<ByteBlock> sets)
+            {
+                ByteBlock set = _sets[setId];
+                if (set.Length > 0) sets.Add(set);
+            }
+
             /// <summary>
             ///  Add matches to the given set for all items with the exact value passed.
             /// </summary>
@@ -506,6 +640,30 @@ namespace Arriba.Structures
                 }
             }
 
+            /// <summary>
+            ///  Describe a set (pinned at 'set') for IntersectPostingLists.
+            /// </summary>
+            /// <param name="set">Pointer to the set bytes</param>
+            /// <param name="length">Length of the set in bytes</param>
+            /// <returns>PostingList with the used values for sparse sets or the bits for dense sets</returns>
+            public static unsafe PostingList ToPostingList(byte* set, int length)
+            {
+                PostingList list = new PostingList();
+
+                if (length < DenseSetLengthCutoff)
+                {
+                    list.Values = (ushort*)set;
+                    list.Length = FindUsedLength(list.Values, (ushort)(length / 2));
+                }
+                else
+                {
+                    list.Bits = (ulong*)set;
+                    list.Length = length / 8;
+                }
+
+                return list;
+            }
+
             /// <summary>
             ///  Find the used portion of a given sparse set. Sets are MaxValue
             ///  padded, so the used portion is the number of non-MaxValue values.
@@ -513,7 +671,7 @@ namespace Arriba.Structures
             /// <param name="set">Set array to search</param>
             /// <param name="totalSpace">Length of full array</param>
             /// <returns>Number of items set, totalSpace if all of them</returns>
-            private unsafe ushort FindUsedLength(ushort* set, ushort totalSpace)
+            private static unsafe ushort FindUsedLength(ushort* set, ushort totalSpace)
             {
                 // If the last value is set, there is no free space
                 if (set == null || totalSpace == 0 || set[totalSpace - 1] != ushort.MaxValue) return totalSpace;
@@ -626,5 +784,22 @@ namespace Arriba.Structures
             #endregion
         }
         #endregion
+
+        #region Arriba.Native Imports
+        // WARNING: Layout must match PostingList in Arriba.Native PostingLists.cpp
+        [StructLayout(LayoutKind.Sequential)]
+        internal unsafe struct PostingList
+        {
+            public ushort* Values;
+            public ulong* Bits;
+            public int Length;
+        }
+
+        private class NativeMethods
+        {
+            [DllImport("Arriba.Native.dll", PreserveSig = true, CallingConvention = CallingConvention.Cdecl), SuppressUnmanagedCodeSecurity]
+            public unsafe static extern int IntersectPostingLists(PostingList* lists, int* termStarts, int termCount, ushort* values, int valuesLength, ulong* bits, ulong* scratch, int bitsLength, int* resultIsBits);
+        }
+        #endregion
     }
 }
@@ -27,12 +27,29 @@ namespace XForm.Types.Comparers
     {
         internal static ComparerExtensions.WhereSingle<long> s_WhereSingleNative = null;
         internal static ComparerExtensions.Where<long> s_WhereNative = null;
+        internal static ComparerExtensions.Hash s_GetHashCodesNative = null;
+        internal static ComparerExtensions.HashIndices s_GetHashCodesIndicesNative = null;
 
         public void GetHashCodes(XArray xarray, int[] hashes)
         {
             if (hashes.Length < xarray.Count) throw new ArgumentOutOfRangeException(""hashes.Length"");
             long[] array = (long[])xarray.Array;
 
+            // Hash natively (in bulk) when there are no nulls to skip
+            if (s_GetHashCodesNative != null && !xarray.HasNulls && !xarray.Selector.IsSingleValue)
+            {
+                if (xarray.Selector.Indices == null)
+                {
+                    s_GetHashCodesNative(array, xarray.Selector.StartIndexInclusive, xarray.Count, true, hashes);
+                }
+                else
+                {
+                    s_GetHashCodesIndicesNative(array, xarray.Selector.Indices, xarray.Selector.StartIndexInclusive, xarray.Count, true, hashes);
+                }
+
+                return;
+            }
+
             for (int i = 0; i < xarray.Count; ++i)
             {
                 int index = xarray.Index(i);
@@ -154,6 +171,12 @@ namespace XForm.Types.Comparers
                     .Replace("long", typeName)
                     .Replace("LongComparer", className);
 
+                // Only primitive arrays have a native (HashN) hash; DateTime, TimeSpan and T hash each value in managed code
+                if (Array.IndexOf(SupportedTypes.PrimitiveTypes, typeName) == -1)
+                {
+                    prefix = RemoveNativeHash(prefix);
+                }
+
                 // Differences for ComparableComparer
                 if (typeName == "T")
                 {
@@ -191,6 +214,15 @@ namespace XForm.Types.Comparers
             }
         }
 
+        private static string RemoveNativeHash(string prefix)
+        {
+            int blockStart = prefix.IndexOf("            // Hash natively (in bulk)");
+            int blockEnd = prefix.IndexOf("            for (int i = 0;", blockStart);
+
+            prefix = prefix.Remove(blockStart, blockEnd - blockStart);
+            return Regex.Replace(prefix, @"^ *internal static ComparerExtensions\.Hash\w* s_GetHashCodes\w*Native = null;\r?\n", "", RegexOptions.Multiline);
+        }
+
         private static void WriteMethod(StreamWriter writer, string typeName, string operatorName, string operatorCode)
         {
             string methodBody;
@@ -4,11 +4,38 @@
 #include "stdafx.h"
 #include <intrin.h>
 #include <nmmintrin.h>
+#include <string.h>
 #include "BitVectorN.h"
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
+
+using namespace System::Runtime::InteropServices;
 
 #pragma unmanaged
+// AVX-512 VPOPCNTDQ: count eight words per instruction, with a masked load for the remainder
+static int CountAvx512N(unsigned __int64* matchVector, int length)
+{
+	__m512i total = _mm512_setzero_si512();
+
+	int i = 0;
+	for (; i + 8 <= length; i += 8)
+	{
+		total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_loadu_si512((__m512i*)(&matchVector[i]))));
+	}
+
+	if (i < length)
+	{
+		__mmask8 valid = (__mmask8)((1U << (length - i)) - 1);
+		total = _mm512_add_epi64(total, _mm512_popcnt_epi64(_mm512_maskz_loadu_epi64(valid, &matchVector[i])));
+	}
+
+	return (int)_mm512_reduce_add_epi64(total);
+}
+
 int CountN(unsigned __int64* matchVector, int length)
 {
+	if (SupportedN.Avx512Vpopcntdq) return CountAvx512N(matchVector, length);
+
 	__int64 count = 0;
 
 	int i = 0;
@@ -36,15 +63,95 @@ unsigned int __inline ctz(unsigned __int64 value)
 	return trailingZero;
 }
 
+// For each byte value, the indices of the set bits in that byte, packed one per byte from the lowest
+static const unsigned __int64 BitIndicesByByte[256] =
+{
+	0x0ULL, 0x0ULL, 0x1ULL, 0x100ULL, 0x2ULL, 0x200ULL, 0x201ULL, 0x20100ULL,
+	0x3ULL, 0x300ULL, 0x301ULL, 0x30100ULL, 0x302ULL, 0x30200ULL, 0x30201ULL, 0x3020100ULL,
+	0x4ULL, 0x400ULL, 0x401ULL, 0x40100ULL, 0x402ULL, 0x40200ULL, 0x40201ULL, 0x4020100ULL,
+	0x403ULL, 0x40300ULL, 0x40301ULL, 0x4030100ULL, 0x40302ULL, 0x4030200ULL, 0x4030201ULL, 0x403020100ULL,
+	0x5ULL, 0x500ULL, 0x501ULL, 0x50100ULL, 0x502ULL, 0x50200ULL, 0x50201ULL, 0x5020100ULL,
+	0x503ULL, 0x50300ULL, 0x50301ULL, 0x5030100ULL, 0x50302ULL, 0x5030200ULL, 0x5030201ULL, 0x503020100ULL,
+	0x504ULL, 0x50400ULL, 0x50401ULL, 0x5040100ULL, 0x50402ULL, 0x5040200ULL, 0x5040201ULL, 0x504020100ULL,
+	0x50403ULL, 0x5040300ULL, 0x5040301ULL, 0x504030100ULL, 0x5040302ULL, 0x504030200ULL, 0x504030201ULL, 0x50403020100ULL,
+	0x6ULL, 0x600ULL, 0x601ULL, 0x60100ULL, 0x602ULL, 0x60200ULL, 0x60201ULL, 0x6020100ULL,
+	0x603ULL, 0x60300ULL, 0x60301ULL, 0x6030100ULL, 0x60302ULL, 0x6030200ULL, 0x6030201ULL, 0x603020100ULL,
+	0x604ULL, 0x60400ULL, 0x60401ULL, 0x6040100ULL, 0x60402ULL, 0x6040200ULL, 0x6040201ULL, 0x604020100ULL,
+	0x60403ULL, 0x6040300ULL, 0x6040301ULL, 0x604030100ULL, 0x6040302ULL, 0x604030200ULL, 0x604030201ULL, 0x60403020100ULL,
+	0x605ULL, 0x60500ULL, 0x60501ULL, 0x6050100ULL, 0x60502ULL, 0x6050200ULL, 0x6050201ULL, 0x605020100ULL,
+	0x60503ULL, 0x6050300ULL, 0x6050301ULL, 0x605030100ULL, 0x6050302ULL, 0x605030200ULL, 0x605030201ULL, 0x60503020100ULL,
+	0x60504ULL, 0x6050400ULL, 0x6050401ULL, 0x605040100ULL, 0x6050402ULL, 0x605040200ULL, 0x605040201ULL, 0x60504020100ULL,
+	0x6050403ULL, 0x605040300ULL, 0x605040301ULL, 0x60504030100ULL, 0x605040302ULL, 0x60504030200ULL, 0x60504030201ULL, 0x6050403020100ULL,
+	0x7ULL, 0x700ULL, 0x701ULL, 0x70100ULL, 0x702ULL, 0x70200ULL, 0x70201ULL, 0x7020100ULL,
+	0x703ULL, 0x70300ULL, 0x70301ULL, 0x7030100ULL, 0x70302ULL, 0x7030200ULL, 0x7030201ULL, 0x703020100ULL,
+	0x704ULL, 0x70400ULL, 0x70401ULL, 0x7040100ULL, 0x70402ULL, 0x7040200ULL, 0x7040201ULL, 0x704020100ULL,
+	0x70403ULL, 0x7040300ULL, 0x7040301ULL, 0x704030100ULL, 0x7040302ULL, 0x704030200ULL, 0x704030201ULL, 0x70403020100ULL,
+	0x705ULL, 0x70500ULL, 0x70501ULL, 0x7050100ULL, 0x70502ULL, 0x7050200ULL, 0x7050201ULL, 0x705020100ULL,
+	0x70503ULL, 0x7050300ULL, 0x7050301ULL, 0x705030100ULL, 0x7050302ULL, 0x705030200ULL, 0x705030201ULL, 0x70503020100ULL,
+	0x70504ULL, 0x7050400ULL, 0x7050401ULL, 0x705040100ULL, 0x7050402ULL, 0x705040200ULL, 0x705040201ULL, 0x70504020100ULL,
+	0x7050403ULL, 0x705040300ULL, 0x705040301ULL, 0x70504030100ULL, 0x705040302ULL, 0x70504030200ULL, 0x70504030201ULL, 0x7050403020100ULL,
+	0x706ULL, 0x70600ULL, 0x70601ULL, 0x7060100ULL, 0x70602ULL, 0x7060200ULL, 0x7060201ULL, 0x706020100ULL,
+	0x70603ULL, 0x7060300ULL, 0x7060301ULL, 0x706030100ULL, 0x7060302ULL, 0x706030200ULL, 0x706030201ULL, 0x70603020100ULL,
+	0x70604ULL, 0x7060400ULL, 0x7060401ULL, 0x706040100ULL, 0x7060402ULL, 0x706040200ULL, 0x706040201ULL, 0x70604020100ULL,
+	0x7060403ULL, 0x706040300ULL, 0x706040301ULL, 0x70604030100ULL, 0x706040302ULL, 0x70604030200ULL, 0x70604030201ULL, 0x7060403020100ULL,
+	0x70605ULL, 0x7060500ULL, 0x7060501ULL, 0x706050100ULL, 0x7060502ULL, 0x706050200ULL, 0x706050201ULL, 0x70605020100ULL,
+	0x7060503ULL, 0x706050300ULL, 0x706050301ULL, 0x70605030100ULL, 0x706050302ULL, 0x70605030200ULL, 0x70605030201ULL, 0x7060503020100ULL,
+	0x7060504ULL, 0x706050400ULL, 0x706050401ULL, 0x70605040100ULL, 0x706050402ULL, 0x70605040200ULL, 0x70605040201ULL, 0x7060504020100ULL,
+	0x706050403ULL, 0x70605040300ULL, 0x70605040301ULL, 0x7060504030100ULL, 0x70605040302ULL, 0x7060504030200ULL, 0x7060504030201ULL, 0x706050403020100ULL
+};
+
+// Blocks with at least this many matches are paged with the lookup table rather than bit by bit
+const int DenseBlockMatchCount = 8;
+
+// Write 64 consecutive indices starting at base
+static __inline void PageAllN(int base, int* result)
+{
+	__m256i indices = _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	__m256i eight = _mm256_set1_epi32(8);
+
+	for (int i = 0; i < 64; i += 8)
+	{
+		_mm256_storeu_si256((__m256i*)(&result[i]), indices);
+		indices = _mm256_add_epi32(indices, eight);
+	}
+}
+
+// Write the indices of every set bit in block, eight bits at a time. Writes up to 64 values (beyond the count returned).
+static __inline int PageBlockN(unsigned __int64 block, int base, int* result)
+{
+	int* resultNext = result;
+
+	for (int i = 0; i < 64; i += 8)
+	{
+		unsigned int bits = (unsigned int)(block >> i) & 0xFF;
+
+		// Widen the packed indices for this byte to ints, offset them to the byte position, and store all eight
+		__m256i indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(&BitIndicesByByte[bits])));
+		_mm256_storeu_si256((__m256i*)resultNext, _mm256_add_epi32(indices, _mm256_set1_epi32(base + i)));
+
+		// Only keep as many as were set
+		resultNext += _mm_popcnt_u32(bits);
+	}
+
+	return (int)(resultNext - result);
+}
+
 int PageN(unsigned __int64* matchVector, int length, int* start, int* result, int resultLength)
 {
 	// Get pointers to the next index and the end of the array
 	int* resultNext = result;
 	int* resultEnd = result + resultLength;
 
+	// If the last page ended on the last bit, there's nothing left to scan
+	int end = length << 6;
+	if (*start >= end)
+	{
+		*start = -1;
+		return 0;
+	}
+
 	// Separate the block and bit to start on
 	int base = *start & ~63;
-	int end = length << 6;
 	int matchWithinBlock = *start & 63;
 
 	// Get the first block
@@ -56,6 +163,29 @@ int PageN(unsigned __int64* matchVector, int length, int* start, int* result, in
 	// Look for matches in each block
 	while (resultNext < resultEnd)
 	{
+		if (resultEnd - resultNext >= 64 && _mm_popcnt_u64(block) >= DenseBlockMatchCount)
+		{
+			// If the block is dense and there's room for a whole block of results, write them without walking each bit
+			if (block == ~0x0ULL)
+			{
+				// Every row matched; write the run of consecutive indices
+				PageAllN(base, resultNext);
+				resultNext += 64;
+				matchWithinBlock = 63;
+			}
+			else
+			{
+				// Write the indices of a mixed block from a per-byte lookup table
+				resultNext += PageBlockN(block, base, resultNext);
+
+				unsigned long lastMatch = 0;
+				_BitScanReverse64(&lastMatch, block);
+				matchWithinBlock = lastMatch;
+			}
+
+			block = 0;
+		}
+
 		while (block != 0 && resultNext != resultEnd)
 		{
 			// The index of the next match is the same as the number of trailing zero bits
@@ -75,6 +205,17 @@ int PageN(unsigned __int64* matchVector, int length, int* start, int* result, in
 		base += 64;
 		if (base >= end) break;
 		block = matchVector[base >> 6];
+
+		// If this block is empty, skip over any following runs of four empty blocks
+		if (block == 0)
+		{
+			while (base + 320 <= end)
+			{
+				__m256i nextBlocks = _mm256_loadu_si256((__m256i*)(&matchVector[(base >> 6) + 1]));
+				if (!_mm256_testz_si256(nextBlocks, nextBlocks)) break;
+				base += 256;
+			}
+		}
 	}
 
 	// Set start to -1 if we finished scanning, or the next start index otherwise
@@ -83,6 +224,321 @@ int PageN(unsigned __int64* matchVector, int length, int* start, int* result, in
 	// Return the match count found
 	return (int)(resultNext - result);
 }
+
+// Copy the values for the set bits of one 64-row block to result, eight rows at a time. Reads all 64 values and may write up to 64 (beyond the count returned).
+static __inline int CompactBlockN(unsigned __int64 block, unsigned __int8* values, unsigned __int8* result)
+{
+	unsigned __int8* resultNext = result;
+	bool fastPext = SupportedN.FastPext;
+
+	for (int i = 0; i < 64; i += 8)
+	{
+		unsigned int bits = (unsigned int)(block >> i) & 0xFF;
+		unsigned __int64 eight = *(unsigned __int64*)(&values[i]);
+
+		// Pack the selected bytes down with pext where it's fast, or with a pshufb of the per-byte index table
+		unsigned __int64 packed;
+		if (fastPext)
+		{
+			packed = _pext_u64(eight, _pdep_u64(bits, 0x0101010101010101ULL) * 0xFF);
+		}
+		else
+		{
+			packed = _mm_cvtsi128_si64(_mm_shuffle_epi8(_mm_cvtsi64_si128(eight), _mm_cvtsi64_si128(BitIndicesByByte[bits])));
+		}
+
+		*(unsigned __int64*)resultNext = packed;
+		resultNext += _mm_popcnt_u32(bits);
+	}
+
+	return (int)(resultNext - result);
+}
+
+static __inline int CompactBlockN(unsigned __int64 block, unsigned __int16* values, unsigned __int16* result)
+{
+	unsigned __int16* resultNext = result;
+
+	for (int i = 0; i < 64; i += 8)
+	{
+		unsigned int bits = (unsigned int)(block >> i) & 0xFF;
+
+		// Build a pshufb control selecting bytes (2n, 2n + 1) for each value index n from the per-byte index table
+		__m128i indices = _mm_cvtepu8_epi16(_mm_cvtsi64_si128(BitIndicesByByte[bits]));
+		__m128i control = _mm_add_epi16(_mm_mullo_epi16(indices, _mm_set1_epi16(0x0202)), _mm_set1_epi16(0x0100));
+		_mm_storeu_si128((__m128i*)resultNext, _mm_shuffle_epi8(_mm_loadu_si128((__m128i*)(&values[i])), control));
+
+		resultNext += _mm_popcnt_u32(bits);
+	}
+
+	return (int)(resultNext - result);
+}
+
+static __inline int CompactBlockN(unsigned __int64 block, unsigned __int32* values, unsigned __int32* result)
+{
+	unsigned __int32* resultNext = result;
+
+	if (SupportedN.Avx512F)
+	{
+		for (int i = 0; i < 64; i += 16)
+		{
+			__mmask16 mask = (__mmask16)(block >> i);
+			_mm512_mask_compressstoreu_epi32(resultNext, mask, _mm512_maskz_loadu_epi32(mask, &values[i]));
+			resultNext += _mm_popcnt_u32(mask);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 64; i += 8)
+		{
+			unsigned int bits = (unsigned int)(block >> i) & 0xFF;
+			__m256i indices = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128(BitIndicesByByte[bits]));
+			_mm256_storeu_si256((__m256i*)resultNext, _mm256_permutevar8x32_epi32(_mm256_loadu_si256((__m256i*)(&values[i])), indices));
+			resultNext += _mm_popcnt_u32(bits);
+		}
+	}
+
+	return (int)(resultNext - result);
+}
+
+static __inline int CompactBlockN(unsigned __int64 block, unsigned __int64* values, unsigned __int64* result)
+{
+	unsigned __int64* resultNext = result;
+
+	if (SupportedN.Avx512F)
+	{
+		for (int i = 0; i < 64; i += 8)
+		{
+			__mmask8 mask = (__mmask8)(block >> i);
+			_mm512_mask_compressstoreu_epi64(resultNext, mask, _mm512_maskz_loadu_epi64(mask, &values[i]));
+			resultNext += _mm_popcnt_u32(mask);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < 64; i += 4)
+		{
+			unsigned int bits = (unsigned int)(block >> i) & 0xF;
+
+			// Permute 32-bit halves: value index n selects lanes (2n, 2n + 1)
+			__m256i indices = _mm256_slli_epi64(_mm256_cvtepu8_epi64(_mm_cvtsi32_si128((int)BitIndicesByByte[bits])), 1);
+			__m256i control = _mm256_or_si256(indices, _mm256_slli_epi64(_mm256_add_epi64(indices, _mm256_set1_epi64x(1)), 32));
+			_mm256_storeu_si256((__m256i*)resultNext, _mm256_permutevar8x32_epi32(_mm256_loadu_si256((__m256i*)(&values[i])), control));
+			resultNext += _mm_popcnt_u32(bits);
+		}
+	}
+
+	return (int)(resultNext - result);
+}
+
+// Copy values[i] for each set bit i in [*start, end) to result, in order, until resultLength values are written.
+// Like PageN, but writes the selected values instead of their indices, so callers don't need the index array.
+// Sets *start to the next index to resume from, or -1 if the vector was fully scanned.
+template<typename T>
+static int CompactN(T* values, unsigned __int64* matchVector, int end, int* start, T* result, int resultLength)
+{
+	T* resultNext = result;
+	T* resultEnd = result + resultLength;
+
+	if (*start >= end)
+	{
+		*start = -1;
+		return 0;
+	}
+
+	int base = *start & ~63;
+	int matchWithinBlock = *start & 63;
+
+	// Get the first block, ignoring bits already checked and bits past the values
+	unsigned __int64 block = matchVector[base >> 6];
+	if (matchWithinBlock > 0) block &= (~0x0ULL << matchWithinBlock);
+	if (end - base < 64) block &= (~0x0ULL >> (64 - (end - base)));
+
+	while (resultNext < resultEnd)
+	{
+		// Copy dense blocks wholly within the values, if there's room for a whole block of results, without walking each bit
+		if (base + 64 <= end && resultEnd - resultNext >= 64 && _mm_popcnt_u64(block) >= DenseBlockMatchCount)
+		{
+			if (block == ~0x0ULL)
+			{
+				memcpy(resultNext, &values[base], 64 * sizeof(T));
+				resultNext += 64;
+				matchWithinBlock = 63;
+			}
+			else
+			{
+				resultNext += CompactBlockN(block, &values[base], resultNext);
+
+				unsigned long lastMatch = 0;
+				_BitScanReverse64(&lastMatch, block);
+				matchWithinBlock = lastMatch;
+			}
+
+			block = 0;
+		}
+
+		while (block != 0 && resultNext != resultEnd)
+		{
+			matchWithinBlock = ctz(block);
+			*(resultNext++) = values[base + matchWithinBlock];
+			block &= block - 1;
+		}
+
+		if (resultNext == resultEnd) break;
+
+		base += 64;
+		if (base >= end) break;
+		block = matchVector[base >> 6];
+		if (end - base < 64) block &= (~0x0ULL >> (64 - (end - base)));
+
+		// If this block is empty, skip over any following runs of four empty blocks
+		if (block == 0)
+		{
+			while (base + 320 <= end)
+			{
+				__m256i nextBlocks = _mm256_loadu_si256((__m256i*)(&matchVector[(base >> 6) + 1]));
+				if (!_mm256_testz_si256(nextBlocks, nextBlocks)) break;
+				base += 256;
+			}
+		}
+	}
+
+	*start = (base >= end ? -1 : base + matchWithinBlock + 1);
+	return (int)(resultNext - result);
+}
+
+// Copy the start and end position of each string i in [*start, end) with a set bit to starts and ends, as CompactN copies values.
+// ends[i] is the end of string i, which starts at ends[i - 1]. Without hasPrevious, string zero starts at zero and ends[-1] isn't read.
+static int CompactString8N(unsigned __int32* ends, bool hasPrevious, unsigned __int64* matchVector, int end, int* start, unsigned __int32* starts, unsigned __int32* resultEnds, int resultLength)
+{
+	int next = *start;
+	int countFound = CompactN<unsigned __int32>(ends, matchVector, end, start, resultEnds, resultLength);
+	int startsFound = 0;
+
+	// The starts are the ends one row back. With no end before string zero, walk the first block bit by bit, since CompactN reads whole blocks.
+	if (!hasPrevious && next < 64)
+	{
+		int blockEnd = (end < 64 ? end : 64);
+		for (; next < blockEnd && startsFound < countFound; ++next)
+		{
+			if ((matchVector[0] >> next) & 1) starts[startsFound++] = (next == 0 ? 0 : ends[next - 1]);
+		}
+	}
+
+	if (startsFound < countFound) CompactN<unsigned __int32>(ends - 1, matchVector, end, &next, starts + startsFound, countFound - startsFound);
+	return countFound;
+}
+
+// Rank/select index: two words per superblock of eight vector words. ranks[2s] is the count of set bits
+// before superblock s, and ranks[2s + 1] packs the 9-bit count of set bits before each of its other seven words.
+// samples[j] is the superblock containing set bit number j * RankSelectSampleRate, so Select only searches a few superblocks.
+// WARNING: Must match BitVectorN::RankSuperblockWords and BitVectorN::RankSelectSampleRate.
+static const int RankSuperblockWordsN = 8;
+static const int RankSelectSampleRateN = 512;
+
+// Build the index for vector[0, length), returning the count of set bits
+static int BuildRanksN(unsigned __int64* matchVector, int length, unsigned __int64* ranks, int* samples)
+{
+	int superblockCount = (length + RankSuperblockWordsN - 1) / RankSuperblockWordsN;
+	unsigned __int64 count = 0;
+	int sampleCount = 0;
+
+	for (int s = 0; s < superblockCount; ++s)
+	{
+		int start = s * RankSuperblockWordsN;
+		int end = (start + RankSuperblockWordsN < length ? start + RankSuperblockWordsN : length);
+
+		unsigned __int64 blockRanks = 0;
+		unsigned __int64 inSuperblock = 0;
+		for (int i = start; i < end; ++i)
+		{
+			if (i > start) blockRanks |= inSuperblock << (9 * (i - start - 1));
+			inSuperblock += _mm_popcnt_u64(matchVector[i]);
+		}
+
+		// Words past the end of the vector have no set bits, so they rank as the superblock total
+		for (int j = end - start; j < RankSuperblockWordsN; ++j)
+		{
+			blockRanks |= inSuperblock << (9 * (j - 1));
+		}
+
+		ranks[2 * s] = count;
+		ranks[2 * s + 1] = blockRanks;
+
+		// Sample the superblock containing each RankSelectSampleRate'th set bit
+		count += inSuperblock;
+		while ((unsigned __int64)sampleCount * RankSelectSampleRateN < count)
+		{
+			samples[sampleCount++] = s;
+		}
+	}
+
+	return (int)count;
+}
+
+// Return the position of set bit number 'rank' (from zero) in word, which must have more than 'rank' set bits.
+// PDEP deposits a single bit there directly where it's fast; where it's microcoded, halve the word by the popcount
+// of its low half down to a byte, then clear the lower set bits of the byte.
+static __forceinline int SelectInWordN(unsigned __int64 word, unsigned __int64 rank)
+{
+	if (SupportedN.FastPext) return (int)_tzcnt_u64(_pdep_u64(1ULL << rank, word));
+
+	int bit = 0;
+	for (int width = 32; width >= 8; width >>= 1)
+	{
+		unsigned __int64 lowCount = __popcnt64(word & ((1ULL << width) - 1));
+		int inHigh = (rank >= lowCount);
+		rank -= (inHigh ? lowCount : 0);
+		word >>= (inHigh ? width : 0);
+		bit += (inHigh ? width : 0);
+	}
+
+	for (; rank > 0; --rank) word = _blsr_u64(word);
+	return bit + (int)_tzcnt_u64(word);
+}
+
+// Return the index of set bit number 'ordinal' (from zero), or -1 if there are 'count' or fewer set bits
+static __inline int SelectN(unsigned __int64* matchVector, int length, unsigned __int64* ranks, int* samples, int count, int ordinal)
+{
+	if (ordinal < 0 || ordinal >= count) return -1;
+	int superblockCount = (length + RankSuperblockWordsN - 1) / RankSuperblockWordsN;
+	int sampleCount = (int)(((__int64)count + RankSelectSampleRateN - 1) / RankSelectSampleRateN);
+
+	// Find the last superblock starting at or before the ordinal between the samples around it
+	int sample = ordinal / RankSelectSampleRateN;
+	int low = samples[sample];
+	int high = (sample + 1 < sampleCount ? samples[sample + 1] : superblockCount - 1);
+	while (low < high)
+	{
+		int middle = low + ((high - low + 1) >> 1);
+		if (ranks[2 * middle] <= (unsigned __int64)ordinal)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle - 1;
+		}
+	}
+
+	// Find the word within the superblock: the number of the seven packed word ranks at or before the remaining ordinal
+	unsigned __int64 remaining = ordinal - ranks[2 * low];
+	unsigned __int64 blockRanks = ranks[2 * low + 1];
+	int word = 0;
+	for (int j = 0; j < RankSuperblockWordsN - 1; ++j)
+	{
+		unsigned __int64 blockRank = (blockRanks >> (9 * j)) & 0x1FF;
+		word += (blockRank <= remaining);
+	}
+
+	if (word > 0) remaining -= (blockRanks >> (9 * (word - 1))) & 0x1FF;
+
+	int index = low * RankSuperblockWordsN + word;
+	if (index >= length) return -1;
+
+	// Select the bit within the word
+	return (index << 6) + SelectInWordN(matchVector[index], remaining);
+}
+
 #pragma managed
 
 namespace XForm
@@ -91,6 +547,8 @@ namespace XForm
 	{
 		Int32 BitVectorN::Count(array<UInt64>^ vector)
 		{
+			COUNT_KERNEL(BitVectorCount, (Int64)vector->Length * 64, (Int64)vector->Length * 8);
+
 			pin_ptr<UInt64> pVector = &vector[0];
 			return CountN(pVector, vector->Length);
 		}
@@ -100,11 +558,144 @@ namespace XForm
 			pin_ptr<UInt64> pVector = &vector[0];
 			pin_ptr<Int32> pIndices = &indicesFound[0];
 			if (countLimit > indicesFound->Length) throw gcnew ArgumentOutOfRangeException("countLimit");
+			COUNT_KERNEL(BitVectorPage, (Int64)vector->Length * 64 - fromIndex, ((Int64)vector->Length * 64 - fromIndex) / 8);
 
 			int nextIndex = fromIndex;
 			int countFound = PageN(pVector, vector->Length, &nextIndex, pIndices, countLimit);
 			fromIndex = nextIndex;
 			return countFound;  
 		}
+
+		Int32 BitVectorN::BuildRanks(array<UInt64>^ vector, array<UInt64>^ ranks, array<Int32>^ samples)
+		{
+			int superblockCount = (vector->Length + RankSuperblockWords - 1) / RankSuperblockWords;
+			if (ranks->Length < 2 * superblockCount) throw gcnew IndexOutOfRangeException("ranks");
+			if (samples->Length < superblockCount) throw gcnew IndexOutOfRangeException("samples");
+			if (superblockCount == 0) return 0;
+
+			COUNT_KERNEL(RankBuild, (Int64)vector->Length * 64, (Int64)vector->Length * 8);
+
+			pin_ptr<UInt64> pVector = &vector[0];
+			pin_ptr<UInt64> pRanks = &ranks[0];
+			pin_ptr<Int32> pSamples = &samples[0];
+			return BuildRanksN(pVector, vector->Length, pRanks, pSamples);
+		}
+
+		void BitVectorN::Select(array<UInt64>^ vector, array<UInt64>^ ranks, array<Int32>^ samples, Int32 count, array<Int32>^ ordinals, Int32 index, Int32 length, array<Int32>^ indices)
+		{
+			int superblockCount = (vector->Length + RankSuperblockWords - 1) / RankSuperblockWords;
+			if (ranks->Length < 2 * superblockCount) throw gcnew IndexOutOfRangeException("ranks");
+			if (count < 0 || (Int64)count > (Int64)vector->Length * 64 || (Int64)count > (Int64)samples->Length * RankSelectSampleRate) throw gcnew ArgumentOutOfRangeException("count");
+			if (index < 0 || length < 0 || index + length > ordinals->Length) throw gcnew IndexOutOfRangeException("ordinals");
+			if (length > indices->Length) throw gcnew IndexOutOfRangeException("indices");
+			if (length == 0) return;
+
+			COUNT_KERNEL(Select, length, (Int64)length * 8);
+
+			pin_ptr<Int32> pOrdinals = &ordinals[index];
+			pin_ptr<Int32> pIndices = &indices[0];
+			if (count == 0)
+			{
+				for (int i = 0; i < length; ++i) pIndices[i] = -1;
+				return;
+			}
+
+			pin_ptr<UInt64> pVector = &vector[0];
+			pin_ptr<UInt64> pRanks = &ranks[0];
+			pin_ptr<Int32> pSamples = &samples[0];
+			for (int i = 0; i < length; ++i)
+			{
+				pIndices[i] = SelectN(pVector, vector->Length, pRanks, pSamples, count, pOrdinals[i]);
+			}
+		}
+
+		static Int32 CompactElementSize(Type^ type)
+		{
+			if (type == Byte::typeid || type == SByte::typeid || type == Boolean::typeid) return 1;
+			if (type == UInt16::typeid || type == Int16::typeid || type == Char::typeid) return 2;
+			if (type == UInt32::typeid || type == Int32::typeid || type == Single::typeid) return 4;
+			if (type == UInt64::typeid || type == Int64::typeid || type == Double::typeid) return 8;
+			throw gcnew ArgumentException(String::Format("BitVectorN.Compact doesn't support {0} values.", type->Name), "values");
+		}
+
+		Int32 BitVectorN::Compact(array<UInt64>^ vector, Array^ values, Int32 index, Int32 length, Int32% fromIndex, Int32 countLimit, Array^ result)
+		{
+			if (index < 0 || length < 0 || index + length > values->Length) throw gcnew IndexOutOfRangeException("values");
+			if (length > vector->Length * 64) throw gcnew IndexOutOfRangeException("vector");
+			if (countLimit < 0 || countLimit > result->Length) throw gcnew ArgumentOutOfRangeException("countLimit");
+			if (result->GetType() != values->GetType()) throw gcnew ArgumentException("result must be the same type as values.", "result");
+			Int32 elementSize = CompactElementSize(values->GetType()->GetElementType());
+
+			if (length == 0)
+			{
+				fromIndex = -1;
+				return 0;
+			}
+
+			COUNT_KERNEL(BitVectorCompact, length - fromIndex, (Int64)(length - fromIndex) * elementSize);
+
+			GCHandle valuesHandle = GCHandle::Alloc(values, GCHandleType::Pinned);
+			GCHandle resultHandle = GCHandle::Alloc(result, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<UInt64> pVector = &vector[0];
+				unsigned __int8* pValues = (unsigned __int8*)valuesHandle.AddrOfPinnedObject().ToPointer() + (Int64)index * elementSize;
+				void* pResult = resultHandle.AddrOfPinnedObject().ToPointer();
+
+				int nextIndex = fromIndex;
+				int countFound = 0;
+
+				switch (elementSize)
+				{
+				case 1:
+					countFound = CompactN<unsigned __int8>(pValues, pVector, length, &nextIndex, (unsigned __int8*)pResult, countLimit);
+					break;
+				case 2:
+					countFound = CompactN<unsigned __int16>((unsigned __int16*)pValues, pVector, length, &nextIndex, (unsigned __int16*)pResult, countLimit);
+					break;
+				case 4:
+					countFound = CompactN<unsigned __int32>((unsigned __int32*)pValues, pVector, length, &nextIndex, (unsigned __int32*)pResult, countLimit);
+					break;
+				case 8:
+					countFound = CompactN<unsigned __int64>((unsigned __int64*)pValues, pVector, length, &nextIndex, (unsigned __int64*)pResult, countLimit);
+					break;
+				}
+
+				fromIndex = nextIndex;
+				return countFound;
+			}
+			finally
+			{
+				valuesHandle.Free();
+				resultHandle.Free();
+			}
+		}
+
+		Int32 BitVectorN::CompactString8(array<UInt64>^ vector, array<Int32>^ positions, Int32 index, Int32 length, Boolean hasPrevious, Int32% fromIndex, Int32 countLimit, array<Int32>^ starts, array<Int32>^ ends)
+		{
+			if (index < 0 || length < 0 || index + length > positions->Length) throw gcnew IndexOutOfRangeException("positions");
+			if (hasPrevious && index == 0) throw gcnew IndexOutOfRangeException("index");
+			if (length > vector->Length * 64) throw gcnew IndexOutOfRangeException("vector");
+			if (countLimit < 0 || countLimit > starts->Length || countLimit > ends->Length) throw gcnew ArgumentOutOfRangeException("countLimit");
+
+			if (length == 0)
+			{
+				fromIndex = -1;
+				return 0;
+			}
+
+			COUNT_KERNEL(BitVectorCompact, length - fromIndex, (Int64)(length - fromIndex) * 8);
+
+			pin_ptr<UInt64> pVector = &vector[0];
+			pin_ptr<Int32> pPositions = &positions[0];
+			pin_ptr<Int32> pStarts = &starts[0];
+			pin_ptr<Int32> pEnds = &ends[0];
+
+			int nextIndex = fromIndex;
+			int countFound = CompactString8N((unsigned __int32*)(pPositions + index), hasPrevious, pVector, length, &nextIndex, (unsigned __int32*)pStarts, (unsigned __int32*)pEnds, countLimit);
+			fromIndex = nextIndex;
+			return countFound;
+		}
 	}
 }
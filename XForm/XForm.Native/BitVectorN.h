@@ -4,6 +4,10 @@
 #pragma once
 using namespace System;
 
+// Unmanaged Count and Page, shared with kernels which run several operations in one call. 'length' is in 64-bit words.
+int CountN(unsigned __int64* matchVector, int length);
+int PageN(unsigned __int64* matchVector, int length, int* start, int* result, int resultLength);
+
 namespace XForm
 {
 	namespace Native
@@ -13,6 +17,26 @@ namespace XForm
 		public:
 			static Int32 Count(array<UInt64>^ vector);
 			static Int32 Page(array<UInt64>^ vector, array<Int32>^ indicesFound, Int32% fromIndex, Int32 countLimit);
+
+			// Copy values[index + i] for each set bit i in [fromIndex, length) to result, in order, up to countLimit values.
+			// Pages like Page, but writes the matching values themselves, so filtered columns don't need an index array and gather.
+			static Int32 Compact(array<UInt64>^ vector, Array^ values, Int32 index, Int32 length, Int32% fromIndex, Int32 countLimit, Array^ result);
+
+			// Compact String8 rows: positions[index + i] is the end of string i, which starts at positions[index + i - 1], or at zero if not hasPrevious.
+			// Copies the start and end of each string with a set bit in [fromIndex, length) to starts and ends, so the strings can share the source text.
+			static Int32 CompactString8(array<UInt64>^ vector, array<Int32>^ positions, Int32 index, Int32 length, Boolean hasPrevious, Int32% fromIndex, Int32 countLimit, array<Int32>^ starts, array<Int32>^ ends);
+
+			// Rank/select index over a vector: ranks holds two values per superblock of RankSuperblockWords words (the set bits before it,
+			// and the packed 9-bit set bits before each of its words), and samples the superblock of every RankSelectSampleRate'th set bit.
+			literal Int32 RankSuperblockWords = 8;
+			literal Int32 RankSelectSampleRate = 512;
+
+			// Build the index into ranks (2 * superblock count values) and samples (superblock count values), returning the count of set bits
+			static Int32 BuildRanks(array<UInt64>^ vector, array<UInt64>^ ranks, array<Int32>^ samples);
+
+			// For each ordinals[index + i] in [0, length), write the index of that set bit (numbered from zero) to indices[i], or -1 if
+			// the vector has fewer set bits. count is the BuildRanks result. Each index is found directly, without paging through the vector.
+			static void Select(array<UInt64>^ vector, array<UInt64>^ ranks, array<Int32>^ samples, Int32 count, array<Int32>^ ordinals, Int32 index, Int32 length, array<Int32>^ indices);
 		};
 	}
 }
@@ -4,6 +4,8 @@
 #pragma once
 using namespace System;
 
+struct WhereTermN;
+
 namespace XForm
 {
 	namespace Native
@@ -21,6 +23,39 @@ namespace XForm
 			static void Where(array<Int16>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, Int16 right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
 			static void Where(array<Int16>^ left, Int32 leftIndex, Byte compareOperator, array<Int16>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
 
+			// Whether 16-bit Where compacts compare masks with PEXT or with a pack and permute. PEXT is microcoded on AMD before Zen 3,
+			// so the default depends on the CPU; set to compare both variants. Setting it also makes AVX-512BW hosts use the AVX2 variants.
+			static property Boolean Where16UsesPext { Boolean get(); void set(Boolean value); }
+
+			// Return 16-bit Where to the CPU default variant, after setting Where16UsesPext to compare them.
+			static void ResetWhere16UsesPext();
+
+			// AVX2 accelerated where comparing [int and long] (array to array) and (array to constant)
+			static void Where(array<UInt32>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, UInt32 right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<UInt32>^ left, Int32 leftIndex, Byte compareOperator, array<UInt32>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Int32>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, Int32 right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Int32>^ left, Int32 leftIndex, Byte compareOperator, array<Int32>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			static void Where(array<UInt64>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, UInt64 right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<UInt64>^ left, Int32 leftIndex, Byte compareOperator, array<UInt64>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Int64>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, Int64 right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Int64>^ left, Int32 leftIndex, Byte compareOperator, array<Int64>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// AVX2 accelerated where comparing [float and double] (array to array) and (array to constant); NaN matches only NotEqual, as in C#
+			static void Where(array<Single>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, Single right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Single>^ left, Int32 leftIndex, Byte compareOperator, array<Single>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Double>^ left, Int32 leftIndex, Int32 length, Byte compareOperator, Double right, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void Where(array<Double>^ left, Int32 leftIndex, Byte compareOperator, array<Double>^ right, Int32 rightIndex, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// AVX2 accelerated where ANDing several (array to constant) terms together in one pass over 64-row blocks
+			literal Int32 WhereAndTermLimit = 16;
+			static void WhereAnd(array<Array^>^ columns, array<Int32>^ indices, array<Byte>^ compareOperators, array<Object^>^ values, Int32 termCount, Int32 length, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// Match values whose bit is set in the membership bitmap 'set' (value v is bit (v & 63) of set[v >> 6], as in BitVector).
+			// Values past the end of set don't match; four words cover every byte and 1,024 every ushort.
+			static void WhereIn(array<Byte>^ left, Int32 index, Int32 length, array<UInt64>^ set, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+			static void WhereIn(array<UInt16>^ left, Int32 index, Int32 length, array<UInt64>^ set, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
 			// Compare values to a constant [non-vector]
 			template<typename T>
 			static void WhereSingle(T* set, int length, Byte compareOperator, T value, Byte booleanOperator, unsigned __int64* matchVector);
@@ -29,5 +64,11 @@ namespace XForm
 			template<typename T>
 			static void WhereSingle(T* left, int length, Byte cOp, T* right, Byte bOp, unsigned __int64* matchVector);
 		};
+
+		// Build the native term comparing column (pinned at start) from index to value. Throws for unsupported column types.
+		void BuildTerm(Array^ column, Object^ value, Byte cOp, void* start, Int32 index, WhereTermN& term);
+
+		// Build the native term for values of type (a primitive numeric type) at start, for columns which aren't managed arrays
+		void BuildTerm(Type^ type, Object^ value, Byte cOp, void* start, Int32 index, WhereTermN& term);
 	}
 }
@@ -7,11 +7,73 @@
 #include "Operator.h"
 #include "ComparerSingle.cpp"
 #include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
 
 #pragma unmanaged
 
-template<CompareOperatorN cOp>
-static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector)
+// Whether to compact compare masks with PEXT: -1 for the CPU default, or 0 or 1 when set via Comparer::Where16UsesPext.
+// Array to constant Where uses AVX-512BW mask compares by default where available; setting either value selects the AVX2 variant instead.
+static signed char s_usePextN = -1;
+
+static __forceinline bool UsePextN()
+{
+	return (s_usePextN < 0 ? SupportedN.FastPext : s_usePextN != 0);
+}
+
+// Compact two 16-row compare masks (0xFFFF for matches, 0x0000 for non-matches) into 32 bits, one per row
+template<bool usePext>
+static __forceinline unsigned int CompactN(__m256i matchMask1, __m256i matchMask2)
+{
+	if (usePext)
+	{
+		// movemask gives one bit per byte, so two per row; PEXT every other bit (1010 = A)
+		unsigned int everyOtherBit = 0xAAAAAAAA;
+		return _pext_u32(_mm256_movemask_epi8(matchMask2), everyOtherBit) << 16 | _pext_u32(_mm256_movemask_epi8(matchMask1), everyOtherBit);
+	}
+	else
+	{
+		// Saturating pack keeps 0xFF and 0x00 bytes, but within 128-bit lanes (1 low, 2 low, 1 high, 2 high), so permute back into row order
+		__m256i packed = _mm256_packs_epi16(matchMask1, matchMask2);
+		return _mm256_movemask_epi8(_mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+	}
+}
+
+// AVX-512BW: compare 32 values into each 32-bit mask, so 64 rows need two compares and no movemask or pext
+template<CompareOperatorN cOp, SigningN sign>
+static __forceinline unsigned int CompareAvx512N(unsigned int valid, __m512i block, __m512i blockOfValue)
+{
+	return (sign == SigningN::Unsigned ? _mm512_mask_cmp_epu16_mask(valid, block, blockOfValue, Avx512PredicateN(cOp)) : _mm512_mask_cmp_epi16_mask(valid, block, blockOfValue, Avx512PredicateN(cOp)));
+}
+
+template<CompareOperatorN cOp, SigningN sign>
+static void WhereAvx512N(unsigned __int16* set, int length, unsigned __int16 value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	__m512i blockOfValue = _mm512_set1_epi16((short)value);
+
+	int i = 0;
+	for (; i + 64 <= length; i += 64)
+	{
+		unsigned int low = CompareAvx512N<cOp, sign>(~0U, _mm512_loadu_si512((__m512i*)(&set[i])), blockOfValue);
+		unsigned int high = CompareAvx512N<cOp, sign>(~0U, _mm512_loadu_si512((__m512i*)(&set[i + 32])), blockOfValue);
+		MergeN(bOp, ((unsigned __int64)high << 32) | low, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	if (i < length)
+	{
+		unsigned __int64 valid = (0x1ULL << (length - i)) - 1;
+		unsigned int lowValid = (unsigned int)valid;
+		unsigned int highValid = (unsigned int)(valid >> 32);
+
+		unsigned int low = CompareAvx512N<cOp, sign>(lowValid, _mm512_maskz_loadu_epi16(lowValid, &set[i]), blockOfValue);
+		unsigned int high = CompareAvx512N<cOp, sign>(highValid, _mm512_maskz_loadu_epi16(highValid, &set[i + 32]), blockOfValue);
+		MergeN(bOp, ((unsigned __int64)high << 32) | low, valid, bitOffset, &matchVector[i >> 6]);
+	}
+}
+
+template<CompareOperatorN cOp, bool usePext>
+static void WhereAvx2N(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector, int bitOffset)
 {
 	int i = 0;
 	unsigned __int64 result;
@@ -23,9 +85,6 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, i
 	// Load copies of the value to compare against
 	__m256i blockOfValue = _mm256_sub_epi16(_mm256_set1_epi16(value), subtractValue);
 
-	// Build a PEXT mask asking for every other bit (1010 = A)
-	unsigned int everyOtherBit = 0xAAAAAAAA;
-
 	// Compare 64-byte blocks and generate a 64-bit result while there's enough data
 	int blockLength = length & ~63;
 	for (; i < blockLength; i += 64)
@@ -67,15 +126,9 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, i
 			break;
 		}
 
-		// Convert the masks into bits (one bit per byte, so still two duplicate bits per row matched)
-		unsigned int matchBits1 = _mm256_movemask_epi8(matchMask1);
-		unsigned int matchBits2 = _mm256_movemask_epi8(matchMask2);
-		unsigned int matchBits3 = _mm256_movemask_epi8(matchMask3);
-		unsigned int matchBits4 = _mm256_movemask_epi8(matchMask4);
-
-		// Get every other bit (so it's one per row) and merge together pairs
-		unsigned int matchBits2_1 = _pext_u32(matchBits2, everyOtherBit) << 16 | _pext_u32(matchBits1, everyOtherBit);
-		unsigned int matchBits4_3 = _pext_u32(matchBits4, everyOtherBit) << 16 | _pext_u32(matchBits3, everyOtherBit);
+		// Convert pairs of masks into bits, one per row
+		unsigned int matchBits2_1 = CompactN<usePext>(matchMask1, matchMask2);
+		unsigned int matchBits4_3 = CompactN<usePext>(matchMask3, matchMask4);
 
 		// Merge the result to get 64 bits for whether 64 rows matched
 		result = ((unsigned __int64)matchBits4_3) << 32 | matchBits2_1;
@@ -87,54 +140,66 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, i
 		}
 
 		// Merge the result with the existing bit vector bits based on the boolean operator requested
-		switch (bOp)
-		{
-		case BooleanOperatorN::And:
-			matchVector[i >> 6] &= result;
-			break;
-		case BooleanOperatorN::Or:
-			matchVector[i >> 6] |= result;
-			break;
-		}
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
 	}
 
 	// Match remaining values individually
 	if (length & 63) 
 	{
 		if(sign == SigningN::Unsigned) 
-			WhereSingle<cOp, unsigned __int16>(&set[i], length - i, value, bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, unsigned __int16>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
 		else 
-			WhereSingle<cOp, __int16>((__int16*)&set[i], length - i, (__int16)value, bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, __int16>((__int16*)&set[i], length - i, (__int16)value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector, int bitOffset)
+{
+	if (SupportedN.Avx512Bw && s_usePextN < 0)
+	{
+		if (sign == SigningN::Unsigned)
+			WhereAvx512N<cOp, SigningN::Unsigned>(set, length, value, bOp, matchVector, bitOffset);
+		else
+			WhereAvx512N<cOp, SigningN::Signed>(set, length, value, bOp, matchVector, bitOffset);
+	}
+	else if (UsePextN())
+	{
+		WhereAvx2N<cOp, true>(bOp, sign, set, length, value, matchVector, bitOffset);
+	}
+	else
+	{
+		WhereAvx2N<cOp, false>(bOp, sign, set, length, value, matchVector, bitOffset);
 	}
 }
 
-static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector)
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector, int bitOffset)
 {
 	switch (cOp)
 	{
 	case CompareOperatorN::Equal:
-		WhereN<CompareOperatorN::Equal>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::Equal>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::NotEqual:
-		WhereN<CompareOperatorN::NotEqual>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::LessThan:
-		WhereN<CompareOperatorN::LessThan>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::LessThanOrEqual:
-		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::GreaterThan:
-		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::GreaterThanOrEqual:
-		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, set, length, value, matchVector);
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
 		break;
 	}
 }
 
-template<CompareOperatorN cOp>
-static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left, int length, unsigned __int16* right, unsigned __int64* matchVector)
+template<CompareOperatorN cOp, bool usePext>
+static void WhereAvx2N(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left, int length, unsigned __int16* right, unsigned __int64* matchVector, int bitOffset)
 {
 	int i = 0;
 	unsigned __int64 result;
@@ -143,9 +208,6 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left,
 	__m256i subtractValue = _mm256_set1_epi16(-32768);
 	if (sign == SigningN::Signed) subtractValue = _mm256_set1_epi16(0);
 
-	// Build a PEXT mask asking for every other bit (1010 = A)
-	unsigned int everyOtherBit = 0xAAAAAAAA;
-
 	// Compare 64-byte blocks and generate a 64-bit result while there's enough data
 	int blockLength = length & ~63;
 	for (; i < blockLength; i += 64)
@@ -193,15 +255,9 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left,
 			break;
 		}
 
-		// Convert the masks into bits (one bit per byte, so still two duplicate bits per row matched)
-		unsigned int matchBits1 = _mm256_movemask_epi8(matchMask1);
-		unsigned int matchBits2 = _mm256_movemask_epi8(matchMask2);
-		unsigned int matchBits3 = _mm256_movemask_epi8(matchMask3);
-		unsigned int matchBits4 = _mm256_movemask_epi8(matchMask4);
-
-		// Get every other bit (so it's one per row) and merge together pairs
-		unsigned int matchBits2_1 = _pext_u32(matchBits2, everyOtherBit) << 16 | _pext_u32(matchBits1, everyOtherBit);
-		unsigned int matchBits4_3 = _pext_u32(matchBits4, everyOtherBit) << 16 | _pext_u32(matchBits3, everyOtherBit);
+		// Convert pairs of masks into bits, one per row
+		unsigned int matchBits2_1 = CompactN<usePext>(matchMask1, matchMask2);
+		unsigned int matchBits4_3 = CompactN<usePext>(matchMask3, matchMask4);
 
 		// Merge the result to get 64 bits for whether 64 rows matched
 		result = ((unsigned __int64)matchBits4_3) << 32 | matchBits2_1;
@@ -213,48 +269,49 @@ static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left,
 		}
 
 		// Merge the result with the existing bit vector bits based on the boolean operator requested
-		switch (bOp)
-		{
-		case BooleanOperatorN::And:
-			matchVector[i >> 6] &= result;
-			break;
-		case BooleanOperatorN::Or:
-			matchVector[i >> 6] |= result;
-			break;
-		}
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
 	}
 
 	// Match remaining values individually
 	if (length & 63)
 	{
 		if (sign == SigningN::Unsigned)
-			WhereSingle<cOp, unsigned __int16>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, unsigned __int16>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6], bitOffset);
 		else
-			WhereSingle<cOp, __int16>((__int16*)&left[i], length - i, (__int16*)&right[i], bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, __int16>((__int16*)&left[i], length - i, (__int16*)&right[i], bOp, &matchVector[i >> 6], bitOffset);
 	}
 }
 
-static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int16* left, int length, unsigned __int16* right, unsigned __int64* matchVector)
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int16* left, int length, unsigned __int16* right, unsigned __int64* matchVector, int bitOffset)
+{
+	if (UsePextN())
+		WhereAvx2N<cOp, true>(bOp, sign, left, length, right, matchVector, bitOffset);
+	else
+		WhereAvx2N<cOp, false>(bOp, sign, left, length, right, matchVector, bitOffset);
+}
+
+static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int16* left, int length, unsigned __int16* right, unsigned __int64* matchVector, int bitOffset)
 {
 	switch (cOp)
 	{
 	case CompareOperatorN::Equal:
-		WhereN<CompareOperatorN::Equal>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::Equal>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::NotEqual:
-		WhereN<CompareOperatorN::NotEqual>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::LessThan:
-		WhereN<CompareOperatorN::LessThan>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::LessThanOrEqual:
-		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::GreaterThan:
-		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	case CompareOperatorN::GreaterThanOrEqual:
-		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, left, length, right, matchVector);
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
 		break;
 	}
 }
@@ -265,17 +322,35 @@ namespace XForm
 {
 	namespace Native
 	{
+		Boolean Comparer::Where16UsesPext::get()
+		{
+			// The default AVX-512BW path compares into mask registers, which need no compaction
+			if (SupportedN.Avx512Bw && s_usePextN < 0) return false;
+			return UsePextN();
+		}
+
+		void Comparer::Where16UsesPext::set(Boolean value)
+		{
+			s_usePextN = (value ? 1 : 0);
+		}
+
+		void Comparer::ResetWhere16UsesPext()
+		{
+			s_usePextN = -1;
+		}
+
 		void Comparer::Where(array<UInt16>^ left, Int32 index, Int32 length, Byte cOp, UInt16 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
 		{
 			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
 			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
 			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 2);
 
 			pin_ptr<UInt16> pLeft = &left[index];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
 
-			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, right, pVector);
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, right, pVector, vectorIndex & 63);
 		}
 
 		void Comparer::Where(array<UInt16>^ left, Int32 leftIndex, Byte cOp, array<UInt16>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
@@ -284,13 +359,14 @@ namespace XForm
 			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
 			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 4);
 
 			pin_ptr<UInt16> pLeft = &left[leftIndex];
 			pin_ptr<UInt16> pRight = &right[rightIndex];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
 
-			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, pRight, pVector);
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, pRight, pVector, vectorIndex & 63);
 		}
 
 		void Comparer::Where(array<Int16>^ left, Int32 index, Int32 length, Byte cOp, Int16 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
@@ -298,12 +374,13 @@ namespace XForm
 			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
 			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException();
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 2);
 
 			pin_ptr<Int16> pLeft = &left[index];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
 
-			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int16*)pLeft, length, (unsigned __int16)right, pVector);
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int16*)pLeft, length, (unsigned __int16)right, pVector, vectorIndex & 63);
 		}
 
 		void Comparer::Where(array<Int16>^ left, Int32 leftIndex, Byte cOp, array<Int16>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
@@ -312,13 +389,14 @@ namespace XForm
 			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
 			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 4);
 
 			pin_ptr<Int16> pLeft = &left[leftIndex];
 			pin_ptr<Int16> pRight = &right[rightIndex];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
 
-			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int16*)pLeft, length, (unsigned __int16*)pRight, pVector);
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int16*)pLeft, length, (unsigned __int16*)pRight, pVector, vectorIndex & 63);
 		}
 	}
 }
@@ -0,0 +1,265 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <nmmintrin.h>
+#include "Operator.h"
+#include "ComparerSingle.cpp"
+#include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+
+#pragma unmanaged
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int32* set, int length, unsigned __int32 value, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load a mask to convert unsigned values for signed comparison (flipping the sign bit maps unsigned order onto signed order)
+	__m256i subtractValue = _mm256_set1_epi32((int)0x80000000);
+	if (sign == SigningN::Signed) subtractValue = _mm256_set1_epi32(0);
+
+	// Load copies of the value to compare against
+	__m256i blockOfValue = _mm256_sub_epi32(_mm256_set1_epi32((int)value), subtractValue);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare eight sets of eight 4-byte values
+		for (int j = 0; j < 8; ++j)
+		{
+			// Load 8 4-byte values to compare
+			__m256i block = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(&set[i + (j << 3)])), subtractValue);
+
+			// Compare them to the desired value, building a mask with 0xFFFFFFFF for matches and 0x00000000 for non-matches
+			__m256i matchMask;
+
+			switch (cOp)
+			{
+			case CompareOperatorN::GreaterThan:
+			case CompareOperatorN::LessThanOrEqual:
+				matchMask = _mm256_cmpgt_epi32(block, blockOfValue);
+				break;
+			case CompareOperatorN::LessThan:
+			case CompareOperatorN::GreaterThanOrEqual:
+				matchMask = _mm256_cmpgt_epi32(blockOfValue, block);
+				break;
+			case CompareOperatorN::Equal:
+			case CompareOperatorN::NotEqual:
+				matchMask = _mm256_cmpeq_epi32(block, blockOfValue);
+				break;
+			}
+
+			// Convert the mask into bits (movemask_ps takes the top bit of each 4-byte value, so one bit per row) and merge into the result
+			result |= ((unsigned __int64)_mm256_movemask_ps(_mm256_castsi256_ps(matchMask))) << (j << 3);
+		}
+
+		// Negate the result for operators we ran the opposites of
+		if (cOp == CompareOperatorN::LessThanOrEqual || cOp == CompareOperatorN::GreaterThanOrEqual || cOp == CompareOperatorN::NotEqual)
+		{
+			result = ~result;
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		if (sign == SigningN::Unsigned)
+			WhereSingle<cOp, unsigned __int32>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
+		else
+			WhereSingle<cOp, __int32>((__int32*)&set[i], length - i, (__int32)value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int32* set, int length, unsigned __int32 value, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int32* left, int length, unsigned __int32* right, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load a mask to convert unsigned values for signed comparison
+	__m256i subtractValue = _mm256_set1_epi32((int)0x80000000);
+	if (sign == SigningN::Signed) subtractValue = _mm256_set1_epi32(0);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare eight sets of eight 4-byte values
+		for (int j = 0; j < 8; ++j)
+		{
+			// Load 8 4-byte values from each side to compare
+			__m256i leftBlock = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(&left[i + (j << 3)])), subtractValue);
+			__m256i rightBlock = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(&right[i + (j << 3)])), subtractValue);
+
+			// Compare them, building a mask with 0xFFFFFFFF for matches and 0x00000000 for non-matches
+			__m256i matchMask;
+
+			switch (cOp)
+			{
+			case CompareOperatorN::GreaterThan:
+			case CompareOperatorN::LessThanOrEqual:
+				matchMask = _mm256_cmpgt_epi32(leftBlock, rightBlock);
+				break;
+			case CompareOperatorN::LessThan:
+			case CompareOperatorN::GreaterThanOrEqual:
+				matchMask = _mm256_cmpgt_epi32(rightBlock, leftBlock);
+				break;
+			case CompareOperatorN::Equal:
+			case CompareOperatorN::NotEqual:
+				matchMask = _mm256_cmpeq_epi32(leftBlock, rightBlock);
+				break;
+			}
+
+			// Convert the mask into bits (one per row) and merge into the result
+			result |= ((unsigned __int64)_mm256_movemask_ps(_mm256_castsi256_ps(matchMask))) << (j << 3);
+		}
+
+		// Negate the result for operators we ran the opposites of
+		if (cOp == CompareOperatorN::LessThanOrEqual || cOp == CompareOperatorN::GreaterThanOrEqual || cOp == CompareOperatorN::NotEqual)
+		{
+			result = ~result;
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		if (sign == SigningN::Unsigned)
+			WhereSingle<cOp, unsigned __int32>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6], bitOffset);
+		else
+			WhereSingle<cOp, __int32>((__int32*)&left[i], length - i, (__int32*)&right[i], bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int32* left, int length, unsigned __int32* right, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void Comparer::Where(array<UInt32>^ left, Int32 index, Int32 length, Byte cOp, UInt32 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 4);
+
+			pin_ptr<UInt32> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<UInt32>^ left, Int32 leftIndex, Byte cOp, array<UInt32>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<UInt32> pLeft = &left[leftIndex];
+			pin_ptr<UInt32> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, pRight, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Int32>^ left, Int32 index, Int32 length, Byte cOp, Int32 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 4);
+
+			pin_ptr<Int32> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int32*)pLeft, length, (unsigned __int32)right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Int32>^ left, Int32 leftIndex, Byte cOp, array<Int32>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<Int32> pLeft = &left[leftIndex];
+			pin_ptr<Int32> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int32*)pLeft, length, (unsigned __int32*)pRight, pVector, vectorIndex & 63);
+		}
+	}
+}
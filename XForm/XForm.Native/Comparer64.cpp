@@ -0,0 +1,265 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <nmmintrin.h>
+#include "Operator.h"
+#include "ComparerSingle.cpp"
+#include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+
+#pragma unmanaged
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int64* set, int length, unsigned __int64 value, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load a mask to convert unsigned values for signed comparison (flipping the sign bit maps unsigned order onto signed order)
+	__m256i subtractValue = _mm256_set1_epi64x((__int64)0x8000000000000000ULL);
+	if (sign == SigningN::Signed) subtractValue = _mm256_set1_epi64x(0);
+
+	// Load copies of the value to compare against
+	__m256i blockOfValue = _mm256_sub_epi64(_mm256_set1_epi64x((__int64)value), subtractValue);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare sixteen sets of four 8-byte values
+		for (int j = 0; j < 16; ++j)
+		{
+			// Load 4 8-byte values to compare
+			__m256i block = _mm256_sub_epi64(_mm256_loadu_si256((__m256i*)(&set[i + (j << 2)])), subtractValue);
+
+			// Compare them to the desired value, building a mask with 0xFFFFFFFFFFFFFFFF for matches and 0x0000000000000000 for non-matches
+			__m256i matchMask;
+
+			switch (cOp)
+			{
+			case CompareOperatorN::GreaterThan:
+			case CompareOperatorN::LessThanOrEqual:
+				matchMask = _mm256_cmpgt_epi64(block, blockOfValue);
+				break;
+			case CompareOperatorN::LessThan:
+			case CompareOperatorN::GreaterThanOrEqual:
+				matchMask = _mm256_cmpgt_epi64(blockOfValue, block);
+				break;
+			case CompareOperatorN::Equal:
+			case CompareOperatorN::NotEqual:
+				matchMask = _mm256_cmpeq_epi64(block, blockOfValue);
+				break;
+			}
+
+			// Convert the mask into bits (movemask_pd takes the top bit of each 8-byte value, so one bit per row) and merge into the result
+			result |= ((unsigned __int64)_mm256_movemask_pd(_mm256_castsi256_pd(matchMask))) << (j << 2);
+		}
+
+		// Negate the result for operators we ran the opposites of
+		if (cOp == CompareOperatorN::LessThanOrEqual || cOp == CompareOperatorN::GreaterThanOrEqual || cOp == CompareOperatorN::NotEqual)
+		{
+			result = ~result;
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		if (sign == SigningN::Unsigned)
+			WhereSingle<cOp, unsigned __int64>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
+		else
+			WhereSingle<cOp, __int64>((__int64*)&set[i], length - i, (__int64)value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int64* set, int length, unsigned __int64 value, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int64* left, int length, unsigned __int64* right, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load a mask to convert unsigned values for signed comparison
+	__m256i subtractValue = _mm256_set1_epi64x((__int64)0x8000000000000000ULL);
+	if (sign == SigningN::Signed) subtractValue = _mm256_set1_epi64x(0);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare sixteen sets of four 8-byte values
+		for (int j = 0; j < 16; ++j)
+		{
+			// Load 4 8-byte values from each side to compare
+			__m256i leftBlock = _mm256_sub_epi64(_mm256_loadu_si256((__m256i*)(&left[i + (j << 2)])), subtractValue);
+			__m256i rightBlock = _mm256_sub_epi64(_mm256_loadu_si256((__m256i*)(&right[i + (j << 2)])), subtractValue);
+
+			// Compare them, building a mask with 0xFFFFFFFFFFFFFFFF for matches and 0x0000000000000000 for non-matches
+			__m256i matchMask;
+
+			switch (cOp)
+			{
+			case CompareOperatorN::GreaterThan:
+			case CompareOperatorN::LessThanOrEqual:
+				matchMask = _mm256_cmpgt_epi64(leftBlock, rightBlock);
+				break;
+			case CompareOperatorN::LessThan:
+			case CompareOperatorN::GreaterThanOrEqual:
+				matchMask = _mm256_cmpgt_epi64(rightBlock, leftBlock);
+				break;
+			case CompareOperatorN::Equal:
+			case CompareOperatorN::NotEqual:
+				matchMask = _mm256_cmpeq_epi64(leftBlock, rightBlock);
+				break;
+			}
+
+			// Convert the mask into bits (one per row) and merge into the result
+			result |= ((unsigned __int64)_mm256_movemask_pd(_mm256_castsi256_pd(matchMask))) << (j << 2);
+		}
+
+		// Negate the result for operators we ran the opposites of
+		if (cOp == CompareOperatorN::LessThanOrEqual || cOp == CompareOperatorN::GreaterThanOrEqual || cOp == CompareOperatorN::NotEqual)
+		{
+			result = ~result;
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		if (sign == SigningN::Unsigned)
+			WhereSingle<cOp, unsigned __int64>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6], bitOffset);
+		else
+			WhereSingle<cOp, __int64>((__int64*)&left[i], length - i, (__int64*)&right[i], bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int64* left, int length, unsigned __int64* right, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, left, length, right, matchVector, bitOffset);
+		break;
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void Comparer::Where(array<UInt64>^ left, Int32 index, Int32 length, Byte cOp, UInt64 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<UInt64> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<UInt64>^ left, Int32 leftIndex, Byte cOp, array<UInt64>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 16);
+
+			pin_ptr<UInt64> pLeft = &left[leftIndex];
+			pin_ptr<UInt64> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Unsigned, pLeft, length, pRight, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Int64>^ left, Int32 index, Int32 length, Byte cOp, Int64 right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<Int64> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int64*)pLeft, length, (unsigned __int64)right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Int64>^ left, Int32 leftIndex, Byte cOp, array<Int64>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 16);
+
+			pin_ptr<Int64> pLeft = &left[leftIndex];
+			pin_ptr<Int64> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN((CompareOperatorN)cOp, (BooleanOperatorN)bOp, SigningN::Signed, (unsigned __int64*)pLeft, length, (unsigned __int64*)pRight, pVector, vectorIndex & 63);
+		}
+	}
+}
@@ -7,12 +7,44 @@
 #include "Operator.h"
 #include "ComparerSingle.cpp"
 #include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
 
 #pragma unmanaged
 
+// AVX-512BW: compare 64 bytes directly into a 64-bit mask register, and compare the remainder with a masked load
 template<CompareOperatorN cOp, SigningN sign>
-static void WhereN(unsigned __int8* set, int length, unsigned __int8 value, BooleanOperatorN bOp, unsigned __int64* matchVector)
+static void WhereAvx512N(unsigned __int8* set, int length, unsigned __int8 value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
 {
+	__m512i blockOfValue = _mm512_set1_epi8((char)value);
+
+	int i = 0;
+	for (; i + 64 <= length; i += 64)
+	{
+		__m512i block = _mm512_loadu_si512((__m512i*)(&set[i]));
+		unsigned __int64 result = (sign == SigningN::Unsigned ? _mm512_cmp_epu8_mask(block, blockOfValue, Avx512PredicateN(cOp)) : _mm512_cmp_epi8_mask(block, blockOfValue, Avx512PredicateN(cOp)));
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	if (i < length)
+	{
+		unsigned __int64 valid = (0x1ULL << (length - i)) - 1;
+		__m512i block = _mm512_maskz_loadu_epi8(valid, &set[i]);
+		unsigned __int64 result = (sign == SigningN::Unsigned ? _mm512_mask_cmp_epu8_mask(valid, block, blockOfValue, Avx512PredicateN(cOp)) : _mm512_mask_cmp_epi8_mask(valid, block, blockOfValue, Avx512PredicateN(cOp)));
+		MergeN(bOp, result, valid, bitOffset, &matchVector[i >> 6]);
+	}
+}
+
+template<CompareOperatorN cOp, SigningN sign>
+static void WhereN(unsigned __int8* set, int length, unsigned __int8 value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	if (SupportedN.Avx512Bw)
+	{
+		WhereAvx512N<cOp, sign>(set, length, value, bOp, matchVector, bitOffset);
+		return;
+	}
+
 	int i = 0;
 	unsigned __int64 result;
 
@@ -75,24 +107,50 @@ static void WhereN(unsigned __int8* set, int length, unsigned __int8 value, Bool
 		}
 
 		// Merge the result with the existing bit vector bits based on the boolean operator requested
-		switch (bOp)
-		{
-		case BooleanOperatorN::And:
-			matchVector[i >> 6] &= result;
-			break;
-		case BooleanOperatorN::Or:
-			matchVector[i >> 6] |= result;
-			break;
-		}
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
 	}
 
 	// Match remaining values individually
 	if (length & 63)
 	{
 		if (sign == SigningN::Unsigned)
-			WhereSingle<cOp, unsigned __int8>(&set[i], length - i, value, bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, unsigned __int8>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
 		else
-			WhereSingle<cOp, __int8>((__int8*)&set[i], length - i, (__int8)value, bOp, &matchVector[i >> 6]);
+			WhereSingle<cOp, __int8>((__int8*)&set[i], length - i, (__int8)value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, SigningN sign, unsigned __int8* set, int length, unsigned __int8 value, unsigned __int64* matchVector, int bitOffset)
+{
+	if (sign == SigningN::Unsigned)
+		WhereN<cOp, SigningN::Unsigned>(set, length, value, bOp, matchVector, bitOffset);
+	else
+		WhereN<cOp, SigningN::Signed>(set, length, value, bOp, matchVector, bitOffset);
+}
+
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int8* set, int length, unsigned __int8 value, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, sign, set, length, value, matchVector, bitOffset);
+		break;
 	}
 }
 
@@ -107,7 +165,8 @@ namespace XForm
 			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
 			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException();
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, length);
 
 			pin_ptr<Byte> pLeft = &left[index];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
@@ -115,22 +174,22 @@ namespace XForm
 			switch ((CompareOperatorN)cOp)
 			{
 			case CompareOperatorN::Equal:
-				WhereN<CompareOperatorN::Equal, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::Equal, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::NotEqual:
-				WhereN<CompareOperatorN::NotEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::NotEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::LessThan:
-				WhereN<CompareOperatorN::LessThan, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::LessThan, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::LessThanOrEqual:
-				WhereN<CompareOperatorN::LessThanOrEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::LessThanOrEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::GreaterThan:
-				WhereN<CompareOperatorN::GreaterThan, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::GreaterThan, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::GreaterThanOrEqual:
-				WhereN<CompareOperatorN::GreaterThanOrEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::GreaterThanOrEqual, SigningN::Unsigned>(pLeft, length, right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			default:
 				throw gcnew ArgumentException("cOp");
@@ -142,7 +201,8 @@ namespace XForm
 			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
 			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException();
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, length);
 
 			pin_ptr<SByte> pLeft = &left[index];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
@@ -150,22 +210,22 @@ namespace XForm
 			switch ((CompareOperatorN)cOp)
 			{
 			case CompareOperatorN::Equal:
-				WhereN<CompareOperatorN::Equal, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::Equal, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::NotEqual:
-				WhereN<CompareOperatorN::NotEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::NotEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::LessThan:
-				WhereN<CompareOperatorN::LessThan, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::LessThan, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::LessThanOrEqual:
-				WhereN<CompareOperatorN::LessThanOrEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::LessThanOrEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::GreaterThan:
-				WhereN<CompareOperatorN::GreaterThan, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::GreaterThan, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::GreaterThanOrEqual:
-				WhereN<CompareOperatorN::GreaterThanOrEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::GreaterThanOrEqual, SigningN::Signed>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			default:
 				throw gcnew ArgumentException("cOp");
@@ -177,7 +237,8 @@ namespace XForm
 			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
 			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
 			if (vectorIndex + length >(vector->Length * 64)) throw gcnew IndexOutOfRangeException();
-			if ((vectorIndex & 63) != 0) throw gcnew ArgumentException("Offset Where must run on a multiple of 64 offset.");
+
+			COUNT_KERNEL(Where, length, length);
 
 			pin_ptr<Boolean> pLeft = &left[index];
 			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
@@ -185,10 +246,10 @@ namespace XForm
 			switch ((CompareOperatorN)cOp)
 			{
 			case CompareOperatorN::Equal:
-				WhereN<CompareOperatorN::Equal, SigningN::Unsigned>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::Equal, SigningN::Unsigned>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			case CompareOperatorN::NotEqual:
-				WhereN<CompareOperatorN::NotEqual, SigningN::Unsigned>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector);
+				WhereN<CompareOperatorN::NotEqual, SigningN::Unsigned>((unsigned __int8*)pLeft, length, (unsigned __int8)right, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
 				break;
 			default:
 				throw gcnew ArgumentException("cOp");
@@ -0,0 +1,202 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <nmmintrin.h>
+#include "Operator.h"
+#include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+void WhereN(WhereTermN& term, int index, int length, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (term.type)
+	{
+	case TermTypeN::TermUInt8:
+		WhereN(term.cOp, bOp, SigningN::Unsigned, (unsigned __int8*)term.column + index, length, (unsigned __int8)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermInt8:
+		WhereN(term.cOp, bOp, SigningN::Signed, (unsigned __int8*)term.column + index, length, (unsigned __int8)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermUInt16:
+		WhereN(term.cOp, bOp, SigningN::Unsigned, (unsigned __int16*)term.column + index, length, (unsigned __int16)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermInt16:
+		WhereN(term.cOp, bOp, SigningN::Signed, (unsigned __int16*)term.column + index, length, (unsigned __int16)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermUInt32:
+		WhereN(term.cOp, bOp, SigningN::Unsigned, (unsigned __int32*)term.column + index, length, (unsigned __int32)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermInt32:
+		WhereN(term.cOp, bOp, SigningN::Signed, (unsigned __int32*)term.column + index, length, (unsigned __int32)term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermUInt64:
+		WhereN(term.cOp, bOp, SigningN::Unsigned, (unsigned __int64*)term.column + index, length, term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermInt64:
+		WhereN(term.cOp, bOp, SigningN::Signed, (unsigned __int64*)term.column + index, length, term.value.integer, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermSingle:
+		WhereN(term.cOp, bOp, (float*)term.column + index, length, term.value.single, matchVector, bitOffset);
+		break;
+	case TermTypeN::TermDouble:
+		WhereN(term.cOp, bOp, (double*)term.column + index, length, term.value.real, matchVector, bitOffset);
+		break;
+	}
+}
+
+static void WhereAndN(WhereTermN* terms, int termCount, int length, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	for (int i = 0; i < length; i += 64)
+	{
+		int blockLength = length - i;
+		if (blockLength > 64) blockLength = 64;
+		unsigned __int64 valid = (blockLength == 64 ? ~0x0ULL : (0x1ULL << blockLength) - 1);
+
+		// For And, start with the rows still matching, so blocks already excluded aren't compared again
+		unsigned __int64 mask = valid;
+		if (bOp == BooleanOperatorN::And)
+		{
+			unsigned __int64* block = &matchVector[i >> 6];
+			unsigned __int64 current = block[0] >> bitOffset;
+			if (bitOffset != 0 && (valid >> (64 - bitOffset)) != 0) current |= block[1] << (64 - bitOffset);
+			mask &= current;
+		}
+
+		// AND each term into the block mask, stopping (and not loading later columns) once no rows are left
+		for (int t = 0; t < termCount && mask != 0; ++t)
+		{
+			WhereN(terms[t], i, blockLength, BooleanOperatorN::And, &mask, 0);
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, mask, valid, bitOffset, &matchVector[i >> 6]);
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void BuildTerm(Array^ column, Object^ value, Byte cOp, void* start, Int32 index, WhereTermN& term)
+		{
+			BuildTerm(column->GetType()->GetElementType(), value, cOp, start, index, term);
+		}
+
+		void BuildTerm(Type^ type, Object^ value, Byte cOp, void* start, Int32 index, WhereTermN& term)
+		{
+			term.cOp = (CompareOperatorN)cOp;
+			term.value.integer = 0;
+
+			if (type == Byte::typeid)
+			{
+				term.type = TermTypeN::TermUInt8;
+				term.column = (unsigned __int8*)start + index;
+				term.value.integer = safe_cast<Byte>(value);
+			}
+			else if (type == SByte::typeid)
+			{
+				term.type = TermTypeN::TermInt8;
+				term.column = (unsigned __int8*)start + index;
+				term.value.integer = (unsigned __int8)safe_cast<SByte>(value);
+			}
+			else if (type == UInt16::typeid)
+			{
+				term.type = TermTypeN::TermUInt16;
+				term.column = (unsigned __int16*)start + index;
+				term.value.integer = safe_cast<UInt16>(value);
+			}
+			else if (type == Int16::typeid)
+			{
+				term.type = TermTypeN::TermInt16;
+				term.column = (unsigned __int16*)start + index;
+				term.value.integer = (unsigned __int16)safe_cast<Int16>(value);
+			}
+			else if (type == UInt32::typeid)
+			{
+				term.type = TermTypeN::TermUInt32;
+				term.column = (unsigned __int32*)start + index;
+				term.value.integer = safe_cast<UInt32>(value);
+			}
+			else if (type == Int32::typeid)
+			{
+				term.type = TermTypeN::TermInt32;
+				term.column = (unsigned __int32*)start + index;
+				term.value.integer = (unsigned __int32)safe_cast<Int32>(value);
+			}
+			else if (type == UInt64::typeid)
+			{
+				term.type = TermTypeN::TermUInt64;
+				term.column = (unsigned __int64*)start + index;
+				term.value.integer = safe_cast<UInt64>(value);
+			}
+			else if (type == Int64::typeid)
+			{
+				term.type = TermTypeN::TermInt64;
+				term.column = (unsigned __int64*)start + index;
+				term.value.integer = (unsigned __int64)safe_cast<Int64>(value);
+			}
+			else if (type == Single::typeid)
+			{
+				term.type = TermTypeN::TermSingle;
+				term.column = (float*)start + index;
+				term.value.single = safe_cast<Single>(value);
+			}
+			else if (type == Double::typeid)
+			{
+				term.type = TermTypeN::TermDouble;
+				term.column = (double*)start + index;
+				term.value.real = safe_cast<Double>(value);
+			}
+			else
+			{
+				throw gcnew ArgumentException(String::Format("Native Where doesn't support {0} columns.", type->Name), "columns");
+			}
+		}
+
+		void Comparer::WhereAnd(array<Array^>^ columns, array<Int32>^ indices, array<Byte>^ compareOperators, array<Object^>^ values, Int32 termCount, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (termCount <= 0 || termCount > WhereAndTermLimit) throw gcnew ArgumentOutOfRangeException("termCount");
+			if (columns->Length < termCount || indices->Length < termCount || compareOperators->Length < termCount || values->Length < termCount) throw gcnew ArgumentException("columns, indices, compareOperators, and values must have termCount entries.");
+			if (length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			// Pin every column for the duration of the pass
+			WhereTermN terms[WhereAndTermLimit];
+			array<GCHandle>^ handles = gcnew array<GCHandle>(termCount);
+			Int64 bytes = 0;
+
+			try
+			{
+				for (int t = 0; t < termCount; ++t)
+				{
+					if (indices[t] < 0 || indices[t] + length > columns[t]->Length) throw gcnew IndexOutOfRangeException("indices");
+					if (compareOperators[t] > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperators");
+
+					handles[t] = GCHandle::Alloc(columns[t], GCHandleType::Pinned);
+					BuildTerm(columns[t], values[t], compareOperators[t], handles[t].AddrOfPinnedObject().ToPointer(), indices[t], terms[t]);
+					if (columns[t]->Length > 0) bytes += (Int64)length * (Buffer::ByteLength(columns[t]) / columns[t]->Length);
+				}
+
+				COUNT_KERNEL(WhereAnd, (Int64)length * termCount, bytes);
+
+				pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+				WhereAndN(terms, termCount, length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+			}
+			finally
+			{
+				for (int t = 0; t < termCount; ++t)
+				{
+					if (handles[t].IsAllocated) handles[t].Free();
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,289 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <nmmintrin.h>
+#include "Operator.h"
+#include "ComparerSingle.cpp"
+#include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+
+#pragma unmanaged
+
+// Floating point comparisons can't run the opposite operator and negate the result, because every
+// ordered comparison with NaN is false. Each operator uses the ordered (false for NaN) predicate except
+// NotEqual, which is unordered (true for NaN), to match the C# operators used by the managed comparers.
+
+template<CompareOperatorN cOp>
+static __forceinline __m256 CompareN(__m256 left, __m256 right)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		return _mm256_cmp_ps(left, right, _CMP_EQ_OQ);
+	case CompareOperatorN::NotEqual:
+		return _mm256_cmp_ps(left, right, _CMP_NEQ_UQ);
+	case CompareOperatorN::LessThan:
+		return _mm256_cmp_ps(left, right, _CMP_LT_OQ);
+	case CompareOperatorN::LessThanOrEqual:
+		return _mm256_cmp_ps(left, right, _CMP_LE_OQ);
+	case CompareOperatorN::GreaterThan:
+		return _mm256_cmp_ps(left, right, _CMP_GT_OQ);
+	default:
+		return _mm256_cmp_ps(left, right, _CMP_GE_OQ);
+	}
+}
+
+template<CompareOperatorN cOp>
+static __forceinline __m256d CompareN(__m256d left, __m256d right)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		return _mm256_cmp_pd(left, right, _CMP_EQ_OQ);
+	case CompareOperatorN::NotEqual:
+		return _mm256_cmp_pd(left, right, _CMP_NEQ_UQ);
+	case CompareOperatorN::LessThan:
+		return _mm256_cmp_pd(left, right, _CMP_LT_OQ);
+	case CompareOperatorN::LessThanOrEqual:
+		return _mm256_cmp_pd(left, right, _CMP_LE_OQ);
+	case CompareOperatorN::GreaterThan:
+		return _mm256_cmp_pd(left, right, _CMP_GT_OQ);
+	default:
+		return _mm256_cmp_pd(left, right, _CMP_GE_OQ);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, float* set, int length, float value, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load copies of the value to compare against
+	__m256 blockOfValue = _mm256_set1_ps(value);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare eight sets of eight floats, converting each mask into one bit per row
+		for (int j = 0; j < 8; ++j)
+		{
+			__m256 block = _mm256_loadu_ps(&set[i + (j << 3)]);
+			result |= ((unsigned __int64)_mm256_movemask_ps(CompareN<cOp>(block, blockOfValue))) << (j << 3);
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		WhereSingle<cOp, float>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, float* left, int length, float* right, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare eight sets of eight floats, converting each mask into one bit per row
+		for (int j = 0; j < 8; ++j)
+		{
+			__m256 leftBlock = _mm256_loadu_ps(&left[i + (j << 3)]);
+			__m256 rightBlock = _mm256_loadu_ps(&right[i + (j << 3)]);
+			result |= ((unsigned __int64)_mm256_movemask_ps(CompareN<cOp>(leftBlock, rightBlock))) << (j << 3);
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		WhereSingle<cOp, float>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, double* set, int length, double value, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Load copies of the value to compare against
+	__m256d blockOfValue = _mm256_set1_pd(value);
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare sixteen sets of four doubles, converting each mask into one bit per row
+		for (int j = 0; j < 16; ++j)
+		{
+			__m256d block = _mm256_loadu_pd(&set[i + (j << 2)]);
+			result |= ((unsigned __int64)_mm256_movemask_pd(CompareN<cOp>(block, blockOfValue))) << (j << 2);
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		WhereSingle<cOp, double>(&set[i], length - i, value, bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<CompareOperatorN cOp>
+static void WhereN(BooleanOperatorN bOp, double* left, int length, double* right, unsigned __int64* matchVector, int bitOffset)
+{
+	int i = 0;
+	unsigned __int64 result;
+
+	// Compare 64-value blocks and generate a 64-bit result while there's enough data
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		result = 0;
+
+		// Compare sixteen sets of four doubles, converting each mask into one bit per row
+		for (int j = 0; j < 16; ++j)
+		{
+			__m256d leftBlock = _mm256_loadu_pd(&left[i + (j << 2)]);
+			__m256d rightBlock = _mm256_loadu_pd(&right[i + (j << 2)]);
+			result |= ((unsigned __int64)_mm256_movemask_pd(CompareN<cOp>(leftBlock, rightBlock))) << (j << 2);
+		}
+
+		// Merge the result with the existing bit vector bits based on the boolean operator requested
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	// Match remaining values individually
+	if (length & 63)
+	{
+		WhereSingle<cOp, double>(&left[i], length - i, &right[i], bOp, &matchVector[i >> 6], bitOffset);
+	}
+}
+
+template<typename T, typename U>
+static void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, T* left, int length, U right, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		WhereN<CompareOperatorN::Equal>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::NotEqual:
+		WhereN<CompareOperatorN::NotEqual>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThan:
+		WhereN<CompareOperatorN::LessThan>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		WhereN<CompareOperatorN::LessThanOrEqual>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThan:
+		WhereN<CompareOperatorN::GreaterThan>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		WhereN<CompareOperatorN::GreaterThanOrEqual>(bOp, left, length, right, matchVector, bitOffset);
+		break;
+	}
+}
+
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, float* set, int length, float value, unsigned __int64* matchVector, int bitOffset)
+{
+	WhereN<float, float>(cOp, bOp, set, length, value, matchVector, bitOffset);
+}
+
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, double* set, int length, double value, unsigned __int64* matchVector, int bitOffset)
+{
+	WhereN<double, double>(cOp, bOp, set, length, value, matchVector, bitOffset);
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void Comparer::Where(array<Single>^ left, Int32 index, Int32 length, Byte cOp, Single right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 4);
+
+			pin_ptr<Single> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN<float, float>((CompareOperatorN)cOp, (BooleanOperatorN)bOp, pLeft, length, right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Single>^ left, Int32 leftIndex, Byte cOp, array<Single>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<Single> pLeft = &left[leftIndex];
+			pin_ptr<Single> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN<float, float*>((CompareOperatorN)cOp, (BooleanOperatorN)bOp, pLeft, length, pRight, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Double>^ left, Int32 index, Int32 length, Byte cOp, Double right, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException();
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException();
+
+			COUNT_KERNEL(Where, length, (Int64)length * 8);
+
+			pin_ptr<Double> pLeft = &left[index];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN<double, double>((CompareOperatorN)cOp, (BooleanOperatorN)bOp, pLeft, length, right, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::Where(array<Double>^ left, Int32 leftIndex, Byte cOp, array<Double>^ right, Int32 rightIndex, Int32 length, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (leftIndex < 0 || rightIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (leftIndex + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (rightIndex + length > right->Length) throw gcnew IndexOutOfRangeException("right");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+
+			COUNT_KERNEL(Where, length, (Int64)length * 16);
+
+			pin_ptr<Double> pLeft = &left[leftIndex];
+			pin_ptr<Double> pRight = &right[rightIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereN<double, double*>((CompareOperatorN)cOp, (BooleanOperatorN)bOp, pLeft, length, pRight, pVector, vectorIndex & 63);
+		}
+	}
+}
@@ -0,0 +1,256 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <string.h>
+#include "Operator.h"
+#include "Comparer.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
+
+#pragma unmanaged
+
+// Words in a membership bitmap covering every byte and every ushort value
+const int ByteSetWords = 4;
+const int UshortSetWords = 1024;
+
+static __forceinline unsigned __int64 IsMemberN(unsigned __int64* set, unsigned int value)
+{
+	return (set[value >> 6] >> (value & 63)) & 0x1;
+}
+
+// Match the rows in [i, length) one at a time, merging them as one final partial block
+template<typename T>
+static void WhereInRemainderN(T* left, int i, int length, unsigned __int64* set, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	if (i >= length) return;
+
+	unsigned __int64 result = 0;
+	for (int j = i; j < length; ++j)
+	{
+		result |= IsMemberN(set, left[j]) << (j - i);
+	}
+
+	MergeN(bOp, result, (0x1ULL << (length - i)) - 1, bitOffset, &matchVector[i >> 6]);
+}
+
+// Byte membership is looked up a nibble at a time: pshufb on the low nibble picks the row of the 16x16 bitmap
+// for that low nibble (bits for high nibbles 0-7 from one table, 8-15 from the other), and a second pshufb on the
+// high nibble picks the bit within the row to test.
+struct ByteInTablesN
+{
+	__m128i low;
+	__m128i high;
+};
+
+static ByteInTablesN BuildByteInTablesN(unsigned __int64* set)
+{
+	__declspec(align(16)) unsigned __int8 low[16];
+	__declspec(align(16)) unsigned __int8 high[16];
+
+	for (int lowNibble = 0; lowNibble < 16; ++lowNibble)
+	{
+		unsigned int lowRow = 0;
+		unsigned int highRow = 0;
+
+		for (int highNibble = 0; highNibble < 8; ++highNibble)
+		{
+			lowRow |= (unsigned int)IsMemberN(set, (highNibble << 4) | lowNibble) << highNibble;
+			highRow |= (unsigned int)IsMemberN(set, ((highNibble + 8) << 4) | lowNibble) << highNibble;
+		}
+
+		low[lowNibble] = (unsigned __int8)lowRow;
+		high[lowNibble] = (unsigned __int8)highRow;
+	}
+
+	ByteInTablesN tables;
+	tables.low = _mm_load_si128((__m128i*)low);
+	tables.high = _mm_load_si128((__m128i*)high);
+	return tables;
+}
+
+// AVX-512BW: look up 64 bytes at a time, testing the bits straight into a mask register
+static void WhereInAvx512N(unsigned __int8* left, int length, ByteInTablesN& tables, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	__m512i low = _mm512_broadcast_i32x4(tables.low);
+	__m512i high = _mm512_broadcast_i32x4(tables.high);
+	__m512i bitForNibble = _mm512_broadcast_i32x4(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+	__m512i nibbleMask = _mm512_set1_epi8(0x0F);
+	__m512i seven = _mm512_set1_epi8(7);
+
+	for (int i = 0; i < length; i += 64)
+	{
+		unsigned __int64 valid = (length - i >= 64 ? ~0x0ULL : (0x1ULL << (length - i)) - 1);
+		__m512i block = _mm512_maskz_loadu_epi8(valid, &left[i]);
+
+		__m512i lowNibbles = _mm512_and_si512(block, nibbleMask);
+		__m512i highNibbles = _mm512_and_si512(_mm512_srli_epi16(block, 4), nibbleMask);
+
+		__m512i row = _mm512_mask_blend_epi8(_mm512_cmpgt_epi8_mask(highNibbles, seven), _mm512_shuffle_epi8(low, lowNibbles), _mm512_shuffle_epi8(high, lowNibbles));
+		unsigned __int64 result = _mm512_mask_test_epi8_mask(valid, row, _mm512_shuffle_epi8(bitForNibble, highNibbles));
+
+		MergeN(bOp, result, valid, bitOffset, &matchVector[i >> 6]);
+	}
+}
+
+static void WhereInN(unsigned __int8* left, int length, unsigned __int64* set, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	ByteInTablesN tables = BuildByteInTablesN(set);
+
+	if (SupportedN.Avx512Bw)
+	{
+		WhereInAvx512N(left, length, tables, bOp, matchVector, bitOffset);
+		return;
+	}
+
+	__m256i low = _mm256_broadcastsi128_si256(tables.low);
+	__m256i high = _mm256_broadcastsi128_si256(tables.high);
+	__m256i bitForNibble = _mm256_broadcastsi128_si256(_mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128));
+	__m256i nibbleMask = _mm256_set1_epi8(0x0F);
+	__m256i seven = _mm256_set1_epi8(7);
+
+	int i = 0;
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		unsigned __int64 result = 0;
+
+		for (int half = 0; half < 2; ++half)
+		{
+			__m256i block = _mm256_loadu_si256((__m256i*)(&left[i + 32 * half]));
+
+			__m256i lowNibbles = _mm256_and_si256(block, nibbleMask);
+			__m256i highNibbles = _mm256_and_si256(_mm256_srli_epi16(block, 4), nibbleMask);
+
+			// Get the row for the low nibble from the table for the high nibble, then test the high nibble bit
+			__m256i row = _mm256_blendv_epi8(_mm256_shuffle_epi8(low, lowNibbles), _mm256_shuffle_epi8(high, lowNibbles), _mm256_cmpgt_epi8(highNibbles, seven));
+			__m256i bit = _mm256_shuffle_epi8(bitForNibble, highNibbles);
+			__m256i matchMask = _mm256_cmpeq_epi8(_mm256_and_si256(row, bit), bit);
+
+			result |= (unsigned __int64)(unsigned int)_mm256_movemask_epi8(matchMask) << (32 * half);
+		}
+
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	WhereInRemainderN(left, i, length, set, bOp, matchVector, bitOffset);
+}
+
+// AVX-512F: gather the bitmap word for 16 values at a time and test each value's bit into a mask register
+static void WhereInAvx512N(unsigned __int16* left, int length, unsigned __int64* set, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	__m512i thirtyOne = _mm512_set1_epi32(31);
+	__m512i one = _mm512_set1_epi32(1);
+
+	int i = 0;
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		unsigned __int64 result = 0;
+
+		for (int k = 0; k < 64; k += 16)
+		{
+			__m512i values = _mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i*)(&left[i + k])));
+			__m512i words = _mm512_i32gather_epi32(_mm512_srli_epi32(values, 5), set, 4);
+			__mmask16 matches = _mm512_test_epi32_mask(_mm512_srlv_epi32(words, _mm512_and_si512(values, thirtyOne)), one);
+
+			result |= (unsigned __int64)matches << k;
+		}
+
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	WhereInRemainderN(left, i, length, set, bOp, matchVector, bitOffset);
+}
+
+// AVX2: gather the 32-bit bitmap word for eight values at a time, and shift each value's bit up to the sign bit to collect it
+static void WhereInN(unsigned __int16* left, int length, unsigned __int64* set, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	if (SupportedN.Avx512F)
+	{
+		WhereInAvx512N(left, length, set, bOp, matchVector, bitOffset);
+		return;
+	}
+
+	__m256i thirtyOne = _mm256_set1_epi32(31);
+
+	int i = 0;
+	int blockLength = length & ~63;
+	for (; i < blockLength; i += 64)
+	{
+		unsigned __int64 result = 0;
+
+		for (int k = 0; k < 64; k += 8)
+		{
+			__m256i values = _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)(&left[i + k])));
+			__m256i words = _mm256_i32gather_epi32((const int*)set, _mm256_srli_epi32(values, 5), 4);
+			__m256i bits = _mm256_sllv_epi32(words, _mm256_sub_epi32(thirtyOne, _mm256_and_si256(values, thirtyOne)));
+
+			result |= (unsigned __int64)(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(bits)) << k;
+		}
+
+		MergeN(bOp, result, ~0x0ULL, bitOffset, &matchVector[i >> 6]);
+	}
+
+	WhereInRemainderN(left, i, length, set, bOp, matchVector, bitOffset);
+}
+
+// Lookups read the whole bitmap, so shorter sets are copied into one which covers every value
+template<typename T, int setWords>
+static void WhereInN(T* left, int length, unsigned __int64* set, int setLength, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	if (setLength >= setWords)
+	{
+		WhereInN(left, length, set, bOp, matchVector, bitOffset);
+		return;
+	}
+
+	unsigned __int64 fullSet[setWords];
+	memset(fullSet, 0, sizeof(fullSet));
+	memcpy(fullSet, set, setLength * sizeof(unsigned __int64));
+	WhereInN(left, length, fullSet, bOp, matchVector, bitOffset);
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void Comparer::WhereIn(array<Byte>^ left, Int32 index, Int32 length, array<UInt64>^ set, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (set->Length == 0) throw gcnew ArgumentException("set must have at least one word.", "set");
+			if (length == 0) return;
+
+			COUNT_KERNEL(WhereIn, length, length);
+
+			pin_ptr<Byte> pLeft = &left[index];
+			pin_ptr<UInt64> pSet = &set[0];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereInN<unsigned __int8, ByteSetWords>(pLeft, length, pSet, set->Length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+		}
+
+		void Comparer::WhereIn(array<UInt16>^ left, Int32 index, Int32 length, array<UInt64>^ set, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > left->Length) throw gcnew IndexOutOfRangeException("left");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (set->Length == 0) throw gcnew ArgumentException("set must have at least one word.", "set");
+			if (length == 0) return;
+
+			COUNT_KERNEL(WhereIn, length, (Int64)length * 2);
+
+			pin_ptr<UInt16> pLeft = &left[index];
+			pin_ptr<UInt64> pSet = &set[0];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			WhereInN<unsigned __int16, UshortSetWords>(pLeft, length, pSet, set->Length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+		}
+	}
+}
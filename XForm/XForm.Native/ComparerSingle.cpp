@@ -6,11 +6,12 @@
 #include <nmmintrin.h>
 #include "Operator.h"
 #include "Comparer.h"
+#include "WhereN.h"
 
 #pragma unmanaged
 
 template<CompareOperatorN cOp, typename T>
-static void WhereSingle(T* set, int length, T value, BooleanOperatorN bOp, unsigned __int64* matchVector)
+static void WhereSingle(T* set, int length, T value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
 {
 	int vectorLength = (length + 63) >> 6;
 	for (int vectorIndex = 0; vectorIndex < vectorLength; ++vectorIndex)
@@ -46,20 +47,14 @@ static void WhereSingle(T* set, int length, T value, BooleanOperatorN bOp, unsig
 			}
 		}
 
-		switch (bOp)
-		{
-		case BooleanOperatorN::And:
-			matchVector[vectorIndex] &= result;
-			break;
-		case BooleanOperatorN::Or:
-			matchVector[vectorIndex] |= result;
-			break;
-		}
+		// Merge only the bits for rows in range, so neighboring rows in the vector are left unchanged
+		unsigned __int64 valid = (end - (vectorIndex << 6) == 64 ? ~0x0ULL : (0x1ULL << (end & 63)) - 1);
+		MergeN(bOp, result, valid, bitOffset, &matchVector[vectorIndex]);
 	}
 }
 
 template<CompareOperatorN cOp, typename T>
-static void WhereSingle(T* left, int length, T* right, BooleanOperatorN bOp, unsigned __int64* matchVector)
+static void WhereSingle(T* left, int length, T* right, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
 {
 	int vectorLength = (length + 63) >> 6;
 	for (int vectorIndex = 0; vectorIndex < vectorLength; ++vectorIndex)
@@ -95,15 +90,9 @@ static void WhereSingle(T* left, int length, T* right, BooleanOperatorN bOp, uns
 			}
 		}
 
-		switch (bOp)
-		{
-		case BooleanOperatorN::And:
-			matchVector[vectorIndex] &= result;
-			break;
-		case BooleanOperatorN::Or:
-			matchVector[vectorIndex] |= result;
-			break;
-		}
+		// Merge only the bits for rows in range, so neighboring rows in the vector are left unchanged
+		unsigned __int64 valid = (end - (vectorIndex << 6) == 64 ? ~0x0ULL : (0x1ULL << (end & 63)) - 1);
+		MergeN(bOp, result, valid, bitOffset, &matchVector[vectorIndex]);
 	}
 }
 
@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include "CpuFeatures.h"
+
+// This file is built without /arch:AVX2, so detection runs on any x64 CPU.
+#pragma unmanaged
+
+static CpuFeaturesN DetectN()
+{
+	CpuFeaturesN features = { 0 };
+	int cpuinfo[4];
+
+	__cpuid(cpuinfo, 0);
+	int maxLeaf = cpuinfo[0];
+
+	// "AuthenticAMD" or "HygonGenuine" (EBX, EDX, ECX)
+	bool isAmd = (cpuinfo[1] == 0x68747541 && cpuinfo[3] == 0x69746E65 && cpuinfo[2] == 0x444D4163) || (cpuinfo[1] == 0x6F677948 && cpuinfo[3] == 0x6E65476E && cpuinfo[2] == 0x656E6975);
+
+	__cpuid(cpuinfo, 1);
+	int ecx1 = cpuinfo[2];
+
+	// Family is the base family plus the extended family when the base family is 0xF
+	int family = (cpuinfo[0] >> 8) & 0xF;
+	if (family == 0xF) family += (cpuinfo[0] >> 20) & 0xFF;
+	features.Sse42 = (ecx1 & (0x1 << 20)) != 0;
+	features.Popcnt = (ecx1 & (0x1 << 23)) != 0;
+
+	// AVX state must be enabled by the OS: OSXSAVE, then XCR0 bits for XMM and YMM (and opmask, ZMM_Hi256, Hi16_ZMM for AVX-512)
+	bool osAvx = false;
+	bool osAvx512 = false;
+	if ((ecx1 & (0x1 << 27)) != 0 && (ecx1 & (0x1 << 28)) != 0)
+	{
+		unsigned __int64 xcr0 = _xgetbv(0);
+		osAvx = (xcr0 & 0x6) == 0x6;
+		osAvx512 = (xcr0 & 0xE6) == 0xE6;
+	}
+
+	if (maxLeaf >= 7)
+	{
+		__cpuidex(cpuinfo, 7, 0);
+		int ebx7 = cpuinfo[1];
+		int ecx7 = cpuinfo[2];
+
+		features.Bmi1 = (ebx7 & (0x1 << 3)) != 0;
+		features.Bmi2 = (ebx7 & (0x1 << 8)) != 0;
+
+		// PEXT and PDEP are microcoded (tens to hundreds of cycles, depending on the mask) on AMD before Zen 3 (family 19h)
+		features.FastPext = features.Bmi2 && !(isAmd && family < 0x19);
+		features.Avx2 = osAvx && (ebx7 & (0x1 << 5)) != 0;
+		features.Avx512F = osAvx512 && (ebx7 & (0x1 << 16)) != 0;
+		features.Avx512Dq = features.Avx512F && (ebx7 & (0x1 << 17)) != 0;
+		features.Avx512Bw = features.Avx512F && (ebx7 & (0x1 << 30)) != 0;
+		features.Avx512Vpopcntdq = features.Avx512F && (ecx7 & (0x1 << 14)) != 0;
+	}
+
+	return features;
+}
+
+extern const CpuFeaturesN SupportedN = DetectN();
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		Boolean CpuFeatures::IsSupported()
+		{
+			return SupportedN.Avx2 && SupportedN.Bmi1 && SupportedN.Bmi2 && SupportedN.Popcnt;
+		}
+
+		String^ CpuFeatures::Describe()
+		{
+			String^ result = String::Empty;
+			if (SupportedN.Popcnt) result += "POPCNT ";
+			if (SupportedN.Sse42) result += "SSE4.2 ";
+			if (SupportedN.Avx2) result += "AVX2 ";
+			if (SupportedN.Bmi1) result += "BMI1 ";
+			if (SupportedN.Bmi2) result += "BMI2 ";
+			if (SupportedN.Bmi2 && !SupportedN.FastPext) result += "(slow PEXT) ";
+			if (SupportedN.Avx512F) result += "AVX-512F ";
+			if (SupportedN.Avx512Dq) result += "AVX-512DQ ";
+			if (SupportedN.Avx512Bw) result += "AVX-512BW ";
+			if (SupportedN.Avx512Vpopcntdq) result += "AVX-512VPOPCNTDQ ";
+			return result->TrimEnd();
+		}
+	}
+}
@@ -0,0 +1,39 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+// Instruction sets the CPU and OS support, detected once when XForm.Native loads.
+// Kernels check these to pick a variant; XForm.Native is built for AVX2, so Avx2, Bmi1, Bmi2, and Popcnt are required to run at all.
+struct CpuFeaturesN
+{
+	bool Popcnt;
+	bool Sse42;
+	bool Avx2;
+	bool Bmi1;
+	bool Bmi2;
+	bool FastPext;
+	bool Avx512F;
+	bool Avx512Dq;
+	bool Avx512Bw;
+	bool Avx512Vpopcntdq;
+};
+
+extern const CpuFeaturesN SupportedN;
+
+namespace XForm
+{
+	namespace Native
+	{
+		public ref class CpuFeatures
+		{
+		public:
+			// Return whether this CPU can run XForm.Native (AVX2, BMI1, BMI2, and POPCNT with OS support for AVX state)
+			static Boolean IsSupported();
+
+			// Return the instruction sets kernels will use, such as "SSE4.2 AVX2 BMI2 AVX-512BW", for diagnostics
+			static String^ Describe();
+		};
+	}
+}
@@ -0,0 +1,343 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <string.h>
+#include "Group.h"
+#include "KernelCounters.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+// Groups with up to this many buckets are accumulated in PartialHistograms copies, with rows rotating between them
+const int PartialHistograms = 4;
+const int PartialHistogramBucketLimit = 256;
+
+// Accumulate one row into a bucket of one of the histograms. Keys past the bucket count are flagged rather than written.
+template<typename K, typename S>
+struct CountRowsN
+{
+	K* keys;
+	S* histograms;
+	int stride;
+	int partialMask;
+	int bucketCount;
+	bool outOfRange;
+
+	__forceinline void Add(int partial, int row)
+	{
+		unsigned int key = keys[row];
+		if (key < (unsigned int)bucketCount) histograms[(partial & partialMask) * stride + key]++;
+		else outOfRange = true;
+	}
+};
+
+template<typename K, typename V, typename S>
+struct SumRowsN
+{
+	K* keys;
+	V* values;
+	S* histograms;
+	int stride;
+	int partialMask;
+	int bucketCount;
+	bool outOfRange;
+
+	__forceinline void Add(int partial, int row)
+	{
+		unsigned int key = keys[row];
+		if (key < (unsigned int)bucketCount) histograms[(partial & partialMask) * stride + key] += (S)values[row];
+		else outOfRange = true;
+	}
+};
+
+// Add rows [0, length), or only those set in vector, or rows indices[0, length) (checked against rowLimit)
+template<typename Rows>
+static void AddRowsN(Rows& rows, int length, unsigned __int64* vector, int* indices, int rowLimit)
+{
+	if (indices != nullptr)
+	{
+		for (int i = 0; i < length; ++i)
+		{
+			int row = indices[i];
+			if ((unsigned int)row < (unsigned int)rowLimit) rows.Add(i, row);
+			else rows.outOfRange = true;
+		}
+	}
+	else if (vector == nullptr)
+	{
+		int i = 0;
+		for (; i + 4 <= length; i += 4)
+		{
+			rows.Add(0, i);
+			rows.Add(1, i + 1);
+			rows.Add(2, i + 2);
+			rows.Add(3, i + 3);
+		}
+
+		for (; i < length; ++i)
+		{
+			rows.Add(i, i);
+		}
+	}
+	else
+	{
+		int partial = 0;
+
+		for (int base = 0; base < length; base += 64)
+		{
+			unsigned __int64 block = vector[base >> 6];
+			if (length - base < 64) block &= (0x1ULL << (length - base)) - 1;
+
+			if (block == ~0x0ULL)
+			{
+				for (int i = 0; i < 64; i += 4)
+				{
+					rows.Add(0, base + i);
+					rows.Add(1, base + i + 1);
+					rows.Add(2, base + i + 2);
+					rows.Add(3, base + i + 3);
+				}
+
+				continue;
+			}
+
+			while (block != 0)
+			{
+				unsigned long bit;
+				_BitScanForward64(&bit, block);
+				rows.Add(partial++, base + (int)bit);
+				block &= block - 1;
+			}
+		}
+	}
+}
+
+// Run rows through partial histograms (for few buckets) or straight into buckets, returning false if any key or index was out of range
+template<typename Rows, typename S>
+static bool AccumulateN(Rows& rows, S* buckets, int bucketCount, int length, unsigned __int64* vector, int* indices, int rowLimit)
+{
+	S partials[PartialHistograms * PartialHistogramBucketLimit];
+	bool usePartials = (bucketCount <= PartialHistogramBucketLimit);
+
+	rows.bucketCount = bucketCount;
+	rows.outOfRange = false;
+
+	if (usePartials)
+	{
+		memset(partials, 0, PartialHistograms * bucketCount * sizeof(S));
+		rows.histograms = partials;
+		rows.stride = bucketCount;
+		rows.partialMask = PartialHistograms - 1;
+	}
+	else
+	{
+		rows.histograms = buckets;
+		rows.stride = 0;
+		rows.partialMask = 0;
+	}
+
+	AddRowsN(rows, length, vector, indices, rowLimit);
+	if (rows.outOfRange) return false;
+
+	if (usePartials)
+	{
+		for (int key = 0; key < bucketCount; ++key)
+		{
+			buckets[key] += partials[key] + partials[bucketCount + key] + partials[2 * bucketCount + key] + partials[3 * bucketCount + key];
+		}
+	}
+
+	return true;
+}
+
+template<typename K>
+static bool GroupCountN(K* keys, int length, unsigned __int64* vector, int* indices, int rowLimit, int* counts, int bucketCount)
+{
+	CountRowsN<K, int> rows;
+	rows.keys = keys;
+	return AccumulateN(rows, counts, bucketCount, length, vector, indices, rowLimit);
+}
+
+template<typename K, typename V, typename S>
+static bool GroupSumN(K* keys, V* values, int length, unsigned __int64* vector, int* indices, int rowLimit, S* sums, int bucketCount)
+{
+	SumRowsN<K, V, S> rows;
+	rows.keys = keys;
+	rows.values = values;
+	return AccumulateN(rows, sums, bucketCount, length, vector, indices, rowLimit);
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		static void CheckKeys(Array^ keys)
+		{
+			Type^ type = keys->GetType()->GetElementType();
+			if (type != Byte::typeid && type != UInt16::typeid) throw gcnew ArgumentException(String::Format("GroupN doesn't support {0} keys.", type->Name), "keys");
+		}
+
+		static void CheckVector(array<UInt64>^ vector, Int32 length)
+		{
+			if (vector != nullptr && vector->Length < ((__int64)length + 63) >> 6) throw gcnew IndexOutOfRangeException("vector");
+		}
+
+		// Address of array[index] in a pinned array of a primitive type
+		static Byte* ElementAddress(GCHandle handle, Array^ array, Int32 index)
+		{
+			Byte* start = (Byte*)handle.AddrOfPinnedObject().ToPointer();
+			return (array->Length == 0 ? start : start + (__int64)index * (Buffer::ByteLength(array) / array->Length));
+		}
+
+		static bool CountKeys(Array^ keys, Byte* pKeys, Int32 length, unsigned __int64* pVector, int* pIndices, Int32 rowLimit, array<Int32>^ counts)
+		{
+			pin_ptr<Int32> pCounts = nullptr;
+			if (counts->Length > 0) pCounts = &counts[0];
+
+			if (keys->GetType()->GetElementType() == Byte::typeid) return GroupCountN((unsigned __int8*)pKeys, length, pVector, pIndices, rowLimit, (int*)pCounts, counts->Length);
+			return GroupCountN((unsigned __int16*)pKeys, length, pVector, pIndices, rowLimit, (int*)pCounts, counts->Length);
+		}
+
+		template<typename K>
+		static bool SumKeys(K* pKeys, Array^ values, Byte* pValues, Int32 length, unsigned __int64* pVector, int* pIndices, Int32 rowLimit, Array^ sums, void* pSums)
+		{
+			Type^ valueType = values->GetType()->GetElementType();
+			Type^ sumType = sums->GetType()->GetElementType();
+
+			if (valueType == Int32::typeid && sumType == Int64::typeid) return GroupSumN(pKeys, (int*)pValues, length, pVector, pIndices, rowLimit, (__int64*)pSums, sums->Length);
+			if (valueType == Int64::typeid && sumType == Int64::typeid) return GroupSumN(pKeys, (__int64*)pValues, length, pVector, pIndices, rowLimit, (__int64*)pSums, sums->Length);
+			if (valueType == Double::typeid && sumType == Double::typeid) return GroupSumN(pKeys, (double*)pValues, length, pVector, pIndices, rowLimit, (double*)pSums, sums->Length);
+
+			throw gcnew ArgumentException(String::Format("GroupN can't sum {0} values into {1} sums.", valueType->Name, sumType->Name), "sums");
+		}
+
+		static bool SumKeys(Array^ keys, Byte* pKeys, Array^ values, Byte* pValues, Int32 length, unsigned __int64* pVector, int* pIndices, Int32 rowLimit, Array^ sums)
+		{
+			GCHandle sumsHandle = GCHandle::Alloc(sums, GCHandleType::Pinned);
+
+			try
+			{
+				void* pSums = sumsHandle.AddrOfPinnedObject().ToPointer();
+				if (keys->GetType()->GetElementType() == Byte::typeid) return SumKeys((unsigned __int8*)pKeys, values, pValues, length, pVector, pIndices, rowLimit, sums, pSums);
+				return SumKeys((unsigned __int16*)pKeys, values, pValues, length, pVector, pIndices, rowLimit, sums, pSums);
+			}
+			finally
+			{
+				sumsHandle.Free();
+			}
+		}
+
+		void GroupN::Count(Array^ keys, Int32 index, Int32 length, array<UInt64>^ vector, array<Int32>^ counts)
+		{
+			CheckKeys(keys);
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > keys->Length) throw gcnew IndexOutOfRangeException("keys");
+			CheckVector(vector, length);
+			if (length == 0) return;
+
+			COUNT_KERNEL(GroupCount, length, (Int64)length * (Buffer::ByteLength(keys) / keys->Length));
+
+			GCHandle keysHandle = GCHandle::Alloc(keys, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<UInt64> pVector = nullptr;
+				if (vector != nullptr) pVector = &vector[0];
+				Byte* pKeys = ElementAddress(keysHandle, keys, index);
+
+				if (!CountKeys(keys, pKeys, length, pVector, nullptr, length, counts)) throw gcnew IndexOutOfRangeException("counts");
+			}
+			finally
+			{
+				keysHandle.Free();
+			}
+		}
+
+		void GroupN::Count(Array^ keys, array<Int32>^ indices, Int32 index, Int32 length, array<Int32>^ counts)
+		{
+			CheckKeys(keys);
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > indices->Length) throw gcnew IndexOutOfRangeException("indices");
+			if (length == 0) return;
+
+			COUNT_KERNEL(GroupCount, length, (Int64)length * 4);
+
+			GCHandle keysHandle = GCHandle::Alloc(keys, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<Int32> pIndices = &indices[index];
+				Byte* pKeys = ElementAddress(keysHandle, keys, 0);
+
+				if (!CountKeys(keys, pKeys, length, nullptr, (int*)pIndices, keys->Length, counts)) throw gcnew IndexOutOfRangeException("indices or counts");
+			}
+			finally
+			{
+				keysHandle.Free();
+			}
+		}
+
+		void GroupN::Sum(Array^ keys, Int32 keyIndex, Array^ values, Int32 valueIndex, Int32 length, array<UInt64>^ vector, Array^ sums)
+		{
+			CheckKeys(keys);
+			if (keyIndex < 0 || valueIndex < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (keyIndex + length > keys->Length) throw gcnew IndexOutOfRangeException("keys");
+			if (valueIndex + length > values->Length) throw gcnew IndexOutOfRangeException("values");
+			CheckVector(vector, length);
+			if (length == 0) return;
+
+			COUNT_KERNEL(GroupSum, length, (Int64)length * (Buffer::ByteLength(keys) / keys->Length + Buffer::ByteLength(values) / values->Length));
+
+			GCHandle keysHandle = GCHandle::Alloc(keys, GCHandleType::Pinned);
+			GCHandle valuesHandle = GCHandle::Alloc(values, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<UInt64> pVector = nullptr;
+				if (vector != nullptr) pVector = &vector[0];
+				Byte* pKeys = ElementAddress(keysHandle, keys, keyIndex);
+				Byte* pValues = ElementAddress(valuesHandle, values, valueIndex);
+
+				if (!SumKeys(keys, pKeys, values, pValues, length, pVector, nullptr, length, sums)) throw gcnew IndexOutOfRangeException("sums");
+			}
+			finally
+			{
+				keysHandle.Free();
+				valuesHandle.Free();
+			}
+		}
+
+		void GroupN::Sum(Array^ keys, Array^ values, array<Int32>^ indices, Int32 index, Int32 length, Array^ sums)
+		{
+			CheckKeys(keys);
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > indices->Length) throw gcnew IndexOutOfRangeException("indices");
+			if (length == 0) return;
+
+			COUNT_KERNEL(GroupSum, length, (Int64)length * 4);
+
+			GCHandle keysHandle = GCHandle::Alloc(keys, GCHandleType::Pinned);
+			GCHandle valuesHandle = GCHandle::Alloc(values, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<Int32> pIndices = &indices[index];
+				Byte* pKeys = ElementAddress(keysHandle, keys, 0);
+				Byte* pValues = ElementAddress(valuesHandle, values, 0);
+				int rowLimit = (keys->Length < values->Length ? keys->Length : values->Length);
+
+				if (!SumKeys(keys, pKeys, values, pValues, length, nullptr, (int*)pIndices, rowLimit, sums)) throw gcnew IndexOutOfRangeException("indices or sums");
+			}
+			finally
+			{
+				keysHandle.Free();
+				valuesHandle.Free();
+			}
+		}
+	}
+}
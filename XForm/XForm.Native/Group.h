@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Grouped Count and Sum over byte or ushort keys (GroupBy bucket indices), accumulating into one bucket per key.
+		// Few-bucket groups are accumulated into several partial histograms which are merged at the end, so runs of
+		// one hot key don't wait on the previous increment of the same bucket. Keys past the end of counts or sums throw.
+		public ref class GroupN
+		{
+		public:
+			// counts[keys[index + i]]++ for each row i in [0, length) set in vector, or for every row if vector is null
+			static void Count(Array^ keys, Int32 index, Int32 length, array<UInt64>^ vector, array<Int32>^ counts);
+
+			// counts[keys[indices[i]]]++ for each i in [index, index + length)
+			static void Count(Array^ keys, array<Int32>^ indices, Int32 index, Int32 length, array<Int32>^ counts);
+
+			// sums[keys[keyIndex + i]] += values[valueIndex + i] for each row i in [0, length) set in vector, or for every row if vector is null.
+			// Int32 and Int64 values are summed into Int64 sums, and Double values into Double sums.
+			static void Sum(Array^ keys, Int32 keyIndex, Array^ values, Int32 valueIndex, Int32 length, array<UInt64>^ vector, Array^ sums);
+
+			// sums[keys[indices[i]]] += values[indices[i]] for each i in [index, index + length)
+			static void Sum(Array^ keys, Array^ values, array<Int32>^ indices, Int32 index, Int32 length, Array^ sums);
+		};
+	}
+}
@@ -0,0 +1,452 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <stdlib.h>
+#include <string.h>
+#include "CpuFeatures.h"
+#include "Hash.h"
+#include "KernelCounters.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+const unsigned __int64 HashC1 = 0x87c37b91114253d5ULL;
+const unsigned __int64 HashC2 = 0x4cf5ad432745937fULL;
+const unsigned __int64 HashFMix1 = 0xff51afd7ed558ccdULL;
+const unsigned __int64 HashFMix2 = 0xc4ceb9fe1a85ec53ULL;
+
+// Values hashed by index are copied into a buffer of this many and then hashed as a contiguous block
+const int HashIndicesBlock = 256;
+
+// How many keys ahead IndexOf prefetches the table buckets for
+const int IndexOfPrefetchDistance = 16;
+
+static __forceinline unsigned __int64 FMixN(unsigned __int64 value)
+{
+	value ^= value >> 33;
+	value *= HashFMix1;
+	value ^= value >> 33;
+	value *= HashFMix2;
+	value ^= value >> 33;
+	return value;
+}
+
+static __forceinline int CombineN(int previous, unsigned int hash, bool combine)
+{
+	return (int)(combine ? (unsigned int)previous * 31 + hash : hash);
+}
+
+// Load a value of 'size' bytes as the Murmur3 k2 tail does, with the first byte highest
+template<int size>
+static __forceinline unsigned __int64 LoadTailN(const unsigned __int8* value);
+
+template<> __forceinline unsigned __int64 LoadTailN<1>(const unsigned __int8* value) { return *value; }
+template<> __forceinline unsigned __int64 LoadTailN<2>(const unsigned __int8* value) { return _byteswap_ushort(*(unsigned __int16*)value); }
+template<> __forceinline unsigned __int64 LoadTailN<4>(const unsigned __int8* value) { return _byteswap_ulong(*(unsigned __int32*)value); }
+template<> __forceinline unsigned __int64 LoadTailN<8>(const unsigned __int8* value) { return _byteswap_uint64(*(unsigned __int64*)value); }
+
+// Murmur3 for keys of at most eight bytes: there are no body blocks and k1 is zero, so only k2 and the finalization remain
+static __forceinline unsigned int HashShortN(unsigned __int64 k2, unsigned __int64 length)
+{
+	k2 *= HashC2;
+	k2 = _rotl64(k2, 33);
+	k2 *= HashC1;
+
+	unsigned __int64 h2 = k2 ^ length;
+	unsigned __int64 h1 = length + h2;
+	h2 += h1;
+
+	return (unsigned int)(FMixN(h1) + FMixN(h2));
+}
+
+// Murmur3 x64 128 (seed zero), returning the low 32 bits of the first 64; sequence for sequence with Hashing.Hash(byte*, int, uint).
+// The managed tail shifts k1 left by 64 (a no-op in C#) before loading eight tail bytes into it, so k1 is just the load here.
+static unsigned int HashBytesN(const unsigned __int8* key, int length)
+{
+	int blockCount = length / 16;
+	unsigned __int64 h1 = 0;
+	unsigned __int64 h2 = 0;
+
+	const unsigned __int64* blocks = (const unsigned __int64*)key;
+	for (int i = 0; i < blockCount; ++i)
+	{
+		unsigned __int64 k1 = blocks[2 * i];
+		unsigned __int64 k2 = blocks[2 * i + 1];
+
+		k1 *= HashC1;
+		k1 = _rotl64(k1, 31);
+		k1 *= HashC2;
+		h1 ^= k1;
+
+		h1 = _rotl64(h1, 27);
+		h1 += h2;
+		h1 = h1 * 5 + 0x52dce729;
+
+		k2 *= HashC2;
+		k2 = _rotl64(k2, 33);
+		k2 *= HashC1;
+		h2 ^= k2;
+
+		h2 = _rotl64(h2, 31);
+		h2 += h1;
+		h2 = h2 * 5 + 0x38495ab5;
+	}
+
+	const unsigned __int8* tail = key + blockCount * 16;
+	int tailLength = length & 15;
+
+	unsigned __int64 k1 = 0;
+	unsigned __int64 k2 = 0;
+
+	if (tailLength > 8)
+	{
+		k1 = *(const unsigned __int64*)tail;
+		tailLength -= 8;
+		tail += 8;
+	}
+
+	k1 *= HashC1;
+	k1 = _rotl64(k1, 31);
+	k1 *= HashC2;
+	h1 ^= k1;
+
+	for (; tailLength > 0; --tailLength, ++tail)
+	{
+		k2 = (k2 << 8) ^ *tail;
+	}
+
+	k2 *= HashC2;
+	k2 = _rotl64(k2, 33);
+	k2 *= HashC1;
+	h2 ^= k2;
+
+	h1 ^= (unsigned __int64)length;
+	h2 ^= (unsigned __int64)length;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = FMixN(h1);
+	h2 = FMixN(h2);
+
+	return (unsigned int)(h1 + h2);
+}
+
+static __forceinline __m512i FMixAvx512N(__m512i value, __m512i fMix1, __m512i fMix2)
+{
+	value = _mm512_xor_si512(value, _mm512_srli_epi64(value, 33));
+	value = _mm512_mullo_epi64(value, fMix1);
+	value = _mm512_xor_si512(value, _mm512_srli_epi64(value, 33));
+	value = _mm512_mullo_epi64(value, fMix2);
+	value = _mm512_xor_si512(value, _mm512_srli_epi64(value, 33));
+	return value;
+}
+
+// Load eight values as k2 tails in 64-bit lanes, byte swapping each one
+template<int size>
+static __forceinline __m512i LoadTailsAvx512N(const unsigned __int8* values);
+
+template<> __forceinline __m512i LoadTailsAvx512N<1>(const unsigned __int8* values)
+{
+	return _mm512_cvtepu8_epi64(_mm_loadl_epi64((__m128i*)values));
+}
+
+template<> __forceinline __m512i LoadTailsAvx512N<2>(const unsigned __int8* values)
+{
+	__m128i swap = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+	return _mm512_cvtepu16_epi64(_mm_shuffle_epi8(_mm_loadu_si128((__m128i*)values), swap));
+}
+
+template<> __forceinline __m512i LoadTailsAvx512N<4>(const unsigned __int8* values)
+{
+	__m256i swap = _mm256_broadcastsi128_si256(_mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12));
+	return _mm512_cvtepu32_epi64(_mm256_shuffle_epi8(_mm256_loadu_si256((__m256i*)values), swap));
+}
+
+template<> __forceinline __m512i LoadTailsAvx512N<8>(const unsigned __int8* values)
+{
+	__m512i swap = _mm512_broadcast_i32x4(_mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8));
+	return _mm512_shuffle_epi8(_mm512_loadu_si512(values), swap);
+}
+
+// AVX-512DQ: HashShortN eight values at a time with 64-bit multiplies and rotates, returning the number of values hashed.
+// AVX2 has no 64-bit multiply, and building one from 32-bit multiplies is no faster than the scalar loop, so AVX2 machines use that.
+template<int size>
+static int HashValuesAvx512N(const unsigned __int8* values, int length, bool combine, int* hashes)
+{
+	__m512i c1 = _mm512_set1_epi64(HashC1);
+	__m512i c2 = _mm512_set1_epi64(HashC2);
+	__m512i fMix1 = _mm512_set1_epi64(HashFMix1);
+	__m512i fMix2 = _mm512_set1_epi64(HashFMix2);
+	__m512i byteLength = _mm512_set1_epi64(size);
+
+	int blockLength = length & ~7;
+	for (int i = 0; i < blockLength; i += 8)
+	{
+		__m512i k2 = LoadTailsAvx512N<size>(values + i * size);
+		k2 = _mm512_mullo_epi64(_mm512_rol_epi64(_mm512_mullo_epi64(k2, c2), 33), c1);
+
+		__m512i h2 = _mm512_xor_si512(k2, byteLength);
+		__m512i h1 = _mm512_add_epi64(byteLength, h2);
+		h2 = _mm512_add_epi64(h2, h1);
+
+		__m256i result = _mm512_cvtepi64_epi32(_mm512_add_epi64(FMixAvx512N(h1, fMix1, fMix2), FMixAvx512N(h2, fMix1, fMix2)));
+
+		if (combine)
+		{
+			__m256i previous = _mm256_loadu_si256((__m256i*)&hashes[i]);
+			result = _mm256_add_epi32(_mm256_sub_epi32(_mm256_slli_epi32(previous, 5), previous), result);
+		}
+
+		_mm256_storeu_si256((__m256i*)&hashes[i], result);
+	}
+
+	return blockLength;
+}
+
+template<int size>
+static void HashValuesN(const unsigned __int8* values, int length, bool combine, int* hashes)
+{
+	int i = (SupportedN.Avx512Dq && SupportedN.Avx512Bw ? HashValuesAvx512N<size>(values, length, combine, hashes) : 0);
+
+	for (; i < length; ++i)
+	{
+		hashes[i] = CombineN(hashes[i], HashShortN(LoadTailN<size>(values + i * size), size), combine);
+	}
+}
+
+// Copy the values at indices into a buffer a block at a time and hash each block, or return false if an index is out of range
+template<int size>
+static bool HashIndicesN(const unsigned __int8* values, int valueCount, const int* indices, int length, bool combine, int* hashes)
+{
+	__declspec(align(64)) unsigned __int8 block[HashIndicesBlock * size];
+
+	for (int start = 0; start < length; start += HashIndicesBlock)
+	{
+		int count = (length - start < HashIndicesBlock ? length - start : HashIndicesBlock);
+
+		for (int i = 0; i < count; ++i)
+		{
+			unsigned int index = (unsigned int)indices[start + i];
+			if (index >= (unsigned int)valueCount) return false;
+			memcpy(&block[i * size], &values[(__int64)index * size], size);
+		}
+
+		HashValuesN<size>(block, count, combine, &hashes[start]);
+	}
+
+	return true;
+}
+
+// Hash each string, returning false if the ends go backwards or past the end of the text
+static bool HashTextN(const unsigned __int8* text, int textLength, int firstStart, const int* ends, int length, bool combine, int* hashes)
+{
+	int start = firstStart;
+
+	for (int i = 0; i < length; ++i)
+	{
+		int end = ends[i];
+		if (end < start || end > textLength) return false;
+
+		hashes[i] = CombineN(hashes[i], HashBytesN(text + start, end - start), combine);
+		start = end;
+	}
+
+	return true;
+}
+
+static void HashValuesN(int size, const unsigned __int8* values, int length, bool combine, int* hashes)
+{
+	switch (size)
+	{
+	case 1: HashValuesN<1>(values, length, combine, hashes); break;
+	case 2: HashValuesN<2>(values, length, combine, hashes); break;
+	case 4: HashValuesN<4>(values, length, combine, hashes); break;
+	default: HashValuesN<8>(values, length, combine, hashes); break;
+	}
+}
+
+static bool HashIndicesN(int size, const unsigned __int8* values, int valueCount, const int* indices, int length, bool combine, int* hashes)
+{
+	switch (size)
+	{
+	case 1: return HashIndicesN<1>(values, valueCount, indices, length, combine, hashes);
+	case 2: return HashIndicesN<2>(values, valueCount, indices, length, combine, hashes);
+	case 4: return HashIndicesN<4>(values, valueCount, indices, length, combine, hashes);
+	default: return HashIndicesN<8>(values, valueCount, indices, length, combine, hashes);
+	}
+}
+
+// HashCore.IndexOf for a batch of keys: each key is compared to the buckets from its hash bucket on, at its probe increment,
+// up to the longest probe in the table. The buckets for the key IndexOfPrefetchDistance ahead are fetched meanwhile.
+template<typename T>
+static void IndexOfN(const T* keys, int length, const int* hashes, const T* tableKeys, const unsigned __int8* metadata, unsigned int tableLength, int maxProbeLength, int* buckets)
+{
+	int limit = (unsigned __int8)(((maxProbeLength + 1) << 4) + 15);
+
+	for (int i = 0; i < length; ++i)
+	{
+		if (i + IndexOfPrefetchDistance < length)
+		{
+			unsigned int ahead = (unsigned int)(((unsigned __int64)(unsigned int)hashes[i + IndexOfPrefetchDistance] * tableLength) >> 32);
+			_mm_prefetch((const char*)&metadata[ahead], _MM_HINT_T0);
+			_mm_prefetch((const char*)&tableKeys[ahead], _MM_HINT_T0);
+		}
+
+		unsigned int hash = (unsigned int)hashes[i];
+		unsigned int bucket = (unsigned int)(((unsigned __int64)hash * tableLength) >> 32);
+		unsigned int increment = (hash & 15) + 1;
+		T key = keys[i];
+
+		int found = -1;
+		for (int matchingMetadata = (1 << 4) + (int)(increment - 1); matchingMetadata <= limit; matchingMetadata += 16)
+		{
+			if (metadata[bucket] == matchingMetadata && tableKeys[bucket] == key)
+			{
+				found = (int)bucket;
+				break;
+			}
+
+			bucket += increment;
+			if (bucket >= tableLength) bucket -= tableLength;
+		}
+
+		buckets[i] = found;
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Size of the values in a primitive numeric array, which Hashing.Hash hashes as their raw bytes
+		static int ValueSize(Array^ values, String^ name, bool integerOnly)
+		{
+			Type^ type = values->GetType()->GetElementType();
+
+			if (type == Byte::typeid || type == SByte::typeid) return 1;
+			if (type == Int16::typeid || type == UInt16::typeid) return 2;
+			if (type == Int32::typeid || type == UInt32::typeid) return 4;
+			if (type == Int64::typeid || type == UInt64::typeid) return 8;
+			if (!integerOnly && type == Single::typeid) return 4;
+			if (!integerOnly && type == Double::typeid) return 8;
+
+			throw gcnew ArgumentException(String::Format("HashN doesn't support {0} values.", type->Name), name);
+		}
+
+		void HashN::Hash(Array^ values, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes)
+		{
+			int size = ValueSize(values, "values", false);
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > values->Length) throw gcnew IndexOutOfRangeException("values");
+			if (length > hashes->Length) throw gcnew IndexOutOfRangeException("hashes");
+			if (length == 0) return;
+
+			COUNT_KERNEL(Hash, length, (Int64)length * (size + 4));
+
+			GCHandle valuesHandle = GCHandle::Alloc(values, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<Int32> pHashes = &hashes[0];
+				const unsigned __int8* pValues = (const unsigned __int8*)valuesHandle.AddrOfPinnedObject().ToPointer();
+
+				HashValuesN(size, pValues + (__int64)index * size, length, combine, pHashes);
+			}
+			finally
+			{
+				valuesHandle.Free();
+			}
+		}
+
+		void HashN::Hash(Array^ values, array<Int32>^ indices, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes)
+		{
+			int size = ValueSize(values, "values", false);
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > indices->Length) throw gcnew IndexOutOfRangeException("indices");
+			if (length > hashes->Length) throw gcnew IndexOutOfRangeException("hashes");
+			if (length == 0) return;
+			if (values->Length == 0) throw gcnew IndexOutOfRangeException("indices");
+
+			COUNT_KERNEL(Hash, length, (Int64)length * (size + 8));
+
+			GCHandle valuesHandle = GCHandle::Alloc(values, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<Int32> pIndices = &indices[index];
+				pin_ptr<Int32> pHashes = &hashes[0];
+				const unsigned __int8* pValues = (const unsigned __int8*)valuesHandle.AddrOfPinnedObject().ToPointer();
+
+				if (!HashIndicesN(size, pValues, values->Length, pIndices, length, combine, pHashes)) throw gcnew IndexOutOfRangeException("indices");
+			}
+			finally
+			{
+				valuesHandle.Free();
+			}
+		}
+
+		void HashN::Hash(array<Byte>^ text, Int32 firstStart, array<Int32>^ ends, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes)
+		{
+			if (firstStart < 0 || index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > ends->Length) throw gcnew IndexOutOfRangeException("ends");
+			if (length > hashes->Length) throw gcnew IndexOutOfRangeException("hashes");
+			if (length == 0) return;
+
+			COUNT_KERNEL(Hash, length, (Int64)length * 8 + ((Int64)ends[index + length - 1] - firstStart));
+
+			pin_ptr<Byte> pText = nullptr;
+			if (text->Length > 0) pText = &text[0];
+			pin_ptr<Int32> pEnds = &ends[index];
+			pin_ptr<Int32> pHashes = &hashes[0];
+
+			if (!HashTextN(pText, text->Length, firstStart, pEnds, length, combine, pHashes)) throw gcnew IndexOutOfRangeException("ends");
+		}
+
+		void HashN::IndexOf(Array^ keys, Int32 index, Int32 length, array<Int32>^ hashes, Array^ tableKeys, array<Byte>^ metadata, Int32 maxProbeLength, array<Int32>^ buckets)
+		{
+			int size = ValueSize(keys, "keys", true);
+			if (keys->GetType() != tableKeys->GetType()) throw gcnew ArgumentException("keys and tableKeys must be the same type.", "tableKeys");
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > keys->Length) throw gcnew IndexOutOfRangeException("keys");
+			if (length > hashes->Length) throw gcnew IndexOutOfRangeException("hashes");
+			if (length > buckets->Length) throw gcnew IndexOutOfRangeException("buckets");
+			if (metadata->Length == 0 || tableKeys->Length < metadata->Length) throw gcnew IndexOutOfRangeException("tableKeys");
+			if (maxProbeLength < 0 || maxProbeLength > 14) throw gcnew ArgumentOutOfRangeException("maxProbeLength");
+			if (length == 0) return;
+
+			COUNT_KERNEL(HashIndexOf, length, (Int64)length * (size + 8));
+
+			GCHandle keysHandle = GCHandle::Alloc(keys, GCHandleType::Pinned);
+			GCHandle tableKeysHandle = GCHandle::Alloc(tableKeys, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<Int32> pHashes = &hashes[0];
+				pin_ptr<Byte> pMetadata = &metadata[0];
+				pin_ptr<Int32> pBuckets = &buckets[0];
+				const unsigned __int8* pKeys = (const unsigned __int8*)keysHandle.AddrOfPinnedObject().ToPointer() + (__int64)index * size;
+				const void* pTableKeys = tableKeysHandle.AddrOfPinnedObject().ToPointer();
+				unsigned int tableLength = (unsigned int)metadata->Length;
+
+				switch (size)
+				{
+				case 1: IndexOfN((const unsigned __int8*)pKeys, length, pHashes, (const unsigned __int8*)pTableKeys, pMetadata, tableLength, maxProbeLength, pBuckets); break;
+				case 2: IndexOfN((const unsigned __int16*)pKeys, length, pHashes, (const unsigned __int16*)pTableKeys, pMetadata, tableLength, maxProbeLength, pBuckets); break;
+				case 4: IndexOfN((const unsigned __int32*)pKeys, length, pHashes, (const unsigned __int32*)pTableKeys, pMetadata, tableLength, maxProbeLength, pBuckets); break;
+				default: IndexOfN((const unsigned __int64*)pKeys, length, pHashes, (const unsigned __int64*)pTableKeys, pMetadata, tableLength, maxProbeLength, pBuckets); break;
+				}
+			}
+			finally
+			{
+				tableKeysHandle.Free();
+				keysHandle.Free();
+			}
+		}
+	}
+}
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Batch hashing for GroupBy, Join, and Choose keys, identical to XForm.Hashing.Hash(value, 0) truncated to an int.
+		// With combine, each hash is merged into the hash already in hashes (hashes[i] * 31 + hash), as GetHashCodes combines key columns.
+		public ref class HashN
+		{
+		public:
+			// Hash values[index + i] into hashes[i] for i in [0, length). Values must be a primitive numeric array.
+			static void Hash(Array^ values, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes);
+
+			// Hash values[indices[index + i]] into hashes[i] for i in [0, length)
+			static void Hash(Array^ values, array<Int32>^ indices, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes);
+
+			// Hash the strings text[ends[index + i - 1], ends[index + i]) into hashes[i] for i in [0, length), with the first string starting at firstStart.
+			// This is the String8 column layout on disk, where each position is the end of one value.
+			static void Hash(array<Byte>^ text, Int32 firstStart, array<Int32>^ ends, Int32 index, Int32 length, Boolean combine, array<Int32>^ hashes);
+
+			// Set buckets[i] to the HashCore bucket holding keys[index + i] (with hash hashes[i]), or -1 if it isn't in the table.
+			// metadata, tableKeys, and maxProbeLength are the HashCore table state. Keys must be integers and are compared bitwise.
+			// Buckets for later keys are prefetched while earlier ones are probed, so lookups in tables larger than cache overlap their misses.
+			static void IndexOf(Array^ keys, Int32 index, Int32 length, array<Int32>^ hashes, Array^ tableKeys, array<Byte>^ metadata, Int32 maxProbeLength, array<Int32>^ buckets);
+		};
+	}
+}
@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <string.h>
+#include "KernelCounters.h"
+
+#pragma unmanaged
+
+static const char* const KernelNamesN[KernelN::KernelCount] =
+{
+	"BitVectorN.Count",
+	"BitVectorN.Page",
+	"BitVectorN.Compact",
+	"BitVectorN.BuildRanks",
+	"BitVectorN.Select",
+	"Comparer.Where",
+	"Comparer.WhereAnd",
+	"Comparer.WhereIn",
+	"GroupN.Count",
+	"GroupN.Sum",
+	"HashN.Hash",
+	"HashN.IndexOf",
+	"ParallelN.Count",
+	"ParallelN.Where",
+	"Plan.Execute",
+	"String8N.SplitTsv",
+	"String8N.SplitCsv",
+	"String8N.SplitCells",
+	"String8N.Where",
+	"String8N.IndexOfAll",
+	"String8N.IndexOfAny",
+	"VariableIntegerN.Widen",
+	"ZoneMapN.Where",
+	"ZoneMapN.CountDecided"
+};
+
+struct KernelCounterN
+{
+	unsigned __int64 calls;
+	unsigned __int64 elements;
+	unsigned __int64 bytes;
+	unsigned __int64 cycles;
+};
+
+// One thread's counters, on their own cache lines. Threads link their counters into a list the first time they count a call;
+// counters are never freed, so readers can walk the list while other threads add to it.
+struct __declspec(align(64)) ThreadCountersN
+{
+	KernelCounterN kernels[KernelN::KernelCount];
+	ThreadCountersN* next;
+};
+
+volatile bool KernelCountingN = false;
+
+static ThreadCountersN* volatile s_threadCountersN = nullptr;
+
+// Each thread finds its counters through a TLS slot; __declspec(thread) variables aren't dependable in a DLL loaded at runtime
+static const DWORD s_countersSlotN = TlsAlloc();
+
+static ThreadCountersN* AddThreadCountersN()
+{
+	if (s_countersSlotN == TLS_OUT_OF_INDEXES) return nullptr;
+
+	ThreadCountersN* counters = (ThreadCountersN*)_aligned_malloc(sizeof(ThreadCountersN), 64);
+	if (counters == nullptr) return nullptr;
+	memset(counters, 0, sizeof(ThreadCountersN));
+
+	ThreadCountersN* head;
+	do
+	{
+		head = s_threadCountersN;
+		counters->next = head;
+	} while (InterlockedCompareExchangePointer((PVOID volatile*)&s_threadCountersN, counters, head) != head);
+
+	TlsSetValue(s_countersSlotN, counters);
+	return counters;
+}
+
+unsigned __int64 KernelStartN()
+{
+	return __rdtsc();
+}
+
+void KernelEndN(KernelN kernel, unsigned __int64 start, __int64 elements, __int64 bytes)
+{
+	unsigned __int64 end = __rdtsc();
+
+	ThreadCountersN* counters = (ThreadCountersN*)TlsGetValue(s_countersSlotN);
+	if (counters == nullptr) counters = AddThreadCountersN();
+	if (counters == nullptr) return;
+
+	KernelCounterN& counter = counters->kernels[kernel];
+	counter.calls++;
+	counter.elements += elements;
+	counter.bytes += bytes;
+	counter.cycles += end - start;
+}
+
+static void ReadCountersN(__int64* result)
+{
+	memset(result, 0, sizeof(KernelCounterN) * KernelN::KernelCount);
+
+	for (ThreadCountersN* counters = s_threadCountersN; counters != nullptr; counters = counters->next)
+	{
+		for (int k = 0; k < KernelN::KernelCount; ++k)
+		{
+			result[4 * k] += counters->kernels[k].calls;
+			result[4 * k + 1] += counters->kernels[k].elements;
+			result[4 * k + 2] += counters->kernels[k].bytes;
+			result[4 * k + 3] += counters->kernels[k].cycles;
+		}
+	}
+}
+
+static void ResetCountersN()
+{
+	for (ThreadCountersN* counters = s_threadCountersN; counters != nullptr; counters = counters->next)
+	{
+		memset(counters->kernels, 0, sizeof(counters->kernels));
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		Boolean KernelCountersN::IsEnabled()
+		{
+#ifdef XFORM_NO_KERNEL_COUNTERS
+			return false;
+#else
+			return KernelCountingN;
+#endif
+		}
+
+		void KernelCountersN::Enable(Boolean enabled)
+		{
+			KernelCountingN = enabled;
+		}
+
+		array<String^>^ KernelCountersN::Names()
+		{
+			array<String^>^ names = gcnew array<String^>(KernelN::KernelCount);
+			for (int k = 0; k < KernelN::KernelCount; ++k)
+			{
+				names[k] = gcnew String(KernelNamesN[k]);
+			}
+
+			return names;
+		}
+
+		void KernelCountersN::Read(array<Int64>^ counters)
+		{
+			if (counters->Length < FieldCount * KernelN::KernelCount) throw gcnew ArgumentOutOfRangeException("counters");
+
+			pin_ptr<Int64> pCounters = &counters[0];
+			ReadCountersN(pCounters);
+		}
+
+		void KernelCountersN::Reset()
+		{
+			ResetCountersN();
+		}
+	}
+}
@@ -0,0 +1,108 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+// Exported kernels with counters. WARNING: Order must stay in sync with KernelNamesN in KernelCounters.cpp.
+enum KernelN : char
+{
+	KernelBitVectorCount = 0,
+	KernelBitVectorPage,
+	KernelBitVectorCompact,
+	KernelRankBuild,
+	KernelSelect,
+	KernelWhere,
+	KernelWhereAnd,
+	KernelWhereIn,
+	KernelGroupCount,
+	KernelGroupSum,
+	KernelHash,
+	KernelHashIndexOf,
+	KernelParallelCount,
+	KernelParallelWhere,
+	KernelPlanExecute,
+	KernelSplitTsv,
+	KernelSplitCsv,
+	KernelSplitCells,
+	KernelString8Where,
+	KernelIndexOfAll,
+	KernelIndexOfAny,
+	KernelWiden,
+	KernelZoneMapWhere,
+	KernelZoneMapCountDecided,
+	KernelCount
+};
+
+#pragma managed(push, off)
+
+// Whether kernels count their calls. Off until KernelCountersN::Enable, so that by default kernels only pay for checking it.
+extern volatile bool KernelCountingN;
+
+// Read the timestamp counter at the start of a kernel call
+unsigned __int64 KernelStartN();
+
+// Count one call of 'kernel' over 'elements' values touching 'bytes' bytes, which started at timestamp 'start', in this thread's counters
+void KernelEndN(KernelN kernel, unsigned __int64 start, __int64 elements, __int64 bytes);
+
+#pragma managed(pop)
+
+// Counts the enclosing kernel call from construction until the end of the scope, including calls which throw, if counting was enabled when it started
+struct KernelScopeN
+{
+	KernelN kernel;
+	bool counting;
+	unsigned __int64 start;
+	__int64 elements;
+	__int64 bytes;
+
+	KernelScopeN(KernelN kernel, __int64 elements, __int64 bytes) : kernel(kernel), counting(KernelCountingN), start(counting ? KernelStartN() : 0), elements(elements), bytes(bytes)
+	{ }
+
+	~KernelScopeN()
+	{
+		if (counting) KernelEndN(kernel, start, elements, bytes);
+	}
+};
+
+#ifndef XFORM_NO_KERNEL_COUNTERS
+
+// Count the rest of this kernel call against 'kernel' (a KernelN name without the Kernel prefix). Place after argument validation, so rejected calls aren't counted.
+// Build with XFORM_NO_KERNEL_COUNTERS to compile the counting (and the KernelCountingN check) out of every kernel.
+#define COUNT_KERNEL(kernel, elements, bytes) KernelScopeN kernelScope(KernelN::Kernel##kernel, (__int64)(elements), (__int64)(bytes))
+
+#else
+
+#define COUNT_KERNEL(kernel, elements, bytes)
+
+#endif
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Calls, elements, bytes touched, and timestamp counter cycles for each exported kernel, counted while enabled (off by default).
+		// Each thread counts into its own counters, so kernels never contend to count; readers sum the counters of every thread.
+		public ref class KernelCountersN
+		{
+		public:
+			// Values Read returns for each kernel: calls, elements, bytes, and cycles
+			literal Int32 FieldCount = 4;
+
+			// Return whether kernels count their calls (never, if XForm.Native was built with XFORM_NO_KERNEL_COUNTERS)
+			static Boolean IsEnabled();
+
+			// Start or stop counting kernel calls. Counters keep their values while counting is off.
+			static void Enable(Boolean enabled);
+
+			// Return the kernel names, in the order Read returns their counters
+			static array<String^>^ Names();
+
+			// Sum the counters of every thread into counters, FieldCount values per kernel in Names order
+			static void Read(array<Int64>^ counters);
+
+			// Zero the counters of every thread. Calls ending on other threads during Reset may be counted before or after it.
+			static void Reset();
+		};
+	}
+}
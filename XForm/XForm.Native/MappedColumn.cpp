@@ -0,0 +1,210 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <string.h>
+#include "Operator.h"
+#include "WhereN.h"
+#include "Comparer.h"
+#include "String8N.h"
+#include "ZoneMap.h"
+#include "MappedColumn.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+// PrefetchVirtualMemory is Windows 8 and later; look it up so the DLL still loads where it's missing
+typedef BOOL(WINAPI *PrefetchVirtualMemoryN)(HANDLE process, ULONG_PTR entryCount, PWIN32_MEMORY_RANGE_ENTRY entries, ULONG flags);
+
+static PrefetchVirtualMemoryN FindPrefetchN()
+{
+	HMODULE kernel32 = GetModuleHandleW(L"kernel32.dll");
+	if (kernel32 == NULL) return NULL;
+	return (PrefetchVirtualMemoryN)GetProcAddress(kernel32, "PrefetchVirtualMemory");
+}
+
+static PrefetchVirtualMemoryN s_prefetch = FindPrefetchN();
+
+static void PrefetchN(void* start, size_t length)
+{
+	if (s_prefetch == NULL || length == 0) return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = start;
+	range.NumberOfBytes = length;
+	s_prefetch(GetCurrentProcess(), 1, &range, 0);
+}
+
+// Map the whole file read-only. The view keeps the file mapped after the file and mapping handles are closed.
+static void* MapN(HANDLE file, __int64 length)
+{
+	HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapping == NULL) return NULL;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)length);
+	CloseHandle(mapping);
+	return view;
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		static Int32 ElementSize(Type^ type)
+		{
+			if (type == Byte::typeid || type == SByte::typeid || type == Boolean::typeid) return 1;
+			if (type == UInt16::typeid || type == Int16::typeid) return 2;
+			if (type == UInt32::typeid || type == Int32::typeid || type == Single::typeid) return 4;
+			if (type == UInt64::typeid || type == Int64::typeid || type == Double::typeid) return 8;
+			throw gcnew ArgumentException(String::Format("MappedColumnN doesn't support {0} columns.", type->Name), "elementType");
+		}
+
+		MappedColumnN^ MappedColumnN::Map(FileStream^ stream, Type^ elementType)
+		{
+			Int32 elementSize = ElementSize(elementType);
+			Int64 length = stream->Length;
+			if (length % elementSize != 0) throw gcnew IOException(String::Format("\"{0}\" isn't a whole number of {1} values.", stream->Name, elementType->Name));
+			if (length / elementSize > Int32::MaxValue) throw gcnew IOException(String::Format("\"{0}\" has too many values to map.", stream->Name));
+
+			// Empty files can't be mapped
+			if (length == 0) return gcnew MappedColumnN(nullptr, 0, elementType, elementSize);
+
+			void* view = MapN(stream->SafeFileHandle->DangerousGetHandle().ToPointer(), length);
+			if (view == nullptr) throw gcnew IOException(String::Format("Unable to map \"{0}\".", stream->Name), HRESULT_FROM_WIN32(GetLastError()));
+			GC::KeepAlive(stream);
+
+			return gcnew MappedColumnN(view, (Int32)(length / elementSize), elementType, elementSize);
+		}
+
+		MappedColumnN::MappedColumnN(void* view, Int32 count, Type^ elementType, Int32 elementSize)
+		{
+			_view = view;
+			_count = count;
+			_elementType = elementType;
+			_elementSize = elementSize;
+		}
+
+		MappedColumnN::~MappedColumnN()
+		{
+			this->!MappedColumnN();
+		}
+
+		MappedColumnN::!MappedColumnN()
+		{
+			if (_view != nullptr)
+			{
+				UnmapViewOfFile(_view);
+				_view = nullptr;
+			}
+		}
+
+		Type^ MappedColumnN::ElementType::get()
+		{
+			return _elementType;
+		}
+
+		Int32 MappedColumnN::Count::get()
+		{
+			return _count;
+		}
+
+		IntPtr MappedColumnN::Pointer::get()
+		{
+			return IntPtr(_view);
+		}
+
+		void MappedColumnN::Prefetch(Int32 index, Int32 length)
+		{
+			if (index < 0 || length < 0 || index + length > _count) throw gcnew IndexOutOfRangeException("index");
+			if (_view == nullptr) return;
+
+			PrefetchN((unsigned __int8*)_view + (Int64)index * _elementSize, (size_t)length * _elementSize);
+		}
+
+		void MappedColumnN::Read(Int32 index, Int32 length, Array^ destination, Int32 destinationIndex)
+		{
+			if (index < 0 || length < 0 || destinationIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > _count) throw gcnew IndexOutOfRangeException("index");
+			if (destinationIndex + length > destination->Length) throw gcnew IndexOutOfRangeException("destination");
+			if (destination->GetType()->GetElementType() != _elementType) throw gcnew ArgumentException(String::Format("destination must be an array of {0}.", _elementType->Name), "destination");
+			if (length == 0) return;
+			if (_view == nullptr) throw gcnew ObjectDisposedException("MappedColumnN");
+
+			GCHandle handle = GCHandle::Alloc(destination, GCHandleType::Pinned);
+
+			try
+			{
+				unsigned __int8* pDestination = (unsigned __int8*)handle.AddrOfPinnedObject().ToPointer();
+				memcpy(pDestination + (Int64)destinationIndex * _elementSize, (unsigned __int8*)_view + (Int64)index * _elementSize, (size_t)length * _elementSize);
+			}
+			finally
+			{
+				handle.Free();
+			}
+		}
+
+		void MappedColumnN::Where(Int32 index, Int32 length, Byte cOp, Object^ value, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > _count) throw gcnew IndexOutOfRangeException("index");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperator");
+			if (bOp > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("booleanOperator");
+			if (length == 0) return;
+			if (_view == nullptr) throw gcnew ObjectDisposedException("MappedColumnN");
+
+			WhereTermN term;
+			BuildTerm(_elementType, value, cOp, _view, index, term);
+
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+			WhereN(term, 0, length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+		}
+
+		Int32 MappedColumnN::Where(Int32 index, Int32 length, Byte cOp, Object^ value, Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0 || firstRow < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > _count) throw gcnew IndexOutOfRangeException("index");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperator");
+			if (bOp > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("booleanOperator");
+			if (blockRowCount <= 0) throw gcnew ArgumentOutOfRangeException("blockRowCount");
+			if (zoneMap->GetType()->GetElementType() != _elementType) throw gcnew ArgumentException(String::Format("zoneMap must be an array of {0}.", _elementType->Name), "zoneMap");
+			if (length == 0) return 0;
+			if (_view == nullptr) throw gcnew ObjectDisposedException("MappedColumnN");
+
+			GCHandle zoneHandle = GCHandle::Alloc(zoneMap, GCHandleType::Pinned);
+
+			try
+			{
+				WhereTermN term;
+				WhereTermN zone;
+				BuildTerm(_elementType, value, cOp, _view, index, term);
+				BuildTerm(zoneMap, value, cOp, zoneHandle.AddrOfPinnedObject().ToPointer(), 0, zone);
+
+				pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+				return ZoneWhereN(&term, zone, zoneMap->Length / 2, blockRowCount, firstRow, length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+			}
+			finally
+			{
+				zoneHandle.Free();
+			}
+		}
+
+		Int32 MappedColumnN::IndexOfAll(Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray)
+		{
+			if (_elementType != Byte::typeid) throw gcnew InvalidOperationException("IndexOfAll requires a Byte column.");
+			if (index < 0 || length < 0 || index + length > _count) throw gcnew IndexOutOfRangeException("index");
+			if (valueIndex < 0 || valueLength <= 0 || valueIndex + valueLength > value->Length) throw gcnew IndexOutOfRangeException("valueIndex");
+			if (length == 0 || matchArray->Length == 0) return 0;
+			if (_view == nullptr) throw gcnew ObjectDisposedException("MappedColumnN");
+
+			// IndexOfAllN runs the AVX2 or folding search on CPUs XForm.Native supports; neither reads past the end of the text, and so of the view
+			pin_ptr<Byte> pValue = &value[valueIndex];
+			pin_ptr<Int32> pMatchArray = &matchArray[0];
+			return IndexOfAllN((unsigned __int8*)_view, index, index + length, pValue, valueLength, ignoreCase, pMatchArray, matchArray->Length);
+		}
+	}
+}
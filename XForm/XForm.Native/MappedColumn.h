@@ -0,0 +1,55 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+using namespace System::IO;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// A read-only memory-mapped view of a column file (V.*.bin), so kernels can run on the values in place instead of on a managed copy.
+		// Views start on an allocation granularity (64 KB) boundary, so the column start is aligned for every vector width and for pages.
+		public ref class MappedColumnN : IDisposable
+		{
+		public:
+			// Map the file open in stream as values of elementType (a primitive numeric type or Boolean). The stream may be closed afterward.
+			static MappedColumnN^ Map(FileStream^ stream, Type^ elementType);
+
+			~MappedColumnN();
+			!MappedColumnN();
+
+			property Type^ ElementType { Type^ get(); }
+			property Int32 Count { Int32 get(); }
+
+			// The address of the first value, or zero for an empty column
+			property IntPtr Pointer { IntPtr get(); }
+
+			// Ask the OS to start reading values [index, index + length) into memory (PrefetchVirtualMemory), so later reads don't wait on the disk.
+			// A hint only; does nothing where the OS doesn't support it.
+			void Prefetch(Int32 index, Int32 length);
+
+			// Copy values [index, index + length) into destination from destinationIndex. destination must be an array of ElementType.
+			void Read(Int32 index, Int32 length, Array^ destination, Int32 destinationIndex);
+
+			// Compare values [index, index + length) to value, merging the results into vector from 'vectorIndex' with booleanOperator, as Comparer::Where
+			void Where(Int32 index, Int32 length, Byte compareOperator, Object^ value, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// Compare values [index, index + length) to value, skipping the zone map blocks which decide rows, as ZoneMapN::Where.
+			// Value [index] is row firstRow of the zone map, which must be an array of ElementType. Returns the number of rows decided from the zone map alone.
+			Int32 Where(Int32 index, Int32 length, Byte compareOperator, Object^ value, Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// Find every index in [index, index + length) where value matches, as String8N::IndexOfAll. Requires a Byte column (String8 text).
+			Int32 IndexOfAll(Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray);
+
+		private:
+			MappedColumnN(void* view, Int32 count, Type^ elementType, Int32 elementSize);
+
+			void* _view;
+			Int32 _count;
+			Type^ _elementType;
+			Int32 _elementSize;
+		};
+	}
+}
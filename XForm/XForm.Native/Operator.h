@@ -12,7 +12,10 @@ public enum CompareOperatorN : char
 	LessThan = 2,
 	LessThanOrEqual = 3,
 	GreaterThan = 4,
-	GreaterThanOrEqual = 5
+	GreaterThanOrEqual = 5,
+
+	// Only String8N::Where compares with StartsWith
+	StartsWith = 8
 };
 
 public enum BooleanOperatorN : char
@@ -0,0 +1,309 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include "Operator.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+#include "BitVectorN.h"
+#include "Comparer.h"
+#include "Parallel.h"
+#include "KernelCounters.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+// Threads in one parallel call, including the caller
+const int ParallelWorkerLimitN = 64;
+
+// Match vector words (of 64 rows) per Where chunk and per Count chunk, enough work to outweigh waking a worker
+const int WhereChunkWords = 1024;
+const int CountChunkWords = 16384;
+
+// Calls with fewer chunks than this run on the calling thread
+const int ParallelChunkMinimum = 4;
+
+// Run one chunk for a worker, returning the count to add to its total
+typedef __int64 (*ParallelChunkN)(void* context, int chunk);
+
+// The chunks a worker owns. Workers take the next chunk from their own range, then from the other ranges once theirs
+// is done, so chunk claims only contend at the end of a call. Padded so workers claiming chunks don't share a cache line.
+__declspec(align(64)) struct ParallelRangeN
+{
+	volatile long next;
+	long end;
+};
+
+__declspec(align(64)) struct ParallelTotalN
+{
+	__int64 value;
+};
+
+struct ParallelJobN
+{
+	ParallelChunkN run;
+	void* context;
+	int workerCount;
+	volatile long remaining;
+	ParallelRangeN ranges[ParallelWorkerLimitN];
+	ParallelTotalN totals[ParallelWorkerLimitN];
+};
+
+static INIT_ONCE s_poolInit = INIT_ONCE_STATIC_INIT;
+static SRWLOCK s_poolLock = SRWLOCK_INIT;
+static HANDLE s_startEvents[ParallelWorkerLimitN];
+static HANDLE s_doneEvent;
+static int s_poolWorkers = 1;
+static int s_workerLimit = 0;
+static ParallelJobN s_job;
+
+static void RunWorkerN(ParallelJobN& job, int worker)
+{
+	__int64 total = 0;
+
+	for (int i = 0; i < job.workerCount; ++i)
+	{
+		ParallelRangeN& range = job.ranges[(worker + i) % job.workerCount];
+
+		while (true)
+		{
+			long chunk = InterlockedIncrement(&range.next) - 1;
+			if (chunk >= range.end) break;
+			total += job.run(job.context, chunk);
+		}
+	}
+
+	job.totals[worker].value = total;
+}
+
+static DWORD WINAPI PoolThreadN(LPVOID parameter)
+{
+	int worker = (int)(INT_PTR)parameter;
+
+	while (true)
+	{
+		WaitForSingleObject(s_startEvents[worker], INFINITE);
+		RunWorkerN(s_job, worker);
+		if (InterlockedDecrement(&s_job.remaining) == 0) SetEvent(s_doneEvent);
+	}
+}
+
+// Start one pool thread per processor (less one for the caller), node by node, with each thread bound to the processors
+// of its NUMA node. Neighbouring workers own neighbouring ranges and steal from each other first, so each node mostly
+// scans one contiguous part of the array, and a worker gets the same rows each time the same array is scanned.
+static BOOL CALLBACK InitPoolN(PINIT_ONCE, PVOID, PVOID*)
+{
+	s_doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+	if (s_doneEvent == NULL) return TRUE;
+
+	ULONG highestNode = 0;
+	if (!GetNumaHighestNodeNumber(&highestNode)) highestNode = 0;
+
+	bool skippedCaller = false;
+	for (ULONG node = 0; node <= highestNode && s_poolWorkers < ParallelWorkerLimitN; ++node)
+	{
+		GROUP_AFFINITY affinity = {};
+		if (!GetNumaNodeProcessorMaskEx((USHORT)node, &affinity) || affinity.Mask == 0) continue;
+
+		int processors = (int)__popcnt64(affinity.Mask);
+		for (int p = 0; p < processors && s_poolWorkers < ParallelWorkerLimitN; ++p)
+		{
+			if (!skippedCaller)
+			{
+				skippedCaller = true;
+				continue;
+			}
+
+			int worker = s_poolWorkers;
+			s_startEvents[worker] = CreateEvent(NULL, FALSE, FALSE, NULL);
+			if (s_startEvents[worker] == NULL) return TRUE;
+
+			HANDLE thread = CreateThread(NULL, 64 * 1024, PoolThreadN, (LPVOID)(INT_PTR)worker, CREATE_SUSPENDED, NULL);
+			if (thread == NULL)
+			{
+				CloseHandle(s_startEvents[worker]);
+				return TRUE;
+			}
+
+			SetThreadGroupAffinity(thread, &affinity, NULL);
+			ResumeThread(thread);
+			CloseHandle(thread);
+			s_poolWorkers++;
+		}
+	}
+
+	return TRUE;
+}
+
+// Run chunks [0, chunkCount) across the pool, returning the sum of the chunk counts
+static __int64 RunParallelN(ParallelChunkN run, void* context, int chunkCount)
+{
+	InitOnceExecuteOnce(&s_poolInit, InitPoolN, NULL, NULL);
+
+	int workerCount = s_poolWorkers;
+	if (s_workerLimit > 0 && workerCount > s_workerLimit) workerCount = s_workerLimit;
+	if (workerCount > chunkCount) workerCount = chunkCount;
+
+	// Run on this thread if the input is small, there are no pool threads, or another call has the pool
+	if (chunkCount < ParallelChunkMinimum || workerCount <= 1 || !TryAcquireSRWLockExclusive(&s_poolLock))
+	{
+		__int64 total = 0;
+		for (int chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			total += run(context, chunk);
+		}
+
+		return total;
+	}
+
+	ParallelJobN& job = s_job;
+	job.run = run;
+	job.context = context;
+	job.workerCount = workerCount;
+	job.remaining = workerCount - 1;
+
+	for (int w = 0; w < workerCount; ++w)
+	{
+		job.ranges[w].next = (long)(((__int64)chunkCount * w) / workerCount);
+		job.ranges[w].end = (long)(((__int64)chunkCount * (w + 1)) / workerCount);
+	}
+
+	for (int w = 1; w < workerCount; ++w)
+	{
+		SetEvent(s_startEvents[w]);
+	}
+
+	RunWorkerN(job, 0);
+	WaitForSingleObject(s_doneEvent, INFINITE);
+
+	__int64 total = 0;
+	for (int w = 0; w < workerCount; ++w)
+	{
+		total += job.totals[w].value;
+	}
+
+	ReleaseSRWLockExclusive(&s_poolLock);
+	return total;
+}
+
+struct CountContextN
+{
+	unsigned __int64* vector;
+	int length;
+};
+
+static __int64 CountChunkN(void* context, int chunk)
+{
+	CountContextN& count = *(CountContextN*)context;
+	int start = chunk * CountChunkWords;
+	int length = count.length - start;
+	if (length > CountChunkWords) length = CountChunkWords;
+
+	return CountN(count.vector + start, length);
+}
+
+// Where chunks end on cache line boundaries in the match vector, so no two workers write the same line.
+// The first chunk also covers the partial line (and partial word, if bitOffset isn't zero) the vector starts in.
+struct WhereContextN
+{
+	WhereTermN term;
+	BooleanOperatorN bOp;
+	unsigned __int64* vector;
+	int bitOffset;
+	int length;
+	int alignWords;
+};
+
+static __int64 WhereChunkN(void* context, int chunk)
+{
+	WhereContextN& where = *(WhereContextN*)context;
+
+	__int64 startRow = (chunk == 0 ? 0 : ((__int64)where.alignWords + (__int64)chunk * WhereChunkWords) * 64 - where.bitOffset);
+	__int64 endRow = ((__int64)where.alignWords + (__int64)(chunk + 1) * WhereChunkWords) * 64 - where.bitOffset;
+	if (endRow > where.length) endRow = where.length;
+	if (startRow >= endRow) return 0;
+
+	__int64 bit = startRow + where.bitOffset;
+	WhereN(where.term, (int)startRow, (int)(endRow - startRow), where.bOp, where.vector + (bit >> 6), (int)(bit & 63));
+	return 0;
+}
+
+static void WhereParallelN(WhereContextN& where)
+{
+	// Words from the start of the vector until one begins a cache line
+	where.alignWords = (int)(((64 - ((unsigned __int64)where.vector & 63)) & 63) >> 3);
+
+	__int64 words = ((__int64)where.bitOffset + where.length + 63) >> 6;
+	__int64 chunkCount = (words - where.alignWords + WhereChunkWords - 1) / WhereChunkWords;
+	if (chunkCount < 1) chunkCount = 1;
+
+	RunParallelN(WhereChunkN, &where, (int)chunkCount);
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		Int32 ParallelN::Count(array<UInt64>^ vector)
+		{
+			if (vector->Length == 0) return 0;
+			COUNT_KERNEL(ParallelCount, (Int64)vector->Length * 64, (Int64)vector->Length * 8);
+
+			pin_ptr<UInt64> pVector = &vector[0];
+
+			CountContextN count;
+			count.vector = pVector;
+			count.length = vector->Length;
+
+			int chunkCount = (int)(((__int64)vector->Length + CountChunkWords - 1) / CountChunkWords);
+			return (Int32)RunParallelN(CountChunkN, &count, chunkCount);
+		}
+
+		void ParallelN::Where(Array^ column, Int32 index, Int32 length, Byte cOp, Object^ value, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > column->Length) throw gcnew IndexOutOfRangeException("column");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperator");
+			if (bOp > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("booleanOperator");
+			if (length == 0) return;
+
+			COUNT_KERNEL(ParallelWhere, length, (Int64)length * (Buffer::ByteLength(column) / column->Length));
+
+			GCHandle handle = GCHandle::Alloc(column, GCHandleType::Pinned);
+
+			try
+			{
+				pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+				WhereContextN where;
+				BuildTerm(column, value, cOp, handle.AddrOfPinnedObject().ToPointer(), index, where.term);
+				where.bOp = (BooleanOperatorN)bOp;
+				where.vector = pVector;
+				where.bitOffset = vectorIndex & 63;
+				where.length = length;
+
+				WhereParallelN(where);
+			}
+			finally
+			{
+				handle.Free();
+			}
+		}
+
+		Int32 ParallelN::WorkerLimit::get()
+		{
+			return s_workerLimit;
+		}
+
+		void ParallelN::WorkerLimit::set(Int32 value)
+		{
+			if (value < 0) throw gcnew ArgumentOutOfRangeException("value");
+			s_workerLimit = value;
+		}
+	}
+}
@@ -0,0 +1,27 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Count and Where for arrays too large for one core's bandwidth, split across a native worker pool.
+		// Small inputs, or calls made while another parallel call is running, run on the calling thread instead,
+		// so callers which already run partitions in parallel (like ParallelRunner) don't oversubscribe the machine.
+		public ref class ParallelN
+		{
+		public:
+			// Return the number of set bits in vector
+			static Int32 Count(array<UInt64>^ vector);
+
+			// Compare 'length' values of column from 'index' to value, merging the results into vector from 'vectorIndex' with booleanOperator
+			static void Where(Array^ column, Int32 index, Int32 length, Byte compareOperator, Object^ value, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// The most threads (including the caller) one call uses; zero, the default, uses one per processor
+			static property Int32 WorkerLimit { Int32 get(); void set(Int32 value); }
+		};
+	}
+}
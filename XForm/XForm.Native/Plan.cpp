@@ -0,0 +1,204 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include <string.h>
+#include "Operator.h"
+#include "WhereN.h"
+#include "BitVectorN.h"
+#include "Comparer.h"
+#include "Plan.h"
+#include "KernelCounters.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+// WARNING: Values must stay in sync with the Plan opcode literals
+enum PlanOpcodeN : char
+{
+	PlanNone = 0,
+	PlanAll = 1,
+	PlanWhere = 2,
+	PlanAnd = 3,
+	PlanOr = 4,
+	PlanAndNot = 5,
+	PlanNot = 6,
+	PlanCount = 7,
+	PlanPage = 8
+};
+
+// One instruction with the pinned buffers it reads and writes resolved
+struct PlanStepN
+{
+	PlanOpcodeN opcode;
+	BooleanOperatorN bOp;
+	unsigned __int64* target;
+	unsigned __int64* source;
+	int* page;
+	int pageLength;
+	WhereTermN term;
+};
+
+static int ExecutePlanN(PlanStepN* steps, int stepCount, int length, int* results)
+{
+	// Vectors are 'words' long, and bits past length in the last word stay clear
+	int words = (length + 63) >> 6;
+	unsigned __int64 lastValid = ((length & 63) == 0 ? ~0x0ULL : (0x1ULL << (length & 63)) - 1);
+	int resultCount = 0;
+
+	for (int s = 0; s < stepCount; ++s)
+	{
+		PlanStepN& step = steps[s];
+		unsigned __int64* target = step.target;
+		unsigned __int64* source = step.source;
+
+		switch (step.opcode)
+		{
+		case PlanOpcodeN::PlanNone:
+			memset(target, 0, words * sizeof(unsigned __int64));
+			break;
+		case PlanOpcodeN::PlanAll:
+			memset(target, 0xFF, words * sizeof(unsigned __int64));
+			if (words > 0) target[words - 1] = lastValid;
+			break;
+		case PlanOpcodeN::PlanWhere:
+			WhereN(step.term, 0, length, step.bOp, target, 0);
+			break;
+		case PlanOpcodeN::PlanAnd:
+			for (int i = 0; i < words; ++i) target[i] &= source[i];
+			break;
+		case PlanOpcodeN::PlanOr:
+			for (int i = 0; i < words; ++i) target[i] |= source[i];
+			break;
+		case PlanOpcodeN::PlanAndNot:
+			for (int i = 0; i < words; ++i) target[i] &= ~source[i];
+			break;
+		case PlanOpcodeN::PlanNot:
+			for (int i = 0; i < words; ++i) target[i] = ~target[i];
+			if (words > 0) target[words - 1] &= lastValid;
+			break;
+		case PlanOpcodeN::PlanCount:
+			results[resultCount++] = CountN(target, words);
+			break;
+		case PlanOpcodeN::PlanPage:
+		{
+			int start = 0;
+			results[resultCount++] = PageN(target, words, &start, step.page, step.pageLength);
+			break;
+		}
+		}
+	}
+
+	return resultCount;
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Pin buffer the first time an instruction uses it, returning the pinned address
+		static void* PinBuffer(Array^ buffer, array<GCHandle>^ handles, int index)
+		{
+			if (!handles[index].IsAllocated) handles[index] = GCHandle::Alloc(buffer, GCHandleType::Pinned);
+			return handles[index].AddrOfPinnedObject().ToPointer();
+		}
+
+		static unsigned __int64* PinVector(array<array<UInt64>^>^ vectors, array<GCHandle>^ handles, int index, int words)
+		{
+			if (index >= vectors->Length || vectors[index] == nullptr) throw gcnew ArgumentException(String::Format("Plan refers to vector {0}, which wasn't passed.", index), "vectors");
+			if (vectors[index]->Length < words) throw gcnew IndexOutOfRangeException("vectors");
+			return (unsigned __int64*)PinBuffer(vectors[index], handles, index);
+		}
+
+		static void FreeAll(array<GCHandle>^ handles)
+		{
+			for (int i = 0; i < handles->Length; ++i)
+			{
+				if (handles[i].IsAllocated) handles[i].Free();
+			}
+		}
+
+		Int32 Plan::Execute(array<Byte>^ program, Int32 instructionCount, array<Array^>^ columns, array<Int32>^ indices, array<Object^>^ values, array<array<UInt64>^>^ vectors, array<array<Int32>^>^ pages, Int32 length, array<Int32>^ results)
+		{
+			if (instructionCount < 0 || instructionCount > InstructionLimit) throw gcnew ArgumentOutOfRangeException("instructionCount");
+			if (program->Length < instructionCount * InstructionLength) throw gcnew ArgumentException("program must have instructionCount instructions.", "program");
+			if (length < 0) throw gcnew IndexOutOfRangeException();
+			int words = (length + 63) >> 6;
+
+			// Pin each buffer once, however many instructions use it
+			PlanStepN steps[InstructionLimit];
+			array<GCHandle>^ vectorHandles = gcnew array<GCHandle>(vectors->Length);
+			array<GCHandle>^ columnHandles = gcnew array<GCHandle>(columns == nullptr ? 0 : columns->Length);
+			array<GCHandle>^ pageHandles = gcnew array<GCHandle>(pages == nullptr ? 0 : pages->Length);
+			pin_ptr<Int32> pResults = nullptr;
+
+			try
+			{
+				int resultCount = 0;
+
+				for (int s = 0; s < instructionCount; ++s)
+				{
+					int at = s * InstructionLength;
+					Byte opcode = program[at];
+					Byte target = program[at + 1];
+					Byte left = program[at + 2];
+					Byte right = program[at + 3];
+
+					PlanStepN& step = steps[s];
+					step.opcode = (PlanOpcodeN)opcode;
+					step.bOp = (BooleanOperatorN)program[at + 5];
+					step.target = PinVector(vectors, vectorHandles, target, words);
+
+					switch (opcode)
+					{
+					case None:
+					case All:
+					case Not:
+						break;
+					case Where:
+						if (columns == nullptr || left >= columns->Length || columns[left] == nullptr) throw gcnew ArgumentException(String::Format("Plan refers to column {0}, which wasn't passed.", left), "columns");
+						if (values == nullptr || right >= values->Length) throw gcnew ArgumentException(String::Format("Plan refers to value {0}, which wasn't passed.", right), "values");
+						if (indices == nullptr || left >= indices->Length) throw gcnew ArgumentException(String::Format("Plan refers to column {0}, which has no index in indices.", left), "indices");
+						if (indices[left] < 0 || indices[left] + length > columns[left]->Length) throw gcnew IndexOutOfRangeException("indices");
+						if (program[at + 4] > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("program");
+						if (program[at + 5] > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("program");
+						BuildTerm(columns[left], values[right], program[at + 4], PinBuffer(columns[left], columnHandles, left), indices[left], step.term);
+						break;
+					case And:
+					case Or:
+					case AndNot:
+						step.source = PinVector(vectors, vectorHandles, left, words);
+						break;
+					case Count:
+						resultCount++;
+						break;
+					case Page:
+						if (pages == nullptr || left >= pages->Length || pages[left] == nullptr) throw gcnew ArgumentException(String::Format("Plan refers to page {0}, which wasn't passed.", left), "pages");
+						step.page = (int*)PinBuffer(pages[left], pageHandles, left);
+						step.pageLength = pages[left]->Length;
+						resultCount++;
+						break;
+					default:
+						throw gcnew ArgumentException(String::Format("Plan instruction {0} has unknown opcode {1}.", s, opcode), "program");
+					}
+				}
+
+				if (resultCount > results->Length) throw gcnew ArgumentException("results must have room for every Count and Page result.", "results");
+				if (resultCount > 0) pResults = &results[0];
+
+				COUNT_KERNEL(PlanExecute, (Int64)length * instructionCount, (Int64)words * 8 * instructionCount);
+				return ExecutePlanN(steps, instructionCount, length, pResults);
+			}
+			finally
+			{
+				FreeAll(vectorHandles);
+				FreeAll(columnHandles);
+				FreeAll(pageHandles);
+			}
+		}
+	}
+}
@@ -0,0 +1,49 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Run a sequence of filter, combine, and count operations over one batch of rows in a single call,
+		// so the buffers are pinned and checked once and there's one managed to native transition for the whole batch.
+		//
+		// The program is InstructionLength bytes per instruction: Opcode, Target, Left, Right, CompareOperator, BooleanOperator.
+		// Target is always an index into vectors; vector bits past 'length' must be clear and are kept clear.
+		public ref class Plan
+		{
+		public:
+			literal Int32 InstructionLength = 6;
+			literal Int32 InstructionLimit = 64;
+
+			// vectors[Target] = no rows
+			literal Byte None = 0;
+
+			// vectors[Target] = every row in [0, length)
+			literal Byte All = 1;
+
+			// vectors[Target] BooleanOperator= (columns[Left] from indices[Left]) CompareOperator values[Right]
+			literal Byte Where = 2;
+
+			// vectors[Target] = vectors[Target] op vectors[Left]
+			literal Byte And = 3;
+			literal Byte Or = 4;
+			literal Byte AndNot = 5;
+
+			// vectors[Target] = rows in [0, length) not in vectors[Target]
+			literal Byte Not = 6;
+
+			// Append the number of rows in vectors[Target] to results
+			literal Byte Count = 7;
+
+			// Write the rows in vectors[Target] to pages[Left] (up to its length) and append the number written to results
+			literal Byte Page = 8;
+
+			// Run instructionCount instructions from program over 'length' rows, returning the number of results appended
+			static Int32 Execute(array<Byte>^ program, Int32 instructionCount, array<Array^>^ columns, array<Int32>^ indices, array<Object^>^ values, array<array<UInt64>^>^ vectors, array<array<Int32>^>^ pages, Int32 length, array<Int32>^ results);
+		};
+	}
+}
@@ -4,7 +4,12 @@
 #include "stdafx.h"
 #include <intrin.h>
 #include <nmmintrin.h>
+#include <string.h>
+#include "Operator.h"
+#include "WhereN.h"
 #include "String8N.h"
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
 
 #pragma unmanaged
 const int Utf8IndexOfMode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ORDERED;
@@ -14,43 +19,193 @@ const int Utf8RangeMaskMode = _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES | _SIDD_UNIT_MA
 const __m128i uppercaseRange = { 'A', 'Z' };
 const __m128i caseConvert = { 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20, 0x20 };
 
-static int SplitTsvN(unsigned __int8* content, int contentIndex, int contentEnd, unsigned __int64* cellVector, unsigned __int64* rowVector)
+// Return a bit for each of the 64 bytes in (block1, block2) equal to value
+static __forceinline unsigned __int64 MatchN(__m256i block1, __m256i block2, __m256i value)
 {
-	// TODO: Fill only one vector (cells) and return rowCount.
-	// Properly handle uneven last < 64 characters.
+	unsigned int low = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, value));
+	unsigned int high = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block2, value));
+	return ((unsigned __int64)high << 32) | low;
+}
+
+// Return a mask with each bit set to the XOR of it and all lower bits; quote bits become a mask of quoted bytes
+static __forceinline unsigned __int64 PrefixXorN(unsigned __int64 bits)
+{
+	return _mm_cvtsi128_si64(_mm_clmulepi64_si128(_mm_set_epi64x(0, bits), _mm_set1_epi8((char)0xFF), 0));
+}
 
+// Set a bit in cellVector for the end of each cell in content [contentIndex, contentEnd) and return the number of rows ended.
+//  - Cells end on the delimiter or on the newline ending the row; the bit for a "\r\n" is set on the '\r' only.
+//  - If quoted, delimiters and newlines between double quotes are ignored (CSV). Splitting must start outside a quoted value.
+//  - A '\r' which is the last byte in range isn't known to end a row, so ranges should end after a '\n'.
+template<char delimiter, bool quoted>
+static int SplitN(unsigned __int8* content, int contentIndex, int contentEnd, unsigned __int64* cellVector)
+{
 	int rowCount = 0;
 
 	// Load vectors of the delimiters we're looking for
+	__m256i delimiterValue = _mm256_set1_epi8(delimiter);
 	__m256i newline = _mm256_set1_epi8('\n');
-	__m256i tab = _mm256_set1_epi8('\t');
+	__m256i carriageReturn = _mm256_set1_epi8('\r');
+	__m256i quote = _mm256_set1_epi8('"');
+
+	// Track the state carried into the next block: a '\r' in the last bit, and whether a quoted value is still open
+	unsigned __int64 previousReturn = 0;
+	unsigned __int64 inQuote = 0;
+
+	__declspec(align(32)) unsigned __int8 tail[64];
 
-	int index = contentIndex;
-	for (; index < contentEnd; index += 64)
+	for (int index = contentIndex; index < contentEnd; index += 64)
 	{
+		int blockLength = contentEnd - index;
+		unsigned __int8* block = &content[index];
+		unsigned __int64 valid = ~0x0ULL;
+
+		// Copy the last partial block, if any, into a zeroed buffer so the loads don't read past the content
+		if (blockLength < 64)
+		{
+			memset(tail, 0, sizeof(tail));
+			memcpy(tail, block, blockLength);
+			block = tail;
+			valid = (0x1ULL << blockLength) - 1;
+		}
+
 		// Load 64 bytes to scan
-		__m256i block1 = _mm256_loadu_si256((__m256i*)(&content[index]));
-		__m256i block2 = _mm256_loadu_si256((__m256i*)(&content[index + 32]));
+		__m256i block1 = _mm256_loadu_si256((__m256i*)(&block[0]));
+		__m256i block2 = _mm256_loadu_si256((__m256i*)(&block[32]));
 
-		// Find all tabs and newlines and build bit vectors of them
-		unsigned int tabs1 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, tab));
-		unsigned int tabs2 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block2, tab));
-		unsigned int lines1 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block1, newline));
-		unsigned int lines2 = _mm256_movemask_epi8(_mm256_cmpeq_epi8(block2, newline));
+		// Find all delimiters, newlines, and carriage returns and build bit vectors of them
+		unsigned __int64 delimiters = MatchN(block1, block2, delimiterValue);
+		unsigned __int64 lines = MatchN(block1, block2, newline);
+		unsigned __int64 returns = MatchN(block1, block2, carriageReturn);
 
-		unsigned __int64 lines = ((unsigned __int64)lines2 << 32) | lines1;
-		unsigned __int64 cells = ((unsigned __int64)tabs2 << 32) | tabs1 | lines;
+		// A '\r' followed by a '\n' ends the row; the '\n' after it is part of the same row end
+		unsigned __int64 nextIsLine = (blockLength > 64 && content[index + 64] == '\n' ? 0x1ULL << 63 : 0);
+		unsigned __int64 lineReturns = returns & ((lines >> 1) | nextIsLine);
+		lines &= ~((returns << 1) | previousReturn);
+		previousReturn = (lineReturns >> 63);
 
-		// Cells are every tab or line and Rows are every line
-		cellVector[index >> 6] = cells;
-		rowVector[index >> 6] = lines;
+		// Ignore delimiters and newlines inside quoted values
+		if (quoted)
+		{
+			unsigned __int64 inQuoted = PrefixXorN(MatchN(block1, block2, quote)) ^ inQuote;
+			inQuote = (unsigned __int64)((__int64)inQuoted >> 63);
+
+			delimiters &= ~inQuoted;
+			lines &= ~inQuoted;
+			lineReturns &= ~inQuoted;
+		}
+
+		// Rows end at every unquoted line end; cells end at every unquoted delimiter or row end
+		unsigned __int64 rows = (lines | lineReturns) & valid;
+		cellVector[index >> 6] = (rows | delimiters) & valid;
 
 		// Count lines
-		rowCount += (int)_mm_popcnt_u64(lines);
+		rowCount += (int)_mm_popcnt_u64(rows);
+	}
+
+	return rowCount;
+}
+
+// Strip the quotes around a quoted CSV cell and unescape each doubled quote within it, in place, updating the cell start and length
+static __forceinline void UnquoteN(unsigned __int8* content, int* start, int* length)
+{
+	if (*length < 2 || content[*start] != '"' || content[*start + *length - 1] != '"') return;
+
+	unsigned __int8* value = &content[*start + 1];
+	int valueLength = *length - 2;
+	*start += 1;
+	*length = valueLength;
+
+	// Copy the value over itself from the first quote on, keeping one quote of each pair
+	unsigned __int8* quote = (unsigned __int8*)memchr(value, '"', valueLength);
+	if (quote == nullptr) return;
+
+	int write = (int)(quote - value);
+	for (int read = write; read < valueLength; ++read)
+	{
+		value[write++] = value[read];
+		if (value[read] == '"' && read + 1 < valueLength && value[read + 1] == '"') read++;
 	}
 
-	// Match remaining values individually
+	*length = write;
+}
+
+// Convert the cell end bits from SplitN for content [contentIndex, contentEnd) into the start and length of each cell.
+// Cells are written column-major, so column c of row r is at [c * rowLimit + r]. Missing cells in short rows are written empty,
+// and cells past the last column are dropped. Returns the number of complete rows written and sets nextIndex to the start of the first row not written.
+//  - Cell ends are extracted with tzcnt/blsr, and the row, column, and resume index advance with conditional moves rather than branches.
+//    Only short rows run the loop writing their missing cells.
+//  - Rows end at a '\n' or "\r\n", so a final row without one isn't written; nextIndex is its start.
+//  - If quoted (CSV), quotes around the cells of complete rows are removed and doubled quotes unescaped, rewriting content in place.
+template<bool quoted>
+static int SplitCellsN(unsigned __int8* content, int contentIndex, int contentEnd, unsigned __int64* cellVector, int columnCount, int rowLimit, int* cellStarts, int* cellLengths, int* nextIndex)
+{
+	int row = 0;
+	int column = 0;
+	int cellStart = contentIndex;
+	int rowStart = contentIndex;
+	int discard[1];
+
+	int lastBlock = (contentEnd - 1) >> 6;
+	for (int block = contentIndex >> 6; block <= lastBlock && row < rowLimit; ++block)
+	{
+		// Get the cell ends in this block, excluding any before contentIndex or at and after contentEnd
+		unsigned __int64 bits = cellVector[block];
+		if (block == (contentIndex >> 6)) bits &= (~0x0ULL << (contentIndex & 63));
+		if (block == lastBlock && (contentEnd & 63) != 0) bits &= (0x1ULL << (contentEnd & 63)) - 1;
+
+		for (int count = (int)_mm_popcnt_u64(bits); count > 0; --count)
+		{
+			// Find the next cell end and clear it
+			int end = (block << 6) + (int)_tzcnt_u64(bits);
+			bits = _blsr_u64(bits);
+
+			// Cells end on a delimiter, a '\n', or the '\r' of a "\r\n"
+			unsigned __int8 delimiter = content[end];
+			int isReturn = (delimiter == '\r');
+			int isRowEnd = (delimiter == '\n') | isReturn;
+			int isWritten = (row < rowLimit);
+
+			// Write the cell, or to a discarded slot for cells past the last column or the row limit
+			int inRange = (column < columnCount) & isWritten;
+			int slot = (inRange ? column * rowLimit + row : 0);
+			(inRange ? cellStarts : discard)[slot] = cellStart;
+			(inRange ? cellLengths : discard)[slot] = end - cellStart;
+
+			// The next cell starts after the delimiter (skipping both bytes of "\r\n")
+			cellStart = end + 1 + isReturn;
+			column++;
+
+			// Write empty cells for any columns missing from a short row
+			int missing = ((isRowEnd & isWritten & (column < columnCount)) ? columnCount - column : 0);
+			for (int m = 0; m < missing; ++m)
+			{
+				cellStarts[(column + m) * rowLimit + row] = cellStart;
+				cellLengths[(column + m) * rowLimit + row] = 0;
+			}
 
+			// At a row end, start the next row
+			rowStart = ((isRowEnd & isWritten) ? cellStart : rowStart);
+			column = (isRowEnd ? 0 : column);
+			row += isRowEnd;
+		}
+	}
+
+	int rowCount = (row < rowLimit ? row : rowLimit);
+
+	// Unquote only the cells of complete rows, so rows from nextIndex on are left as-is to split again
+	if (quoted)
+	{
+		for (int c = 0; c < columnCount; ++c)
+		{
+			for (int r = 0; r < rowCount; ++r)
+			{
+				UnquoteN(content, &cellStarts[c * rowLimit + r], &cellLengths[c * rowLimit + r]);
+			}
+		}
+	}
+
+	*nextIndex = rowStart;
 	return rowCount;
 }
 
@@ -187,18 +342,757 @@ static int IndexOfAllInternal(Byte* text, Int32 textIndex, Int32 textLength, Byt
 	return resultCount;
 }
 
+// IndexOfAny groups values into eight buckets (value v in bucket v % 8) and matches the first bytes of each with nibble lookup tables (Teddy)
+const int IndexOfAnyBucketCount = 8;
+const int IndexOfAnyPrefixLength = 3;
+
+template<bool ignoreCase>
+static __forceinline unsigned __int8 ToLowerN(unsigned __int8 c)
+{
+	return (ignoreCase && c >= 'A' && c <= 'Z' ? c | 0x20 : c);
+}
+
+template<bool ignoreCase>
+static __forceinline __m256i ToLowerN(__m256i block)
+{
+	if (!ignoreCase) return block;
+
+	// Set 0x20 in bytes between 'A' and 'Z' (signed comparison, so bytes over 0x7F aren't changed)
+	__m256i isUpper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+	return _mm256_or_si256(block, _mm256_and_si256(isUpper, _mm256_set1_epi8(0x20)));
+}
+
+template<bool ignoreCase>
+static bool EqualsAnyN(Byte* text, Byte* value, int valueLength)
+{
+	for (int i = 0; i < valueLength; ++i)
+	{
+		if (ToLowerN<ignoreCase>(text[i]) != value[i]) return false;
+	}
+
+	return true;
+}
+
+template<bool ignoreCase>
+static __forceinline bool EqualsAvx2N(Byte* text, Byte* value, int valueLength)
+{
+	int i = 0;
+	for (; i + 32 <= valueLength; i += 32)
+	{
+		__m256i textBlock = ToLowerN<ignoreCase>(_mm256_loadu_si256((__m256i*)(&text[i])));
+		__m256i valueBlock = ToLowerN<ignoreCase>(_mm256_loadu_si256((__m256i*)(&value[i])));
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(textBlock, valueBlock)) != -1) return false;
+	}
+
+	for (; i < valueLength; ++i)
+	{
+		if (ToLowerN<ignoreCase>(text[i]) != ToLowerN<ignoreCase>(value[i])) return false;
+	}
+
+	return true;
+}
+
+// IndexOfAll with AVX2: find candidates where the first and last bytes of value match for 32 indices at a time, then compare the rest.
+// Long values are screened by two bytes 32 indices apart instead of a 16-byte cmpistri and a full comparison per partial match.
+template<bool ignoreCase>
+static int IndexOfAllAvx2Internal(Byte* text, Int32 textIndex, Int32 textLength, Byte* value, Int32 valueLength, Int32* result, Int32 resultLimit)
+{
+	int resultCount = 0;
+	int lastMatchPosition = textLength - valueLength;
+	if (valueLength <= 0 || resultLimit <= 0) return 0;
+
+	__m256i first = _mm256_set1_epi8((char)ToLowerN<ignoreCase>(value[0]));
+	__m256i last = _mm256_set1_epi8((char)ToLowerN<ignoreCase>(value[valueLength - 1]));
+
+	// Scan 32 indices at a time while the loads for the last byte fit in the text
+	int i = textIndex;
+	for (; i + 31 <= lastMatchPosition; i += 32)
+	{
+		__m256i firstBlock = ToLowerN<ignoreCase>(_mm256_loadu_si256((__m256i*)(&text[i])));
+		__m256i lastBlock = ToLowerN<ignoreCase>(_mm256_loadu_si256((__m256i*)(&text[i + valueLength - 1])));
+		unsigned int candidateBits = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, first), _mm256_cmpeq_epi8(lastBlock, last)));
+
+		while (candidateBits != 0)
+		{
+			int matchIndex = i + (int)_tzcnt_u32(candidateBits);
+			candidateBits = _blsr_u32(candidateBits);
+
+			if (EqualsAvx2N<ignoreCase>(text + matchIndex, value, valueLength))
+			{
+				result[resultCount++] = matchIndex;
+				if (resultCount == resultLimit) return resultCount;
+			}
+		}
+	}
+
+	// Check the remaining indices one at a time
+	for (; i <= lastMatchPosition; ++i)
+	{
+		if (EqualsAvx2N<ignoreCase>(text + i, value, valueLength))
+		{
+			result[resultCount++] = i;
+			if (resultCount == resultLimit) return resultCount;
+		}
+	}
+
+	return resultCount;
+}
+
+// Check each value in the buckets set in 'buckets' for a match at text[index], adding each match found.
+// Returns false if the result array filled; results for the partially reported index are removed so the search can resume at it.
+template<bool ignoreCase>
+static bool MatchBucketsN(Byte* text, int index, int textEnd, unsigned int buckets, Byte** values, Int32* valueLengths, Int32 valueCount, Int32* result, Int32* resultValues, Int32& resultCount, Int32 resultLimit)
+{
+	int firstResultAtIndex = resultCount;
+
+	while (buckets != 0)
+	{
+		int bucket = (int)_tzcnt_u32(buckets);
+		buckets = _blsr_u32(buckets);
+
+		for (int v = bucket; v < valueCount; v += IndexOfAnyBucketCount)
+		{
+			if (index + valueLengths[v] > textEnd) continue;
+			if (!EqualsAnyN<ignoreCase>(text + index, values[v], valueLengths[v])) continue;
+
+			if (resultCount == resultLimit)
+			{
+				resultCount = firstResultAtIndex;
+				return false;
+			}
+
+			result[resultCount] = index;
+			resultValues[resultCount] = v;
+			resultCount++;
+		}
+	}
+
+	return true;
+}
+
+// Find every index in text where any of the values match, in one pass, reporting the match index and value index of each.
+// Values must be lowercase if ignoreCase, and resultLimit must be at least valueCount so all matches at one index fit.
+// nextIndex is set to the index to continue searching from if the results filled, or -1 if the search finished.
+template<bool ignoreCase>
+static int IndexOfAnyInternal(Byte* text, Int32 textIndex, Int32 textLength, Byte** values, Int32* valueLengths, Int32 valueCount, Int32* result, Int32* resultValues, Int32 resultLimit, Int32* nextIndex)
+{
+	int resultCount = 0;
+
+	// Match only as many prefix bytes as the shortest value has
+	int prefixLength = IndexOfAnyPrefixLength;
+	for (int v = 0; v < valueCount; ++v)
+	{
+		if (valueLengths[v] < prefixLength) prefixLength = valueLengths[v];
+	}
+
+	// Build tables of the buckets with each low and high nibble at each prefix position
+	__declspec(align(16)) unsigned __int8 lowTable[IndexOfAnyPrefixLength][16] = { 0 };
+	__declspec(align(16)) unsigned __int8 highTable[IndexOfAnyPrefixLength][16] = { 0 };
+	for (int v = 0; v < valueCount; ++v)
+	{
+		unsigned __int8 bucketBit = (unsigned __int8)(1 << (v % IndexOfAnyBucketCount));
+		for (int k = 0; k < prefixLength; ++k)
+		{
+			lowTable[k][values[v][k] & 0x0F] |= bucketBit;
+			highTable[k][values[v][k] >> 4] |= bucketBit;
+		}
+	}
+
+	__m256i low[IndexOfAnyPrefixLength];
+	__m256i high[IndexOfAnyPrefixLength];
+	for (int k = 0; k < prefixLength; ++k)
+	{
+		low[k] = _mm256_broadcastsi128_si256(_mm_load_si128((__m128i*)lowTable[k]));
+		high[k] = _mm256_broadcastsi128_si256(_mm_load_si128((__m128i*)highTable[k]));
+	}
+
+	__m256i nibbleMask = _mm256_set1_epi8(0x0F);
+	__declspec(align(32)) unsigned __int8 candidates[32];
+
+	// Scan 32 indices at a time while the prefix loads fit in the text
+	int i = textIndex;
+	for (; i + 32 + prefixLength - 1 <= textLength; i += 32)
+	{
+		// Find the buckets which could match at each index; a bucket matches if every prefix byte is in a value in it
+		__m256i match = _mm256_set1_epi8((char)0xFF);
+		for (int k = 0; k < prefixLength; ++k)
+		{
+			__m256i block = ToLowerN<ignoreCase>(_mm256_loadu_si256((__m256i*)(&text[i + k])));
+			__m256i lowBuckets = _mm256_shuffle_epi8(low[k], _mm256_and_si256(block, nibbleMask));
+			__m256i highBuckets = _mm256_shuffle_epi8(high[k], _mm256_and_si256(_mm256_srli_epi16(block, 4), nibbleMask));
+			match = _mm256_and_si256(match, _mm256_and_si256(lowBuckets, highBuckets));
+		}
+
+		unsigned int candidateBits = ~(unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(match, _mm256_setzero_si256()));
+		if (candidateBits == 0) continue;
+
+		// Verify the values in each candidate bucket
+		_mm256_store_si256((__m256i*)candidates, match);
+		while (candidateBits != 0)
+		{
+			int j = (int)_tzcnt_u32(candidateBits);
+			candidateBits = _blsr_u32(candidateBits);
+
+			if (!MatchBucketsN<ignoreCase>(text, i + j, textLength, candidates[j], values, valueLengths, valueCount, result, resultValues, resultCount, resultLimit))
+			{
+				*nextIndex = i + j;
+				return resultCount;
+			}
+		}
+	}
+
+	// Check remaining indices against every bucket
+	for (; i < textLength; ++i)
+	{
+		if (!MatchBucketsN<ignoreCase>(text, i, textLength, (1 << IndexOfAnyBucketCount) - 1, values, valueLengths, valueCount, result, resultValues, resultCount, resultLimit))
+		{
+			*nextIndex = i;
+			return resultCount;
+		}
+	}
+
+	*nextIndex = -1;
+	return resultCount;
+}
+
+// Unicode ignoreCase search folds uppercase UTF-8 to lowercase in windows of the text and searches the folded bytes.
+// Folding covers ASCII, Latin-1 Supplement, Greek, and Cyrillic; every folded character has the same UTF-8 length, so indices don't change.
+const int FoldWindowLength = 4096;
+const int FoldValueLimit = 1024;
+
+// Fold the two byte character (lead, next) to lowercase; returns false if it isn't an uppercase character folded
+static __forceinline bool FoldPairN(unsigned __int8& lead, unsigned __int8& next)
+{
+	switch (lead)
+	{
+	case 0xC3:
+		// Latin-1 Supplement: U+00C0 - U+00DE, except U+00D7 (multiplication sign), are +0x20
+		if (next >= 0x80 && next <= 0x9E && next != 0x97) { next += 0x20; return true; }
+		break;
+	case 0xCE:
+		// Greek: U+0391 - U+039F are +0x20; U+03A0 - U+03A9 are +0x20 into the next lead byte
+		if (next >= 0x91 && next <= 0x9F) { next += 0x20; return true; }
+		if (next >= 0xA0 && next <= 0xA9 && next != 0xA2) { lead = 0xCF; next -= 0x20; return true; }
+		break;
+	case 0xD0:
+		// Cyrillic: U+0410 - U+041F are +0x20; U+0420 - U+042F are +0x20 and U+0400 - U+040F are +0x50, into the next lead byte
+		if (next >= 0x90 && next <= 0x9F) { next += 0x20; return true; }
+		if (next >= 0xA0 && next <= 0xAF) { lead = 0xD1; next -= 0x20; return true; }
+		if (next >= 0x80 && next <= 0x8F) { lead = 0xD1; next += 0x10; return true; }
+		break;
+	}
+
+	return false;
+}
+
+// Fold text [start, end) to lowercase into folded. text[textEnd - 1] is the last byte which may be read.
+// Blocks of 16 ASCII bytes (no high bits set) are folded with SSE2; other blocks a character at a time.
+static void FoldN(Byte* text, int start, int end, int textEnd, Byte* folded)
+{
+	Byte* out = folded - start;
+	int i = start;
+
+	// If start is on the second byte of a character, fold it with the lead byte before it
+	if (i > 0 && i < end && (text[i] & 0xC0) == 0x80)
+	{
+		unsigned __int8 lead = text[i - 1];
+		unsigned __int8 next = text[i];
+		FoldPairN(lead, next);
+		out[i++] = next;
+	}
+
+	__m128i belowUpper = _mm_set1_epi8('A' - 1);
+	__m128i aboveUpper = _mm_set1_epi8('Z' + 1);
+	__m128i caseBit = _mm_set1_epi8(0x20);
+
+	while (i < end)
+	{
+		if (i + 16 <= end)
+		{
+			__m128i block = _mm_loadu_si128((__m128i*)(&text[i]));
+			if (_mm_movemask_epi8(block) == 0)
+			{
+				__m128i isUpper = _mm_and_si128(_mm_cmpgt_epi8(block, belowUpper), _mm_cmpgt_epi8(aboveUpper, block));
+				_mm_storeu_si128((__m128i*)(&out[i]), _mm_or_si128(block, _mm_and_si128(isUpper, caseBit)));
+				i += 16;
+				continue;
+			}
+		}
+
+		// Fold the characters in this block one at a time; the last may end just after the block
+		int blockEnd = (i + 16 < end ? i + 16 : end);
+		while (i < blockEnd)
+		{
+			unsigned __int8 c = text[i];
+			if (c < 0x80)
+			{
+				out[i++] = ToLowerN<true>(c);
+			}
+			else if (i + 1 < textEnd && (text[i + 1] & 0xC0) == 0x80)
+			{
+				unsigned __int8 next = text[i + 1];
+				FoldPairN(c, next);
+				out[i] = c;
+				if (i + 1 < end) out[i + 1] = next;
+				i += 2;
+			}
+			else
+			{
+				out[i++] = c;
+			}
+		}
+	}
+}
+
+static __forceinline bool IsAsciiN(Byte* value, int valueLength)
+{
+	for (int i = 0; i < valueLength; ++i)
+	{
+		if (value[i] >= 0x80) return false;
+	}
+
+	return true;
+}
+
+// IndexOfAll ignoring case for non-ASCII values. valueLength must be at most FoldValueLimit.
+// Candidates are screened on the first and last folded bytes 16 indices at a time (SSE2), so this runs on any x64 CPU.
+static int IndexOfAllFoldInternal(Byte* text, Int32 textIndex, Int32 textLength, Byte* value, Int32 valueLength, Int32* result, Int32 resultLimit)
+{
+	Byte foldedValue[FoldValueLimit];
+	Byte window[FoldWindowLength];
+	int resultCount = 0;
+
+	if (valueLength <= 0 || valueLength > FoldValueLimit || resultLimit <= 0) return 0;
+	FoldN(value, 0, valueLength, valueLength, foldedValue);
+
+	__m128i first = _mm_set1_epi8((char)foldedValue[0]);
+	__m128i last = _mm_set1_epi8((char)foldedValue[valueLength - 1]);
+
+	// Fold and search each window, overlapping the next window start by valueLength - 1 so matches across windows are found
+	int windowStart = textIndex;
+	while (windowStart + valueLength <= textLength)
+	{
+		int windowEnd = (windowStart + FoldWindowLength < textLength ? windowStart + FoldWindowLength : textLength);
+		FoldN(text, windowStart, windowEnd, textLength, window);
+
+		int lastMatchPosition = windowEnd - windowStart - valueLength;
+		int i = 0;
+		for (; i <= lastMatchPosition; i += 16)
+		{
+			unsigned int candidateBits;
+			if (i + 15 <= lastMatchPosition)
+			{
+				__m128i firstBlock = _mm_loadu_si128((__m128i*)(&window[i]));
+				__m128i lastBlock = _mm_loadu_si128((__m128i*)(&window[i + valueLength - 1]));
+				candidateBits = (unsigned int)_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(firstBlock, first), _mm_cmpeq_epi8(lastBlock, last)));
+			}
+			else
+			{
+				// Check every remaining index
+				candidateBits = (1U << (lastMatchPosition - i + 1)) - 1;
+			}
+
+			while (candidateBits != 0)
+			{
+				unsigned long bit;
+				_BitScanForward(&bit, candidateBits);
+				candidateBits &= candidateBits - 1;
+
+				int matchIndex = i + (int)bit;
+				int k = 0;
+				while (k < valueLength && window[matchIndex + k] == foldedValue[k]) ++k;
+
+				if (k == valueLength)
+				{
+					result[resultCount++] = windowStart + matchIndex;
+					if (resultCount == resultLimit) return resultCount;
+				}
+			}
+		}
+
+		if (windowEnd == textLength) break;
+		windowStart = windowEnd - valueLength + 1;
+	}
+
+	return resultCount;
+}
+
+int IndexOfAllN(unsigned __int8* text, int textIndex, int textLength, unsigned __int8* value, int valueLength, bool ignoreCase, int* result, int resultLimit)
+{
+	bool avx2 = SupportedN.Avx2 && SupportedN.Bmi1;
+
+	if (ignoreCase)
+	{
+		// Fold non-ASCII values with Unicode case pairs; ASCII values can only match ASCII text, so ASCII folding matches correctly
+		if (valueLength <= FoldValueLimit && !IsAsciiN(value, valueLength))
+		{
+			return IndexOfAllFoldInternal(text, textIndex, textLength, value, valueLength, result, resultLimit);
+		}
+
+		return (avx2 ? IndexOfAllAvx2Internal<true>(text, textIndex, textLength, value, valueLength, result, resultLimit) : IndexOfAllInternal<true>(text, textIndex, textLength, value, valueLength, result, resultLimit));
+	}
+	else
+	{
+		return (avx2 ? IndexOfAllAvx2Internal<false>(text, textIndex, textLength, value, valueLength, result, resultLimit) : IndexOfAllInternal<false>(text, textIndex, textLength, value, valueLength, result, resultLimit));
+	}
+}
+
+// String8 column Where: compare each row of a String8 column to a constant.
+// Row r is text[start, ends[r] - endsOffset), where row 0 starts at firstStart and each later row starts where the previous row ended.
+struct String8ValueN
+{
+	const Byte* bytes;
+	int length;
+
+	// The first min(length, 8) bytes in the low bytes of a word, lowercased for StartsWith
+	unsigned __int64 prefix;
+};
+
+// Return the first 'length' (up to 8) bytes at p in the low bytes of a word with the remaining bytes zero.
+// Reads a whole word when it fits before textEnd, so only rows at the very end of the text copy byte by byte.
+static __forceinline unsigned __int64 LoadPrefixN(const Byte* p, int length, const Byte* textEnd)
+{
+	if (length >= 8) return *(unsigned __int64*)p;
+	if (p + 8 <= textEnd) return _bzhi_u64(*(unsigned __int64*)p, 8 * length);
+
+	unsigned __int64 word = 0;
+	memcpy(&word, p, length);
+	return word;
+}
+
+// Set 0x20 in each byte of word between 'A' and 'Z', as ToLowerN<true> does for one byte
+static __forceinline unsigned __int64 ToLowerWordN(unsigned __int64 word)
+{
+	const unsigned __int64 high = 0x8080808080808080ULL;
+	unsigned __int64 low = word & ~high;
+
+	// Each byte's high bit is set if it is ASCII, at least 'A', and not over 'Z'
+	unsigned __int64 upper = ~word & (low + 0x3F3F3F3F3F3F3F3FULL) & ~(low + 0x2525252525252525ULL) & high;
+	return word | (upper >> 2);
+}
+
+// Return the index of the first byte which differs between left and right, or length if they are equal
+static __forceinline int FirstDifferenceN(const Byte* left, const Byte* right, int length)
+{
+	int i = 0;
+	for (; i + 32 <= length; i += 32)
+	{
+		unsigned int equal = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((__m256i*)(&left[i])), _mm256_loadu_si256((__m256i*)(&right[i]))));
+		if (equal != 0xFFFFFFFF) return i + (int)_tzcnt_u32(~equal);
+	}
+
+	for (; i + 8 <= length; i += 8)
+	{
+		unsigned __int64 difference = *(unsigned __int64*)(&left[i]) ^ *(unsigned __int64*)(&right[i]);
+		if (difference != 0) return i + (int)(_tzcnt_u64(difference) >> 3);
+	}
+
+	for (; i < length; ++i)
+	{
+		if (left[i] != right[i]) return i;
+	}
+
+	return length;
+}
+
+// Compare one row to the value in ordinal byte order, as String8.CompareTo: negative if the row sorts earlier, zero if equal, positive if later
+static __forceinline int CompareRowN(const Byte* row, int rowLength, const String8ValueN& value, const Byte* textEnd)
+{
+	int common = (rowLength < value.length ? rowLength : value.length);
+	int prefixLength = (common < 8 ? common : 8);
+
+	// Compare the first eight bytes as big-endian words
+	unsigned __int64 left = _byteswap_uint64(LoadPrefixN(row, prefixLength, textEnd));
+	unsigned __int64 right = _byteswap_uint64(_bzhi_u64(value.prefix, 8 * prefixLength));
+	if (left != right) return (left < right ? -1 : 1);
+
+	if (common > 8)
+	{
+		int i = 8 + FirstDifferenceN(row + 8, value.bytes + 8, common - 8);
+		if (i < common) return (row[i] < value.bytes[i] ? -1 : 1);
+	}
+
+	return rowLength - value.length;
+}
+
+// Return whether one row, already known to be long enough, equals (or for StartsWith, case-insensitively starts with) the value.
+// Rows are rejected on the first eight bytes before the rest is compared.
+template<CompareOperatorN cOp>
+static __forceinline bool MatchRowN(const Byte* row, const String8ValueN& value, const Byte* textEnd)
+{
+	const bool ignoreCase = (cOp == CompareOperatorN::StartsWith);
+	int prefixLength = (value.length < 8 ? value.length : 8);
+
+	unsigned __int64 prefix = LoadPrefixN(row, prefixLength, textEnd);
+	if (ignoreCase) prefix = ToLowerWordN(prefix);
+	if (prefix != value.prefix) return false;
+
+	return (value.length <= 8 || EqualsAvx2N<ignoreCase>((Byte*)row + 8, (Byte*)value.bytes + 8, value.length - 8));
+}
+
+template<CompareOperatorN cOp>
+static __forceinline bool IsLengthCandidateN(int length, int valueLength)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+	case CompareOperatorN::NotEqual:
+		return length == valueLength;
+	case CompareOperatorN::StartsWith:
+		return length >= valueLength;
+	default:
+		return true;
+	}
+}
+
+// Return a bit for each of the 'count' (up to 64) rows ending at ends[0, count) which could match on length alone.
+// 'previousEnd' is the end of the row before ends[0]; when it is also ends[-1], full blocks find lengths eight rows at a time.
+// Sets 'invalid' if any row has a negative length, as ends must never decrease.
+template<CompareOperatorN cOp>
+static __forceinline unsigned __int64 LengthCandidatesN(const int* ends, int previousEnd, bool previousInArray, int count, int valueLength, bool& invalid)
+{
+	unsigned __int64 candidates = 0;
+
+	if (count == 64 && previousInArray)
+	{
+		__m256i valueLengths = _mm256_set1_epi32(valueLength);
+		__m256i negative = _mm256_setzero_si256();
+
+		for (int i = 0; i < 64; i += 8)
+		{
+			__m256i lengths = _mm256_sub_epi32(_mm256_loadu_si256((__m256i*)(&ends[i])), _mm256_loadu_si256((__m256i*)(&ends[i - 1])));
+			negative = _mm256_or_si256(negative, lengths);
+
+			unsigned int bits;
+			if (cOp == CompareOperatorN::Equal || cOp == CompareOperatorN::NotEqual)
+			{
+				bits = (unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(lengths, valueLengths)));
+			}
+			else if (cOp == CompareOperatorN::StartsWith)
+			{
+				bits = ~(unsigned int)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(valueLengths, lengths))) & 0xFF;
+			}
+			else
+			{
+				bits = 0xFF;
+			}
+
+			candidates |= (unsigned __int64)bits << i;
+		}
+
+		if (_mm256_movemask_ps(_mm256_castsi256_ps(negative)) != 0) invalid = true;
+		return candidates;
+	}
+
+	for (int i = 0; i < count; ++i)
+	{
+		int length = ends[i] - previousEnd;
+		if (length < 0) invalid = true;
+		if (IsLengthCandidateN<cOp>(length, valueLength)) candidates |= (0x1ULL << i);
+		previousEnd = ends[i];
+	}
+
+	return candidates;
+}
+
+// Compare 'length' rows to the value, merging the results into matchVector from bitOffset with bOp.
+// Each block of 64 rows is screened on row lengths, checked to be within the text, and only then are the candidate rows read.
+// Returns false, without reading the block, if ends decrease or run past the text.
+template<CompareOperatorN cOp>
+static bool WhereString8N(const Byte* text, int textLength, int firstStart, const int* ends, int endsOffset, bool previousInArray, int length, const String8ValueN& value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	const Byte* textEnd = text + textLength;
+	int previousEnd = firstStart + endsOffset;
+
+	for (int i = 0; i < length; i += 64)
+	{
+		int count = (length - i < 64 ? length - i : 64);
+		unsigned __int64 valid = (count == 64 ? ~0x0ULL : (0x1ULL << count) - 1);
+
+		// Ends never decrease, so the block is in the text if the last row ends within it
+		bool invalid = false;
+		unsigned __int64 candidates = LengthCandidatesN<cOp>(ends + i, previousEnd, (i > 0 || previousInArray), count, value.length, invalid);
+		if (invalid || (__int64)ends[i + count - 1] - endsOffset > textLength) return false;
+
+		unsigned __int64 result = 0;
+		if (cOp == CompareOperatorN::Equal || cOp == CompareOperatorN::NotEqual || cOp == CompareOperatorN::StartsWith)
+		{
+			while (candidates != 0)
+			{
+				int row = i + (int)_tzcnt_u64(candidates);
+				candidates = _blsr_u64(candidates);
+
+				int start = (row == 0 ? firstStart : ends[row - 1] - endsOffset);
+				if (MatchRowN<cOp>(text + start, value, textEnd)) result |= (0x1ULL << (row - i));
+			}
+
+			if (cOp == CompareOperatorN::NotEqual) result = ~result & valid;
+		}
+		else
+		{
+			int start = previousEnd - endsOffset;
+			for (int j = 0; j < count; ++j)
+			{
+				int end = ends[i + j] - endsOffset;
+				int cmp = CompareRowN(text + start, end - start, value, textEnd);
+
+				bool match = (cOp == CompareOperatorN::LessThan ? cmp < 0
+					: cOp == CompareOperatorN::LessThanOrEqual ? cmp <= 0
+					: cOp == CompareOperatorN::GreaterThan ? cmp > 0
+					: cmp >= 0);
+
+				if (match) result |= (0x1ULL << j);
+				start = end;
+			}
+		}
+
+		MergeN(bOp, result, valid, bitOffset, &matchVector[i >> 6]);
+		previousEnd = ends[i + count - 1];
+	}
+
+	return true;
+}
+
+static bool WhereString8N(CompareOperatorN cOp, const Byte* text, int textLength, int firstStart, const int* ends, int endsOffset, bool previousInArray, int length, const String8ValueN& value, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		return WhereString8N<CompareOperatorN::Equal>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	case CompareOperatorN::NotEqual:
+		return WhereString8N<CompareOperatorN::NotEqual>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	case CompareOperatorN::LessThan:
+		return WhereString8N<CompareOperatorN::LessThan>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	case CompareOperatorN::LessThanOrEqual:
+		return WhereString8N<CompareOperatorN::LessThanOrEqual>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	case CompareOperatorN::GreaterThan:
+		return WhereString8N<CompareOperatorN::GreaterThan>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	case CompareOperatorN::GreaterThanOrEqual:
+		return WhereString8N<CompareOperatorN::GreaterThanOrEqual>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	default:
+		return WhereString8N<CompareOperatorN::StartsWith>(text, textLength, firstStart, ends, endsOffset, previousInArray, length, value, bOp, matchVector, bitOffset);
+	}
+}
+
 #pragma managed
 
 namespace XForm
 {
 	namespace Native
 	{
-		Int32 String8N::SplitTsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector, array<UInt64>^ rowVector)
+		static void ValidateSplit(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector)
+		{
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > content->Length) throw gcnew IndexOutOfRangeException("content");
+			if (index + length > (cellVector->Length * 64)) throw gcnew IndexOutOfRangeException("cellVector");
+			if ((index & 63) != 0) throw gcnew ArgumentException("Split must start on a multiple of 64 offset.");
+		}
+
+		Int32 String8N::SplitTsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector)
+		{
+			ValidateSplit(content, index, length, cellVector);
+			if (length == 0) return 0;
+
+			COUNT_KERNEL(SplitTsv, length, (Int64)length + length / 8);
+
+			pin_ptr<Byte> pContent = &content[0];
+			pin_ptr<UInt64> pCellVector = &cellVector[0];
+			return SplitN<'\t', false>(pContent, index, index + length, pCellVector);
+		}
+
+		Int32 String8N::SplitCsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector)
 		{
+			ValidateSplit(content, index, length, cellVector);
+			if (length == 0) return 0;
+
+			COUNT_KERNEL(SplitCsv, length, (Int64)length + length / 8);
+
 			pin_ptr<Byte> pContent = &content[0];
 			pin_ptr<UInt64> pCellVector = &cellVector[0];
-			pin_ptr<UInt64> pRowVector = &rowVector[0];
-			return SplitTsvN(pContent, index, index + length, pCellVector, pRowVector);
+			return SplitN<',', true>(pContent, index, index + length, pCellVector);
+		}
+
+		Int32 String8N::SplitCells(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector, Int32 columnCount, array<Int32>^ cellStarts, array<Int32>^ cellLengths, Int32 rowLimit, Boolean quoted, Int32% nextIndex)
+		{
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > content->Length) throw gcnew IndexOutOfRangeException("content");
+			if (index + length > (cellVector->Length * 64)) throw gcnew IndexOutOfRangeException("cellVector");
+			if (columnCount <= 0) throw gcnew ArgumentOutOfRangeException("columnCount");
+			if (rowLimit < 0 || (Int64)columnCount * rowLimit > cellStarts->Length || (Int64)columnCount * rowLimit > cellLengths->Length) throw gcnew ArgumentOutOfRangeException("rowLimit");
+
+			nextIndex = index;
+			if (length == 0 || rowLimit == 0) return 0;
+
+			COUNT_KERNEL(SplitCells, length, (Int64)length + length / 8);
+
+			pin_ptr<Byte> pContent = &content[0];
+			pin_ptr<UInt64> pCellVector = &cellVector[0];
+			pin_ptr<Int32> pCellStarts = &cellStarts[0];
+			pin_ptr<Int32> pCellLengths = &cellLengths[0];
+
+			int next = index;
+			int rowCount = (quoted
+				? SplitCellsN<true>(pContent, index, index + length, pCellVector, columnCount, rowLimit, pCellStarts, pCellLengths, &next)
+				: SplitCellsN<false>(pContent, index, index + length, pCellVector, columnCount, rowLimit, pCellStarts, pCellLengths, &next));
+			nextIndex = next;
+			return rowCount;
+		}
+
+		Int32 String8N::IndexOfAny(array<Byte>^ content, Int32 index, Int32 length, array<array<Byte>^>^ values, Boolean ignoreCase, array<Int32>^ matchArray, array<Int32>^ matchValueArray, Int32% nextIndex)
+		{
+			nextIndex = -1;
+			if (content == nullptr || content->Length == 0) return 0;
+			if (values == nullptr || values->Length == 0) return 0;
+			if (index < 0 || length < 0 || index + length > content->Length) throw gcnew IndexOutOfRangeException("content");
+			if (values->Length > IndexOfAnyValueLimit) throw gcnew ArgumentOutOfRangeException("values");
+			if (matchArray->Length < values->Length) throw gcnew ArgumentException("matchArray must have room for a match for every value.");
+			if (matchValueArray->Length < matchArray->Length) throw gcnew ArgumentException("matchValueArray must be as long as matchArray.");
+
+			// Copy the values into one buffer, lowercased if ignoring case, so they can be used unpinned
+			int valueCount = values->Length;
+			int totalLength = 0;
+			for (int v = 0; v < valueCount; ++v)
+			{
+				if (values[v] == nullptr || values[v]->Length == 0) throw gcnew ArgumentException("values must not be empty.");
+				totalLength += values[v]->Length;
+			}
+
+			array<Byte>^ buffer = gcnew array<Byte>(totalLength);
+			Byte* valuePointers[IndexOfAnyValueLimit];
+			Int32 valueLengths[IndexOfAnyValueLimit];
+
+			COUNT_KERNEL(IndexOfAny, length, length);
+
+			pin_ptr<Byte> pContent = &content[0];
+			pin_ptr<Byte> pBuffer = &buffer[0];
+			pin_ptr<Int32> pMatchArray = &matchArray[0];
+			pin_ptr<Int32> pMatchValueArray = &matchValueArray[0];
+
+			int offset = 0;
+			for (int v = 0; v < valueCount; ++v)
+			{
+				valuePointers[v] = pBuffer + offset;
+				valueLengths[v] = values[v]->Length;
+				for (int i = 0; i < valueLengths[v]; ++i)
+				{
+					Byte c = values[v][i];
+					buffer[offset++] = (ignoreCase && c >= 'A' && c <= 'Z' ? (Byte)(c | 0x20) : c);
+				}
+			}
+
+			int next = -1;
+			int countFound;
+			if (ignoreCase)
+			{
+				countFound = IndexOfAnyInternal<true>(pContent, index, index + length, valuePointers, valueLengths, valueCount, pMatchArray, pMatchValueArray, matchArray->Length, &next);
+			}
+			else
+			{
+				countFound = IndexOfAnyInternal<false>(pContent, index, index + length, valuePointers, valueLengths, valueCount, pMatchArray, pMatchValueArray, matchArray->Length, &next);
+			}
+
+			nextIndex = next;
+			return countFound;
 		}
 
 		Int32 String8N::IndexOfAll(array<Byte>^ content, Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray)
@@ -206,12 +1100,20 @@ namespace XForm
 			if (content == nullptr || content->Length == 0) return 0;
 			if (value == nullptr || value->Length == 0) return 0;
 
+			COUNT_KERNEL(IndexOfAll, length, length);
+
 			pin_ptr<Byte> pContent = &content[0];
 			pin_ptr<Byte> pValue = &value[valueIndex];
 			pin_ptr<Int32> pMatchArray = &matchArray[0];
 
 			if (ignoreCase)
 			{
+				// Fold non-ASCII values with Unicode case pairs; ASCII values can only match ASCII text, so ASCII folding matches correctly
+				if (valueLength <= FoldValueLimit && !IsAsciiN(pValue, valueLength))
+				{
+					return IndexOfAllFoldInternal(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
+				}
+
 				return IndexOfAllInternal<true>(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
 			}
 			else
@@ -219,5 +1121,76 @@ namespace XForm
 				return IndexOfAllInternal<false>(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
 			}
 		}
+
+		void String8N::Where(array<Byte>^ text, Int32 firstStart, array<Int32>^ ends, Int32 endsIndex, Int32 endsOffset, Int32 length, Byte cOp, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (endsIndex < 0 || length < 0 || vectorIndex < 0) throw gcnew IndexOutOfRangeException();
+			if (firstStart < 0 || firstStart > text->Length) throw gcnew IndexOutOfRangeException("firstStart");
+			if (endsIndex + length > ends->Length) throw gcnew IndexOutOfRangeException("ends");
+			if (valueIndex < 0 || valueLength < 0 || (valueLength > 0 && valueIndex + valueLength > value->Length)) throw gcnew IndexOutOfRangeException("valueIndex");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual && cOp != (Byte)CompareOperatorN::StartsWith) throw gcnew ArgumentException("compareOperator");
+			if (bOp > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("booleanOperator");
+			if (length == 0) return;
+
+			COUNT_KERNEL(String8Where, length, (Int64)length * 4 + ((Int64)ends[endsIndex + length - 1] - endsOffset - firstStart));
+
+			pin_ptr<Byte> pText = nullptr;
+			if (text->Length > 0) pText = &text[0];
+
+			pin_ptr<Byte> pValue = nullptr;
+			if (valueLength > 0) pValue = &value[valueIndex];
+
+			pin_ptr<Int32> pEnds = &ends[endsIndex];
+			pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+
+			String8ValueN term;
+			term.bytes = pValue;
+			term.length = valueLength;
+			term.prefix = LoadPrefixN(pValue, (valueLength < 8 ? valueLength : 8), pValue + valueLength);
+			if (cOp == (Byte)CompareOperatorN::StartsWith) term.prefix = ToLowerWordN(term.prefix);
+
+			// ReadRaw leaves the end of the row before the first one just before it, so the first block can find lengths in bulk too
+			bool previousInArray = (endsIndex > 0 && (Int64)ends[endsIndex - 1] == (Int64)firstStart + endsOffset);
+
+			if (!WhereString8N((CompareOperatorN)cOp, pText, text->Length, firstStart, pEnds, endsOffset, previousInArray, length, term, (BooleanOperatorN)bOp, pVector, vectorIndex & 63))
+			{
+				throw gcnew IndexOutOfRangeException("ends");
+			}
+		}
+
+		Boolean String8N::IsAvx2Supported()
+		{
+			return SupportedN.Avx2 && SupportedN.Bmi1;
+		}
+
+		Int32 String8N::IndexOfAllAvx2(array<Byte>^ content, Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray)
+		{
+			if (content == nullptr || content->Length == 0) return 0;
+			if (value == nullptr || value->Length == 0) return 0;
+			if (index < 0 || length < 0 || index + length > content->Length) throw gcnew IndexOutOfRangeException("index");
+			if (valueIndex < 0 || valueLength <= 0 || valueIndex + valueLength > value->Length) throw gcnew IndexOutOfRangeException("valueIndex");
+
+			COUNT_KERNEL(IndexOfAll, length, length);
+
+			pin_ptr<Byte> pContent = &content[0];
+			pin_ptr<Byte> pValue = &value[valueIndex];
+			pin_ptr<Int32> pMatchArray = &matchArray[0];
+
+			if (ignoreCase)
+			{
+				// Fold non-ASCII values with Unicode case pairs; ASCII values can only match ASCII text, so ASCII folding matches correctly
+				if (valueLength <= FoldValueLimit && !IsAsciiN(pValue, valueLength))
+				{
+					return IndexOfAllFoldInternal(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
+				}
+
+				return IndexOfAllAvx2Internal<true>(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
+			}
+			else
+			{
+				return IndexOfAllAvx2Internal<false>(pContent, index, index + length, pValue, valueLength, pMatchArray, matchArray->Length);
+			}
+		}
 	}
 }
@@ -4,6 +4,10 @@
 #pragma once
 using namespace System;
 
+// Find every index in [textIndex, textLength) where value matches, like String8N::IndexOfAll, with the fastest variant the CPU supports.
+// Shared with kernels over text which isn't in a managed array.
+int IndexOfAllN(unsigned __int8* text, int textIndex, int textLength, unsigned __int8* value, int valueLength, bool ignoreCase, int* result, int resultLimit);
+
 namespace XForm
 {
 	namespace Native
@@ -11,8 +15,35 @@ namespace XForm
 		public ref class String8N
 		{
 		public:
-			static Int32 SplitTsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector, array<UInt64>^ rowVector);
+			// Set a bit in cellVector for each cell end in content (delimiters and row ends) and return the row count.
+			// For "\r\n" row ends, the bit is set on the '\r'. SplitCsv ignores commas and newlines within double quotes.
+			static Int32 SplitTsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector);
+			static Int32 SplitCsv(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector);
+
+			// Convert the cell vector from SplitTsv or SplitCsv into the start and length of each cell, with column c of row r at [c * rowLimit + r].
+			// Returns the number of complete rows converted (at most rowLimit) and sets nextIndex to the start of the first row not converted.
+			// Short rows get empty cells for their missing columns, extra cells are dropped, and a final row without a newline isn't converted.
+			// If quoted (for SplitCsv vectors), quotes around cells are removed and doubled quotes unescaped, rewriting content in place.
+			static Int32 SplitCells(array<Byte>^ content, Int32 index, Int32 length, array<UInt64>^ cellVector, Int32 columnCount, array<Int32>^ cellStarts, array<Int32>^ cellLengths, Int32 rowLimit, Boolean quoted, Int32% nextIndex);
+
+			// Compare each row of a String8 column to value, merging the results into vector from 'vectorIndex' with booleanOperator, as Comparer::Where.
+			// Row i is text[start, ends[endsIndex + i] - endsOffset), where the first row starts at firstStart and each other row where the previous one ended.
+			// compareOperator is a CompareOperator from Equal to GreaterThanOrEqual (ordinal, like String8.CompareTo) or StartsWith (ignoring ASCII case).
+			// Rows are screened on length and their first eight bytes before the rest of the bytes are compared.
+			static void Where(array<Byte>^ text, Int32 firstStart, array<Int32>^ ends, Int32 endsIndex, Int32 endsOffset, Int32 length, Byte compareOperator, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// Find every index where value matches, returning up to matchArray.Length indices.
+			// ignoreCase folds ASCII and the Latin-1 Supplement, Greek, and Cyrillic case pairs (for values up to 1,024 bytes).
 			static Int32 IndexOfAll(array<Byte>^ content, Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray);
+
+			// IndexOfAll screening 32 indices at a time on the first and last bytes of value. Requires AVX2; see IsAvx2Supported.
+			static Boolean IsAvx2Supported();
+			static Int32 IndexOfAllAvx2(array<Byte>^ content, Int32 index, Int32 length, array<Byte>^ value, Int32 valueIndex, Int32 valueLength, Boolean ignoreCase, array<Int32>^ matchArray);
+
+			// Find every index where any of values match in one pass, returning the match index in matchArray and the value matched in matchValueArray.
+			// nextIndex is set to the index to continue from if matchArray filled, or -1 if the search finished.
+			literal Int32 IndexOfAnyValueLimit = 256;
+			static Int32 IndexOfAny(array<Byte>^ content, Int32 index, Int32 length, array<array<Byte>^>^ values, Boolean ignoreCase, array<Int32>^ matchArray, array<Int32>^ matchValueArray, Int32% nextIndex);
 		};
 	}
 }
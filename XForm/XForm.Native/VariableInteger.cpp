@@ -0,0 +1,104 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include <intrin.h>
+#include "KernelCounters.h"
+#include "CpuFeatures.h"
+#include "VariableInteger.h"
+
+#pragma unmanaged
+
+static void WidenN(unsigned __int8* values, int length, int* result)
+{
+	int i = 0;
+
+	if (SupportedN.Avx512F)
+	{
+		for (; i + 64 <= length; i += 64)
+		{
+			for (int k = 0; k < 64; k += 16)
+			{
+				_mm512_storeu_si512(&result[i + k], _mm512_cvtepu8_epi32(_mm_loadu_si128((__m128i*)(&values[i + k]))));
+			}
+		}
+	}
+
+	for (; i + 32 <= length; i += 32)
+	{
+		for (int k = 0; k < 32; k += 8)
+		{
+			_mm256_storeu_si256((__m256i*)(&result[i + k]), _mm256_cvtepu8_epi32(_mm_loadl_epi64((__m128i*)(&values[i + k]))));
+		}
+	}
+
+	for (; i < length; ++i)
+	{
+		result[i] = values[i];
+	}
+}
+
+static void WidenN(unsigned __int16* values, int length, int* result)
+{
+	int i = 0;
+
+	if (SupportedN.Avx512F)
+	{
+		for (; i + 64 <= length; i += 64)
+		{
+			for (int k = 0; k < 64; k += 16)
+			{
+				_mm512_storeu_si512(&result[i + k], _mm512_cvtepu16_epi32(_mm256_loadu_si256((__m256i*)(&values[i + k]))));
+			}
+		}
+	}
+
+	for (; i + 32 <= length; i += 32)
+	{
+		for (int k = 0; k < 32; k += 8)
+		{
+			_mm256_storeu_si256((__m256i*)(&result[i + k]), _mm256_cvtepu16_epi32(_mm_loadu_si128((__m128i*)(&values[i + k]))));
+		}
+	}
+
+	for (; i < length; ++i)
+	{
+		result[i] = values[i];
+	}
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		void VariableIntegerN::Widen(array<Byte>^ values, Int32 index, Int32 length, array<Int32>^ result)
+		{
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > values->Length) throw gcnew IndexOutOfRangeException("values");
+			if (length > result->Length) throw gcnew IndexOutOfRangeException("result");
+			if (length == 0) return;
+
+			COUNT_KERNEL(Widen, length, (Int64)length * 5);
+
+			pin_ptr<Byte> pValues = &values[index];
+			pin_ptr<Int32> pResult = &result[0];
+			WidenN(pValues, length, pResult);
+		}
+
+		void VariableIntegerN::Widen(array<UInt16>^ values, Int32 index, Int32 length, array<Int32>^ result)
+		{
+			if (index < 0 || length < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > values->Length) throw gcnew IndexOutOfRangeException("values");
+			if (length > result->Length) throw gcnew IndexOutOfRangeException("result");
+			if (length == 0) return;
+
+			COUNT_KERNEL(Widen, length, (Int64)length * 6);
+
+			pin_ptr<UInt16> pValues = &values[index];
+			pin_ptr<Int32> pResult = &result[0];
+			WidenN(pValues, length, pResult);
+		}
+	}
+}
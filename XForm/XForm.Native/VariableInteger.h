@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+using namespace System;
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Kernels for VariableIntegerReader columns, which store int values as byte or ushort while every value fits.
+		public ref class VariableIntegerN
+		{
+		public:
+			// Widen values [index, index + length) to int into result[0, length)
+			static void Widen(array<Byte>^ values, Int32 index, Int32 length, array<Int32>^ result);
+			static void Widen(array<UInt16>^ values, Int32 index, Int32 length, array<Int32>^ result);
+		};
+	}
+}
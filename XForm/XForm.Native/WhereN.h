@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+#include "Operator.h"
+
+// Unmanaged array to constant Where kernels, shared with kernels which combine several comparisons.
+// Each merges the result for 'length' values into matchVector using bOp, starting 'bitOffset' (0-63) bits into matchVector[0].
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int8* set, int length, unsigned __int8 value, unsigned __int64* matchVector, int bitOffset);
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int16* set, int length, unsigned __int16 value, unsigned __int64* matchVector, int bitOffset);
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int32* set, int length, unsigned __int32 value, unsigned __int64* matchVector, int bitOffset);
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, SigningN sign, unsigned __int64* set, int length, unsigned __int64 value, unsigned __int64* matchVector, int bitOffset);
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, float* set, int length, float value, unsigned __int64* matchVector, int bitOffset);
+void WhereN(CompareOperatorN cOp, BooleanOperatorN bOp, double* set, int length, double value, unsigned __int64* matchVector, int bitOffset);
+
+enum TermTypeN : char
+{
+	TermUInt8 = 0,
+	TermInt8 = 1,
+	TermUInt16 = 2,
+	TermInt16 = 3,
+	TermUInt32 = 4,
+	TermInt32 = 5,
+	TermUInt64 = 6,
+	TermInt64 = 7,
+	TermSingle = 8,
+	TermDouble = 9
+};
+
+// One (column, operator, constant) comparison, built from managed arrays by XForm::Native::BuildTerm
+struct WhereTermN
+{
+	void* column;
+	TermTypeN type;
+	CompareOperatorN cOp;
+
+	union
+	{
+		unsigned __int64 integer;
+		float single;
+		double real;
+	} value;
+};
+
+// Compare 'length' values of the term column from 'index' to the term constant with the Where kernel for the column type
+void WhereN(WhereTermN& term, int index, int length, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset);
+
+#pragma managed(push, off)
+
+// Merge the result bits for one block of up to 64 rows into matchVector, where the block starts 'bitOffset' (0-63) bits into matchVector[0].
+// 'valid' has a bit set for each row in the block; vector bits for rows outside the block are left unchanged.
+// The block spills into matchVector[1] only when bitOffset is non-zero and rows remain past the end of matchVector[0].
+static __forceinline void MergeN(BooleanOperatorN bOp, unsigned __int64 result, unsigned __int64 valid, int bitOffset, unsigned __int64* matchVector)
+{
+	unsigned __int64 low = result << bitOffset;
+	unsigned __int64 lowValid = valid << bitOffset;
+
+	switch (bOp)
+	{
+	case BooleanOperatorN::And:
+		matchVector[0] &= (low | ~lowValid);
+		break;
+	case BooleanOperatorN::Or:
+		matchVector[0] |= (low & lowValid);
+		break;
+	}
+
+	if (bitOffset == 0) return;
+
+	unsigned __int64 high = result >> (64 - bitOffset);
+	unsigned __int64 highValid = valid >> (64 - bitOffset);
+	if (highValid == 0) return;
+
+	switch (bOp)
+	{
+	case BooleanOperatorN::And:
+		matchVector[1] &= (high | ~highValid);
+		break;
+	case BooleanOperatorN::Or:
+		matchVector[1] |= (high & highValid);
+		break;
+	}
+}
+
+// Merge the same result for all 'length' rows, for rows decided without comparing them. And with no matches clears the rows, and Or with all matches sets them.
+static __forceinline void MergeAllN(bool matches, BooleanOperatorN bOp, int length, unsigned __int64* matchVector, int bitOffset)
+{
+	if (matches == (bOp == BooleanOperatorN::And)) return;
+
+	unsigned __int64 result = (matches ? ~0x0ULL : 0x0ULL);
+	for (int i = 0; i < length; i += 64)
+	{
+		unsigned __int64 valid = (length - i >= 64 ? ~0x0ULL : (0x1ULL << (length - i)) - 1);
+		MergeN(bOp, result, valid, bitOffset, &matchVector[i >> 6]);
+	}
+}
+
+// AVX-512 compare predicate for each CompareOperatorN, for _mm512_cmp_ep*_mask
+static __forceinline constexpr int Avx512PredicateN(CompareOperatorN cOp)
+{
+	return (cOp == CompareOperatorN::Equal ? _MM_CMPINT_EQ
+		: cOp == CompareOperatorN::NotEqual ? _MM_CMPINT_NE
+		: cOp == CompareOperatorN::LessThan ? _MM_CMPINT_LT
+		: cOp == CompareOperatorN::LessThanOrEqual ? _MM_CMPINT_LE
+		: cOp == CompareOperatorN::GreaterThan ? _MM_CMPINT_NLE
+		: _MM_CMPINT_NLT);
+}
+
+#pragma managed(pop)
@@ -0,0 +1,194 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include "stdafx.h"
+#include "Operator.h"
+#include "WhereN.h"
+#include "KernelCounters.h"
+#include "Comparer.h"
+#include "ZoneMap.h"
+
+using namespace System::Runtime::InteropServices;
+
+#pragma unmanaged
+
+enum ZoneResultN : char
+{
+	ZonePartial = 0,
+	ZoneMatchNone = 1,
+	ZoneMatchAll = 2
+};
+
+// Decide (row cOp value) for every row with a value in [min, max], if the bounds allow it
+template<typename T>
+static ZoneResultN ClassifyN(T min, T max, CompareOperatorN cOp, T value)
+{
+	// NaN bounds and values compare false to everything, so they can't decide rows
+	if (min != min || max != max || value != value) return ZoneResultN::ZonePartial;
+
+	switch (cOp)
+	{
+	case CompareOperatorN::Equal:
+		if (value < min || value > max) return ZoneResultN::ZoneMatchNone;
+		if (min == max) return ZoneResultN::ZoneMatchAll;
+		break;
+	case CompareOperatorN::NotEqual:
+		if (value < min || value > max) return ZoneResultN::ZoneMatchAll;
+		if (min == max) return ZoneResultN::ZoneMatchNone;
+		break;
+	case CompareOperatorN::LessThan:
+		if (max < value) return ZoneResultN::ZoneMatchAll;
+		if (min >= value) return ZoneResultN::ZoneMatchNone;
+		break;
+	case CompareOperatorN::LessThanOrEqual:
+		if (max <= value) return ZoneResultN::ZoneMatchAll;
+		if (min > value) return ZoneResultN::ZoneMatchNone;
+		break;
+	case CompareOperatorN::GreaterThan:
+		if (min > value) return ZoneResultN::ZoneMatchAll;
+		if (max <= value) return ZoneResultN::ZoneMatchNone;
+		break;
+	case CompareOperatorN::GreaterThanOrEqual:
+		if (min >= value) return ZoneResultN::ZoneMatchAll;
+		if (max < value) return ZoneResultN::ZoneMatchNone;
+		break;
+	}
+
+	return ZoneResultN::ZonePartial;
+}
+
+template<typename T>
+static __forceinline ZoneResultN ClassifyN(void* zoneMap, int block, CompareOperatorN cOp, T value)
+{
+	T* zone = (T*)zoneMap + 2 * (__int64)block;
+	return ClassifyN<T>(zone[0], zone[1], cOp, value);
+}
+
+// Classify one block with the zone term (whose column is the zone map) for the block values' type
+static ZoneResultN ClassifyN(WhereTermN& zone, int block)
+{
+	switch (zone.type)
+	{
+	case TermTypeN::TermUInt8:
+		return ClassifyN<unsigned __int8>(zone.column, block, zone.cOp, (unsigned __int8)zone.value.integer);
+	case TermTypeN::TermInt8:
+		return ClassifyN<signed char>(zone.column, block, zone.cOp, (signed char)zone.value.integer);
+	case TermTypeN::TermUInt16:
+		return ClassifyN<unsigned __int16>(zone.column, block, zone.cOp, (unsigned __int16)zone.value.integer);
+	case TermTypeN::TermInt16:
+		return ClassifyN<__int16>(zone.column, block, zone.cOp, (__int16)zone.value.integer);
+	case TermTypeN::TermUInt32:
+		return ClassifyN<unsigned __int32>(zone.column, block, zone.cOp, (unsigned __int32)zone.value.integer);
+	case TermTypeN::TermInt32:
+		return ClassifyN<__int32>(zone.column, block, zone.cOp, (__int32)zone.value.integer);
+	case TermTypeN::TermUInt64:
+		return ClassifyN<unsigned __int64>(zone.column, block, zone.cOp, zone.value.integer);
+	case TermTypeN::TermInt64:
+		return ClassifyN<__int64>(zone.column, block, zone.cOp, (__int64)zone.value.integer);
+	case TermTypeN::TermSingle:
+		return ClassifyN<float>(zone.column, block, zone.cOp, zone.value.single);
+	case TermTypeN::TermDouble:
+		return ClassifyN<double>(zone.column, block, zone.cOp, zone.value.real);
+	}
+
+	return ZoneResultN::ZonePartial;
+}
+
+// Walk rows [firstRow, firstRow + length) a zone block at a time, returning the number of rows the zone map decides.
+// With a column term, decided blocks are merged as all or no matches and the other blocks are compared with the Where kernel.
+int ZoneWhereN(WhereTermN* column, WhereTermN& zone, int zoneCount, int blockRowCount, int firstRow, int length, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset)
+{
+	int decided = 0;
+
+	int i = 0;
+	while (i < length)
+	{
+		int block = (int)(((__int64)firstRow + i) / blockRowCount);
+		__int64 blockEnd = ((__int64)block + 1) * blockRowCount - firstRow;
+		int end = (blockEnd < length ? (int)blockEnd : length);
+
+		ZoneResultN result = (block < zoneCount ? ClassifyN(zone, block) : ZoneResultN::ZonePartial);
+		if (result != ZoneResultN::ZonePartial) decided += end - i;
+
+		if (column != nullptr)
+		{
+			int bit = bitOffset + i;
+			if (result == ZoneResultN::ZonePartial)
+			{
+				WhereN(*column, i, end - i, bOp, matchVector + (bit >> 6), bit & 63);
+			}
+			else
+			{
+				MergeAllN(result == ZoneResultN::ZoneMatchAll, bOp, end - i, matchVector + (bit >> 6), bit & 63);
+			}
+		}
+
+		i = end;
+	}
+
+	return decided;
+}
+
+#pragma managed
+
+namespace XForm
+{
+	namespace Native
+	{
+		Int32 ZoneMapN::Where(Array^ column, Int32 index, Int32 length, Byte cOp, Object^ value, Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Byte bOp, array<UInt64>^ vector, Int32 vectorIndex)
+		{
+			if (index < 0 || length < 0 || vectorIndex < 0 || firstRow < 0) throw gcnew IndexOutOfRangeException();
+			if (index + length > column->Length) throw gcnew IndexOutOfRangeException("column");
+			if (vectorIndex + length > (vector->Length * 64)) throw gcnew IndexOutOfRangeException("vector");
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperator");
+			if (bOp > (Byte)BooleanOperatorN::Or) throw gcnew ArgumentException("booleanOperator");
+			if (blockRowCount <= 0) throw gcnew ArgumentOutOfRangeException("blockRowCount");
+			if (zoneMap->GetType() != column->GetType()) throw gcnew ArgumentException("zoneMap must be the same type as column.", "zoneMap");
+			if (length == 0) return 0;
+
+			COUNT_KERNEL(ZoneMapWhere, length, (Int64)length * (Buffer::ByteLength(column) / column->Length));
+
+			GCHandle columnHandle = GCHandle::Alloc(column, GCHandleType::Pinned);
+			GCHandle zoneHandle = GCHandle::Alloc(zoneMap, GCHandleType::Pinned);
+
+			try
+			{
+				WhereTermN term;
+				WhereTermN zone;
+				BuildTerm(column, value, cOp, columnHandle.AddrOfPinnedObject().ToPointer(), index, term);
+				BuildTerm(zoneMap, value, cOp, zoneHandle.AddrOfPinnedObject().ToPointer(), 0, zone);
+
+				pin_ptr<UInt64> pVector = &vector[vectorIndex >> 6];
+				return ZoneWhereN(&term, zone, zoneMap->Length / 2, blockRowCount, firstRow, length, (BooleanOperatorN)bOp, pVector, vectorIndex & 63);
+			}
+			finally
+			{
+				columnHandle.Free();
+				zoneHandle.Free();
+			}
+		}
+
+		Int32 ZoneMapN::CountDecided(Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Int32 length, Byte cOp, Object^ value)
+		{
+			if (length < 0 || firstRow < 0) throw gcnew IndexOutOfRangeException();
+			if (cOp > (Byte)CompareOperatorN::GreaterThanOrEqual) throw gcnew ArgumentException("compareOperator");
+			if (blockRowCount <= 0) throw gcnew ArgumentOutOfRangeException("blockRowCount");
+			if (length == 0 || zoneMap->Length < 2) return 0;
+
+			COUNT_KERNEL(ZoneMapCountDecided, length, 0);
+
+			GCHandle zoneHandle = GCHandle::Alloc(zoneMap, GCHandleType::Pinned);
+
+			try
+			{
+				WhereTermN zone;
+				BuildTerm(zoneMap, value, cOp, zoneHandle.AddrOfPinnedObject().ToPointer(), 0, zone);
+				return ZoneWhereN(nullptr, zone, zoneMap->Length / 2, blockRowCount, firstRow, length, BooleanOperatorN::And, nullptr, 0);
+			}
+			finally
+			{
+				zoneHandle.Free();
+			}
+		}
+	}
+}
@@ -0,0 +1,31 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#pragma once
+#include "WhereN.h"
+using namespace System;
+
+// Compare rows [firstRow, firstRow + length) of column to the zone map term zone a block at a time, as ZoneMapN::Where, and return the rows decided.
+// Shared with kernels over columns which aren't in a managed array.
+int ZoneWhereN(WhereTermN* column, WhereTermN& zone, int zoneCount, int blockRowCount, int firstRow, int length, BooleanOperatorN bOp, unsigned __int64* matchVector, int bitOffset);
+
+namespace XForm
+{
+	namespace Native
+	{
+		// Where for columns with a zone map: the minimum and maximum value of each block of blockRowCount rows, interleaved as
+		// [min0, max0, min1, max1, ...] in an array of the column type. Blocks where the bounds show every row or no row matches
+		// are merged without reading the values; only blocks which overlap the comparison run the Where kernel.
+		// Zones with a NaN bound (blocks with NaN values) never decide rows, and rows past the last zone are compared normally.
+		public ref class ZoneMapN
+		{
+		public:
+			// Compare values [index, index + length) of column to value, merging the results into vector from 'vectorIndex' with booleanOperator,
+			// as Comparer::Where. column[index] is row firstRow of the zone map. Returns the number of rows decided from the zone map alone.
+			static Int32 Where(Array^ column, Int32 index, Int32 length, Byte compareOperator, Object^ value, Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Byte booleanOperator, array<UInt64>^ vector, Int32 vectorIndex);
+
+			// Return the number of rows [firstRow, firstRow + length) the zone map decides for (row compareOperator value), without comparing any values
+			static Int32 CountDecided(Array^ zoneMap, Int32 blockRowCount, Int32 firstRow, Int32 length, Byte compareOperator, Object^ value);
+		};
+	}
+}
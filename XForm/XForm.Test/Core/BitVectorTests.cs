@@ -1,6 +1,7 @@
 ﻿// Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+using System;
 using System.Text;
 
 using Microsoft.VisualStudio.TestTools.UnitTesting;
@@ -87,6 +88,158 @@ namespace XForm.Test.Core
             Assert.AreEqual("30, 33, 36, 39, 42", Join(page, count));
         }
 
+        [TestMethod]
+        public void BitVector_PageNative()
+        {
+            NativeAccelerator.Enable();
+            Random r = new Random(4);
+
+            // Build 40 words: full words, dense mixed words, a long run of empty words, then mixed words
+            BitVector set = new BitVector(40 * 64);
+            for (int i = 0; i < 4 * 64; ++i)
+            {
+                set.Set(i);
+            }
+
+            for (int i = 4 * 64; i < 8 * 64; ++i)
+            {
+                if (r.Next(2) == 0) set.Set(i);
+            }
+
+            for (int i = 28 * 64; i < 40 * 64; ++i)
+            {
+                if (r.Next(100) < 30) set.Set(i);
+            }
+
+            // Verify pages with room for whole blocks, including pages ending partway through a word
+            foreach (int pageSize in new int[] { 64, 100, 200, 1000 })
+            {
+                AssertPagesMatch(set, pageSize);
+            }
+
+            // Verify paging from Capacity after a page ended on the last bit of a vector of whole words
+            set = new BitVector(128);
+            set.All(128);
+
+            int[] page = new int[64];
+            int index = 64;
+            Assert.AreEqual(64, set.Page(page, ref index));
+            Assert.AreEqual(128, index);
+            Assert.AreEqual(0, set.Page(page, ref index));
+            Assert.AreEqual(-1, index);
+        }
+
+        private static void AssertPagesMatch(BitVector set, int pageSize)
+        {
+            int[] page = new int[pageSize];
+            int[] expectedPage = new int[pageSize];
+
+            int index = 0;
+            int expectedIndex = 0;
+            while (expectedIndex != -1)
+            {
+                int expectedCount = ManagedPage(set, expectedPage, ref expectedIndex);
+                int count = set.Page(page, ref index);
+
+                Assert.AreEqual(expectedCount, count, $"Count paging {pageSize:n0}");
+                Assert.AreEqual(expectedIndex, index, $"Next index paging {pageSize:n0}");
+                Assert.AreEqual(Join(expectedPage, expectedCount), Join(page, count), $"Indices paging {pageSize:n0}");
+            }
+        }
+
+        // Page with the indexer, as the managed Page does, since the native Page replaces it once enabled
+        private static int ManagedPage(BitVector set, int[] indicesFound, ref int fromIndex)
+        {
+            int countFound = 0;
+            int i;
+            for (i = fromIndex; i < set.Capacity; ++i)
+            {
+                if (set[i])
+                {
+                    indicesFound[countFound] = i;
+                    countFound++;
+
+                    if (countFound == indicesFound.Length) break;
+                }
+            }
+
+            fromIndex = (i == set.Capacity ? -1 : i + 1);
+            return countFound;
+        }
+
+        [TestMethod]
+        public void BitVector_RankSelect()
+        {
+            // Verify the managed index, then the native one
+            RankSelectScenarios();
+            NativeAccelerator.Enable();
+            RankSelectScenarios();
+
+            // Verify paging from a match number
+            BitVector set = new BitVector(900);
+            for (int i = 0; i < 45; i += 3)
+            {
+                set[i] = true;
+            }
+
+            int[] page = new int[4];
+            int ordinal = 5;
+            RankSelect index = new RankSelect(set);
+            int count = index.Page(page, ref ordinal);
+            Assert.AreEqual(9, ordinal);
+            Assert.AreEqual("15, 18, 21, 24", Join(page, count));
+
+            ordinal = 13;
+            count = index.Page(page, ref ordinal);
+            Assert.AreEqual(-1, ordinal);
+            Assert.AreEqual("39, 42", Join(page, count));
+        }
+
+        private static void RankSelectScenarios()
+        {
+            Random r = new Random(30);
+
+            // Lengths around word and superblock boundaries, sparse to full
+            foreach (int length in new int[] { 0, 1, 63, 64, 511, 512, 513, 5000, 100000 })
+            {
+                foreach (int density in new int[] { 0, 1, 50, 100 })
+                {
+                    BitVector set = new BitVector(length);
+                    for (int i = 0; i < length; ++i)
+                    {
+                        if (r.Next(100) < density) set.Set(i);
+                    }
+
+                    RankSelect index = new RankSelect(set);
+                    Assert.AreEqual(set.Count, index.Count);
+
+                    int rank = 0;
+                    int[] ordinals = new int[index.Count];
+                    for (int i = 0; i < length; ++i)
+                    {
+                        Assert.AreEqual(rank, index.Rank(i), $"Rank({i}) of {length} at {density}%");
+                        if (set[i])
+                        {
+                            Assert.AreEqual(i, index.Select(rank), $"Select({rank}) of {length} at {density}%");
+                            ordinals[rank] = rank;
+                            rank++;
+                        }
+                    }
+
+                    Assert.AreEqual(rank, index.Rank(length));
+                    Assert.AreEqual(-1, index.Select(rank));
+
+                    // Verify batch Select matches
+                    int[] indices = new int[ordinals.Length];
+                    index.Select(ordinals, 0, ordinals.Length, indices);
+                    for (int i = 0; i < ordinals.Length; ++i)
+                    {
+                        Assert.AreEqual(index.Select(i), indices[i]);
+                    }
+                }
+            }
+        }
+
         private static void AssertOnly(BitVector set, int limit, int expected)
         {
             Assert.IsTrue(set[expected]);
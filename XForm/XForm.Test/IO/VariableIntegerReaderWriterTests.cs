@@ -61,5 +61,14 @@ namespace XForm.Test.IO
 
             context.StreamProvider.Delete(columnPath);
         }
+
+        [TestMethod]
+        public void VariableIntegerReaderWriter_NativeWiden()
+        {
+            // Verify byte and ushort columns read back the same when widened natively
+            NativeAccelerator.Enable();
+            RoundTrip("NativeInByteRange", Enumerable.Range(0, 15000).Select((i) => i % 256).ToArray());
+            RoundTrip("NativeInUshortRange", Enumerable.Range(0, 15000).ToArray());
+        }
     }
 }
@@ -0,0 +1,115 @@
+﻿// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+using System;
+using System.IO;
+using System.Linq;
+
+using Microsoft.VisualStudio.TestTools.UnitTesting;
+
+using XForm.Data;
+using XForm.Extensions;
+using XForm.IO;
+
+namespace XForm.Test.IO
+{
+    [TestClass]
+    public class ZoneMapTests
+    {
+        [TestMethod]
+        public void ZoneMap_RoundTrip()
+        {
+            XDatabaseContext context = new XDatabaseContext();
+
+            string columnPath = Path.Combine("ZoneMapTests", "Column");
+            context.StreamProvider.Delete(columnPath);
+
+            // Two full zones and a partial one, with a NaN in the second
+            float[] values = Enumerable.Range(0, 2 * ZoneMap.BlockRowCount + 10).Select((i) => (float)i).ToArray();
+            values[ZoneMap.BlockRowCount + 5] = float.NaN;
+
+            using (IColumnWriter writer = new ZoneMapWriter<float>(context.StreamProvider, columnPath, new PrimitiveArrayWriter<float>(context.StreamProvider.OpenWrite(Path.Combine(columnPath, "V.f32.bin")))))
+            {
+                writer.Append(XArray.All(values, 100));
+                writer.Append(XArray.All(values, values.Length).Slice(100, values.Length));
+            }
+
+            ZoneMap map = ZoneMap.TryRead(context.StreamProvider, typeof(float), columnPath);
+            Assert.IsNotNull(map);
+            Assert.AreEqual(3, map.ZoneCount);
+
+            float[] minMax = (float[])map.MinMax;
+            Assert.AreEqual(0.0f, minMax[0]);
+            Assert.AreEqual((float)(ZoneMap.BlockRowCount - 1), minMax[1]);
+            Assert.IsTrue(float.IsNaN(minMax[2]));
+            Assert.AreEqual((float)(2 * ZoneMap.BlockRowCount + 0), minMax[4]);
+            Assert.AreEqual((float)(2 * ZoneMap.BlockRowCount + 9), minMax[5]);
+
+            // Byte columns get zone maps too
+            byte[] bytes = Enumerable.Range(0, ZoneMap.BlockRowCount + 10).Select((i) => (byte)(i / ZoneMap.BlockRowCount + 7)).ToArray();
+            using (IColumnWriter writer = new ZoneMapWriter<byte>(context.StreamProvider, columnPath, new PrimitiveArrayWriter<byte>(context.StreamProvider.OpenWrite(Path.Combine(columnPath, "V.u8.bin")))))
+            {
+                writer.Append(XArray.All(bytes, bytes.Length));
+            }
+
+            map = ZoneMap.TryRead(context.StreamProvider, typeof(byte), columnPath);
+            Assert.IsNotNull(map);
+            CollectionAssert.AreEqual(new byte[] { 7, 7, 8, 8 }, (byte[])map.MinMax);
+        }
+
+        [TestMethod]
+        public void ZoneMap_Where()
+        {
+            int rowCount = 5 * ZoneMap.BlockRowCount + 123;
+            int[] sorted = Enumerable.Range(0, rowCount).ToArray();
+            float[] clustered = Enumerable.Range(0, rowCount).Select((i) => (float)(i / 1000)).ToArray();
+            long[] shuffled = Enumerable.Range(0, rowCount).Select((i) => ((long)i * 7919) % rowCount).ToArray();
+            clustered[ZoneMap.BlockRowCount * 2 + 17] = float.NaN;
+
+            XDatabaseContext context = new XDatabaseContext();
+            context.StreamProvider.Delete("Table\\ZoneMap_Where");
+
+            context
+                .FromArrays(rowCount)
+                .WithColumn("Sorted", sorted)
+                .WithColumn("Clustered", clustered)
+                .WithColumn("Shuffled", shuffled)
+                .Save("ZoneMap_Where", context);
+
+            WhereQueries(context, sorted, clustered, shuffled);
+
+            // Run with blocks the zone maps decide skipped, if available
+            NativeAccelerator.Enable();
+            WhereQueries(context, sorted, clustered, shuffled);
+        }
+
+        private static void WhereQueries(XDatabaseContext context, int[] sorted, float[] clustered, long[] shuffled)
+        {
+            foreach (int value in new int[] { -1, 0, 4095, 4096, 10000, sorted.Length - 1, sorted.Length })
+            {
+                AssertCount(context, $"where [Sorted] = {value}", sorted.Count((v) => v == value));
+                AssertCount(context, $"where [Sorted] != {value}", sorted.Count((v) => v != value));
+                AssertCount(context, $"where [Sorted] < {value}", sorted.Count((v) => v < value));
+                AssertCount(context, $"where [Sorted] >= {value}", sorted.Count((v) => v >= value));
+                AssertCount(context, $"where [Shuffled] > {value}", shuffled.Count((v) => v > value));
+            }
+
+            foreach (float value in new float[] { -1, 0, 8, 20 })
+            {
+                AssertCount(context, $"where [Clustered] = {value}", clustered.Count((v) => v == value));
+                AssertCount(context, $"where [Clustered] != {value}", clustered.Count((v) => v != value));
+                AssertCount(context, $"where [Clustered] <= {value}", clustered.Count((v) => v <= value));
+                AssertCount(context, $"where [Clustered] > {value}", clustered.Count((v) => v > value));
+            }
+
+            // Zoned terms with other terms in an AND or OR
+            AssertCount(context, "where [Sorted] >= 10000 AND [Shuffled] < 500", sorted.Where((v, i) => v >= 10000 && shuffled[i] < 500).Count());
+            AssertCount(context, "where [Sorted] < 100 OR [Clustered] = 12", sorted.Where((v, i) => v < 100 || clustered[i] == 12).Count());
+        }
+
+        private static void AssertCount(XDatabaseContext context, string where, int expected)
+        {
+            Assert.AreEqual((long)expected, context.Query($"read ZoneMap_Where\r\n{where}").Count(), where);
+        }
+    }
+}
@@ -2,8 +2,12 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 using System;
+using System.Collections.Generic;
+using System.IO;
 using System.Linq;
+using System.Text;
 
+using Microsoft.CodeAnalysis.Elfie.Model.Strings;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 
 using XForm.Data;
@@ -24,6 +28,675 @@ namespace XForm.Test.Query
             Comparer_AllTypes();
         }
 
+        [TestMethod]
+        public void Comparer_NaN()
+        {
+            Comparer_NaNAllTypes();
+            NativeAccelerator.Enable();
+            Comparer_NaNAllTypes();
+        }
+
+        [TestMethod]
+        public void Comparer_WhereOffset()
+        {
+            int[] left = Enumerable.Range(0, 150).Select((i) => (i * 7) % 10).ToArray();
+
+            foreach (int vectorIndex in new int[] { 0, 1, 31, 63, 64, 90 })
+            {
+                foreach (BooleanOperator bOp in new BooleanOperator[] { BooleanOperator.And, BooleanOperator.Or })
+                {
+                    // Start with alternating bits, so rows outside the range must be left unchanged
+                    ulong[] array = Enumerable.Repeat(0x5555555555555555UL, (vectorIndex + left.Length + 127) >> 6).ToArray();
+                    BitVector vector = new BitVector(array);
+                    vector.Capacity = array.Length * 64;
+
+                    XForm.Native.Comparer.Where(left, 0, left.Length, (byte)CompareOperator.LessThan, 5, (byte)bOp, array, vectorIndex);
+
+                    for (int i = 0; i < vector.Capacity; ++i)
+                    {
+                        bool expected = (i % 2 == 0);
+                        int row = i - vectorIndex;
+                        if (row >= 0 && row < left.Length) expected = (bOp == BooleanOperator.And ? expected && left[row] < 5 : expected || left[row] < 5);
+                        Assert.AreEqual(expected, vector[i], $"{bOp} at offset {vectorIndex}, bit {i}");
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_WhereIn()
+        {
+            byte[] bytes = Enumerable.Range(0, 300).Select((i) => (byte)((i * 37) % 256)).ToArray();
+            ushort[] ushorts = Enumerable.Range(0, 300).Select((i) => (ushort)((i * 907) % 65536)).ToArray();
+
+            // Byte values past the end of the (two word) set must not match
+            ulong[] byteSet = new ulong[2];
+            ulong[] ushortSet = new ulong[65536 >> 6];
+            for (int i = 0; i < 128; i += 3) byteSet[i >> 6] |= (0x1UL << (i & 63));
+            for (int i = 0; i < 65536; i += 7) ushortSet[i >> 6] |= (0x1UL << (i & 63));
+
+            foreach (int vectorIndex in new int[] { 0, 1, 63, 64, 90 })
+            {
+                foreach (BooleanOperator bOp in new BooleanOperator[] { BooleanOperator.And, BooleanOperator.Or })
+                {
+                    ulong[] byteArray = Enumerable.Repeat(0x5555555555555555UL, (vectorIndex + bytes.Length + 127) >> 6).ToArray();
+                    ulong[] ushortArray = (ulong[])byteArray.Clone();
+                    XForm.Native.Comparer.WhereIn(bytes, 0, bytes.Length, byteSet, (byte)bOp, byteArray, vectorIndex);
+                    XForm.Native.Comparer.WhereIn(ushorts, 0, ushorts.Length, ushortSet, (byte)bOp, ushortArray, vectorIndex);
+
+                    BitVector byteVector = new BitVector(byteArray);
+                    BitVector ushortVector = new BitVector(ushortArray);
+                    for (int i = 0; i < byteArray.Length * 64; ++i)
+                    {
+                        bool expectedByte = (i % 2 == 0);
+                        bool expectedUshort = expectedByte;
+                        int row = i - vectorIndex;
+
+                        if (row >= 0 && row < bytes.Length)
+                        {
+                            bool byteMatch = (bytes[row] < 128 && bytes[row] % 3 == 0);
+                            bool ushortMatch = (ushorts[row] % 7 == 0);
+                            expectedByte = (bOp == BooleanOperator.And ? expectedByte && byteMatch : expectedByte || byteMatch);
+                            expectedUshort = (bOp == BooleanOperator.And ? expectedUshort && ushortMatch : expectedUshort || ushortMatch);
+                        }
+
+                        Assert.AreEqual(expectedByte, byteVector[i], $"byte {bOp} at offset {vectorIndex}, bit {i}");
+                        Assert.AreEqual(expectedUshort, ushortVector[i], $"ushort {bOp} at offset {vectorIndex}, bit {i}");
+                    }
+                }
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_GroupCountAndSum()
+        {
+            // Runs of one key, then mixed keys, with a partial final block
+            int length = 1000;
+            byte[] keys = Enumerable.Range(0, length).Select((i) => (byte)(i < 300 ? 2 : (i * 7) % 5)).ToArray();
+            ushort[] wideKeys = keys.Select((k) => (ushort)(k * 100)).ToArray();
+            long[] values = Enumerable.Range(0, length).Select((i) => (long)(i % 13) - 6).ToArray();
+            int[] indices = Enumerable.Range(0, length / 3).Select((i) => i * 3).ToArray();
+
+            ulong[] vector = new ulong[(length + 63) >> 6];
+            for (int i = 0; i < length; ++i)
+            {
+                if (i % 3 == 0) vector[i >> 6] |= (0x1UL << (i & 63));
+            }
+
+            // The vector and the indices select the same rows, so every form must agree
+            int[] expectedCounts = new int[5];
+            long[] expectedSums = new long[5];
+            foreach (int row in indices)
+            {
+                expectedCounts[keys[row]]++;
+                expectedSums[keys[row]] += values[row];
+            }
+
+            int[] counts = new int[5];
+            long[] sums = new long[5];
+            XForm.Native.GroupN.Count(keys, 0, length, vector, counts);
+            XForm.Native.GroupN.Sum(keys, 0, values, 0, length, vector, sums);
+            CollectionAssert.AreEqual(expectedCounts, counts);
+            CollectionAssert.AreEqual(expectedSums, sums);
+
+            counts = new int[5];
+            sums = new long[5];
+            XForm.Native.GroupN.Count(keys, indices, 0, indices.Length, counts);
+            XForm.Native.GroupN.Sum(keys, values, indices, 0, indices.Length, sums);
+            CollectionAssert.AreEqual(expectedCounts, counts);
+            CollectionAssert.AreEqual(expectedSums, sums);
+
+            // Many-bucket ushort keys are accumulated directly rather than in partial histograms
+            int[] wideCounts = new int[401];
+            XForm.Native.GroupN.Count(wideKeys, indices, 0, indices.Length, wideCounts);
+            for (int key = 0; key < 5; ++key) Assert.AreEqual(expectedCounts[key], wideCounts[key * 100]);
+
+            // Every row, and keys past the end of the buckets
+            counts = new int[5];
+            XForm.Native.GroupN.Count(keys, 0, length, null, counts);
+            Assert.AreEqual(length, counts.Sum());
+            Assert.ThrowsException<IndexOutOfRangeException>(() => XForm.Native.GroupN.Count(keys, 0, length, null, new int[2]));
+        }
+
+        [TestMethod]
+        public void Comparer_Hash()
+        {
+            Random r = new Random(5);
+            long[] longs = Enumerable.Range(0, 1001).Select((i) => ((long)r.Next() << 32) | (uint)r.Next()).ToArray();
+            int[] ints = longs.Select((l) => unchecked((int)l)).ToArray();
+            int[] indices = Enumerable.Range(0, 300).Select((i) => (i * 7) % longs.Length).ToArray();
+
+            // Native hashes must match the managed hash exactly, alone and combined with a previous key column
+            int[] hashes = new int[longs.Length];
+            XForm.Native.HashN.Hash(ints, 1, ints.Length - 1, false, hashes);
+            for (int i = 0; i < ints.Length - 1; ++i) Assert.AreEqual(unchecked((int)Hashing.Hash(ints[i + 1], 0)), hashes[i]);
+
+            int[] combined = (int[])hashes.Clone();
+            XForm.Native.HashN.Hash(longs, 1, longs.Length - 1, true, combined);
+            for (int i = 0; i < longs.Length - 1; ++i) Assert.AreEqual(unchecked(hashes[i] * 31 + (int)Hashing.Hash(longs[i + 1], 0)), combined[i]);
+
+            XForm.Native.HashN.Hash(longs, indices, 0, indices.Length, false, hashes);
+            for (int i = 0; i < indices.Length; ++i) Assert.AreEqual(unchecked((int)Hashing.Hash(longs[indices[i]], 0)), hashes[i]);
+
+            // Back-to-back strings of every length through two Murmur3 blocks
+            byte[] text = Enumerable.Range(0, 3 + 40 * 39 / 2).Select((i) => (byte)(i * 31)).ToArray();
+            int[] ends = new int[40];
+            for (int i = 0, end = 3; i < ends.Length; ++i)
+            {
+                end += i;
+                ends[i] = end;
+            }
+
+            XForm.Native.HashN.Hash(text, 3, ends, 0, ends.Length, false, hashes);
+            for (int i = 0, start = 3; i < ends.Length; start = ends[i], ++i) Assert.AreEqual(unchecked((int)Hashing.Hash(new String8(text, start, ends[i] - start), 0)), hashes[i]);
+
+            // Batch lookups (native for integer keys) find the same keys as one at a time
+            NativeAccelerator.Enable();
+            IXArrayComparer comparer = TypeProviderFactory.Get(typeof(long)).TryGetComparer();
+            Dictionary5<long, int> dictionary = new Dictionary5<long, int>(new EqualityComparerAdapter<long>(comparer));
+            for (int i = 0; i < longs.Length; i += 2) dictionary[longs[i]] = i;
+
+            hashes = new int[longs.Length];
+            comparer.GetHashCodes(XArray.All(longs), hashes);
+
+            BitVector found = new BitVector(longs.Length);
+            int[] values = new int[longs.Length];
+            Assert.AreEqual(501, dictionary.TryGetValues(longs, 0, longs.Length, hashes, found, values));
+            for (int i = 0; i < longs.Length; ++i)
+            {
+                Assert.AreEqual(i % 2 == 0, found[i]);
+                if (i % 2 == 0) Assert.AreEqual(i, values[i / 2]);
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_WhereParallel()
+        {
+            // Large enough to be split across workers, with a partial final chunk
+            int[] left = Enumerable.Range(0, 1000000).Select((i) => (i * 7) % 10).ToArray();
+
+            foreach (int vectorIndex in new int[] { 0, 1, 63, 64, 600 })
+            {
+                foreach (BooleanOperator bOp in new BooleanOperator[] { BooleanOperator.And, BooleanOperator.Or })
+                {
+                    ulong[] expected = Enumerable.Repeat(0x5555555555555555UL, (vectorIndex + left.Length + 127) >> 6).ToArray();
+                    ulong[] actual = (ulong[])expected.Clone();
+
+                    XForm.Native.Comparer.Where(left, 10, left.Length - 10, (byte)CompareOperator.LessThan, 5, (byte)bOp, expected, vectorIndex);
+                    XForm.Native.ParallelN.Where(left, 10, left.Length - 10, (byte)CompareOperator.LessThan, 5, (byte)bOp, actual, vectorIndex);
+
+                    CollectionAssert.AreEqual(expected, actual, $"{bOp} at offset {vectorIndex}");
+                    Assert.AreEqual(XForm.Native.BitVectorN.Count(expected), XForm.Native.ParallelN.Count(actual));
+                }
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_KernelCounters()
+        {
+            NativeAccelerator.Enable();
+            NativeAccelerator.ResetKernelCounters();
+
+            int[] left = Enumerable.Range(0, 1000).ToArray();
+            ulong[] vector = new ulong[(left.Length + 63) >> 6];
+
+            // Kernels don't count calls until counting is enabled
+            Assert.IsFalse(NativeAccelerator.KernelCountersEnabled);
+            XForm.Native.Comparer.Where(left, 0, left.Length, (byte)CompareOperator.LessThan, 500, (byte)BooleanOperator.Or, vector, 0);
+            Assert.AreEqual(0, NativeAccelerator.ReadKernelCounters().First((c) => c.Kernel == "Comparer.Where").Calls);
+
+            try
+            {
+                NativeAccelerator.EnableKernelCounters(true);
+                Assert.IsTrue(NativeAccelerator.KernelCountersEnabled);
+
+                XForm.Native.Comparer.Where(left, 0, left.Length, (byte)CompareOperator.LessThan, 500, (byte)BooleanOperator.Or, vector, 0);
+                XForm.Native.Comparer.Where(left, 0, left.Length, (byte)CompareOperator.Equal, 900, (byte)BooleanOperator.Or, vector, 0);
+
+                NativeKernelCounter where = NativeAccelerator.ReadKernelCounters().First((c) => c.Kernel == "Comparer.Where");
+                Assert.AreEqual(2, where.Calls);
+                Assert.AreEqual(2 * left.Length, where.Elements);
+                Assert.AreEqual(2 * 4 * left.Length, where.Bytes);
+                Assert.IsTrue(where.Cycles > 0);
+
+                NativeAccelerator.ResetKernelCounters();
+                Assert.AreEqual(0, NativeAccelerator.ReadKernelCounters().First((c) => c.Kernel == "Comparer.Where").Calls);
+            }
+            finally
+            {
+                NativeAccelerator.EnableKernelCounters(false);
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_MappedColumn()
+        {
+            int[] values = Enumerable.Range(0, 1000).Select((i) => (i * 7) % 10).ToArray();
+            byte[] text = Encoding.UTF8.GetBytes(String.Join(" ", Enumerable.Range(0, 500).Select((i) => (i % 3 == 0 ? "HELLO" : "world"))));
+            string valuesPath = Path.GetTempFileName();
+            string textPath = Path.GetTempFileName();
+
+            try
+            {
+                byte[] bytes = new byte[values.Length * 4];
+                Buffer.BlockCopy(values, 0, bytes, 0, bytes.Length);
+                File.WriteAllBytes(valuesPath, bytes);
+                File.WriteAllBytes(textPath, text);
+
+                using (XForm.Native.MappedColumnN column = OpenMapped(valuesPath, typeof(int)))
+                {
+                    Assert.AreEqual(values.Length, column.Count);
+                    Assert.AreEqual(0L, column.Pointer.ToInt64() % 4096, "The view must be page aligned.");
+
+                    int[] copy = new int[values.Length - 20];
+                    column.Prefetch(10, copy.Length);
+                    column.Read(10, copy.Length, copy, 0);
+                    CollectionAssert.AreEqual(values.Skip(10).Take(copy.Length).ToArray(), copy);
+
+                    // Where on the mapped values matches Where on the array
+                    ulong[] expected = Enumerable.Repeat(0x5555555555555555UL, 17).ToArray();
+                    ulong[] actual = (ulong[])expected.Clone();
+                    XForm.Native.Comparer.Where(values, 10, values.Length - 10, (byte)CompareOperator.LessThan, 5, (byte)BooleanOperator.And, expected, 3);
+                    column.Where(10, values.Length - 10, (byte)CompareOperator.LessThan, 5, (byte)BooleanOperator.And, actual, 3);
+                    CollectionAssert.AreEqual(expected, actual);
+
+                    // Zoned Where on the mapped values matches zoned Where on the array, with bounds where the second and third block are decided
+                    int[] zoneMap = new int[] { 0, 9, 0, 4, 5, 9 };
+                    expected = new ulong[17];
+                    actual = new ulong[17];
+                    Assert.AreEqual(512, XForm.Native.ZoneMapN.Where(values, 10, values.Length - 10, (byte)CompareOperator.LessThan, 5, zoneMap, 256, 0, (byte)BooleanOperator.Or, expected, 0));
+                    Assert.AreEqual(512, column.Where(10, values.Length - 10, (byte)CompareOperator.LessThan, 5, zoneMap, 256, 0, (byte)BooleanOperator.Or, actual, 0));
+                    CollectionAssert.AreEqual(expected, actual);
+                }
+
+                using (XForm.Native.MappedColumnN column = OpenMapped(textPath, typeof(byte)))
+                {
+                    byte[] value = Encoding.UTF8.GetBytes("hello");
+                    int[] expected = new int[text.Length];
+                    int[] actual = new int[text.Length];
+
+                    int expectedCount = XForm.Native.String8N.IndexOfAll(text, 0, text.Length, value, 0, value.Length, true, expected);
+                    Assert.AreEqual(167, expectedCount);
+                    Assert.AreEqual(expectedCount, column.IndexOfAll(0, text.Length, value, 0, value.Length, true, actual));
+                    CollectionAssert.AreEqual(expected, actual);
+                }
+            }
+            finally
+            {
+                File.Delete(valuesPath);
+                File.Delete(textPath);
+            }
+        }
+
+        private static XForm.Native.MappedColumnN OpenMapped(string path, Type elementType)
+        {
+            using (FileStream stream = new FileStream(path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite | FileShare.Delete))
+            {
+                return XForm.Native.MappedColumnN.Map(stream, elementType);
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_Where16Compaction()
+        {
+            // Values on both sides of the signed and unsigned boundaries, with a partial final block
+            ushort[] left = Enumerable.Range(0, 200).Select((i) => (ushort)(32766 + (i * 7) % 5)).ToArray();
+            ushort[] right = Enumerable.Range(0, 200).Select((i) => (ushort)(32766 + (i * 3) % 5)).ToArray();
+            short[] signedLeft = left.Select((u) => (short)u).ToArray();
+
+            try
+            {
+                foreach (bool usePext in new bool[] { true, false })
+                {
+                    XForm.Native.Comparer.Where16UsesPext = usePext;
+
+                    for (CompareOperator cOp = CompareOperator.Equal; cOp <= CompareOperator.GreaterThanOrEqual; ++cOp)
+                    {
+                        ulong[] constant = new ulong[4];
+                        ulong[] pair = new ulong[4];
+                        ulong[] signed = new ulong[4];
+                        XForm.Native.Comparer.Where(left, 0, left.Length, (byte)cOp, (ushort)32768, (byte)BooleanOperator.Or, constant, 0);
+                        XForm.Native.Comparer.Where(left, 0, (byte)cOp, right, 0, left.Length, (byte)BooleanOperator.Or, pair, 0);
+                        XForm.Native.Comparer.Where(signedLeft, 0, signedLeft.Length, (byte)cOp, (short)-32768, (byte)BooleanOperator.Or, signed, 0);
+
+                        for (int i = 0; i < left.Length; ++i)
+                        {
+                            Assert.AreEqual(CompareOperators(left[i], 32768, cOp), new BitVector(constant)[i], $"{cOp} constant, PEXT={usePext}, row {i}");
+                            Assert.AreEqual(CompareOperators(left[i], right[i], cOp), new BitVector(pair)[i], $"{cOp} array, PEXT={usePext}, row {i}");
+                            Assert.AreEqual(CompareOperators(signedLeft[i], -32768, cOp), new BitVector(signed)[i], $"{cOp} signed, PEXT={usePext}, row {i}");
+                        }
+                    }
+                }
+            }
+            finally
+            {
+                XForm.Native.Comparer.ResetWhere16UsesPext();
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_ExecutePlan()
+        {
+            int length = 150;
+            int[] numbers = Enumerable.Range(0, length).Select((i) => (i * 7) % 10).ToArray();
+            double[] ratios = Enumerable.Range(0, length).Select((i) => (i % 4) / 2.0).ToArray();
+
+            // v0 = [Number] < 5 AND ([Ratio] = 0.5 OR [Number] = 9); v1 = NOT([Ratio] = 0.5 OR [Number] = 9)
+            byte[] program = new byte[]
+            {
+                XForm.Native.Plan.All, 0, 0, 0, 0, 0,
+                XForm.Native.Plan.Where, 0, 0, 0, (byte)CompareOperator.LessThan, (byte)BooleanOperator.And,
+                XForm.Native.Plan.None, 1, 0, 0, 0, 0,
+                XForm.Native.Plan.Where, 1, 1, 1, (byte)CompareOperator.Equal, (byte)BooleanOperator.Or,
+                XForm.Native.Plan.Where, 1, 0, 2, (byte)CompareOperator.Equal, (byte)BooleanOperator.Or,
+                XForm.Native.Plan.And, 0, 1, 0, 0, 0,
+                XForm.Native.Plan.Not, 1, 0, 0, 0, 0,
+                XForm.Native.Plan.Count, 0, 0, 0, 0, 0,
+                XForm.Native.Plan.Page, 0, 0, 0, 0, 0,
+                XForm.Native.Plan.Count, 1, 0, 0, 0, 0,
+            };
+
+            ulong[][] vectors = new ulong[][] { new ulong[3], new ulong[3] };
+            int[][] pages = new int[][] { new int[length] };
+            int[] results = new int[3];
+
+            int resultCount = XForm.Native.Plan.Execute(program, program.Length / XForm.Native.Plan.InstructionLength, new Array[] { numbers, ratios }, new int[] { 0, 0 }, new object[] { 5, 0.5, 9 }, vectors, pages, length, results);
+
+            int[] expected = Enumerable.Range(0, length).Where((i) => numbers[i] < 5 && (ratios[i] == 0.5 || numbers[i] == 9)).ToArray();
+            int expectedNot = Enumerable.Range(0, length).Count((i) => !(ratios[i] == 0.5 || numbers[i] == 9));
+
+            Assert.AreEqual(3, resultCount);
+            Assert.AreEqual(expected.Length, results[0]);
+            Assert.AreEqual(expected.Length, results[1]);
+            Assert.AreEqual(expectedNot, results[2]);
+            CollectionAssert.AreEqual(expected, pages[0].Take(results[1]).ToArray());
+
+            // Instructions referring to buffers which weren't passed are rejected before anything runs
+            program[6 + 2] = 5;
+            Assert.ThrowsException<ArgumentException>(() => XForm.Native.Plan.Execute(program, 2, new Array[] { numbers, ratios }, new int[] { 0, 0 }, new object[] { 5, 0.5, 9 }, vectors, pages, length, results));
+
+            // Columns without a start index are rejected as well
+            program[6 + 2] = 1;
+            Assert.ThrowsException<ArgumentException>(() => XForm.Native.Plan.Execute(program, 2, new Array[] { numbers, ratios }, new int[] { 0 }, new object[] { 5, 0.5, 9 }, vectors, pages, length, results));
+        }
+
+        [TestMethod]
+        public void Comparer_SplitTsvCsv()
+        {
+            Random r = new Random(6);
+            byte[] alphabet = Encoding.UTF8.GetBytes("a\t,\n\r\"");
+
+            // Random content covers partial final blocks, "\r\n" across block boundaries, lone '\r', and quotes open across blocks
+            for (int iteration = 0; iteration < 2000; ++iteration)
+            {
+                int start = 64 * r.Next(2);
+                byte[] content = new byte[start + r.Next(201)];
+                for (int i = 0; i < content.Length; ++i)
+                {
+                    content[i] = alphabet[r.Next(alphabet.Length)];
+                }
+
+                AssertSplit(content, start, (byte)'\t', false);
+                AssertSplit(content, start, (byte)',', true);
+            }
+
+            // "\r\n" split exactly across the first block boundary
+            byte[] boundary = Enumerable.Repeat((byte)'a', 130).ToArray();
+            boundary[63] = (byte)'\r';
+            boundary[64] = (byte)'\n';
+            AssertSplit(boundary, 0, (byte)'\t', false);
+            AssertSplit(boundary, 0, (byte)',', true);
+        }
+
+        private static void AssertSplit(byte[] content, int start, byte delimiter, bool quoted)
+        {
+            int length = content.Length - start;
+            ulong[] expected = new ulong[(content.Length + 63) >> 6];
+            ulong[] actual = new ulong[expected.Length];
+
+            // Cells end at unquoted delimiters and row ends; rows end at '\n' (except after '\r') and at the '\r' of "\r\n"
+            int expectedRows = 0;
+            bool inQuote = false;
+            for (int i = start; i < content.Length; ++i)
+            {
+                byte c = content[i];
+                if (quoted && c == (byte)'"') inQuote = !inQuote;
+                if (inQuote) continue;
+
+                bool isRowEnd = (c == (byte)'\n' && !(i > start && content[i - 1] == (byte)'\r')) || (c == (byte)'\r' && i + 1 < content.Length && content[i + 1] == (byte)'\n');
+                if (isRowEnd) expectedRows++;
+                if (isRowEnd || c == delimiter) expected[i >> 6] |= 0x1UL << (i & 63);
+            }
+
+            int actualRows = (quoted ? XForm.Native.String8N.SplitCsv(content, start, length, actual) : XForm.Native.String8N.SplitTsv(content, start, length, actual));
+            Assert.AreEqual(expectedRows, actualRows, $"Rows for {length} bytes from {start}");
+            if (length > 0) CollectionAssert.AreEqual(expected, actual, $"Cells for {length} bytes from {start}");
+        }
+
+        [TestMethod]
+        public void Comparer_SplitCells()
+        {
+            // Short rows get empty cells, extra cells are dropped, and "\r\n" ends rows like '\n'
+            AssertSplitCells("a\tb\tc\r\nd\ne\tf\tg\th\n", 3, false, "a|b|c", "d||", "e|f|g");
+
+            // CSV quotes are removed and doubled quotes unescaped; quoted delimiters and newlines stay in the cell
+            AssertSplitCells("\"a,b\",\"say \"\"hi\"\"\"\r\n\"\",x\"y\"\n\"line\nbreak\",z\n", 2, true, "a,b|say \"hi\"", "|x\"y\"", "line\nbreak|z");
+
+            // A final row without a newline isn't converted; nextIndex points to it
+            byte[] content = Encoding.UTF8.GetBytes("a,b\nc,d\n\"e\"\"\",f");
+            ulong[] cellVector = new ulong[1];
+            XForm.Native.String8N.SplitCsv(content, 0, content.Length, cellVector);
+
+            int[] starts = new int[2 * 2];
+            int[] lengths = new int[2 * 2];
+            int nextIndex = 0;
+            Assert.AreEqual(2, XForm.Native.String8N.SplitCells(content, 0, content.Length, cellVector, 2, starts, lengths, 2, true, ref nextIndex));
+            Assert.AreEqual(8, nextIndex);
+
+            // Converting again from nextIndex leaves the unterminated row quoted and unconverted
+            Assert.AreEqual(0, XForm.Native.String8N.SplitCells(content, nextIndex, content.Length - nextIndex, cellVector, 2, starts, lengths, 2, true, ref nextIndex));
+            Assert.AreEqual(8, nextIndex);
+            Assert.AreEqual("\"e\"\"\",f", Encoding.UTF8.GetString(content, 8, content.Length - 8));
+        }
+
+        private static void AssertSplitCells(string text, int columnCount, bool quoted, params string[] expectedRows)
+        {
+            // Start past the first block so block masking is covered, and resume from nextIndex one row at a time to cover the rowLimit cutoff
+            byte[] content = Encoding.UTF8.GetBytes(new string('-', 70) + text);
+            ulong[] cellVector = new ulong[(content.Length + 63) >> 6];
+            if (quoted)
+            {
+                XForm.Native.String8N.SplitCsv(content, 70, content.Length - 70, cellVector);
+            }
+            else
+            {
+                XForm.Native.String8N.SplitTsv(content, 70, content.Length - 70, cellVector);
+            }
+
+            for (int rowLimit = 1; rowLimit <= expectedRows.Length + 1; ++rowLimit)
+            {
+                byte[] copy = (byte[])content.Clone();
+                int[] starts = new int[columnCount * rowLimit];
+                int[] lengths = new int[columnCount * rowLimit];
+                List<string> actualRows = new List<string>();
+
+                int index = 70;
+                while (index < copy.Length)
+                {
+                    int nextIndex = 0;
+                    int rowCount = XForm.Native.String8N.SplitCells(copy, index, copy.Length - index, cellVector, columnCount, starts, lengths, rowLimit, quoted, ref nextIndex);
+                    Assert.AreEqual(Math.Min(rowLimit, expectedRows.Length - actualRows.Count), rowCount, $"Rows from {index} with limit {rowLimit}");
+
+                    for (int row = 0; row < rowCount; ++row)
+                    {
+                        actualRows.Add(string.Join("|", Enumerable.Range(0, columnCount).Select((column) => Encoding.UTF8.GetString(copy, starts[column * rowLimit + row], lengths[column * rowLimit + row]))));
+                    }
+
+                    index = nextIndex;
+                }
+
+                Assert.AreEqual(copy.Length, index, $"Resume index with limit {rowLimit}");
+                CollectionAssert.AreEqual(expectedRows, actualRows, $"Rows with limit {rowLimit}");
+            }
+        }
+
+        [TestMethod]
+        public void Comparer_IndexOfAllIgnoreCase()
+        {
+            // Latin-1, Greek, and Cyrillic uppercase must match lowercase values natively, with ASCII and other text around them
+            byte[] content = Encoding.UTF8.GetBytes("xx \u00C9COLE \u00E9cole \u0394\u0395\u039B\u03A4\u0391 \u041C\u041E\u0421\u041A\u0412\u0410 \u00C3\u00C9cole");
+            int[] matches = new int[10];
+
+            Assert.AreEqual(3, XForm.Native.String8N.IndexOfAll(content, 0, content.Length, Encoding.UTF8.GetBytes("\u00E9cole"), 0, 6, true, matches));
+            Assert.AreEqual(Encoding.UTF8.GetByteCount("xx "), matches[0]);
+            Assert.AreEqual(1, XForm.Native.String8N.IndexOfAll(content, 0, content.Length, Encoding.UTF8.GetBytes("\u00E9cole"), 0, 6, false, matches));
+
+            byte[] greek = Encoding.UTF8.GetBytes("\u03B4\u03B5\u03BB\u03C4\u03B1");
+            Assert.AreEqual(1, XForm.Native.String8N.IndexOfAll(content, 0, content.Length, greek, 0, greek.Length, true, matches));
+
+            byte[] cyrillic = Encoding.UTF8.GetBytes("\u043C\u043E\u0441\u043A\u0432\u0430");
+            Assert.AreEqual(1, XForm.Native.String8N.IndexOfAll(content, 0, content.Length, cyrillic, 0, cyrillic.Length, true, matches));
+        }
+
+        [TestMethod]
+        public void Comparer_IndexOfAny()
+        {
+            Random r = new Random(8);
+            byte[] alphabet = Encoding.UTF8.GetBytes("abAB-");
+
+            // More values than buckets, including one byte values and values longer than the three byte prefix which share it
+            byte[][] values = new string[] { "ab", "b", "aB", "abab", "ababa", "abab-ab", "-", "ba", "bab", "a-b", "BBB" }.Select((s) => Encoding.UTF8.GetBytes(s)).ToArray();
+
+            byte[] content = null;
+            for (int iteration = 0; iteration < 50; ++iteration)
+            {
+                // Random lengths end the text at every offset in the final 32 byte block
+                int start = r.Next(40);
+                content = new byte[start + r.Next(3000)];
+                for (int i = 0; i < content.Length; ++i)
+                {
+                    content[i] = alphabet[r.Next(alphabet.Length)];
+                }
+
+                // Room for exactly one match per value pages on nearly every index; 1024 is the WhereContainsAny batch size
+                foreach (bool ignoreCase in new bool[] { false, true })
+                {
+                    AssertIndexOfAny(content, start, values, ignoreCase, values.Length);
+                    AssertIndexOfAny(content, start, values, ignoreCase, 1024);
+                }
+            }
+
+            // Over IndexOfAnyValueLimit values are rejected; WhereContainsAny searches for each value separately instead
+            byte[][] tooMany = Enumerable.Range(0, XForm.Native.String8N.IndexOfAnyValueLimit + 1).Select((i) => Encoding.UTF8.GetBytes(i.ToString())).ToArray();
+            int[] tooManyMatches = new int[tooMany.Length];
+            int nextIndex = 0;
+            Assert.ThrowsException<ArgumentOutOfRangeException>(() => XForm.Native.String8N.IndexOfAny(content, 0, content.Length, tooMany, true, tooManyMatches, tooManyMatches, ref nextIndex));
+        }
+
+        private static void AssertIndexOfAny(byte[] content, int start, byte[][] values, bool ignoreCase, int matchLimit)
+        {
+            // Expect every (index, value) found by IndexOfAll for each value separately
+            List<long> expected = new List<long>();
+            int[] allMatches = new int[content.Length + 1];
+            for (int v = 0; v < values.Length; ++v)
+            {
+                int count = XForm.Native.String8N.IndexOfAll(content, start, content.Length - start, values[v], 0, values[v].Length, ignoreCase, allMatches);
+                for (int i = 0; i < count; ++i)
+                {
+                    expected.Add(((long)allMatches[i] << 16) | (long)v);
+                }
+            }
+
+            // Page through IndexOfAny, resuming from nextIndex until it finishes
+            List<long> actual = new List<long>();
+            int[] matches = new int[matchLimit];
+            int[] matchValues = new int[matchLimit];
+            int previousLastIndex = -1;
+            int nextIndex = start;
+            while (nextIndex != -1)
+            {
+                int from = nextIndex;
+                int count = XForm.Native.String8N.IndexOfAny(content, from, content.Length - from, values, ignoreCase, matches, matchValues, ref nextIndex);
+                Assert.IsTrue(nextIndex == -1 || count > 0, $"IndexOfAny from {from} must find a match before stopping");
+
+                // A full batch stops before an index whose matches don't all fit, so matches at one index are never split across batches
+                if (count > 0)
+                {
+                    Assert.IsTrue(matches[0] > previousLastIndex, $"Matches at {matches[0]} returned in two batches");
+                    Assert.IsTrue(nextIndex == -1 || nextIndex > matches[count - 1], $"Resume index {nextIndex} before the last match returned");
+                    previousLastIndex = matches[count - 1];
+                }
+
+                for (int i = 0; i < count; ++i)
+                {
+                    actual.Add(((long)matches[i] << 16) | (long)matchValues[i]);
+                }
+            }
+
+            expected.Sort();
+            actual.Sort();
+            CollectionAssert.AreEqual(expected, actual, $"IndexOfAny for {content.Length - start} bytes from {start}, ignoreCase {ignoreCase}, limit {matchLimit}");
+        }
+
+        private static void Comparer_NaNAllTypes()
+        {
+            // Every third value is NaN; NaN must match only NotEqual, as with the C# operators
+            float[] floats = Enumerable.Range(0, 150).Select((i) => (i % 3 == 0 ? float.NaN : (float)(i % 10))).ToArray();
+            double[] doubles = floats.Select((f) => (double)f).ToArray();
+
+            Comparer_VerifyNaN<float>(floats, 5.0f, (l, r, cOp) => CompareOperators(l, r, cOp));
+            Comparer_VerifyNaN<float>(floats, float.NaN, (l, r, cOp) => CompareOperators(l, r, cOp));
+            Comparer_VerifyNaN<double>(doubles, 5.0, (l, r, cOp) => CompareOperators(l, r, cOp));
+            Comparer_VerifyNaN<double>(doubles, double.NaN, (l, r, cOp) => CompareOperators(l, r, cOp));
+        }
+
+        private static void Comparer_VerifyNaN<T>(T[] left, T value, Func<T, T, CompareOperator, bool> expected)
+        {
+            T[] right = left.Reverse().ToArray();
+
+            foreach (CompareOperator cOp in new CompareOperator[] { CompareOperator.Equal, CompareOperator.NotEqual, CompareOperator.LessThan, CompareOperator.LessThanOrEqual, CompareOperator.GreaterThan, CompareOperator.GreaterThanOrEqual })
+            {
+                ComparerExtensions.Comparer comparer = TypeProviderFactory.Get(typeof(T).Name).TryGetComparer(cOp);
+
+                // Array to constant
+                BitVector vector = new BitVector(left.Length);
+                comparer(XArray.All(left, left.Length), XArray.Single(new T[1] { value }, left.Length), vector);
+                for (int i = 0; i < left.Length; ++i)
+                {
+                    Assert.AreEqual(expected(left[i], value, cOp), vector[i], $"{left[i]} {cOp} {value}");
+                }
+
+                // Array to array
+                vector = new BitVector(left.Length);
+                comparer(XArray.All(left, left.Length), XArray.All(right, right.Length), vector);
+                for (int i = 0; i < left.Length; ++i)
+                {
+                    Assert.AreEqual(expected(left[i], right[i], cOp), vector[i], $"{left[i]} {cOp} {right[i]}");
+                }
+            }
+        }
+
+        private static bool CompareOperators(double left, double right, CompareOperator cOp)
+        {
+            switch (cOp)
+            {
+                case CompareOperator.Equal:
+                    return left == right;
+                case CompareOperator.NotEqual:
+                    return left != right;
+                case CompareOperator.GreaterThan:
+                    return left > right;
+                case CompareOperator.GreaterThanOrEqual:
+                    return left >= right;
+                case CompareOperator.LessThan:
+                    return left < right;
+                case CompareOperator.LessThanOrEqual:
+                    return left <= right;
+            }
+
+            throw new NotImplementedException(cOp.ToString());
+        }
+
         private static void Comparer_AllTypes()
         {
             int[] ascending = Enumerable.Range(0, 120).ToArray();
@@ -51,6 +724,10 @@ namespace XForm.Test.Query
             Comparer_VerifyWhereAll<short>(someNegative.Select((i) => (short)i).ToArray(), alternating.Select((i) => (short)i).ToArray(), 0);
             Comparer_VerifyWhereAll<int>(someNegative.Select((i) => (int)i).ToArray(), alternating.Select((i) => (int)i).ToArray(), 0);
             Comparer_VerifyWhereAll<long>(someNegative.Select((i) => (long)i).ToArray(), alternating.Select((i) => (long)i).ToArray(), 0);
+
+            // Try with values on both sides of the signed range for unsigned types
+            Comparer_VerifyWhereAll<uint>(ascending.Select((i) => (uint)i + 0x7FFFFFC0U).ToArray(), alternating.Select((i) => (uint)i + 0x7FFFFFC0U).ToArray(), 0x80000000U);
+            Comparer_VerifyWhereAll<ulong>(ascending.Select((i) => (ulong)i + 0x7FFFFFFFFFFFFFC0UL).ToArray(), alternating.Select((i) => (ulong)i + 0x7FFFFFFFFFFFFFC0UL).ToArray(), 0x8000000000000000UL);
         }
 
         private static void Comparer_VerifyWhereAll<T>(T[] left, T[] right, T value) where T : IComparable<T>
@@ -238,5 +238,27 @@ namespace XForm.Test.Query
 
             TableTestHarness.AssertAreEqual(expected, actual, 25);
         }
+
+        [TestMethod]
+        public void Verb_SkipAfterWhere()
+        {
+            // Skip past several batches of sparse matches, so Where drops whole batches and seeks within the last one
+            int[] values = Enumerable.Range(0, 100000).ToArray();
+            int[] flags = values.Select((i) => (i * 37) % 7).ToArray();
+            int[] matches = values.Where((i) => flags[i] < 3).ToArray();
+
+            IXTable expected = TableTestHarness.DatabaseContext.FromArrays(matches.Length - 20000)
+                .WithColumn("Value", matches.Skip(20000).ToArray())
+                .WithColumn("Flag", matches.Skip(20000).Select((i) => flags[i]).ToArray());
+
+            IXTable actual = TableTestHarness.DatabaseContext.FromArrays(values.Length)
+                .WithColumn("Value", values)
+                .WithColumn("Flag", flags)
+                .Query(@"
+                    where [Flag] < 3
+                    skip 20000", TableTestHarness.DatabaseContext);
+
+            TableTestHarness.AssertAreEqual(expected, actual, 25);
+        }
     }
 }
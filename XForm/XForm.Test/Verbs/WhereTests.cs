@@ -1,9 +1,12 @@
 ﻿using System;
+using System.Linq;
 
 using Elfie.Test;
 
+using Microsoft.CodeAnalysis.Elfie.Model.Strings;
 using Microsoft.VisualStudio.TestTools.UnitTesting;
 
+using XForm.Data;
 using XForm.Extensions;
 using XForm.Query;
 
@@ -79,6 +82,162 @@ namespace XForm.Test.Verbs
             Assert.AreEqual((long)50, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [EventTime] : \"0z\"\r\nwhere Cast([ID], Int32) > 499").Count());
         }
 
+        [TestMethod]
+        public void Where_MultipleNumericTerms()
+        {
+            Where_MultipleNumericTermsQueries();
+
+            // Run with several numeric terms fused into one native Where, if available
+            NativeAccelerator.Enable();
+            Where_MultipleNumericTermsQueries();
+        }
+
+        private static void Where_MultipleNumericTermsQueries()
+        {
+            Assert.AreEqual((long)99, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) > 499 AND Cast([ID], Int32) < 600 AND Cast([ID], Int32) != 550").Count());
+            Assert.AreEqual((long)0, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) < 100 AND Cast([ID], Int64) > 900").Count());
+            Assert.AreEqual((long)50, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) > 499 AND Cast([ID], Int16) <= 999 AND [EventTime] : \"0z\"").Count());
+            Assert.AreEqual((long)200, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) < 100 OR Cast([ID], Int64) >= 900").Count());
+            Assert.AreEqual((long)12, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) < 10 OR Cast([ID], Int16) = 500 OR [ID] : \"999\"").Count());
+        }
+
+        [TestMethod]
+        public void Where_MultipleContainsTerms()
+        {
+            Where_MultipleContainsTermsQueries();
+
+            // Run with the Contains values on one column searched for in a single native pass, if available
+            NativeAccelerator.Enable();
+            Where_MultipleContainsTermsQueries();
+        }
+
+        private static void Where_MultipleContainsTermsQueries()
+        {
+            Assert.AreEqual((long)19, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] : \"99\" OR [ID] : \"999\"").Count());
+            Assert.AreEqual((long)38, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] : \"99\" OR [ID] : \"88\" OR [ID] : \"9999\"").Count());
+            Assert.AreEqual((long)48, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] : \"99\" OR Cast([ID], Int32) < 10 OR [ID] : \"88\"").Count());
+
+            // Over 1024 matches in one page, both from row zero and in a page starting at row 600
+            foreach (int batchSize in new int[] { 1000, 600 })
+            {
+                Assert.AreEqual((long)491, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [UserGuid] : \"4\" OR [UserGuid] : \"F\" OR [UserGuid] : \"f4\"").Count(batchSize: batchSize));
+            }
+        }
+
+        [TestMethod]
+        public void Where_String8Terms()
+        {
+            Where_String8TermsQueries();
+
+            // Run with String8 to constant terms compared natively on the raw String8 bytes, if available
+            NativeAccelerator.Enable();
+            Where_String8TermsQueries();
+        }
+
+        private static void Where_String8TermsQueries()
+        {
+            Assert.AreEqual((long)1, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] = \"500\"").Count());
+            Assert.AreEqual((long)999, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] != \"500\"").Count());
+            Assert.AreEqual((long)0, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] = \"\"").Count());
+            Assert.AreEqual((long)1000, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] != \"\"").Count());
+            Assert.AreEqual((long)0, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] = \"500000000000\"").Count());
+
+            Assert.AreEqual((long)445, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] < \"5\"").Count());
+            Assert.AreEqual((long)446, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] <= \"5\"").Count());
+            Assert.AreEqual((long)10, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] > \"99\"").Count());
+            Assert.AreEqual((long)11, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] >= \"99\"").Count());
+            Assert.AreEqual((long)2, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] < \"10\"").Count());
+            Assert.AreEqual((long)1000, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] > \"\"").Count());
+
+            Assert.AreEqual((long)11, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] |> \"99\"").Count());
+            Assert.AreEqual((long)0, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] |> \"\"").Count());
+            Assert.AreEqual((long)90, SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere [ID] |> \"5\" AND Cast([ID], Int32) > 509").Count());
+        }
+
+        [TestMethod]
+        public void Where_LargeBatch()
+        {
+            Where_LargeBatchQueries();
+
+            // Run with batches large enough for Where and Count to be split across the native worker pool, if available
+            NativeAccelerator.Enable();
+            Where_LargeBatchQueries();
+        }
+
+        private static void Where_LargeBatchQueries()
+        {
+            // Over four million rows in one batch, so the match vector has enough words for a parallel Count
+            int rowCount = (1 << 22) + 1000;
+            int[] values = Enumerable.Range(0, rowCount).Select((i) => (i * 7) % 10).ToArray();
+            IXTable source = TableTestHarness.DatabaseContext.FromArrays(rowCount).WithColumn("Value", values);
+
+            Assert.AreEqual((long)values.Count((v) => v < 3), source.Query("where [Value] < 3", TableTestHarness.DatabaseContext).Count(batchSize: rowCount));
+        }
+
+        [TestMethod]
+        public void Where_FilteredValues()
+        {
+            Where_FilteredValuesQueries();
+
+            // Run with matching values of contiguous columns copied straight from the match vector, if available
+            NativeAccelerator.Enable();
+            Where_FilteredValuesQueries();
+        }
+
+        private static void Where_FilteredValuesQueries()
+        {
+            // Runs of every row matching, mixed blocks, and sparse blocks
+            int rowCount = 25000;
+            int[] key = Enumerable.Range(0, rowCount).Select((i) => (i % 1000 < 300 ? 0 : (i * 37) % 100)).ToArray();
+            long[] longs = Enumerable.Range(0, rowCount).Select((i) => (long)i << 33).ToArray();
+            short[] shorts = Enumerable.Range(0, rowCount).Select((i) => (short)i).ToArray();
+            byte[] bytes = Enumerable.Range(0, rowCount).Select((i) => (byte)i).ToArray();
+            double[] doubles = Enumerable.Range(0, rowCount).Select((i) => i / 8.0).ToArray();
+
+            IXTable source = TableTestHarness.DatabaseContext.FromArrays(rowCount)
+                .WithColumn("Key", key)
+                .WithColumn("Long", longs)
+                .WithColumn("Short", shorts)
+                .WithColumn("Byte", bytes)
+                .WithColumn("Double", doubles);
+
+            int[] matches = Enumerable.Range(0, rowCount).Where((i) => key[i] < 40).ToArray();
+            IXTable expected = TableTestHarness.DatabaseContext.FromArrays(matches.Length)
+                .WithColumn("Key", matches.Select((i) => key[i]).ToArray())
+                .WithColumn("Long", matches.Select((i) => longs[i]).ToArray())
+                .WithColumn("Short", matches.Select((i) => shorts[i]).ToArray())
+                .WithColumn("Byte", matches.Select((i) => bytes[i]).ToArray())
+                .WithColumn("Double", matches.Select((i) => doubles[i]).ToArray());
+
+            foreach (int pageSize in new int[] { 100, 4096, 25000 })
+            {
+                TableTestHarness.AssertAreEqual(expected, source.Query("where [Key] < 40", TableTestHarness.DatabaseContext), pageSize);
+            }
+        }
+
+        [TestMethod]
+        public void Where_FilteredStrings()
+        {
+            string[] expected = FilteredIds(1000);
+
+            // Every row below 300 matches, and only some above; verify the values themselves so the comparison doesn't depend on test order
+            Assert.AreEqual(SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) < 300 OR [ID] : \"7\"").Count(), (long)expected.Length);
+            Assert.IsTrue(expected.All((id) => int.Parse(id) < 300 || id.Contains("7")));
+
+            // Compare with String8 rows compacted from their raw positions, if available, in pages from row zero and from later rows
+            NativeAccelerator.Enable();
+            foreach (int batchSize in new int[] { 1000, 600, 64 })
+            {
+                CollectionAssert.AreEqual(expected, FilteredIds(batchSize), $"Batch Size {batchSize:n0}");
+            }
+        }
+
+        private static string[] FilteredIds(int batchSize)
+        {
+            IXTable query = SampleDatabase.XDatabaseContext.Query("read WebRequest\r\nwhere Cast([ID], Int32) < 300 OR [ID] : \"7\"");
+            return query.ToList<String8>("ID", batchSize: batchSize).SelectMany((page) => page.Select((id) => id.ToString())).ToArray();
+        }
+
         [TestMethod]
         public void Where_ContainsChaining()
         {
@@ -0,0 +1,494 @@
+﻿// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.Reflection;
+using System.Runtime.InteropServices;
+
+using XForm.Extensions;
+using XForm.Query;
+using XForm.Types;
+using XForm.Types.Comparers;
+
+namespace XForm
+{
+    /// <summary>
+    ///  NativeKernelBenchmarks times XForm.Native kernels over the same matrix as Arriba.Native.Benchmarks: working sets
+    ///  sized for L1, L2, the last level cache, and DRAM, selectivities of 1%, 50%, and 99% for kernels whose speed depends on
+    ///  the data, and buffers at 0 and 8 bytes past a cache line boundary. Data is seeded the same way every run, so two builds
+    ///  (or one build on two machines) can be compared from the --csv output; the checksum column shows if their results differ.
+    ///
+    ///  Usage: xform benchmarknative [--csv] [--quick] [--kernel name]
+    /// </summary>
+    /// <remarks>
+    ///  The kernels are called through the same delegates NativeAccelerator binds, so the times include the managed
+    ///  to native transition and pinning, as in queries. Managed code can't read the TSC, so times are reported in
+    ///  ns per element rather than cycles. Kernels taking a whole array (BitVectorN.Count and Page) can't be offset within it;
+    ///  for them, the alignment column is where the runtime placed the array.
+    /// </remarks>
+    internal class NativeKernelBenchmarks
+    {
+        // Rows per kernel call; queries pass batches of this size
+        private const int Rows = XTableExtensions.DefaultBatchSize;
+
+        // Distinct instances generated per run; larger working sets repeat them at new addresses
+        private const int TemplateCount = 16;
+
+        private const int CacheLineBytes = 64;
+        private const ulong RandomSeed = 0x9E3779B97F4A7C15UL;
+
+        private static readonly string[] s_levelNames = { "L1", "L2", "LLC", "DRAM" };
+        private static readonly long[] s_levelBytes = { 24 * 1024, 192 * 1024, 4 * 1024 * 1024, 256 * 1024 * 1024 };
+        private static readonly double[] s_selectivities = { 0.01, 0.5, 0.99 };
+        private static readonly int[] s_alignments = { 0, 8 };
+
+        private bool _csv;
+        private bool _quick;
+        private string _kernelName;
+
+        private ulong _random;
+        private List<GCHandle> _pinned;
+
+        // What a kernel reads and writes per call and how to build one call of it at a selectivity and alignment
+        private class Kernel
+        {
+            public string Name;
+            public bool DataDependent;
+            public bool IsPlaced;
+            public Func<double, long> BytesPerCall;
+            public Func<NativeKernelBenchmarks, double, int, Instance> Build;
+        }
+
+        // One call's buffers, bound into Run, and an FNV-1a hash of what the call wrote (for the checksum)
+        private class Instance
+        {
+            public Func<int> Run;
+            public Func<uint> Hash;
+            public int Alignment;
+        }
+
+        public NativeKernelBenchmarks(string[] args)
+        {
+            for (int i = 1; i < args.Length; ++i)
+            {
+                if (args[i].Equals("--csv", StringComparison.OrdinalIgnoreCase))
+                {
+                    _csv = true;
+                }
+                else if (args[i].Equals("--quick", StringComparison.OrdinalIgnoreCase))
+                {
+                    _quick = true;
+                }
+                else if (args[i].Equals("--kernel", StringComparison.OrdinalIgnoreCase) && i + 1 < args.Length)
+                {
+                    _kernelName = args[++i];
+                }
+                else
+                {
+                    throw new UsageException("'benchmarknative' [--csv] [--quick] [--kernel name]");
+                }
+            }
+
+            _pinned = new List<GCHandle>();
+        }
+
+        public void Run()
+        {
+            // Quick runs skip DRAM and take fewer, shorter trials; enough to spot a large regression
+            double minimumSeconds = (_quick ? 0.005 : 0.02);
+            int trials = (_quick ? 3 : 5);
+            int levelCount = s_levelNames.Length - (_quick ? 1 : 0);
+
+            WriteHeader();
+
+            foreach (Kernel kernel in Kernels())
+            {
+                if (_kernelName != null && !_kernelName.Equals(kernel.Name, StringComparison.OrdinalIgnoreCase)) continue;
+
+                if (kernel.Build == null)
+                {
+                    if (!_csv) Console.WriteLine($"{kernel.Name,-24} (not exported)");
+                    continue;
+                }
+
+                foreach (double selectivity in (kernel.DataDependent ? s_selectivities : new double[] { 0.5 }))
+                {
+                    long bytesPerCall = kernel.BytesPerCall(selectivity);
+
+                    for (int level = 0; level < levelCount; ++level)
+                    {
+                        // Skip cache levels a single call's buffers don't fit in
+                        if (bytesPerCall > s_levelBytes[level]) continue;
+
+                        foreach (int alignment in (kernel.IsPlaced ? s_alignments : new int[] { 0 }))
+                        {
+                            // Build instances filling about the working set, repeating the template data at new addresses
+                            List<Instance> instances = new List<Instance>();
+                            long instanceCount = s_levelBytes[level] / bytesPerCall;
+                            for (int i = 0; i < instanceCount; ++i)
+                            {
+                                if (i % TemplateCount == 0) _random = RandomSeed;
+                                instances.Add(kernel.Build(this, selectivity, alignment));
+                            }
+
+                            double secondsPerCall = Measure(instances, minimumSeconds, trials);
+                            uint checksum = Checksum(instances[0]);
+                            WriteMeasurement(kernel, s_levelNames[level], instances.Count * bytesPerCall, selectivity, instances[0].Alignment, bytesPerCall, secondsPerCall, checksum);
+
+                            Free();
+                        }
+                    }
+                }
+            }
+        }
+
+        private List<Kernel> Kernels()
+        {
+            List<Kernel> kernels = new List<Kernel>();
+
+            AddWhere<int>(kernels, "Comparer.Where(int)", (r) => (int)(r % 1000), (t) => (int)t);
+            AddWhere<ushort>(kernels, "Comparer.Where(ushort)", (r) => (ushort)(r % 1000), (t) => (ushort)t);
+            AddWhere<byte>(kernels, "Comparer.Where(byte)", (r) => (byte)(r % 200), (t) => (byte)(t / 5));
+            AddWhere<long>(kernels, "Comparer.Where(long)", (r) => (long)(r % 1000), (t) => (long)t);
+
+            Func<ulong[], int> count = TryGetMethod<Func<ulong[], int>>("XForm.Native.BitVectorN", "Count");
+            kernels.Add(new Kernel()
+            {
+                Name = "BitVectorN.Count",
+                DataDependent = false,
+                BytesPerCall = (s) => Rows / 8,
+                Build = (count == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    ulong[] vector = b.Vector(selectivity);
+                    return new Instance() { Run = () => count(vector), Hash = () => 0, Alignment = b.AlignmentOf(vector) };
+                }))
+            });
+
+            BitVector.PageSignature page = TryGetMethod<BitVector.PageSignature>("XForm.Native.BitVectorN", "Page");
+            kernels.Add(new Kernel()
+            {
+                Name = "BitVectorN.Page",
+                DataDependent = true,
+                BytesPerCall = (s) => Rows / 8 + (long)(s * Rows) * 4,
+                Build = (page == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    ulong[] vector = b.Vector(selectivity);
+                    int[] indices = new int[Rows];
+                    return new Instance()
+                    {
+                        Run = () => { int next = 0; return page(vector, indices, ref next, indices.Length); },
+                        Hash = () => Fnv(indices, 0, indices.Length),
+                        Alignment = b.AlignmentOf(vector)
+                    };
+                }))
+            });
+
+            // Text with selectivity of the bytes a cell end (nine in ten tabs, one in ten newlines)
+            Func<byte[], int, int, ulong[], int> splitTsv = TryGetMethod<Func<byte[], int, int, ulong[], int>>("XForm.Native.String8N", "SplitTsv");
+            kernels.Add(new Kernel()
+            {
+                Name = "String8N.SplitTsv",
+                DataDependent = true,
+                IsPlaced = true,
+                BytesPerCall = (s) => Rows + Rows / 8,
+                Build = (splitTsv == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    int index;
+                    byte[] content = b.Place<byte>(Rows, alignment, out index);
+                    for (int i = 0; i < Rows; ++i) content[index + i] = (byte)(b.NextBit(selectivity) ? (b.NextBit(0.9) ? '\t' : '\n') : 'a');
+
+                    ulong[] cellVector = new ulong[(index + Rows + 63) >> 6];
+                    return new Instance()
+                    {
+                        Run = () => splitTsv(content, index, Rows, cellVector),
+                        Hash = () => Fnv(cellVector, 0, cellVector.Length),
+                        Alignment = alignment
+                    };
+                }))
+            });
+
+            // Text with a match starting in each eight byte slot with selectivity probability
+            String8Comparer.IndexOfAll indexOfAll = TryGetMethod<String8Comparer.IndexOfAll>("XForm.Native.String8N", "IndexOfAllAvx2") ?? TryGetMethod<String8Comparer.IndexOfAll>("XForm.Native.String8N", "IndexOfAll");
+            byte[] value = { (byte)'x', (byte)'f', (byte)'o', (byte)'r', (byte)'m' };
+            kernels.Add(new Kernel()
+            {
+                Name = "String8N.IndexOfAll",
+                DataDependent = true,
+                IsPlaced = true,
+                BytesPerCall = (s) => Rows + (long)(s * Rows / 8) * 4,
+                Build = (indexOfAll == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    int index;
+                    byte[] content = b.Text(selectivity, alignment, value, out index);
+                    int[] matches = new int[Rows / 8 + 1];
+                    return new Instance()
+                    {
+                        Run = () => indexOfAll(content, index, Rows, value, 0, value.Length, true, matches),
+                        Hash = () => Fnv(matches, 0, matches.Length),
+                        Alignment = alignment
+                    };
+                }))
+            });
+
+            String8Comparer.IndexOfAny indexOfAny = TryGetMethod<String8Comparer.IndexOfAny>("XForm.Native.String8N", "IndexOfAny");
+            byte[][] values = { value, new byte[] { (byte)'q', (byte)'u', (byte)'e' }, new byte[] { (byte)'z', (byte)'z', (byte)'z', (byte)'z' } };
+            kernels.Add(new Kernel()
+            {
+                Name = "String8N.IndexOfAny",
+                DataDependent = true,
+                IsPlaced = true,
+                BytesPerCall = (s) => Rows + (long)(s * Rows / 8) * 8,
+                Build = (indexOfAny == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    int index;
+                    byte[] content = b.Text(selectivity, alignment, value, out index);
+                    int[] matches = new int[Rows / 8 + 1];
+                    int[] matchValues = new int[matches.Length];
+                    return new Instance()
+                    {
+                        Run = () => { int next = index; return indexOfAny(content, index, Rows, values, true, matches, matchValues, ref next); },
+                        Hash = () => Fnv(matches, 0, matches.Length),
+                        Alignment = alignment
+                    };
+                }))
+            });
+
+            ComparerExtensions.Hash hash = TryGetMethod<ComparerExtensions.Hash>("XForm.Native.HashN", "Hash");
+            kernels.Add(new Kernel()
+            {
+                Name = "HashN.Hash(int)",
+                DataDependent = false,
+                IsPlaced = true,
+                BytesPerCall = (s) => Rows * 8,
+                Build = (hash == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    int index;
+                    int[] keys = b.Place<int>(Rows, alignment, out index);
+                    for (int i = 0; i < Rows; ++i) keys[index + i] = (int)b.NextRandom();
+
+                    int[] hashes = new int[Rows];
+                    return new Instance()
+                    {
+                        Run = () => { hash(keys, index, Rows, false, hashes); return hashes[0]; },
+                        Hash = () => Fnv(hashes, 0, hashes.Length),
+                        Alignment = alignment
+                    };
+                }))
+            });
+
+            return kernels;
+        }
+
+        // Where [Value] < threshold, with values uniform so that 'selectivity' of them match
+        private void AddWhere<T>(List<Kernel> kernels, string name, Func<ulong, T> valueFromRandom, Func<double, T> threshold)
+        {
+            ComparerExtensions.WhereSingle<T> where = TryGetMethod<ComparerExtensions.WhereSingle<T>>("XForm.Native.Comparer", "Where");
+            int elementBytes = Marshal.SizeOf(typeof(T));
+
+            kernels.Add(new Kernel()
+            {
+                Name = name,
+                DataDependent = true,
+                IsPlaced = true,
+                BytesPerCall = (s) => (long)Rows * elementBytes + Rows / 8,
+                Build = (where == null ? null : (Func<NativeKernelBenchmarks, double, int, Instance>)((b, selectivity, alignment) =>
+                {
+                    int index;
+                    T[] left = b.Place<T>(Rows, alignment, out index);
+                    for (int i = 0; i < Rows; ++i) left[index + i] = valueFromRandom(b.NextRandom());
+
+                    T right = threshold(selectivity * 1000);
+                    ulong[] vector = new ulong[Rows / 64];
+                    return new Instance()
+                    {
+                        Run = () => { where(left, index, Rows, (byte)CompareOperator.LessThan, right, (byte)BooleanOperator.Or, vector, 0); return 0; },
+                        Hash = () => Fnv(vector, 0, vector.Length),
+                        Alignment = alignment
+                    };
+                }))
+            });
+        }
+
+        private static T TryGetMethod<T>(string namespaceAndTypeName, string methodName) where T : class
+        {
+            // Kernels a build doesn't export are skipped, so older builds can still be compared
+            try
+            {
+                return NativeAccelerator.GetMethod<T>(namespaceAndTypeName, methodName);
+            }
+            catch (ArgumentException)
+            {
+                return null;
+            }
+        }
+
+        #region Data
+        // xorshift64*, reseeded for each set of templates so every run (and every build compared) sees the same data
+        private ulong NextRandom()
+        {
+            _random ^= _random >> 12;
+            _random ^= _random << 25;
+            _random ^= _random >> 27;
+            return _random * 0x2545F4914F6CDD1DUL;
+        }
+
+        private bool NextBit(double probability)
+        {
+            return (NextRandom() >> 11) * (1.0 / 9007199254740992.0) < probability;
+        }
+
+        private ulong[] Vector(double selectivity)
+        {
+            ulong[] vector = new ulong[Rows / 64];
+            for (int i = 0; i < vector.Length; ++i)
+            {
+                for (int bit = 0; bit < 64; ++bit)
+                {
+                    if (NextBit(selectivity)) vector[i] |= 0x1UL << bit;
+                }
+            }
+
+            return vector;
+        }
+
+        private byte[] Text(double selectivity, int alignment, byte[] value, out int index)
+        {
+            byte[] content = Place<byte>(Rows, alignment, out index);
+            for (int i = 0; i < Rows; ++i) content[index + i] = (byte)('a' + (int)(NextRandom() % 26));
+
+            for (int slot = 0; slot + value.Length <= Rows; slot += 8)
+            {
+                if (NextBit(selectivity)) Buffer.BlockCopy(value, 0, content, index + slot, value.Length);
+            }
+
+            return content;
+        }
+
+        // Allocate an array with 'length' elements from 'index', pinned so that index is 'alignment' bytes past a cache line
+        private T[] Place<T>(int length, int alignment, out int index)
+        {
+            int elementBytes = Marshal.SizeOf(typeof(T));
+            T[] array = new T[length + (CacheLineBytes + alignment) / elementBytes + 1];
+
+            GCHandle handle = GCHandle.Alloc(array, GCHandleType.Pinned);
+            _pinned.Add(handle);
+
+            long address = handle.AddrOfPinnedObject().ToInt64();
+            long target = ((address + CacheLineBytes - 1) & ~(long)(CacheLineBytes - 1)) + alignment;
+            index = (int)((target - address) / elementBytes);
+            return array;
+        }
+
+        private int AlignmentOf(Array array)
+        {
+            GCHandle handle = GCHandle.Alloc(array, GCHandleType.Pinned);
+            _pinned.Add(handle);
+            return (int)(handle.AddrOfPinnedObject().ToInt64() & (CacheLineBytes - 1));
+        }
+
+        private void Free()
+        {
+            foreach (GCHandle handle in _pinned)
+            {
+                handle.Free();
+            }
+
+            _pinned.Clear();
+        }
+        #endregion
+
+        #region Measurement
+        // Run every instance in turn until 'minimumSeconds' pass; report the fastest of 'trials' runs
+        private static double Measure(List<Instance> instances, double minimumSeconds, int trials)
+        {
+            double best = double.MaxValue;
+            int sink = 0;
+
+            // Warm up: touch every instance once
+            foreach (Instance instance in instances) sink += instance.Run();
+
+            for (int trial = 0; trial < trials; ++trial)
+            {
+                long calls = 0;
+                Stopwatch w = Stopwatch.StartNew();
+
+                do
+                {
+                    for (int i = 0; i < instances.Count; ++i) sink += instances[i].Run();
+                    calls += instances.Count;
+                } while (w.Elapsed.TotalSeconds < minimumSeconds);
+
+                best = Math.Min(best, w.Elapsed.TotalSeconds / calls);
+            }
+
+            GC.KeepAlive(sink);
+            return best;
+        }
+
+        // FNV-1a of the first instance's return value and outputs, which should match across builds and CPUs
+        private static uint Checksum(Instance instance)
+        {
+            int returned = instance.Run();
+            return Fnv(new int[] { returned }, 0, 1) ^ instance.Hash();
+        }
+
+        private static uint Fnv<T>(T[] array, int index, int length) where T : struct
+        {
+            byte[] bytes = new byte[length * Marshal.SizeOf(typeof(T))];
+            Buffer.BlockCopy(array, index * Marshal.SizeOf(typeof(T)), bytes, 0, bytes.Length);
+
+            uint hash = 2166136261U;
+            for (int i = 0; i < bytes.Length; ++i)
+            {
+                hash = (hash ^ bytes[i]) * 16777619U;
+            }
+
+            return hash;
+        }
+        #endregion
+
+        #region Output
+        private void WriteHeader()
+        {
+            string dllPath = Assembly.Load("XForm.Native").Location;
+            string cpu = Environment.GetEnvironmentVariable("PROCESSOR_IDENTIFIER") ?? "Unknown";
+            Func<string> describe = TryGetMethod<Func<string>>("XForm.Native.CpuFeatures", "Describe");
+            string features = (describe != null ? describe() : "");
+
+            if (_csv)
+            {
+                Console.WriteLine($"# dll: {dllPath}");
+                Console.WriteLine($"# cpu: {cpu}");
+                Console.WriteLine($"# features: {features}");
+                Console.WriteLine("kernel,level,workingSetBytes,selectivity,alignment,elementsPerCall,bytesPerCall,nsPerCall,nsPerElement,gigabytesPerSecond,checksum");
+            }
+            else
+            {
+                Console.WriteLine($"{"dll",-10} {dllPath}");
+                Console.WriteLine($"{"cpu",-10} {cpu}");
+                Console.WriteLine($"{"features",-10} {features}");
+                Console.WriteLine();
+                Console.WriteLine($"{"Kernel",-24} {"Level",-5} {"WorkingSet",10} {"Select",6} {"Align",5} {"ns/call",12} {"ns/elem",10} {"GB/s",8} {"Checksum",9}");
+            }
+        }
+
+        private void WriteMeasurement(Kernel kernel, string level, long workingSetBytes, double selectivity, int alignment, long bytesPerCall, double secondsPerCall, uint checksum)
+        {
+            double nanoseconds = secondsPerCall * 1e9;
+            double nanosecondsPerElement = nanoseconds / Rows;
+            double gigabytesPerSecond = (bytesPerCall / secondsPerCall) / 1e9;
+
+            if (_csv)
+            {
+                Console.WriteLine($"{kernel.Name},{level},{workingSetBytes},{selectivity:f2},{alignment},{Rows},{bytesPerCall},{nanoseconds:f2},{nanosecondsPerElement:f5},{gigabytesPerSecond:f3},{checksum:x8}");
+            }
+            else
+            {
+                Console.WriteLine($"{kernel.Name,-24} {level,-5} {workingSetBytes / 1024,9}K {selectivity,6:f2} {alignment,5} {nanoseconds,12:f1} {nanosecondsPerElement,10:f4} {gigabytesPerSecond,8:f2} {checksum,9:x}");
+            }
+        }
+        #endregion
+    }
+}
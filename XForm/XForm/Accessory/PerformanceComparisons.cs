@@ -65,6 +65,7 @@ namespace XForm
 
             //WhereUShortUnderConstant();
             //WhereUShortEqualsUshort();
+            //WhereUShortCompaction();
             //ByteLessThanConstant();
             //DoubleWhere();
             //Join();
@@ -177,6 +178,38 @@ namespace XForm
             }
         }
 
+        public void WhereUShortCompaction()
+        {
+            // Native 16-bit Where compacts compare masks with PEXT or with a pack and permute; PEXT is microcoded on AMD before Zen 3
+            Func<bool> getUsesPext = NativeAccelerator.GetMethod<Func<bool>>("XForm.Native.Comparer", "get_Where16UsesPext");
+            Action<bool> setUsesPext = NativeAccelerator.GetMethod<Action<bool>>("XForm.Native.Comparer", "set_Where16UsesPext");
+            Action resetUsesPext = NativeAccelerator.GetMethod<Action>("XForm.Native.Comparer", "ResetWhere16UsesPext");
+            bool cpuDefault = getUsesPext();
+
+            foreach (string query in new string[] { "where [Value] <= 50", "where [Value] = [Threshold]" })
+            {
+                using (Benchmarker b = new Benchmarker($"ushort[{Count:n0}] | {query} | count [CPU default: {(cpuDefault ? "PEXT" : "Packs")}]", DefaultMeasureMilliseconds))
+                {
+                    foreach (bool usePext in new bool[] { true, false })
+                    {
+                        setUsesPext(usePext);
+
+                        b.Measure($"XForm Native {(usePext ? "PEXT" : "Packs")} Count", Values.Length, () =>
+                        {
+                            return (int)Context.FromArrays(Values.Length)
+                            .WithColumn("Value", Values)
+                            .WithColumn("Threshold", Thresholds)
+                            .Query(query, Context)
+                            .Count();
+                        });
+                    }
+
+                    resetUsesPext();
+                    b.AssertResultsEqual();
+                }
+            }
+        }
+
         public void DoubleWhere()
         {
             using (Benchmarker b = new Benchmarker($"ushort[{Count:n0}] | where [Value] < 50 || [Value] > 950 | count", DefaultMeasureMilliseconds))
@@ -363,14 +396,12 @@ namespace XForm
 
             byte[] content = new byte[64 * 1024];
             BitVector cells = new BitVector(content.Length);
-            BitVector rows = new BitVector(content.Length);
             int[] rowEnds = new int[1024];
 
             byte[] allContent = new byte[tsvStream.Length];
             tsvStream.Seek(0, SeekOrigin.Begin);
             tsvStream.Read(allContent, 0, allContent.Length);
             BitVector allCells = new BitVector(allContent.Length);
-            BitVector allRows = new BitVector(allContent.Length);
 
             using (Benchmarker b = new Benchmarker($"Tsv Parse [{rowCount:n0}] | count", DefaultMeasureMilliseconds))
             {
@@ -417,7 +448,7 @@ namespace XForm
                 });
 
 
-                Func<byte[], int, int, ulong[], ulong[], int> splitTsvN = NativeAccelerator.GetMethod<Func<byte[], int, int, ulong[], ulong[], int>>("XForm.Native.String8N", "SplitTsv");
+                Func<byte[], int, int, ulong[], int> splitTsvN = NativeAccelerator.GetMethod<Func<byte[], int, int, ulong[], int>>("XForm.Native.String8N", "SplitTsv");
                 b.Measure("XForm Native Split", (int)tsvStream.Length, () =>
                 {
                     tsvStream.Seek(0, SeekOrigin.Begin);
@@ -429,7 +460,7 @@ namespace XForm
                         if (lengthRead == 0) break;
                         if (lengthRead < content.Length) Array.Clear(content, lengthRead, content.Length - lengthRead);
 
-                        int lineCount = splitTsvN(content, 0, lengthRead, cells.Array, rows.Array);
+                        int lineCount = splitTsvN(content, 0, lengthRead, cells.Array);
                         count += lineCount;
 
                         int fromRow = 0;
@@ -441,7 +472,7 @@ namespace XForm
 
                 b.MeasureParallel("XForm Native Split Parallel", (int)tsvStream.Length, (index, length) =>
                 {
-                    return splitTsvN(allContent, index, length, allCells.Array, allRows.Array) - 1;
+                    return splitTsvN(allContent, index, length, allCells.Array) - 1;
                 });
             }
         }
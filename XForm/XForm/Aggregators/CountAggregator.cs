@@ -1,6 +1,8 @@
 ﻿// Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+using System;
+
 using XForm.Data;
 
 namespace XForm.Aggregators
@@ -18,6 +20,9 @@ namespace XForm.Aggregators
 
     public class CountAggregator : IAggregator, IFoundIndicesTracker
     {
+        internal static Action<Array, int, int, ulong[], int[]> s_nativeCount;
+        internal static Action<Array, int[], int, int, int[]> s_nativeCountIndices;
+
         private int[] _countPerBucket;
         private int _distinctCount;
 
@@ -64,6 +69,10 @@ namespace XForm.Aggregators
             {
                 AddInt(rowIndices, newDistinctCount);
             }
+            else if (s_nativeCount != null && !rowIndices.Selector.IsSingleValue)
+            {
+                AddNative(rowIndices);
+            }
             else if (rowIndices.Array is byte[])
             {
                 AddByte(rowIndices, newDistinctCount);
@@ -74,6 +83,19 @@ namespace XForm.Aggregators
             }
         }
 
+        private void AddNative(XArray rowIndices)
+        {
+            // Count byte and ushort bucket indices natively, for contiguous or indexed rows
+            if (rowIndices.Selector.Indices != null)
+            {
+                s_nativeCountIndices(rowIndices.Array, rowIndices.Selector.Indices, rowIndices.Selector.StartIndexInclusive, rowIndices.Count, _countPerBucket);
+            }
+            else
+            {
+                s_nativeCount(rowIndices.Array, rowIndices.Selector.StartIndexInclusive, rowIndices.Count, null, _countPerBucket);
+            }
+        }
+
         private void AddInt(XArray rowIndices, int newDistinctCount)
         {
             int[] array = (int[])rowIndices.Array;
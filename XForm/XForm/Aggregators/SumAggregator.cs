@@ -22,6 +22,9 @@ namespace XForm.Aggregators
 
     public class SumAggregator : IAggregator
     {
+        internal static Action<Array, int, Array, int, int, ulong[], Array> s_nativeSum;
+        internal static Action<Array, Array, int[], int, int, Array> s_nativeSumIndices;
+
         private IXColumn _sumColumn;
         private Func<XArray> _sumCurrentGetter;
 
@@ -51,6 +54,10 @@ namespace XForm.Aggregators
             {
                 AddInt(rowIndices, sumValues, newDistinctCount);
             }
+            else if (s_nativeSum != null && CanAddNative(rowIndices, sumValues))
+            {
+                AddNative(rowIndices, sumValues);
+            }
             else if (rowIndices.Array is byte[])
             {
                 AddByte(rowIndices, sumValues, newDistinctCount);
@@ -61,6 +68,26 @@ namespace XForm.Aggregators
             }
         }
 
+        private static bool CanAddNative(XArray rowIndices, XArray sumValues)
+        {
+            // Byte and ushort bucket indices can be summed natively if both sides are contiguous or share the same row indices
+            if (sumValues.HasNulls || rowIndices.Selector.IsSingleValue || sumValues.Selector.IsSingleValue) return false;
+            if (rowIndices.Selector.Indices == null) return (sumValues.Selector.Indices == null);
+            return (rowIndices.Selector.Indices == sumValues.Selector.Indices && rowIndices.Selector.StartIndexInclusive == sumValues.Selector.StartIndexInclusive);
+        }
+
+        private void AddNative(XArray rowIndices, XArray sumValues)
+        {
+            if (rowIndices.Selector.Indices != null)
+            {
+                s_nativeSumIndices(rowIndices.Array, sumValues.Array, rowIndices.Selector.Indices, rowIndices.Selector.StartIndexInclusive, rowIndices.Count, _sumPerBucket);
+            }
+            else
+            {
+                s_nativeSum(rowIndices.Array, rowIndices.Selector.StartIndexInclusive, sumValues.Array, sumValues.Selector.StartIndexInclusive, rowIndices.Count, null, _sumPerBucket);
+            }
+        }
+
         private void AddInt(XArray rowIndices, XArray sumValues, int newDistinctCount)
         {
             long[] sumArray = (long[])sumValues.Array;
@@ -3,6 +3,8 @@
 
 using System;
 
+using Microsoft.CodeAnalysis.Elfie.Model.Strings;
+
 using XForm.Data;
 using XForm.Transforms;
 
@@ -33,8 +35,20 @@ namespace XForm.Columns
         {
             Func<XArray> sourceGetter = _column.CurrentGetter();
             int[] remapArray = null;
+            Array compactArray = null;
+
+            // Compact String8 rows from their raw positions, when the column has them, rather than remapping each String8
+            Func<object> rawGetter = (_column.ColumnDetails.Type == typeof(String8) ? _column.ComponentGetter(ColumnComponent.String8Raw) : null);
+            if (rawGetter != null)
+            {
+                String8[] stringArray = null;
+                int[] startsArray = null;
+                int[] endsArray = null;
+
+                return () => _remapper.Remap(sourceGetter, rawGetter, ref remapArray, ref stringArray, ref startsArray, ref endsArray);
+            }
 
-            return () => _remapper.Remap(sourceGetter(), ref remapArray);
+            return () => _remapper.Remap(sourceGetter(), ref remapArray, ref compactArray);
         }
 
         public Func<ArraySelector, XArray> SeekGetter()
@@ -56,7 +70,8 @@ namespace XForm.Columns
             if (sourceGetter == null) return null;
 
             int[] remapArray = null;
-            return () => _remapper.Remap(sourceGetter(), ref remapArray);
+            Array compactArray = null;
+            return () => _remapper.Remap(sourceGetter(), ref remapArray, ref compactArray);
         }
 
         public Func<ArraySelector, XArray> IndicesSeekGetter()
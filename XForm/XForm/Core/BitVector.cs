@@ -92,7 +92,7 @@ namespace XForm
                 const ulong m4 = 0x0f0f0f0f0f0f0f0fUL;
                 const ulong h1 = 0x0101010101010101UL;
 
-                ushort count = 0;
+                int count = 0;
 
                 int length = _bitVector.Length;
                 for (int i = 0; i < length; ++i)
@@ -103,7 +103,7 @@ namespace XForm
                     x = (x & m2) + ((x >> 2) & m2);
                     x = (x + (x >> 4)) & m4;
 
-                    count += (ushort)((x * h1) >> 56);
+                    count += (int)((x * h1) >> 56);
                 }
 
                 return count;
@@ -26,6 +26,7 @@ namespace XForm
         private int _totalRowCount;
         private BitVector _bestRowVector;
         private int[] _rowBuffer;
+        private int[] _hashes;
 
         public ChooseDictionary(ChooseDirection direction, ColumnDetails rankColumn, ColumnDetails[] keyColumns, int initialCapacity = -1)
         {
@@ -63,13 +64,27 @@ namespace XForm
             // Give the arrays to the keys and rank columns
             SetCurrentArrays(keys, rankValues, rowIndexxarray);
 
+            // Hash every row (resizes use a separate array; they run during an Expand in the middle of the outer Add)
+            int[] hashes;
+            if (isResize)
+            {
+                hashes = new int[rankValues.Count];
+            }
+            else
+            {
+                Allocator.AllocateToSize(ref _hashes, rankValues.Count);
+                hashes = _hashes;
+            }
+
+            HashArrays(hashes, rankValues.Count);
+
             for (uint rowIndex = 0; rowIndex < rankValues.Count; ++rowIndex)
             {
                 // Set values to insert as current
                 SetCurrent(rowIndex);
 
                 // Get the hash of the row
-                uint hash = HashCurrent();
+                uint hash = unchecked((uint)hashes[rowIndex]);
 
                 // Add the new item
                 if (!this.Add(hash))
@@ -154,16 +169,15 @@ namespace XForm
             _bestRowIndices.SetCurrent(index);
         }
 
-        private uint HashCurrent()
+        private void HashArrays(int[] hashes, int rowCount)
         {
-            int hash = 0;
+            // Combine the hashes of each key column for each row, as the keys' HashCurrent would, a whole column at a time
+            Array.Clear(hashes, 0, rowCount);
 
             for (int keyIndex = 0; keyIndex < _keys.Length; ++keyIndex)
             {
-                hash = _keys[keyIndex].HashCurrent(hash);
+                _keys[keyIndex].HashArray(hashes);
             }
-
-            return unchecked((uint)hash);
         }
 
         protected override bool EqualsCurrent(uint index)
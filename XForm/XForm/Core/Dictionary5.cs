@@ -23,6 +23,11 @@ namespace XForm
 
         private T _currentKey;
         private U _currentValue;
+        private int[] _bucketsBuffer;
+
+        // Integer keys can be found natively, comparing them bitwise
+        private static readonly bool s_isIntegerKey = (typeof(T) == typeof(int) || typeof(T) == typeof(uint) || typeof(T) == typeof(long) || typeof(T) == typeof(ulong)
+            || typeof(T) == typeof(short) || typeof(T) == typeof(ushort) || typeof(T) == typeof(byte) || typeof(T) == typeof(sbyte));
 
         public Dictionary5(IEqualityComparer<T> comparer, int initialCapacity = -1)
         {
@@ -122,6 +127,48 @@ namespace XForm
             }
         }
 
+        /// <summary>
+        ///  Look up a range of keys at once, given their hashes from the comparer GetHashCode.
+        ///  Integer keys with an XForm comparer are found natively, so the table reads for many keys overlap.
+        /// </summary>
+        /// <param name="keys">Array containing keys to find</param>
+        /// <param name="index">Index of first key to find</param>
+        /// <param name="length">Count of keys to find</param>
+        /// <param name="hashes">Hash of each key, from [0, length)</param>
+        /// <param name="found">BitVector to set the bit for each key found in, from [0, length)</param>
+        /// <param name="values">Array to write the value for each key found to, in order</param>
+        /// <returns>Count of keys found</returns>
+        public int TryGetValues(T[] keys, int index, int length, int[] hashes, BitVector found, U[] values)
+        {
+            Allocator.AllocateToSize(ref _bucketsBuffer, length);
+
+            if (s_IndexOfNative != null && s_isIntegerKey && _comparer is EqualityComparerAdapter<T>)
+            {
+                s_IndexOfNative(keys, index, length, hashes, _keys, this.Metadata, this.MaxProbeLength, _bucketsBuffer);
+            }
+            else
+            {
+                for (int i = 0; i < length; ++i)
+                {
+                    _currentKey = keys[index + i];
+                    _bucketsBuffer[i] = this.IndexOf(unchecked((uint)hashes[i]));
+                }
+            }
+
+            int countFound = 0;
+            for (int i = 0; i < length; ++i)
+            {
+                int bucket = _bucketsBuffer[i];
+                if (bucket != -1)
+                {
+                    found.Set(i);
+                    values[countFound++] = _values[bucket];
+                }
+            }
+
+            return countFound;
+        }
+
         /// <summary>
         ///  Return whether this Dictionary contains the given key.
         /// </summary>
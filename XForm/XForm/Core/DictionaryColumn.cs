@@ -14,6 +14,7 @@ namespace XForm
         Array Values { get; }
         void Reset(int size);
         int HashCurrent(int hash);
+        void HashArray(int[] hashes);
         void SetArray(XArray xarray);
         void SetCurrent(uint index);
         void SwapCurrent(uint index);
@@ -53,6 +54,25 @@ namespace XForm
             return (hash << 5) - hash + _comparer.GetHashCode(_current);
         }
 
+        public void HashArray(int[] hashes)
+        {
+            // Combine the hash of every row in the current array into hashes, exactly as HashCurrent would for each row
+            if (_currentArray.HasNulls)
+            {
+                // Null rows hash as the default value (as SetCurrent sets them), where GetHashCodes would skip them
+                for (int i = 0; i < _currentArray.Count; ++i)
+                {
+                    int realIndex = _currentArray.Index(i);
+                    TColumnType value = (_currentArray.NullRows[realIndex] ? default(TColumnType) : _currentTypedArray[realIndex]);
+                    hashes[i] = (hashes[i] << 5) - hashes[i] + _comparer.GetHashCode(value);
+                }
+            }
+            else
+            {
+                _comparer.GetHashCodes(_currentArray, hashes);
+            }
+        }
+
         public void SetArray(XArray xarray)
         {
             _currentArray = xarray;
@@ -23,6 +23,7 @@ namespace XForm
 
         private int _currentRowAdding;
         private int[] _currentAddedArrayIndices;
+        private int[] _currentHashes;
 
         public GroupByDictionary(ColumnDetails[] keyColumns, int initialCapacity = -1)
         {
@@ -50,13 +51,17 @@ namespace XForm
             // Build an array to contain the found (or added) index for each key
             Allocator.AllocateToSize(ref _currentAddedArrayIndices, rowCount);
 
+            // Hash every row
+            Allocator.AllocateToSize(ref _currentHashes, rowCount);
+            HashArrays(_currentHashes, rowCount);
+
             for (uint rowIndex = 0; rowIndex < rowCount; ++rowIndex)
             {
                 // Set values to insert as current
                 SetCurrent(rowIndex);
 
                 // Get the hash of the row
-                uint hash = HashCurrent();
+                uint hash = unchecked((uint)_currentHashes[rowIndex]);
 
                 // Add the new item
                 if (!this.Add(hash))
@@ -84,13 +89,17 @@ namespace XForm
 
             int[] indicesArray = (int[])indices.Array;
 
+            // Hash every row (into a separate array; this runs during an Expand in the middle of the outer FindOrAdd)
+            int[] hashes = new int[rowCount];
+            HashArrays(hashes, rowCount);
+
             for (uint rowIndex = 0; rowIndex < rowCount; ++rowIndex)
             {
                 // Set values to insert as current
                 SetCurrent(rowIndex, indicesArray[indices.Index((int)rowIndex)]);
 
                 // Get the hash of the row
-                uint hash = HashCurrent();
+                uint hash = unchecked((uint)hashes[rowIndex]);
 
                 // Add the new item
                 if (!this.Add(hash))
@@ -155,16 +164,15 @@ namespace XForm
             _currentRowAdding = -1;
         }
 
-        private uint HashCurrent()
+        private void HashArrays(int[] hashes, int rowCount)
         {
-            int hash = 0;
+            // Combine the hashes of each key column for each row, as the keys' HashCurrent would, a whole column at a time
+            Array.Clear(hashes, 0, rowCount);
 
             for (int keyIndex = 0; keyIndex < _keys.Length; ++keyIndex)
             {
-                hash = _keys[keyIndex].HashCurrent(hash);
+                _keys[keyIndex].HashArray(hashes);
             }
-
-            return unchecked((uint)hash);
         }
 
         protected override bool EqualsCurrent(uint index)
@@ -68,6 +68,9 @@ namespace XForm
         // Items can be a maximum of 14 buckets from the initial bucket they hash to, so the probe length fits in four bits with a sentinel zero
         private const int ProbeLengthLimit = 14;
 
+        // Native batch IndexOf for tables with integer keys
+        internal static ComparerExtensions.IndexOf s_IndexOfNative = null;
+
         public HashCore()
         {
             // Descendant needs to call Reset to ensure arrays allocated,
@@ -8,12 +8,30 @@ using System.IO;
 using System.Linq;
 using System.Reflection;
 
+using XForm.Aggregators;
 using XForm.Data;
+using XForm.IO;
+using XForm.Query.Expression;
+using XForm.Transforms;
 using XForm.Types;
 using XForm.Types.Comparers;
 
 namespace XForm
 {
+    /// <summary>
+    ///  NativeKernelCounter is the calls, values, bytes, and timestamp counter cycles of one XForm.Native kernel, summed across threads.
+    /// </summary>
+    public struct NativeKernelCounter
+    {
+        public string Kernel { get; set; }
+        public long Calls { get; set; }
+        public long Elements { get; set; }
+        public long Bytes { get; set; }
+        public long Cycles { get; set; }
+
+        public double BytesPerCycle => (Cycles == 0 ? 0.0 : (double)Bytes / Cycles);
+    }
+
     /// <summary>
     ///  NativeAccelerator allows enabling or disabling accelerated C++ implementations
     ///  of key XForm operations.
@@ -23,6 +41,17 @@ namespace XForm
     /// </remarks>
     public static class NativeAccelerator
     {
+        // Rows (for Where) and vector words (for Count) from which ParallelN splits a call across its workers: four chunks of
+        // WhereChunkWords or CountChunkWords in Parallel.cpp. Smaller calls use the single threaded kernels, skipping the pool.
+        private const int ParallelWhereRows = 4 * 1024 * 64;
+        private const int ParallelCountWords = 4 * 16384;
+
+        private static Func<string[]> s_kernelNames;
+        private static Action<long[]> s_readKernelCounters;
+        private static Action s_resetKernelCounters;
+        private static Func<bool> s_kernelCountersEnabled;
+        private static Action<bool> s_enableKernelCounters;
+
         public static T GetMethod<T>(string namespaceAndTypeName, string methodName)
         {
             Type delegateOrFuncType = typeof(T);
@@ -46,21 +75,172 @@ namespace XForm
             string nativeBinaryPath = Path.Combine(Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location), "XForm.Native.dll");
             if (!File.Exists(nativeBinaryPath) || !Environment.Is64BitProcess) return;
 
-            BitVector.s_nativeCount = GetMethod<Func<ulong[], int>>("XForm.Native.BitVectorN", "Count");
+            // XForm.Native is built for AVX2; don't enable it on CPUs which can't run it. Kernels pick AVX-512 variants themselves.
+            if (!GetMethod<Func<bool>>("XForm.Native.CpuFeatures", "IsSupported")()) return;
+
+            // Kernels only count their calls once EnableKernelCounters turns counting on
+            s_kernelNames = GetMethod<Func<string[]>>("XForm.Native.KernelCountersN", "Names");
+            s_readKernelCounters = GetMethod<Action<long[]>>("XForm.Native.KernelCountersN", "Read");
+            s_resetKernelCounters = GetMethod<Action>("XForm.Native.KernelCountersN", "Reset");
+            s_kernelCountersEnabled = GetMethod<Func<bool>>("XForm.Native.KernelCountersN", "IsEnabled");
+            s_enableKernelCounters = GetMethod<Action<bool>>("XForm.Native.KernelCountersN", "Enable");
+
+            Func<ulong[], int> count = GetMethod<Func<ulong[], int>>("XForm.Native.BitVectorN", "Count");
+            Func<ulong[], int> parallelCount = GetMethod<Func<ulong[], int>>("XForm.Native.ParallelN", "Count");
+            BitVector.s_nativeCount = (vector) => (vector.Length >= ParallelCountWords ? parallelCount(vector) : count(vector));
             BitVector.s_nativePage = GetMethod<BitVector.PageSignature>("XForm.Native.BitVectorN", "Page");
+            RankSelect.s_nativeBuild = GetMethod<RankSelect.BuildSignature>("XForm.Native.BitVectorN", "BuildRanks");
+            RankSelect.s_nativeSelect = GetMethod<RankSelect.SelectSignature>("XForm.Native.BitVectorN", "Select");
+
+            // Copy matching values of filtered columns straight from the match vector
+            RowRemapper.s_nativeCompact = GetMethod<RowRemapper.CompactSignature>("XForm.Native.BitVectorN", "Compact");
+            RowRemapper.s_nativeCompactString8 = GetMethod<RowRemapper.CompactString8Signature>("XForm.Native.BitVectorN", "CompactString8");
 
-            String8Comparer.s_IndexOfAllNative = GetMethod<String8Comparer.IndexOfAll>("XForm.Native.String8N", "IndexOfAll");
+            // Read primitive column files through memory-mapped views
+            MappedArrayReader.s_MapNative = GetMethod<Func<FileStream, Type, IDisposable>>("XForm.Native.MappedColumnN", "Map");
+
+            // Use the AVX2 IndexOfAll where supported, falling back to the SSE4.2 version
+            bool isAvx2Supported = GetMethod<Func<bool>>("XForm.Native.String8N", "IsAvx2Supported")();
+            String8Comparer.s_IndexOfAllNative = GetMethod<String8Comparer.IndexOfAll>("XForm.Native.String8N", (isAvx2Supported ? "IndexOfAllAvx2" : "IndexOfAll"));
+            String8Comparer.s_IndexOfAnyNative = GetMethod<String8Comparer.IndexOfAny>("XForm.Native.String8N", "IndexOfAny");
+            String8Comparer.s_WhereRawNative = GetMethod<String8Comparer.WhereRaw>("XForm.Native.String8N", "Where");
 
             UshortComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<ushort>>("XForm.Native.Comparer", "Where");
             ShortComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<short>>("XForm.Native.Comparer", "Where");
+            UintComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<uint>>("XForm.Native.Comparer", "Where");
+            IntComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<int>>("XForm.Native.Comparer", "Where");
+            UlongComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<ulong>>("XForm.Native.Comparer", "Where");
+            LongComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<long>>("XForm.Native.Comparer", "Where");
+            FloatComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<float>>("XForm.Native.Comparer", "Where");
+            DoubleComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<double>>("XForm.Native.Comparer", "Where");
             //ByteComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<byte>>("XForm.Native.Comparer", "Where");
             //SbyteComparer.s_WhereNative = GetMethod<ComparerExtensions.Where<sbyte>>("XForm.Native.Comparer", "Where");
 
-            UshortComparer.s_WhereSingleNative = GetMethod<ComparerExtensions.WhereSingle<ushort>>("XForm.Native.Comparer", "Where");
-            ShortComparer.s_WhereSingleNative = GetMethod<ComparerExtensions.WhereSingle<short>>("XForm.Native.Comparer", "Where");
-            ByteComparer.s_WhereSingleNative = GetMethod<ComparerExtensions.WhereSingle<byte>>("XForm.Native.Comparer", "Where");
-            SbyteComparer.s_WhereSingleNative = GetMethod<ComparerExtensions.WhereSingle<sbyte>>("XForm.Native.Comparer", "Where");
+            SetComparer.s_WhereInNative = GetMethod<ComparerExtensions.WhereIn<byte>>("XForm.Native.Comparer", "WhereIn");
+
+            // Widen byte and ushort VariableInteger columns in bulk
+            VariableIntegerReader.s_WidenByteNative = GetMethod<ComparerExtensions.Widen<byte>>("XForm.Native.VariableIntegerN", "Widen");
+            VariableIntegerReader.s_WidenUshortNative = GetMethod<ComparerExtensions.Widen<ushort>>("XForm.Native.VariableIntegerN", "Widen");
+
+            CountAggregator.s_nativeCount = GetMethod<Action<Array, int, int, ulong[], int[]>>("XForm.Native.GroupN", "Count");
+            CountAggregator.s_nativeCountIndices = GetMethod<Action<Array, int[], int, int, int[]>>("XForm.Native.GroupN", "Count");
+            SumAggregator.s_nativeSum = GetMethod<Action<Array, int, Array, int, int, ulong[], Array>>("XForm.Native.GroupN", "Sum");
+            SumAggregator.s_nativeSumIndices = GetMethod<Action<Array, Array, int[], int, int, Array>>("XForm.Native.GroupN", "Sum");
+
+            // Hash numeric keys and String8 runs in bulk for GroupBy, Join, and Choose
+            ComparerExtensions.Hash hash = GetMethod<ComparerExtensions.Hash>("XForm.Native.HashN", "Hash");
+            ComparerExtensions.HashIndices hashIndices = GetMethod<ComparerExtensions.HashIndices>("XForm.Native.HashN", "Hash");
+            ByteComparer.s_GetHashCodesNative = hash;
+            ByteComparer.s_GetHashCodesIndicesNative = hashIndices;
+            SbyteComparer.s_GetHashCodesNative = hash;
+            SbyteComparer.s_GetHashCodesIndicesNative = hashIndices;
+            ShortComparer.s_GetHashCodesNative = hash;
+            ShortComparer.s_GetHashCodesIndicesNative = hashIndices;
+            UshortComparer.s_GetHashCodesNative = hash;
+            UshortComparer.s_GetHashCodesIndicesNative = hashIndices;
+            IntComparer.s_GetHashCodesNative = hash;
+            IntComparer.s_GetHashCodesIndicesNative = hashIndices;
+            UintComparer.s_GetHashCodesNative = hash;
+            UintComparer.s_GetHashCodesIndicesNative = hashIndices;
+            LongComparer.s_GetHashCodesNative = hash;
+            LongComparer.s_GetHashCodesIndicesNative = hashIndices;
+            UlongComparer.s_GetHashCodesNative = hash;
+            UlongComparer.s_GetHashCodesIndicesNative = hashIndices;
+            FloatComparer.s_GetHashCodesNative = hash;
+            FloatComparer.s_GetHashCodesIndicesNative = hashIndices;
+            DoubleComparer.s_GetHashCodesNative = hash;
+            DoubleComparer.s_GetHashCodesIndicesNative = hashIndices;
+            String8Comparer.s_GetHashCodesNative = GetMethod<ComparerExtensions.HashText>("XForm.Native.HashN", "Hash");
+            HashCore.s_IndexOfNative = GetMethod<ComparerExtensions.IndexOf>("XForm.Native.HashN", "IndexOf");
+
+            // Skip comparing blocks zone maps decide for single column to constant terms
+            TermExpression.s_WhereZonedNative = GetMethod<ComparerExtensions.WhereZoned>("XForm.Native.ZoneMapN", "Where");
+            TermExpression.s_CountZoneDecidedNative = GetMethod<ComparerExtensions.CountZoneDecided>("XForm.Native.ZoneMapN", "CountDecided");
+
+            AndExpression.s_WhereAndNative = GetMethod<ComparerExtensions.WhereAnd>("XForm.Native.Comparer", "WhereAnd");
+            OrExpression.s_ExecutePlanNative = GetMethod<ComparerExtensions.ExecutePlan>("XForm.Native.Plan", "Execute");
+
+            // Column to constant Where for numeric types, split across the ParallelN workers for calls covering enough rows
+            ComparerExtensions.WhereParallel parallelWhere = GetMethod<ComparerExtensions.WhereParallel>("XForm.Native.ParallelN", "Where");
+            UshortComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<ushort>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            ShortComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<short>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            UintComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<uint>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            IntComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<int>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            UlongComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<ulong>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            LongComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<long>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            FloatComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<float>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            DoubleComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<double>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            ByteComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<byte>>("XForm.Native.Comparer", "Where"), parallelWhere);
+            SbyteComparer.s_WhereSingleNative = ParallelAbove(GetMethod<ComparerExtensions.WhereSingle<sbyte>>("XForm.Native.Comparer", "Where"), parallelWhere);
             BoolComparer.s_WhereSingleNative = GetMethod<ComparerExtensions.WhereSingle<bool>>("XForm.Native.Comparer", "Where");
         }
+
+        private static ComparerExtensions.WhereSingle<T> ParallelAbove<T>(ComparerExtensions.WhereSingle<T> where, ComparerExtensions.WhereParallel parallelWhere)
+        {
+            return (left, index, length, compareOperator, right, booleanOperator, vector, vectorIndex) =>
+            {
+                if (length >= ParallelWhereRows)
+                {
+                    parallelWhere(left, index, length, compareOperator, right, booleanOperator, vector, vectorIndex);
+                }
+                else
+                {
+                    where(left, index, length, compareOperator, right, booleanOperator, vector, vectorIndex);
+                }
+            };
+        }
+
+        /// <summary>
+        ///  Read the native kernel counters, summed across threads since the process started or the last ResetKernelCounters.
+        ///  Returns no counters unless the accelerator is enabled; kernels only count calls while EnableKernelCounters is on.
+        /// </summary>
+        /// <returns>NativeKernelCounter for each kernel which counts calls</returns>
+        public static List<NativeKernelCounter> ReadKernelCounters()
+        {
+            List<NativeKernelCounter> result = new List<NativeKernelCounter>();
+            if (s_readKernelCounters == null) return result;
+
+            // Read returns calls, elements, bytes, and cycles for each kernel in Names order
+            string[] names = s_kernelNames();
+            long[] counters = new long[4 * names.Length];
+            s_readKernelCounters(counters);
+
+            for (int i = 0; i < names.Length; ++i)
+            {
+                result.Add(new NativeKernelCounter()
+                {
+                    Kernel = names[i],
+                    Calls = counters[4 * i],
+                    Elements = counters[4 * i + 1],
+                    Bytes = counters[4 * i + 2],
+                    Cycles = counters[4 * i + 3]
+                });
+            }
+
+            return result;
+        }
+
+        /// <summary>
+        ///  Zero the native kernel counters for every thread.
+        /// </summary>
+        public static void ResetKernelCounters()
+        {
+            s_resetKernelCounters?.Invoke();
+        }
+
+        /// <summary>
+        ///  Whether native kernels are counting their calls.
+        /// </summary>
+        public static bool KernelCountersEnabled => (s_kernelCountersEnabled != null && s_kernelCountersEnabled());
+
+        /// <summary>
+        ///  Start or stop counting native kernel calls. Counting is off by default, so kernels don't pay for it unless asked.
+        ///  Does nothing unless the accelerator is enabled.
+        /// </summary>
+        /// <param name="enabled">True to count kernel calls, False to stop</param>
+        public static void EnableKernelCounters(bool enabled)
+        {
+            s_enableKernelCounters?.Invoke(enabled);
+        }
     }
 }
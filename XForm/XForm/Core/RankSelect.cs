@@ -0,0 +1,227 @@
+﻿// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+using System;
+
+namespace XForm
+{
+    /// <summary>
+    ///  RankSelect is a rank/select index over a BitVector, so callers can jump to the k'th matching row
+    ///  or count the matches before a row without paging through the vector from the start.
+    /// </summary>
+    /// <remarks>
+    ///  The vector is split into superblocks of SuperblockWords ulongs (512 rows). For each superblock, the index stores
+    ///  the count of set bits before it and the packed 9-bit count of set bits before each of its other seven words.
+    ///  Every SelectSampleRate'th set bit records its superblock, so Select only searches the superblocks between two samples.
+    ///
+    ///  The index must be rebuilt (Build) after the BitVector changes.
+    /// </remarks>
+    public class RankSelect
+    {
+        public const int SuperblockWords = 8;
+        public const int SelectSampleRate = 512;
+
+        internal static BuildSignature s_nativeBuild;
+        internal delegate int BuildSignature(ulong[] vector, ulong[] ranks, int[] samples);
+
+        internal static SelectSignature s_nativeSelect;
+        internal delegate void SelectSignature(ulong[] vector, ulong[] ranks, int[] samples, int count, int[] ordinals, int index, int length, int[] indices);
+
+        private BitVector _vector;
+        private ulong[] _ranks;
+        private int[] _samples;
+
+        public RankSelect(BitVector vector)
+        {
+            Build(vector);
+        }
+
+        /// <summary>
+        ///  Count of set bits in the vector when the index was built.
+        /// </summary>
+        public int Count { get; private set; }
+
+        /// <summary>
+        ///  Build (or rebuild) the index over a BitVector, reusing the index arrays when they're large enough.
+        /// </summary>
+        /// <param name="vector">BitVector to index</param>
+        public void Build(BitVector vector)
+        {
+            _vector = vector;
+            ulong[] array = vector.Array;
+
+            int superblockCount = (array.Length + SuperblockWords - 1) / SuperblockWords;
+            Allocator.AllocateToSize(ref _ranks, 2 * superblockCount);
+            Allocator.AllocateToSize(ref _samples, superblockCount);
+
+            if (s_nativeBuild != null)
+            {
+                Count = s_nativeBuild(array, _ranks, _samples);
+                return;
+            }
+
+            long count = 0;
+            int sampleCount = 0;
+
+            for (int s = 0; s < superblockCount; ++s)
+            {
+                int start = s * SuperblockWords;
+                int end = Math.Min(start + SuperblockWords, array.Length);
+
+                ulong blockRanks = 0;
+                ulong inSuperblock = 0;
+                for (int i = start; i < SuperblockWords + start; ++i)
+                {
+                    // Words past the end of the vector have no set bits, so they rank as the superblock total
+                    if (i > start) blockRanks |= inSuperblock << (9 * (i - start - 1));
+                    if (i < end) inSuperblock += (ulong)PopCount(array[i]);
+                }
+
+                _ranks[2 * s] = (ulong)count;
+                _ranks[2 * s + 1] = blockRanks;
+
+                count += (long)inSuperblock;
+                while ((long)sampleCount * SelectSampleRate < count)
+                {
+                    _samples[sampleCount++] = s;
+                }
+            }
+
+            Count = (int)count;
+        }
+
+        /// <summary>
+        ///  Return the number of set bits before index.
+        /// </summary>
+        /// <param name="index">Index to count set bits before, in [0, Capacity]</param>
+        /// <returns>Count of set bits in [0, index)</returns>
+        public int Rank(int index)
+        {
+            if (index < 0) throw new ArgumentOutOfRangeException("index");
+
+            ulong[] array = _vector.Array;
+            int word = index >> 6;
+            if (word >= array.Length) return Count;
+
+            int superblock = word / SuperblockWords;
+            int block = word - superblock * SuperblockWords;
+
+            long rank = (long)_ranks[2 * superblock];
+            if (block > 0) rank += (long)((_ranks[2 * superblock + 1] >> (9 * (block - 1))) & 0x1FF);
+            if ((index & 63) != 0) rank += PopCount(array[word] & (ulong.MaxValue >> (64 - (index & 63))));
+
+            return (int)rank;
+        }
+
+        /// <summary>
+        ///  Return the index of the set bit numbered 'ordinal' (from zero), or -1 if there are ordinal or fewer set bits.
+        ///  Page from the result to read the matches from the ordinal'th on.
+        /// </summary>
+        /// <param name="ordinal">Number of the set bit to find</param>
+        /// <returns>Index of the set bit, or -1 if there is no set bit with that number</returns>
+        public int Select(int ordinal)
+        {
+            if (ordinal < 0 || ordinal >= Count) return -1;
+
+            ulong[] array = _vector.Array;
+            int superblockCount = (array.Length + SuperblockWords - 1) / SuperblockWords;
+            int sampleCount = (int)(((long)Count + SelectSampleRate - 1) / SelectSampleRate);
+
+            // Find the last superblock starting at or before the ordinal between the samples around it
+            int sample = ordinal / SelectSampleRate;
+            int low = _samples[sample];
+            int high = (sample + 1 < sampleCount ? _samples[sample + 1] : superblockCount - 1);
+            while (low < high)
+            {
+                int middle = low + ((high - low + 1) >> 1);
+                if (_ranks[2 * middle] <= (ulong)ordinal)
+                {
+                    low = middle;
+                }
+                else
+                {
+                    high = middle - 1;
+                }
+            }
+
+            // Find the word within the superblock
+            int remaining = ordinal - (int)_ranks[2 * low];
+            ulong blockRanks = _ranks[2 * low + 1];
+            int block = 0;
+            while (block < SuperblockWords - 1 && (int)((blockRanks >> (9 * block)) & 0x1FF) <= remaining)
+            {
+                block++;
+            }
+
+            if (block > 0) remaining -= (int)((blockRanks >> (9 * (block - 1))) & 0x1FF);
+
+            // Find the bit within the word
+            int word = low * SuperblockWords + block;
+            ulong bits = array[word];
+            for (int bit = 0; bit < 64; ++bit)
+            {
+                if ((bits & (0x1UL << bit)) != 0)
+                {
+                    if (remaining == 0) return (word << 6) + bit;
+                    remaining--;
+                }
+            }
+
+            return -1;
+        }
+
+        /// <summary>
+        ///  Find the index of the set bit numbered ordinals[index + i] for each i in [0, length), as Select.
+        /// </summary>
+        /// <param name="ordinals">Array of set bit numbers to find</param>
+        /// <param name="index">Index of the first ordinal to find</param>
+        /// <param name="length">Number of ordinals to find</param>
+        /// <param name="indices">Array to write the set bit indices to, from zero</param>
+        public void Select(int[] ordinals, int index, int length, int[] indices)
+        {
+            if (index < 0 || length < 0 || index + length > ordinals.Length) throw new ArgumentOutOfRangeException("ordinals");
+            if (length > indices.Length) throw new ArgumentOutOfRangeException("indices");
+
+            if (s_nativeSelect != null)
+            {
+                s_nativeSelect(_vector.Array, _ranks, _samples, Count, ordinals, index, length, indices);
+                return;
+            }
+
+            for (int i = 0; i < length; ++i)
+            {
+                indices[i] = Select(ordinals[index + i]);
+            }
+        }
+
+        /// <summary>
+        ///  Page the indices of the set bits from the one numbered 'fromOrdinal', as BitVector.Page would from its index.
+        /// </summary>
+        /// <param name="indicesFound">Array to write matching indices to</param>
+        /// <param name="fromOrdinal">Number of the first set bit to return; set to the number of the next one, or -1 if no more</param>
+        /// <param name="countLimit">Maximum number of indices to return, or -1 to fill indicesFound</param>
+        /// <returns>Count of indices written to indicesFound</returns>
+        public int Page(int[] indicesFound, ref int fromOrdinal, int countLimit = -1)
+        {
+            int fromIndex = Select(fromOrdinal);
+            if (fromIndex == -1)
+            {
+                fromOrdinal = -1;
+                return 0;
+            }
+
+            int countFound = _vector.Page(indicesFound, ref fromIndex, countLimit);
+            fromOrdinal = (fromIndex == -1 ? -1 : fromOrdinal + countFound);
+            return countFound;
+        }
+
+        private static int PopCount(ulong x)
+        {
+            // Count using the hamming weight algorithm [http://en.wikipedia.org/wiki/Hamming_weight]
+            x -= (x >> 1) & 0x5555555555555555UL;
+            x = (x & 0x3333333333333333UL) + ((x >> 2) & 0x3333333333333333UL);
+            x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fUL;
+            return (int)((x * 0x0101010101010101UL) >> 56);
+        }
+    }
+}
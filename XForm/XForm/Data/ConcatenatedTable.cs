@@ -6,6 +6,7 @@ using System.Collections.Generic;
 using System.Linq;
 using System.Threading;
 
+using XForm.Columns;
 using XForm.Data;
 using XForm.Extensions;
 
@@ -184,6 +185,12 @@ namespace XForm.IO
         private List<IXColumn> _sources;
         private Func<XArray> _currentGetter;
 
+        private bool _isZoneMapSubscribed;
+        private Func<object> _zoneMapGetter;
+
+        private bool _isMappedSubscribed;
+        private Func<object> _mappedGetter;
+
         private Array _nullArray = null;
 
         public ColumnDetails ColumnDetails { get; private set; }
@@ -208,10 +215,14 @@ namespace XForm.IO
             {
                 IXColumn source = _sources[index];
                 if (_isSubscribed) { _currentGetter = source?.CurrentGetter() ?? null; }
+                if (_isZoneMapSubscribed) { _zoneMapGetter = source?.ComponentGetter(ColumnComponent.ZoneMap); }
+                if (_isMappedSubscribed) { _mappedGetter = source?.ComponentGetter(ColumnComponent.Mapped); }
             }
             else
             {
                 _currentGetter = null;
+                _zoneMapGetter = null;
+                _mappedGetter = null;
             }
         }
 
@@ -250,6 +261,20 @@ namespace XForm.IO
 
         public Func<object> ComponentGetter(string componentName)
         {
+            // Pass through the zone map of the current source; sources without one return null for their rows
+            if (componentName.Equals(ColumnComponent.ZoneMap))
+            {
+                _isZoneMapSubscribed = true;
+                return () => _zoneMapGetter?.Invoke();
+            }
+
+            // Pass through the mapped view of the current source the same way
+            if (componentName.Equals(ColumnComponent.Mapped))
+            {
+                _isMappedSubscribed = true;
+                return () => _mappedGetter?.Invoke();
+            }
+
             return null;
         }
     }
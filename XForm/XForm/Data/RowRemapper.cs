@@ -4,7 +4,10 @@
 using System;
 using System.Collections.Generic;
 
+using Microsoft.CodeAnalysis.Elfie.Model.Strings;
+
 using XForm.Data;
+using XForm.Types;
 
 namespace XForm.Transforms
 {
@@ -16,11 +19,24 @@ namespace XForm.Transforms
     /// </summary>
     public class RowRemapper
     {
+        internal static CompactSignature s_nativeCompact;
+        internal delegate int CompactSignature(ulong[] vector, Array values, int index, int length, ref int fromIndex, int countLimit, Array result);
+
+        internal static CompactString8Signature s_nativeCompactString8;
+        internal delegate int CompactString8Signature(ulong[] vector, int[] positions, int index, int length, bool hasPrevious, ref int fromIndex, int countLimit, int[] starts, int[] ends);
+
+        // Types the native Compact can copy directly from the vector
+        private static HashSet<Type> s_compactTypes = new HashSet<Type>() { typeof(bool), typeof(byte), typeof(sbyte), typeof(ushort), typeof(short), typeof(uint), typeof(int), typeof(ulong), typeof(long), typeof(float), typeof(double) };
+
         private BitVector _vector;
         private int[] _indices;
         private int _count;
 
         private bool _indicesFound;
+        private int _pageStartVectorIndex;
+
+        // Set once the vector index after the current page is known, by paging indices or compacting values
+        private bool _pageEndFound;
         private int _nextVectorIndex;
 
         private Dictionary<ArraySelector, ArraySelector> _cachedRemappings;
@@ -30,14 +46,16 @@ namespace XForm.Transforms
             _cachedRemappings = new Dictionary<ArraySelector, ArraySelector>();
         }
 
-        public void SetMatches(BitVector vector, int count = -1)
+        public void SetMatches(BitVector vector, int count = -1, int fromVectorIndex = 0)
         {
             _vector = vector;
             _count = (count == -1 ? vector.Count : count);
 
-            // Set that we need indices again starting from the vector start
+            // Set that we need indices again starting from the requested vector index
             _indicesFound = false;
-            _nextVectorIndex = 0;
+            _pageEndFound = false;
+            _pageStartVectorIndex = fromVectorIndex;
+            _nextVectorIndex = fromVectorIndex;
 
             // Clear cached remappings (they will need to be recomputed)
             _cachedRemappings.Clear();
@@ -46,15 +64,12 @@ namespace XForm.Transforms
         public bool NextMatchPage(int countLimit)
         {
             // If we didn't page the previous set, skip past them
-            if (!_indicesFound)
-            {
-                Allocator.AllocateToSize(ref _indices, _count);
-                int countFound = _vector.Page(_indices, ref _nextVectorIndex, _count);
-                if (countFound != _count) throw new InvalidOperationException($"RowRemapper found {countFound:n0} rows when {_count:n0} expected paging in Vector with {_vector.Count:n0} total matches up to index {_nextVectorIndex:n0}.");
-            }
+            if (!_pageEndFound) FindIndices();
 
             // Set that we need indices again and the next expected count
             _indicesFound = false;
+            _pageEndFound = false;
+            _pageStartVectorIndex = _nextVectorIndex;
             _count = countLimit;
 
             // Clear cached remappings (they will need to be recomputed)
@@ -69,6 +84,7 @@ namespace XForm.Transforms
             _indices = indices;
             _count = count;
             _indicesFound = true;
+            _pageEndFound = true;
 
             // Clear cached remappings (they will need to be recomputed)
             _cachedRemappings.Clear();
@@ -76,6 +92,94 @@ namespace XForm.Transforms
 
         public int Count => _count;
 
+        private void FindIndices()
+        {
+            if (_indicesFound) return;
+            _indicesFound = true;
+
+            Allocator.AllocateToSize(ref _indices, _count);
+            _nextVectorIndex = _pageStartVectorIndex;
+            int countFound = _vector.Page(_indices, ref _nextVectorIndex, _count);
+            if (countFound != _count) throw new InvalidOperationException($"RowRemapper found {countFound:n0} rows when {_count:n0} expected paging in Vector with {_vector.Count:n0} total matches up to index {_nextVectorIndex:n0}.");
+            _pageEndFound = true;
+        }
+
+        /// <summary>
+        ///  Remap a source XArray to the matching rows, copying the matching values into compactArray instead
+        ///  of building indices when the values are contiguous and the native Compact is available.
+        /// </summary>
+        /// <param name="source">XArray of source rows, one per vector bit</param>
+        /// <param name="remapArray">Array to reuse for remapped indices</param>
+        /// <param name="compactArray">Array to reuse for compacted values</param>
+        /// <returns>XArray of the matching rows</returns>
+        public XArray Remap(XArray source, ref int[] remapArray, ref Array compactArray)
+        {
+            if (s_nativeCompact != null && _vector != null && !_indicesFound && source.Selector.Indices == null && !source.Selector.IsSingleValue && !source.HasNulls && s_compactTypes.Contains(source.Array.GetType().GetElementType()))
+            {
+                Allocator.AllocateToSize(ref compactArray, _count, source.Array.GetType().GetElementType());
+
+                int nextVectorIndex = _pageStartVectorIndex;
+                int countFound = s_nativeCompact(_vector.Array, source.Array, source.Selector.StartIndexInclusive, source.Count, ref nextVectorIndex, _count, compactArray);
+                if (countFound != _count) throw new InvalidOperationException($"RowRemapper found {countFound:n0} rows when {_count:n0} expected compacting Vector with {_vector.Count:n0} total matches up to index {nextVectorIndex:n0}.");
+
+                _nextVectorIndex = nextVectorIndex;
+                _pageEndFound = true;
+
+                return XArray.All(compactArray, _count);
+            }
+
+            return Remap(source, ref remapArray);
+        }
+
+        /// <summary>
+        ///  Remap a String8 column to the matching rows, compacting the start and end positions of the matching strings
+        ///  from its String8Raw instead of building indices when the native CompactString8 is available. The strings
+        ///  returned share the source text byte[].
+        /// </summary>
+        /// <param name="sourceGetter">Getter for the source String8 XArray, one row per vector bit</param>
+        /// <param name="rawGetter">Getter for the String8Raw of the same rows</param>
+        /// <param name="remapArray">Array to reuse for remapped indices</param>
+        /// <param name="compactArray">Array to reuse for compacted strings</param>
+        /// <param name="startsArray">Array to reuse for the compacted string start positions</param>
+        /// <param name="endsArray">Array to reuse for the compacted string end positions</param>
+        /// <returns>XArray of the matching rows</returns>
+        public XArray Remap(Func<XArray> sourceGetter, Func<object> rawGetter, ref int[] remapArray, ref String8[] compactArray, ref int[] startsArray, ref int[] endsArray)
+        {
+            if (s_nativeCompactString8 != null && _vector != null && !_indicesFound)
+            {
+                String8Raw raw = (String8Raw)rawGetter();
+                if (raw.Selector.Indices == null)
+                {
+                    Allocator.AllocateToSize(ref compactArray, _count);
+                    Allocator.AllocateToSize(ref startsArray, _count);
+                    Allocator.AllocateToSize(ref endsArray, _count);
+
+                    // Find the row ends and text offset as String8ColumnReader.Read does; the first string in the column starts at zero
+                    byte[] textArray = (byte[])raw.Bytes.Array;
+                    int[] positionArray = (int[])raw.Positions.Array;
+                    bool includesFirstString = (raw.Selector.StartIndexInclusive == 0);
+                    int positionOffset = raw.Positions.Index((includesFirstString ? 0 : 1));
+                    int textOffset = (includesFirstString ? 0 : positionArray[raw.Positions.Index(0)]) - raw.Bytes.Index(0);
+
+                    int nextVectorIndex = _pageStartVectorIndex;
+                    int countFound = s_nativeCompactString8(_vector.Array, positionArray, positionOffset, raw.Selector.Count, !includesFirstString, ref nextVectorIndex, _count, startsArray, endsArray);
+                    if (countFound != _count) throw new InvalidOperationException($"RowRemapper found {countFound:n0} rows when {_count:n0} expected compacting Vector with {_vector.Count:n0} total matches up to index {nextVectorIndex:n0}.");
+
+                    for (int i = 0; i < _count; ++i)
+                    {
+                        compactArray[i] = new String8(textArray, startsArray[i] - textOffset, endsArray[i] - startsArray[i]);
+                    }
+
+                    _nextVectorIndex = nextVectorIndex;
+                    _pageEndFound = true;
+
+                    return XArray.All(compactArray, _count);
+                }
+            }
+
+            return Remap(sourceGetter(), ref remapArray);
+        }
+
         public XArray Remap(XArray source, ref int[] remapArray)
         {
             // See if we have the remapping cached already
@@ -86,13 +190,7 @@ namespace XForm.Transforms
             }
 
             // Convert the BitVector to indices if we haven't yet (deferred to first column wanting values)
-            if (!_indicesFound)
-            {
-                _indicesFound = true;
-                Allocator.AllocateToSize(ref _indices, _count);
-                int countFound = _vector.Page(_indices, ref _nextVectorIndex, _count);
-                if (countFound != _count) throw new InvalidOperationException($"RowRemapper found {countFound:n0} rows when {_count:n0} expected paging in Vector with {_vector.Count:n0} total matches up to index {_nextVectorIndex:n0}.");
-            }
+            FindIndices();
 
             // Remap the outer selector
             XArray remapped = source.Select(ArraySelector.Map(_indices, _count), ref remapArray);
@@ -36,6 +36,7 @@ namespace XForm
             _server.AddResponder("count", CountWithinTimeout);
             _server.AddResponder("save", Save);
             _server.AddResponder("test", Test);
+            _server.AddResponder("counters", Counters);
         }
 
         public void Run()
@@ -59,6 +60,42 @@ namespace XForm
             response.Close();
         }
 
+        private void Counters(IHttpRequest request, IHttpResponse response)
+        {
+            using (ITabularWriter writer = WriterForFormat("json", response))
+            {
+                try
+                {
+                    String8Block block = new String8Block();
+
+                    // Start or stop counting kernel calls if requested (counting is off until enabled)
+                    string enable = request.QueryString["enable"];
+                    if (enable != null) NativeAccelerator.EnableKernelCounters(enable == "true");
+
+                    // Return the native kernel counters which have counted calls, and reset them if requested
+                    writer.SetColumns(new string[] { "Kernel", "Calls", "Elements", "Bytes", "Cycles", "BytesPerCycle" });
+                    foreach (NativeKernelCounter counter in NativeAccelerator.ReadKernelCounters())
+                    {
+                        if (counter.Calls == 0) continue;
+
+                        writer.Write(block.GetCopy(counter.Kernel));
+                        writer.Write(counter.Calls);
+                        writer.Write(counter.Elements);
+                        writer.Write(counter.Bytes);
+                        writer.Write(counter.Cycles);
+                        writer.Write(block.GetCopy(counter.BytesPerCycle.ToString("0.000")));
+                        writer.NextRow();
+                    }
+
+                    if (request.QueryString["reset"] == "true") NativeAccelerator.ResetKernelCounters();
+                }
+                catch (Exception ex)
+                {
+                    ReportError(request, response, ex);
+                }
+            }
+        }
+
         public void HandleRequest(IHttpRequest request, IHttpResponse response)
         {
             _server.HandleRequest(request, response);
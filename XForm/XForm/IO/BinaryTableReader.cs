@@ -29,6 +29,9 @@ namespace XForm.IO
         private Type _indicesType;
         private bool _loadedIndicesType;
 
+        private ZoneMap _zoneMap;
+        private bool _loadedZoneMap;
+
         public ColumnDetails ColumnDetails { get; private set; }
 
         public BinaryReaderColumn(BinaryTableReader table, ColumnDetails details, IStreamProvider streamProvider)
@@ -70,6 +73,33 @@ namespace XForm.IO
                 return () => reader.ReadRaw(_table.CurrentSelector);
             }
 
+            if (componentName.Equals(ColumnComponent.ZoneMap))
+            {
+                // Enum columns store distinct values, not rows, and compare on their indices
+                if (IndicesType != null) return null;
+
+                if (!_loadedZoneMap)
+                {
+                    _zoneMap = ZoneMap.TryRead(_streamProvider, ColumnDetails.Type, Path.Combine(_table.TablePath, ColumnDetails.Name));
+                    _loadedZoneMap = true;
+                }
+
+                if (_zoneMap == null) return null;
+                return () => new ZoneMapPage(_zoneMap, _table.CurrentSelector.StartIndexInclusive);
+            }
+
+            if (componentName.Equals(ColumnComponent.Mapped))
+            {
+                // Enum columns store distinct values, not rows; columns with nulls are read through a NullableReader
+                if (IndicesType != null) return null;
+
+                GetReader();
+                IMappedColumnReader reader = _columnReader as IMappedColumnReader;
+                if (reader == null) return null;
+
+                return () => new MappedColumnPage(reader, _table.CurrentSelector);
+            }
+
             return null;
         }
 
@@ -298,7 +298,8 @@ namespace XForm.IO
         public void Dispose()
         {
             // If we're still an enum column, write the distinct values out
-            if (_dictionary != null)
+            bool wasEnum = (_dictionary != null);
+            if (wasEnum)
             {
                 _valueWriter.Append(_dictionary.Values());
                 _dictionary = null;
@@ -306,8 +307,12 @@ namespace XForm.IO
 
             if (_valueWriter != null)
             {
+                Type valueType = _valueWriter.WritingAsType;
                 _valueWriter.Dispose();
                 _valueWriter = null;
+
+                // A zone map of the distinct values doesn't describe the rows; enum columns compare indices instead
+                if (wasEnum) ZoneMap.Delete(_streamProvider, _columnPath, valueType);
             }
 
             if (_rowIndexWriter != null)
@@ -166,8 +166,12 @@ namespace XForm.IO
     /// </summary>
     public class VariableIntegerReader : IColumnReader
     {
+        internal static ComparerExtensions.Widen<byte> s_WidenByteNative = null;
+        internal static ComparerExtensions.Widen<ushort> s_WidenUshortNative = null;
+
         private IColumnReader _reader;
         private Func<XArray, XArray> _converter;
+        private int[] _widenedArray;
 
         public VariableIntegerReader(IStreamProvider streamProvider, string columnPathPrefix, CachingOption option)
         {
@@ -199,9 +203,29 @@ namespace XForm.IO
         public XArray Read(ArraySelector selector)
         {
             XArray raw = _reader.Read(selector);
-            XArray asInteger = (_converter == null ? raw : _converter(raw));
+            if (_converter == null) return raw;
+
+            // Widen contiguous byte and ushort values natively, if available
+            if (raw.Selector.Indices == null && !raw.Selector.IsSingleValue && !raw.HasNulls)
+            {
+                byte[] bytes = raw.Array as byte[];
+                ushort[] ushorts = raw.Array as ushort[];
+
+                if (bytes != null && s_WidenByteNative != null)
+                {
+                    Allocator.AllocateToSize(ref _widenedArray, raw.Count);
+                    s_WidenByteNative(bytes, raw.Selector.StartIndexInclusive, raw.Count, _widenedArray);
+                    return XArray.All(_widenedArray, raw.Count);
+                }
+                else if (ushorts != null && s_WidenUshortNative != null)
+                {
+                    Allocator.AllocateToSize(ref _widenedArray, raw.Count);
+                    s_WidenUshortNative(ushorts, raw.Selector.StartIndexInclusive, raw.Count, _widenedArray);
+                    return XArray.All(_widenedArray, raw.Count);
+                }
+            }
 
-            return asInteger;
+            return _converter(raw);
         }
 
         public void Dispose()
@@ -0,0 +1,176 @@
+﻿// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Runtime.InteropServices;
+
+using XForm.Data;
+using XForm.Extensions;
+using XForm.IO.StreamProvider;
+using XForm.Types;
+
+namespace XForm.IO
+{
+    /// <summary>
+    ///  ZoneMap holds the minimum and maximum value of each block of BlockRowCount rows in a column, interleaved
+    ///  as [min0, max0, min1, max1, ...] in an array of the column type. Where can skip comparing the rows in blocks
+    ///  where the bounds show every row or no row matches.
+    /// </summary>
+    public class ZoneMap
+    {
+        public const int BlockRowCount = 4096;
+
+        // Types written by PrimitiveTypeProvider which native Where can compare.
+        // Byte columns usually stay enums and drop their zone map, but those with over 256 distinct values (with null) keep it.
+        private static HashSet<Type> s_supportedTypes = new HashSet<Type>() { typeof(byte), typeof(sbyte), typeof(ushort), typeof(short), typeof(uint), typeof(int), typeof(ulong), typeof(long), typeof(float), typeof(double) };
+
+        public Type Type { get; private set; }
+        public Array MinMax { get; private set; }
+        public int ZoneCount => MinMax.Length / 2;
+
+        private ZoneMap(Type type, Array minMax)
+        {
+            Type = type;
+            MinMax = minMax;
+        }
+
+        public static bool IsSupported(Type type)
+        {
+            return s_supportedTypes.Contains(type);
+        }
+
+        public static string FilePath(string columnPath, Type type)
+        {
+            return Path.Combine(columnPath, $"VZ.{PrimitiveTypeProvider<byte>.BinaryFileTypePart(type)}.bin");
+        }
+
+        /// <summary>
+        ///  Read the zone map for a column, if one was written.
+        /// </summary>
+        /// <param name="streamProvider">IStreamProvider to read from</param>
+        /// <param name="type">Column value type</param>
+        /// <param name="columnPath">Column folder path</param>
+        /// <returns>ZoneMap for the column, or null if it didn't have one</returns>
+        public static ZoneMap TryRead(IStreamProvider streamProvider, Type type, string columnPath)
+        {
+            if (!IsSupported(type)) return null;
+
+            string filePath = FilePath(columnPath, type);
+            if (!streamProvider.UncachedExists(filePath)) return null;
+
+            using (Stream stream = streamProvider.OpenRead(filePath))
+            using (MemoryStream bytes = new MemoryStream())
+            {
+                stream.CopyTo(bytes);
+
+                int bytesPerItem = Marshal.SizeOf(type);
+                Array minMax = Array.CreateInstance(type, (int)(bytes.Length / bytesPerItem));
+                Buffer.BlockCopy(bytes.GetBuffer(), 0, minMax, 0, minMax.Length * bytesPerItem);
+                return new ZoneMap(type, minMax);
+            }
+        }
+
+        public static void Delete(IStreamProvider streamProvider, string columnPath, Type type)
+        {
+            if (!IsSupported(type)) return;
+            streamProvider.Delete(FilePath(columnPath, type));
+        }
+    }
+
+    /// <summary>
+    ///  ZoneMapPage is the ColumnComponent.ZoneMap for the current rows: the zone map and the file row the first current row is.
+    /// </summary>
+    public struct ZoneMapPage
+    {
+        public ZoneMap ZoneMap;
+        public int FirstRow;
+
+        public ZoneMapPage(ZoneMap zoneMap, int firstRow)
+        {
+            ZoneMap = zoneMap;
+            FirstRow = firstRow;
+        }
+    }
+
+    /// <summary>
+    ///  ZoneMapWriter wraps the value writer for a primitive column and writes the column ZoneMap when disposed.
+    /// </summary>
+    /// <typeparam name="T">Column value type</typeparam>
+    public class ZoneMapWriter<T> : IColumnWriter where T : IComparable<T>
+    {
+        private IStreamProvider _streamProvider;
+        private string _columnPath;
+        private IColumnWriter _writer;
+
+        private T[] _minMax;
+        private int _zoneCount;
+        private int _rowCountInZone;
+
+        public ZoneMapWriter(IStreamProvider streamProvider, string columnPath, IColumnWriter writer)
+        {
+            _streamProvider = streamProvider;
+            _columnPath = columnPath;
+            _writer = writer;
+        }
+
+        public Type WritingAsType => _writer.WritingAsType;
+
+        public bool CanAppend(XArray xarray)
+        {
+            return _writer.CanAppend(xarray);
+        }
+
+        public void Append(XArray xarray)
+        {
+            T[] array = (T[])xarray.Array;
+
+            for (int i = 0; i < xarray.Count; ++i)
+            {
+                T value = array[xarray.Index(i)];
+
+                if (_rowCountInZone == 0)
+                {
+                    if (_minMax == null || _minMax.Length < 2 * (_zoneCount + 1)) Allocator.ExpandToSize(ref _minMax, 2 * Math.Max(64, 2 * _zoneCount));
+                    _minMax[2 * _zoneCount] = value;
+                    _minMax[2 * _zoneCount + 1] = value;
+                }
+                else
+                {
+                    // CompareTo orders NaN before every value, so zones with NaN get a NaN minimum and never decide rows
+                    if (value.CompareTo(_minMax[2 * _zoneCount]) < 0) _minMax[2 * _zoneCount] = value;
+                    if (value.CompareTo(_minMax[2 * _zoneCount + 1]) > 0) _minMax[2 * _zoneCount + 1] = value;
+                }
+
+                _rowCountInZone++;
+                if (_rowCountInZone == ZoneMap.BlockRowCount)
+                {
+                    _zoneCount++;
+                    _rowCountInZone = 0;
+                }
+            }
+
+            _writer.Append(xarray);
+        }
+
+        public void Dispose()
+        {
+            if (_writer != null)
+            {
+                _writer.Dispose();
+                _writer = null;
+
+                // Write the zone map, including the last partial zone
+                int zoneCount = _zoneCount + (_rowCountInZone > 0 ? 1 : 0);
+                if (zoneCount > 0)
+                {
+                    using (PrimitiveArrayWriter<T> zoneWriter = new PrimitiveArrayWriter<T>(_streamProvider.OpenWrite(ZoneMap.FilePath(_columnPath, typeof(T)))))
+                    {
+                        zoneWriter.Append(XArray.All(_minMax, 2 * zoneCount));
+                    }
+                }
+            }
+        }
+    }
+}
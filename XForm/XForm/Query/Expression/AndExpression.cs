@@ -1,17 +1,29 @@
 ﻿// Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+using System;
 using System.Text;
 
 using XForm.Data;
+using XForm.Types;
 
 namespace XForm.Query.Expression
 {
     internal class AndExpression : IExpression
     {
+        // WARNING: Must match XForm.Native.Comparer::WhereAndTermLimit
+        private const int NativeTermLimit = 16;
+        internal static ComparerExtensions.WhereAnd s_WhereAndNative = null;
+
         private IExpression[] _terms;
         private BitVector _termVector;
 
+        private bool[] _isNativeTerm;
+        private Array[] _nativeColumns;
+        private int[] _nativeIndices;
+        private byte[] _nativeOperators;
+        private object[] _nativeValues;
+
         public AndExpression(IExpression[] terms)
         {
             _terms = terms;
@@ -22,14 +34,58 @@ namespace XForm.Query.Expression
             Allocator.AllocateToSize(ref _termVector, vector.Capacity);
             vector.All(vector.Capacity);
 
-            foreach (IExpression term in _terms)
+            // Evaluate the simple column to constant terms in one native pass, if available
+            bool anyNative = (s_WhereAndNative != null && EvaluateNative(vector));
+
+            for (int i = 0; i < _terms.Length; ++i)
             {
+                if (anyNative && _isNativeTerm[i]) continue;
+
                 _termVector.None();
-                term.Evaluate(_termVector);
+                _terms[i].Evaluate(_termVector);
                 vector.And(_termVector);
             }
         }
 
+        private bool EvaluateNative(BitVector vector)
+        {
+            if (_isNativeTerm == null)
+            {
+                _isNativeTerm = new bool[_terms.Length];
+                _nativeColumns = new Array[NativeTermLimit];
+                _nativeIndices = new int[NativeTermLimit];
+                _nativeOperators = new byte[NativeTermLimit];
+                _nativeValues = new object[NativeTermLimit];
+            }
+
+            // Find the terms which compare a whole column to a constant
+            int termCount = 0;
+            for (int i = 0; i < _terms.Length; ++i)
+            {
+                _isNativeTerm[i] = false;
+                if (termCount == NativeTermLimit) continue;
+
+                TermExpression term = _terms[i] as TermExpression;
+                XArray left;
+                object right;
+                CompareOperator cOp;
+                if (term == null || !term.TryGetNativeTerm(out left, out right, out cOp) || left.Count != vector.Capacity) continue;
+
+                _nativeColumns[termCount] = left.Array;
+                _nativeIndices[termCount] = left.Selector.StartIndexInclusive;
+                _nativeOperators[termCount] = (byte)cOp;
+                _nativeValues[termCount] = right;
+                _isNativeTerm[i] = true;
+                termCount++;
+            }
+
+            // A single term gains nothing over the normal comparer
+            if (termCount < 2) return false;
+
+            s_WhereAndNative(_nativeColumns, _nativeIndices, _nativeOperators, _nativeValues, termCount, vector.Capacity, (byte)BooleanOperator.And, vector.Array, 0);
+            return true;
+        }
+
         public override string ToString()
         {
             StringBuilder result = new StringBuilder();
@@ -1,32 +1,167 @@
 ﻿// Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+using System;
+using System.Collections.Generic;
 using System.Text;
 
+using Microsoft.CodeAnalysis.Elfie.Model.Strings;
+
 using XForm.Data;
+using XForm.Types;
+using XForm.Types.Comparers;
 
 namespace XForm.Query.Expression
 {
     internal class OrExpression : IExpression
     {
+        // WARNING: Must match XForm.Native.Plan::InstructionLength, InstructionLimit, and Where
+        private const int NativeInstructionLength = 6;
+        private const int NativeTermLimit = 64;
+        private const byte NativeWhereOpcode = 2;
+        internal static ComparerExtensions.ExecutePlan s_ExecutePlanNative = null;
+
         private IExpression[] _terms;
         private BitVector _termVector;
 
+        // Column to constant terms, which are ORed into the vector by one native plan
+        private bool[] _isNativeTerm;
+        private byte[] _nativeProgram;
+        private Array[] _nativeColumns;
+        private int[] _nativeIndices;
+        private object[] _nativeValues;
+        private ulong[][] _nativeVectors;
+        private int[] _nativeResults;
+
+        // Contains terms on the same String8 column, which are searched for in one pass
+        private bool[] _isContainsTerm;
+        private Func<object> _containsRawGetter;
+        private String8[] _containsValues;
+        private String8Comparer _containsComparer;
+
         public OrExpression(IExpression[] terms)
         {
             _terms = terms;
+            FindContainsTerms();
+        }
+
+        private void FindContainsTerms()
+        {
+            // Group the raw Contains terms by column
+            Dictionary<IXColumn, List<int>> termsByColumn = new Dictionary<IXColumn, List<int>>();
+            IXColumn column;
+            Func<object> rawGetter;
+            String8 value;
+
+            for (int i = 0; i < _terms.Length; ++i)
+            {
+                TermExpression term = _terms[i] as TermExpression;
+                if (term == null || !term.TryGetContainsTerm(out column, out rawGetter, out value)) continue;
+
+                List<int> indices;
+                if (!termsByColumn.TryGetValue(column, out indices))
+                {
+                    indices = new List<int>();
+                    termsByColumn[column] = indices;
+                }
+
+                indices.Add(i);
+            }
+
+            // Combine the largest group, if it has more than one term
+            List<int> group = null;
+            foreach (List<int> indices in termsByColumn.Values)
+            {
+                if (group == null || indices.Count > group.Count) group = indices;
+            }
+
+            if (group == null || group.Count < 2) return;
+
+            _isContainsTerm = new bool[_terms.Length];
+            _containsValues = new String8[group.Count];
+            _containsComparer = new String8Comparer();
+
+            for (int i = 0; i < group.Count; ++i)
+            {
+                ((TermExpression)_terms[group[i]]).TryGetContainsTerm(out column, out _containsRawGetter, out _containsValues[i]);
+                _isContainsTerm[group[i]] = true;
+            }
         }
 
         public void Evaluate(BitVector vector)
         {
             Allocator.AllocateToSize(ref _termVector, vector.Capacity);
 
-            foreach (IExpression term in _terms)
+            // Evaluate the simple column to constant terms in one native call, if available
+            bool anyNative = (s_ExecutePlanNative != null && EvaluateNative(vector));
+
+            // Search for all Contains values on the same column at once, if there are several
+            if (_containsValues != null)
             {
                 _termVector.None();
-                term.Evaluate(_termVector);
+                _containsComparer.WhereContainsAny((String8Raw)_containsRawGetter(), _containsValues, _termVector);
                 vector.Or(_termVector);
             }
+
+            for (int i = 0; i < _terms.Length; ++i)
+            {
+                if (_isContainsTerm != null && _isContainsTerm[i]) continue;
+                if (anyNative && _isNativeTerm[i]) continue;
+
+                _termVector.None();
+                _terms[i].Evaluate(_termVector);
+                vector.Or(_termVector);
+            }
+        }
+
+        private bool EvaluateNative(BitVector vector)
+        {
+            if (_isNativeTerm == null)
+            {
+                _isNativeTerm = new bool[_terms.Length];
+                _nativeProgram = new byte[NativeTermLimit * NativeInstructionLength];
+                _nativeColumns = new Array[NativeTermLimit];
+                _nativeIndices = new int[NativeTermLimit];
+                _nativeValues = new object[NativeTermLimit];
+                _nativeVectors = new ulong[1][];
+                _nativeResults = new int[0];
+            }
+
+            // Find the terms which compare a whole column to a constant, and OR each into the vector
+            int termCount = 0;
+            for (int i = 0; i < _terms.Length; ++i)
+            {
+                _isNativeTerm[i] = false;
+                if (termCount == NativeTermLimit) continue;
+
+                TermExpression term = _terms[i] as TermExpression;
+                XArray left;
+                object right;
+                CompareOperator cOp;
+                if (term == null || !term.TryGetNativeTerm(out left, out right, out cOp) || left.Count != vector.Capacity) continue;
+
+                _nativeColumns[termCount] = left.Array;
+                _nativeIndices[termCount] = left.Selector.StartIndexInclusive;
+                _nativeValues[termCount] = right;
+
+                int at = termCount * NativeInstructionLength;
+                _nativeProgram[at] = NativeWhereOpcode;
+                _nativeProgram[at + 1] = 0;
+                _nativeProgram[at + 2] = (byte)termCount;
+                _nativeProgram[at + 3] = (byte)termCount;
+                _nativeProgram[at + 4] = (byte)cOp;
+                _nativeProgram[at + 5] = (byte)BooleanOperator.Or;
+
+                _isNativeTerm[i] = true;
+                termCount++;
+            }
+
+            // A single term gains nothing over the normal comparer
+            if (termCount < 2) return false;
+
+            _nativeVectors[0] = vector.Array;
+            s_ExecutePlanNative(_nativeProgram, termCount, _nativeColumns, _nativeIndices, _nativeValues, _nativeVectors, null, vector.Capacity, _nativeResults);
+            return true;
         }
 
         public override string ToString()
@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 using System;
+using System.Collections.Generic;
 
 using Microsoft.CodeAnalysis.Elfie.Model.Strings;
 
@@ -16,6 +17,11 @@ namespace XForm.Query.Expression
 {
     internal class TermExpression : IExpression
     {
+        internal static ComparerExtensions.WhereZoned s_WhereZonedNative = null;
+        internal static ComparerExtensions.CountZoneDecided s_CountZoneDecidedNative = null;
+
+        private static HashSet<Type> s_nativeTypes = new HashSet<Type>() { typeof(byte), typeof(sbyte), typeof(ushort), typeof(short), typeof(uint), typeof(int), typeof(ulong), typeof(long), typeof(float), typeof(double) };
+
         private IXColumn _left;
         private CompareOperator _cOp;
         private IXColumn _right;
@@ -25,6 +31,21 @@ namespace XForm.Query.Expression
         private ComparerExtensions.Comparer _comparer;
         private Action<BitVector> _evaluate;
 
+        // Set if this term is a numeric column to constant comparison a fused native Where can evaluate
+        private bool _canEvaluateNative;
+        private CompareOperator _nativeCompareOperator;
+
+        // Set if the left column has a zone map, so that blocks its bounds decide aren't compared
+        private Func<object> _zoneMapGetter;
+
+        // Set if the left column may be read from a memory-mapped file, so that its values are compared in place
+        private Func<object> _mappedGetter;
+        private Action<BitVector> _evaluateUnmapped;
+
+        // Set if this term is a String8 column Contains constant which is evaluated on the raw String8 bytes
+        private Func<object> _string8RawGetter;
+        private String8 _containsValue;
+
         public TermExpression(IXTable source, IXColumn left, CompareOperator op, IXColumn right)
         {
             _evaluate = EvaluateNormal;
@@ -88,6 +109,28 @@ namespace XForm.Query.Expression
                 // Get a comparer which can compare the values
                 _comparer = TypeProviderFactory.Get(left.ColumnDetails.Type).TryGetComparer(op);
                 if (_comparer == null) throw new ArgumentException($"No comparer found for type {left.ColumnDetails.Type.Name}.");
+
+                // Track whether this term could run in a fused native Where instead
+                _canEvaluateNative = op <= CompareOperator.GreaterThanOrEqual && _right.IsConstantColumn() && !_left.IsEnumColumn() && s_nativeTypes.Contains(_left.ColumnDetails.Type);
+                _nativeCompareOperator = op;
+
+                // Use the column zone map, if it has one, to skip comparing blocks it decides
+                if (_canEvaluateNative && s_WhereZonedNative != null)
+                {
+                    _zoneMapGetter = _left.ComponentGetter(ColumnComponent.ZoneMap);
+                    if (_zoneMapGetter != null) _evaluate = EvaluateZoned;
+                }
+
+                // Compare on the mapped column file, if the column is read from one, rather than copying the values out first
+                if (_canEvaluateNative)
+                {
+                    _mappedGetter = _left.ComponentGetter(ColumnComponent.Mapped);
+                    if (_mappedGetter != null)
+                    {
+                        _evaluateUnmapped = _evaluate;
+                        _evaluate = EvaluateMapped;
+                    }
+                }
             }
 
             // Optimize Enum to Constant comparisons to use the underlying indices
@@ -114,6 +157,9 @@ namespace XForm.Query.Expression
                     String8 rightValue = (String8)_right.ValuesGetter()().Array.GetValue(0);
                     String8Comparer string8Comparer = new String8Comparer();
 
+                    _string8RawGetter = rawGetter;
+                    _containsValue = rightValue;
+
                     _evaluate = (vector) =>
                     {
                         String8Raw raw = (String8Raw)rawGetter();
@@ -121,6 +167,26 @@ namespace XForm.Query.Expression
                     };
                 }
             }
+
+            // Compare String8 to constant equality, ordering, and StartsWith natively on the raw byte[] and int[]
+            if (String8Comparer.s_WhereRawNative != null && (op <= CompareOperator.GreaterThanOrEqual || op == CompareOperator.StartsWith) && _right.IsConstantColumn() && !_right.IsNullConstant() && _left.ColumnDetails.Type == typeof(String8) && !_left.IsEnumColumn())
+            {
+                Func<object> rawGetter = _left.ComponentGetter(ColumnComponent.String8Raw);
+                String8 rightValue = (String8)_right.ValuesGetter()().Array.GetValue(0);
+
+                // StartsWith an empty value matches no rows in String8Comparer; leave it there
+                if (rawGetter != null && !(op == CompareOperator.StartsWith && rightValue.IsEmpty()))
+                {
+                    String8Comparer string8Comparer = new String8Comparer();
+                    CompareOperator rawOperator = op;
+
+                    _evaluate = (vector) =>
+                    {
+                        String8Raw raw = (String8Raw)rawGetter();
+                        string8Comparer.Where(raw, rawOperator, rightValue, vector);
+                    };
+                }
+            }
         }
 
         public void Evaluate(BitVector result)
@@ -128,6 +194,90 @@ namespace XForm.Query.Expression
             _evaluate(result);
         }
 
+        /// <summary>
+        ///  Get the current column values and constant for this term, if it compares a contiguous,
+        ///  non-null numeric column to a non-null constant, so that it can be evaluated by a fused native Where.
+        /// </summary>
+        /// <param name="left">XArray of the column values for the current rows</param>
+        /// <param name="right">Constant value the column is compared to</param>
+        /// <param name="cOp">CompareOperator to compare with</param>
+        /// <returns>True if the term can be evaluated natively, False otherwise</returns>
+        internal bool TryGetNativeTerm(out XArray left, out object right, out CompareOperator cOp)
+        {
+            left = default(XArray);
+            right = null;
+            cOp = _nativeCompareOperator;
+            if (!_canEvaluateNative) return false;
+
+            // Leave terms on mapped columns to EvaluateMapped, which doesn't copy the values
+            MappedColumnPage mapped;
+            if (TryGetMappedPage(out mapped)) return false;
+
+            XArray leftValues = _leftGetter();
+            XArray rightValues = _rightGetter();
+            if (leftValues.Selector.Indices != null || leftValues.Selector.IsSingleValue || leftValues.HasNulls) return false;
+            if (!rightValues.Selector.IsSingleValue || rightValues.HasNulls) return false;
+
+            left = leftValues;
+            right = rightValues.Array.GetValue(rightValues.Index(0));
+
+            // Leave terms where the zone map decides rows to EvaluateZoned, which doesn't compare them
+            ZoneMapPage page;
+            if (TryGetZoneMapPage(leftValues, rightValues, out page) && s_CountZoneDecidedNative(page.ZoneMap.MinMax, ZoneMap.BlockRowCount, page.FirstRow, leftValues.Count, (byte)cOp, right) > 0) return false;
+
+            return true;
+        }
+
+        /// <summary>
+        ///  Get the zone map for the current rows, if the column has one and the current values can be compared with it natively.
+        /// </summary>
+        private bool TryGetZoneMapPage(XArray left, XArray right, out ZoneMapPage page)
+        {
+            page = default(ZoneMapPage);
+            if (_zoneMapGetter == null) return false;
+            if (left.Selector.Indices != null || left.Selector.IsSingleValue || left.HasNulls) return false;
+            if (!right.Selector.IsSingleValue || right.HasNulls) return false;
+
+            // Partitions without a zone map return null; zone maps of a casted column are of the source type
+            object current = _zoneMapGetter();
+            if (current == null) return false;
+
+            page = (ZoneMapPage)current;
+            return page.ZoneMap.Type == _left.ColumnDetails.Type;
+        }
+
+        /// <summary>
+        ///  Get the mapped column reader and rows for the current rows, if the left column is read from a memory-mapped file of its own type.
+        /// </summary>
+        private bool TryGetMappedPage(out MappedColumnPage page)
+        {
+            page = default(MappedColumnPage);
+            if (_mappedGetter == null) return false;
+
+            // Partitions read another way return null; the mapped values of a casted column are of the source type
+            object current = _mappedGetter();
+            if (current == null) return false;
+
+            page = (MappedColumnPage)current;
+            return page.Selector.Indices == null && page.Reader.ElementType == _left.ColumnDetails.Type;
+        }
+
+        /// <summary>
+        ///  Get the column, raw String8 getter, and constant for this term, if it is a String8 column Contains
+        ///  a non-empty constant evaluated on the raw String8 bytes, so that it can be searched for with other values in one pass.
+        /// </summary>
+        /// <param name="column">Column searched</param>
+        /// <param name="rawGetter">Getter for the String8Raw for the current rows</param>
+        /// <param name="value">Constant value searched for</param>
+        /// <returns>True if the term is a raw Contains term, False otherwise</returns>
+        internal bool TryGetContainsTerm(out IXColumn column, out Func<object> rawGetter, out String8 value)
+        {
+            column = _left;
+            rawGetter = _string8RawGetter;
+            value = _containsValue;
+            return (rawGetter != null && !value.IsEmpty());
+        }
+
         private void EvaluateNormal(BitVector result)
         {
             // Get the pair of values to compare
@@ -138,6 +288,46 @@ namespace XForm.Query.Expression
             _comparer(left, right, result);
         }
 
+        private void EvaluateZoned(BitVector result)
+        {
+            XArray left = _leftGetter();
+            XArray right = _rightGetter();
+
+            ZoneMapPage page;
+            if (TryGetZoneMapPage(left, right, out page))
+            {
+                s_WhereZonedNative(left.Array, left.Selector.StartIndexInclusive, left.Count, (byte)_nativeCompareOperator, right.Array.GetValue(right.Index(0)), page.ZoneMap.MinMax, ZoneMap.BlockRowCount, page.FirstRow, (byte)BooleanOperator.Or, result.Array, 0);
+            }
+            else
+            {
+                _comparer(left, right, result);
+            }
+        }
+
+        private void EvaluateMapped(BitVector result)
+        {
+            MappedColumnPage page;
+            XArray right = _rightGetter();
+            if (!right.Selector.IsSingleValue || right.HasNulls || !TryGetMappedPage(out page))
+            {
+                _evaluateUnmapped(result);
+                return;
+            }
+
+            object value = right.Array.GetValue(right.Index(0));
+
+            // Use the zone map as EvaluateZoned would, if the column has one
+            object zoneMap = _zoneMapGetter?.Invoke();
+            if (zoneMap != null && ((ZoneMapPage)zoneMap).ZoneMap.Type == _left.ColumnDetails.Type)
+            {
+                page.Reader.Where(page.Selector, _nativeCompareOperator, value, (ZoneMapPage)zoneMap, result);
+            }
+            else
+            {
+                page.Reader.Where(page.Selector, _nativeCompareOperator, value, result);
+            }
+        }
+
         private void WhereIsNull(XArray source, XArray unused, BitVector vector)
         {
             BoolComparer.WhereNull(source, true, vector);
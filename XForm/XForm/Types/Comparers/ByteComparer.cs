@@ -16,12 +16,29 @@ namespace XForm.Types.Comparers
     {
         internal static ComparerExtensions.WhereSingle<byte> s_WhereSingleNative = null;
         internal static ComparerExtensions.Where<byte> s_WhereNative = null;
+        internal static ComparerExtensions.Hash s_GetHashCodesNative = null;
+        internal static ComparerExtensions.HashIndices s_GetHashCodesIndicesNative = null;
 
         public void GetHashCodes(XArray xarray, int[] hashes)
         {
             if (hashes.Length < xarray.Count) throw new ArgumentOutOfRangeException("hashes.Length");
             byte[] array = (byte[])xarray.Array;
 
+            // Hash natively (in bulk) when there are no nulls to skip
+            if (s_GetHashCodesNative != null && !xarray.HasNulls && !xarray.Selector.IsSingleValue)
+            {
+                if (xarray.Selector.Indices == null)
+                {
+                    s_GetHashCodesNative(array, xarray.Selector.StartIndexInclusive, xarray.Count, true, hashes);
+                }
+                else
+                {
+                    s_GetHashCodesIndicesNative(array, xarray.Selector.Indices, xarray.Selector.StartIndexInclusive, xarray.Count, true, hashes);
+                }
+
+                return;
+            }
+
             for (int i = 0; i < xarray.Count; ++i)
             {
                 int index = xarray.Index(i);
@@ -16,6 +16,8 @@ namespace XForm.Types.Comparers
     /// </summary>
     internal class SetComparer
     {
+        internal static ComparerExtensions.WhereIn<byte> s_WhereInNative = null;
+
         private BitVector _set;
         private bool[] _array;
 
@@ -121,10 +123,17 @@ namespace XForm.Types.Comparers
             else if (!left.Selector.IsSingleValue)
             {
                 // Fastest Path: Contiguous Array to constant.
-                int zeroOffset = left.Selector.StartIndexInclusive;
-                for (int i = left.Selector.StartIndexInclusive; i < left.Selector.EndIndexExclusive; ++i)
+                if (s_WhereInNative != null)
+                {
+                    s_WhereInNative(leftArray, left.Selector.StartIndexInclusive, left.Selector.Count, _set.Array, (byte)BooleanOperator.Or, vector.Array, 0);
+                }
+                else
                 {
-                    if (_array[leftArray[i]]) vector.Set(i - zeroOffset);
+                    int zeroOffset = left.Selector.StartIndexInclusive;
+                    for (int i = left.Selector.StartIndexInclusive; i < left.Selector.EndIndexExclusive; ++i)
+                    {
+                        if (_array[leftArray[i]]) vector.Set(i - zeroOffset);
+                    }
                 }
             }
             else
@@ -19,21 +19,41 @@ namespace XForm.Types.Comparers
     {
         internal static ComparerExtensions.WhereSingle<String8> s_WhereSingleNative = null;
         internal static ComparerExtensions.Where<String8> s_WhereNative = null;
+        internal static ComparerExtensions.HashText s_GetHashCodesNative = null;
 
         public delegate int IndexOfAll(byte[] text, int textIndex, int textLength, byte[] value, int valueIndex, int valueLength, bool ignoreCase, int[] resultArray);
         internal static IndexOfAll s_IndexOfAllNative = null;
 
+        public delegate int IndexOfAny(byte[] text, int textIndex, int textLength, byte[][] values, bool ignoreCase, int[] resultArray, int[] resultValueArray, ref int nextIndex);
+        internal static IndexOfAny s_IndexOfAnyNative = null;
+
+        public delegate void WhereRaw(byte[] text, int firstStart, int[] ends, int endsIndex, int endsOffset, int length, byte cOp, byte[] value, int valueIndex, int valueLength, byte bOp, ulong[] vector, int vectorIndex);
+        internal static WhereRaw s_WhereRawNative = null;
+
         internal int[] _indicesBuffer;
+        internal int[] _valueIndicesBuffer;
+        private String8[] _anyValues;
+        private byte[][] _anyValueBytes;
+        private int[] _hashEndsBuffer;
 
         public void GetHashCodes(XArray xarray, int[] hashes)
         {
             if (hashes.Length < xarray.Count) throw new ArgumentOutOfRangeException("hashes.Length");
             String8[] array = (String8[])xarray.Array;
 
+            // Hash natively when the strings are back-to-back in one byte[], as they are when read from disk
+            byte[] text;
+            int firstStart;
+            if (s_GetHashCodesNative != null && !xarray.HasNulls && TryGetEnds(xarray, out text, out firstStart))
+            {
+                s_GetHashCodesNative(text, firstStart, _hashEndsBuffer, 0, xarray.Count, true, hashes);
+                return;
+            }
+
             for (int i = 0; i < xarray.Count; ++i)
             {
                 int index = xarray.Index(i);
-                if (xarray.HasNulls || xarray.NullRows[index] == false)
+                if (!xarray.HasNulls || xarray.NullRows[index] == false)
                 {
                     hashes[i] = (hashes[i] << 5) - hashes[i] + unchecked((int)Hashing.Hash(array[xarray.Index(i)], 0));
                 }
@@ -45,6 +65,33 @@ namespace XForm.Types.Comparers
             return unchecked((int)Hashing.Hash(value, 0));
         }
 
+        private bool TryGetEnds(XArray xarray, out byte[] text, out int firstStart)
+        {
+            String8[] array = (String8[])xarray.Array;
+            text = null;
+            firstStart = 0;
+            if (xarray.Count == 0 || xarray.Selector.IsSingleValue) return false;
+
+            String8 first = array[xarray.Index(0)];
+            if (first.Array == null) return false;
+
+            // Record where each string ends, stopping if one doesn't start where the previous one ended
+            Allocator.AllocateToSize(ref _hashEndsBuffer, xarray.Count);
+            int previousEnd = first.Index;
+            for (int i = 0; i < xarray.Count; ++i)
+            {
+                String8 value = array[xarray.Index(i)];
+                if (value.Array != first.Array || value.Index != previousEnd) return false;
+
+                previousEnd += value.Length;
+                _hashEndsBuffer[i] = previousEnd;
+            }
+
+            text = first.Array;
+            firstStart = first.Index;
+            return true;
+        }
+
         public void WhereEqual(XArray left, XArray right, BitVector vector)
         {
             String8[] leftArray = (String8[])left.Array;
@@ -670,6 +717,97 @@ namespace XForm.Types.Comparers
             }
         }
 
+        /// <summary>
+        ///  Where overload to compare String8 rows to a constant on the raw String8 byte[] and int[] natively, without building String8s.
+        ///  This is only available when the native Where is, when comparing to a constant, and before any other row filtering operations.
+        /// </summary>
+        /// <param name="left">Raw String8 byte[] and int[] for current rows</param>
+        /// <param name="cOp">CompareOperator from Equal to GreaterThanOrEqual, or StartsWith</param>
+        /// <param name="rightValue">Constant Value to compare to</param>
+        /// <param name="vector">BitVector to record matches to</param>
+        public void Where(String8Raw left, CompareOperator cOp, String8 rightValue, BitVector vector)
+        {
+            int[] positions = (int[])left.Positions.Array;
+
+            // Find where the first row starts and how to convert positions to indices in the bytes, as String8ColumnReader.Read does
+            bool includesFirstString = (left.Selector.StartIndexInclusive == 0);
+            int firstStringStart = (includesFirstString ? 0 : positions[left.Positions.Index(0)]);
+            int positionOffset = left.Positions.Index((includesFirstString ? 0 : 1));
+            int textOffset = firstStringStart - left.Bytes.Index(0);
+
+            s_WhereRawNative((byte[])left.Bytes.Array, left.Bytes.Index(0), positions, positionOffset, textOffset, left.Selector.Count, (byte)cOp, rightValue.Array, rightValue.Index, rightValue.Length, (byte)BooleanOperator.Or, vector.Array, 0);
+        }
+
+        /// <summary>
+        ///  WhereContainsAny sets rows in the String8 rows block containing any of the values.
+        ///  The native IndexOfAny finds matches for all values in one pass; otherwise each value is searched for separately.
+        ///  This is only available when comparing to constants and before any other row filtering operations.
+        /// </summary>
+        /// <param name="left">Raw String8 byte[] and int[] for current rows</param>
+        /// <param name="values">Constant non-empty Values to look for</param>
+        /// <param name="vector">BitVector to record matches to</param>
+        public void WhereContainsAny(String8Raw left, String8[] values, BitVector vector)
+        {
+            if (s_IndexOfAnyNative == null || values.Length > 256)
+            {
+                foreach (String8 value in values)
+                {
+                    WhereContains(left, value, vector);
+                }
+
+                return;
+            }
+
+            // Copy the values to exact byte arrays for the native search (once per values array)
+            if (!ReferenceEquals(_anyValues, values))
+            {
+                _anyValues = values;
+                _anyValueBytes = new byte[values.Length][];
+                for (int i = 0; i < values.Length; ++i)
+                {
+                    _anyValueBytes[i] = new byte[values[i].Length];
+                    values[i].WriteTo(_anyValueBytes[i], 0);
+                }
+            }
+
+            String8 all = new String8((byte[])left.Bytes.Array, 0, left.Bytes.Selector.EndIndexExclusive);
+            Allocator.AllocateToSize(ref _indicesBuffer, Math.Max(1024, values.Length));
+            Allocator.AllocateToSize(ref _valueIndicesBuffer, _indicesBuffer.Length);
+
+            int startRowIndex = left.Positions.Selector.StartIndexInclusive;
+            int nextRowIndex = startRowIndex;
+            int endRowIndex = left.Positions.Selector.EndIndexExclusive;
+
+            int nextByteIndex = left.Bytes.Selector.StartIndexInclusive;
+            int[] positions = (int[])left.Positions.Array;
+
+            bool includesFirstString = (left.Selector.StartIndexInclusive == 0);
+            int firstStringStart = (includesFirstString ? 0 : positions[left.Positions.Index(0)]);
+            int textOffset = firstStringStart - left.Bytes.Index(0);
+
+            // Positions are row ends; when the selector doesn't start at row zero, the first position is the end of the row before it
+            int firstRowOffset = (includesFirstString ? 0 : 1);
+
+            while (nextByteIndex != -1)
+            {
+                // Find a batch of matches for any value
+                int countFound = s_IndexOfAnyNative(all.Array, nextByteIndex, all.Length - nextByteIndex, _anyValueBytes, true, _indicesBuffer, _valueIndicesBuffer, ref nextByteIndex);
+
+                // Map the indices found to rows; matches are in index order, so rows only move forward, even across batches
+                for (int i = 0; i < countFound; ++i)
+                {
+                    int indexToFind = _indicesBuffer[i] + textOffset;
+
+                    // Find the row the match starts in (the first row ending after it)
+                    while (nextRowIndex < endRowIndex && indexToFind >= positions[nextRowIndex]) nextRowIndex++;
+                    if (nextRowIndex == endRowIndex) break;
+
+                    // If it's fully within that row, add it
+                    if (indexToFind + values[_valueIndicesBuffer[i]].Length <= positions[nextRowIndex]) vector.Set(nextRowIndex - startRowIndex - firstRowOffset);
+                }
+            }
+        }
+
         public bool WhereContains(String8 left, String8 right)
         {
             return left.IndexOf(right) != -1;
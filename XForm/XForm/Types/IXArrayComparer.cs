@@ -45,7 +45,18 @@ namespace XForm.Types
         public delegate void Comparer(XArray left, XArray right, BitVector vector);
 
         public delegate void WhereSingle<T>(T[] left, int index, int length, byte compareOperator, T right, byte booleanOperator, ulong[] vector, int vectorIndex);
+        public delegate void WhereParallel(Array column, int index, int length, byte compareOperator, object right, byte booleanOperator, ulong[] vector, int vectorIndex);
         public delegate void Where<T>(T[] left, int leftIndex, byte compareOperator, T[] right, int rightIndex, int length, byte booleanOperator, ulong[] vector, int vectorIndex);
+        public delegate int WhereZoned(Array column, int index, int length, byte compareOperator, object value, Array zoneMap, int blockRowCount, int firstRow, byte booleanOperator, ulong[] vector, int vectorIndex);
+        public delegate int CountZoneDecided(Array zoneMap, int blockRowCount, int firstRow, int length, byte compareOperator, object value);
+        public delegate void WhereIn<T>(T[] left, int index, int length, ulong[] set, byte booleanOperator, ulong[] vector, int vectorIndex);
+        public delegate void Widen<T>(T[] values, int index, int length, int[] result);
+        public delegate void Hash(Array values, int index, int length, bool combine, int[] hashes);
+        public delegate void HashIndices(Array values, int[] indices, int index, int length, bool combine, int[] hashes);
+        public delegate void HashText(byte[] text, int firstStart, int[] ends, int index, int length, bool combine, int[] hashes);
+        public delegate void IndexOf(Array keys, int index, int length, int[] hashes, Array tableKeys, byte[] metadata, int maxProbeLength, int[] buckets);
+        public delegate void WhereAnd(Array[] columns, int[] indices, byte[] compareOperators, object[] values, int termCount, int length, byte booleanOperator, ulong[] vector, int vectorIndex);
+        public delegate int ExecutePlan(byte[] program, int instructionCount, Array[] columns, int[] indices, object[] values, ulong[][] vectors, int[][] pages, int length, int[] results);
 
         public static Comparer TryBuild(this IXArrayComparer comparer, CompareOperator cOp)
         {
@@ -9,6 +9,7 @@ using XForm.Data;
 using XForm.Extensions;
 using XForm.IO;
 using XForm.IO.StreamProvider;
+using XForm.Query;
 using XForm.Types.Comparers;
 
 namespace XForm.Types
@@ -29,13 +30,20 @@ namespace XForm.Types
             {
                 string filePath = ValuesFilePath(columnPath);
                 if (!streamProvider.UncachedExists(filePath)) return null;
-                return new PrimitiveArrayReader<T>(streamProvider.OpenRead(filePath));
+
+                Stream stream = streamProvider.OpenRead(filePath);
+                return MappedArrayReader.TryOpen<T>(stream) ?? new PrimitiveArrayReader<T>(stream);
             });
         }
 
         public IColumnWriter BinaryWriter(IStreamProvider streamProvider, string columnPath)
         {
-            return new PrimitiveArrayWriter<T>(streamProvider.OpenWrite(ValuesFilePath(columnPath)));
+            IColumnWriter writer = new PrimitiveArrayWriter<T>(streamProvider.OpenWrite(ValuesFilePath(columnPath)));
+
+            // Write a zone map beside column values so Where can skip blocks without matches
+            if (ZoneMap.IsSupported(typeof(T)) && !columnPath.EndsWith(".bin")) writer = new ZoneMapWriter<T>(streamProvider, columnPath, writer);
+
+            return writer;
         }
 
         public NegatedTryConvert TryGetNegatedTryConvert(Type sourceType, Type targetType, object defaultValue)
@@ -154,6 +162,145 @@ namespace XForm.Types
         }
     }
 
+    public static class MappedArrayReader
+    {
+        internal static Func<FileStream, Type, IDisposable> s_MapNative;
+
+        // Return a MappedArrayReader for the column file open in stream, or null if native mapping isn't enabled, stream isn't a file, or the file can't be mapped
+        public static IColumnReader TryOpen<T>(Stream stream)
+        {
+            FileStream fileStream = stream as FileStream;
+            if (s_MapNative == null || fileStream == null) return null;
+
+            IDisposable map;
+            try
+            {
+                map = s_MapNative(fileStream, typeof(T));
+            }
+            catch (IOException)
+            {
+                // Leave files the OS won't map (some network shares, for one) to PrimitiveArrayReader on the still open stream
+                return null;
+            }
+
+            // The mapped view stays valid after the file is closed
+            fileStream.Dispose();
+            return new MappedArrayReader<T>(map);
+        }
+    }
+
+    /// <summary>
+    ///  IMappedColumnReader is implemented by column readers over a memory-mapped column file,
+    ///  so that Where can compare the values in place instead of reading them into an array first.
+    /// </summary>
+    public interface IMappedColumnReader
+    {
+        Type ElementType { get; }
+
+        // Compare the selected rows to value, setting the bits for matches in vector from zero
+        void Where(ArraySelector selector, CompareOperator cOp, object value, BitVector vector);
+
+        // Compare the selected rows to value, as Where, skipping the blocks the zone map page decides
+        void Where(ArraySelector selector, CompareOperator cOp, object value, ZoneMapPage page, BitVector vector);
+    }
+
+    /// <summary>
+    ///  MappedColumnPage is the ColumnComponent.Mapped for the current rows: the mapped column reader and the rows currently selected.
+    /// </summary>
+    public struct MappedColumnPage
+    {
+        public IMappedColumnReader Reader;
+        public ArraySelector Selector;
+
+        public MappedColumnPage(IMappedColumnReader reader, ArraySelector selector)
+        {
+            Reader = reader;
+            Selector = selector;
+        }
+    }
+
+    /// <summary>
+    ///  MappedArrayReader reads a primitive column file through a native memory-mapped view (XForm.Native.MappedColumnN).
+    ///  Where compares the mapped values in place. Read copies each requested range straight from the OS file cache
+    ///  rather than through FileStream reads and a page buffer. After each read or Where, the OS is asked to read ahead
+    ///  the same number of rows, since reads are usually sequential.
+    /// </summary>
+    public class MappedArrayReader<T> : IColumnReader, IMappedColumnReader
+    {
+        private IDisposable _map;
+        private Action<int, int, Array, int> _read;
+        private Action<int, int> _prefetch;
+        private Action<int, int, byte, object, byte, ulong[], int> _where;
+        private Func<int, int, byte, object, Array, int, int, byte, ulong[], int, int> _whereZoned;
+        private T[] _array;
+
+        private XArray _currentArray;
+        private ArraySelector _currentSelector;
+
+        public MappedArrayReader(IDisposable map)
+        {
+            _map = map;
+            _read = (Action<int, int, Array, int>)Delegate.CreateDelegate(typeof(Action<int, int, Array, int>), map, "Read");
+            _prefetch = (Action<int, int>)Delegate.CreateDelegate(typeof(Action<int, int>), map, "Prefetch");
+            _where = (Action<int, int, byte, object, byte, ulong[], int>)Delegate.CreateDelegate(typeof(Action<int, int, byte, object, byte, ulong[], int>), map, "Where");
+            _whereZoned = (Func<int, int, byte, object, Array, int, int, byte, ulong[], int, int>)Delegate.CreateDelegate(typeof(Func<int, int, byte, object, Array, int, int, byte, ulong[], int, int>), map, "Where");
+            Count = ((Func<int>)Delegate.CreateDelegate(typeof(Func<int>), map, "get_Count"))();
+        }
+
+        public int Count { get; private set; }
+        public Type ElementType => typeof(T);
+
+        public XArray Read(ArraySelector selector)
+        {
+            if (selector.Indices != null) throw new NotImplementedException();
+
+            // Return the previous xarray if re-requested
+            if (selector.Equals(_currentSelector)) return _currentArray;
+
+            // Copy the rows from the mapped file
+            Allocator.AllocateToSize(ref _array, selector.Count);
+            _read(selector.StartIndexInclusive, selector.Count, _array, 0);
+            PrefetchAfter(selector);
+
+            // Cache and return the current xarray
+            _currentArray = XArray.All(_array, selector.Count);
+            _currentSelector = selector;
+            return _currentArray;
+        }
+
+        public void Where(ArraySelector selector, CompareOperator cOp, object value, BitVector vector)
+        {
+            if (selector.Indices != null) throw new NotImplementedException();
+
+            _where(selector.StartIndexInclusive, selector.Count, (byte)cOp, value, (byte)BooleanOperator.Or, vector.Array, 0);
+            PrefetchAfter(selector);
+        }
+
+        public void Where(ArraySelector selector, CompareOperator cOp, object value, ZoneMapPage page, BitVector vector)
+        {
+            if (selector.Indices != null) throw new NotImplementedException();
+
+            _whereZoned(selector.StartIndexInclusive, selector.Count, (byte)cOp, value, page.ZoneMap.MinMax, ZoneMap.BlockRowCount, page.FirstRow, (byte)BooleanOperator.Or, vector.Array, 0);
+            PrefetchAfter(selector);
+        }
+
+        private void PrefetchAfter(ArraySelector selector)
+        {
+            // Start reading the next rows in while these are used
+            int nextCount = Math.Min(selector.Count, Count - selector.EndIndexExclusive);
+            if (nextCount > 0) _prefetch(selector.EndIndexExclusive, nextCount);
+        }
+
+        public void Dispose()
+        {
+            if (_map != null)
+            {
+                _map.Dispose();
+                _map = null;
+            }
+        }
+    }
+
     public class PrimitiveArrayWriter<T> : IColumnWriter
     {
         private int _bytesPerItem;
@@ -179,16 +179,19 @@ namespace XForm.Verbs
     {
         // JoinDictionary uses a Dictionary5 internally
         private Dictionary5<T, int> _dictionary;
+        private IXArrayComparer _comparer;
         private IValueCopier<T> _valueCopier;
 
-        // Reused buffers for the matching row vector and matching row right side indices
+        // Reused buffers for the matching row vector, matching row right side indices, and key hashes
         private int[] _returnedIndicesBuffer;
         private BitVector _returnedVector;
+        private int[] _hashesBuffer;
 
         public JoinDictionary(int initialCapacity)
         {
             ITypeProvider typeProvider = TypeProviderFactory.Get(typeof(T));
-            IEqualityComparer<T> comparer = new EqualityComparerAdapter<T>(typeProvider.TryGetComparer());
+            _comparer = typeProvider.TryGetComparer();
+            IEqualityComparer<T> comparer = new EqualityComparerAdapter<T>(_comparer);
             _dictionary = new Dictionary5<T, int>(comparer, initialCapacity);
             _valueCopier = (IValueCopier<T>)(typeProvider.TryGetCopier());
         }
@@ -228,18 +231,30 @@ namespace XForm.Verbs
 
             int countFound = 0;
             T[] keyArray = (T[])keys.Array;
-            for (int i = 0; i < keys.Count; ++i)
+            if (!keys.HasNulls && keys.Selector.Indices == null && !keys.Selector.IsSingleValue)
             {
-                int index = keys.Index(i);
-                int foundAtIndex;
-                if ((keys.HasNulls && keys.NullRows[index]) || !_dictionary.TryGetValue(keyArray[index], out foundAtIndex))
-                {
-                    _returnedVector.Clear(i);
-                }
-                else
+                // Hash the keys in bulk and look them up together
+                Allocator.AllocateToSize(ref _hashesBuffer, keys.Count);
+                Array.Clear(_hashesBuffer, 0, keys.Count);
+                _comparer.GetHashCodes(keys, _hashesBuffer);
+
+                countFound = _dictionary.TryGetValues(keyArray, keys.Selector.StartIndexInclusive, keys.Count, _hashesBuffer, _returnedVector, _returnedIndicesBuffer);
+            }
+            else
+            {
+                for (int i = 0; i < keys.Count; ++i)
                 {
-                    _returnedVector.Set(i);
-                    _returnedIndicesBuffer[countFound++] = foundAtIndex;
+                    int index = keys.Index(i);
+                    int foundAtIndex;
+                    if ((keys.HasNulls && keys.NullRows[index]) || !_dictionary.TryGetValue(keyArray[index], out foundAtIndex))
+                    {
+                        _returnedVector.Clear(i);
+                    }
+                    else
+                    {
+                        _returnedVector.Set(i);
+                        _returnedIndicesBuffer[countFound++] = foundAtIndex;
+                    }
                 }
             }
 
@@ -24,6 +24,7 @@ namespace XForm.Verbs
     /// <summary>
     ///  'Skip' skips the first [count] rows from the source.
     ///  Skip and Limit can be used to do paging, but the service must re-run the query each time.
+    ///  When the source is a Where, it drops the skipped matches itself without paging them.
     /// </summary>
     /// <remarks>
     ///  Ideal paging would be by identifying the source table RowId which was last returned and seeking past it to start.
@@ -47,6 +48,14 @@ namespace XForm.Verbs
 
         public override int Next(int desiredCount, CancellationToken cancellationToken)
         {
+            // If the source is a Where, have it drop the skipped matches instead of returning them
+            Where where = _source as Where;
+            if (where != null && _countToSkip > _rowCountSkipped)
+            {
+                where.SkipMatches(_countToSkip - _rowCountSkipped);
+                _rowCountSkipped = _countToSkip;
+            }
+
             // Skip the desired number of rows
             while(_countToSkip > _rowCountSkipped)
             {
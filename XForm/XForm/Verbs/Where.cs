@@ -30,6 +30,7 @@ namespace XForm.Verbs
     {
         private IExpression _expression;
         private BitVector _vector;
+        private RankSelect _rankSelect;
         private RowRemapper _mapper;
 
         private RemappedColumn[] _columns;
@@ -39,6 +40,9 @@ namespace XForm.Verbs
         private int _currentMatchesReturned;
         private int _nextCountToReturn;
 
+        // Matches to drop before returning more, requested by an outer Skip
+        private int _countToSkip;
+
         // Track the total rows we've gotten and returned
         private int _totalRowsRetrieved;
         private int _totalRowsMatched;
@@ -63,6 +67,9 @@ namespace XForm.Verbs
 
         private int CountToRequest(int desiredCount)
         {
+            // When skipping, request enough rows to get past the skipped matches too
+            if (_countToSkip > 0) desiredCount = (int)Math.Min((long)desiredCount + _countToSkip, XTableExtensions.DefaultBatchSize);
+
             // By default, request the amount to return
             int result = desiredCount;
 
@@ -96,12 +103,50 @@ namespace XForm.Verbs
             _currentMatchesTotal = 0;
             _currentMatchesReturned = 0;
             _nextCountToReturn = 0;
+            _countToSkip = 0;
+        }
+
+        /// <summary>
+        ///  Drop the next [count] matches instead of returning them. Batches with fewer matches are skipped
+        ///  without paging their vectors, and the batch where skipping ends is seeked into with a RankSelect.
+        /// </summary>
+        /// <param name="count">Number of matches to skip</param>
+        public void SkipMatches(int count)
+        {
+            _countToSkip += count;
+        }
+
+        private int NextFromMatch(int desiredCount)
+        {
+            // Find the vector index of the first match to return and page from there
+            if (_rankSelect == null)
+            {
+                _rankSelect = new RankSelect(_vector);
+            }
+            else
+            {
+                _rankSelect.Build(_vector);
+            }
+
+            _nextCountToReturn = Math.Min(desiredCount, _currentMatchesTotal - _currentMatchesReturned);
+            _mapper.SetMatches(_vector, _nextCountToReturn, _rankSelect.Select(_currentMatchesReturned));
+            return _nextCountToReturn;
         }
 
         public override int Next(int desiredCount, CancellationToken cancellationToken)
         {
             _currentMatchesReturned += _nextCountToReturn;
 
+            // If skipping, drop previously retrieved extra rows first
+            if (_countToSkip > 0 && _currentMatchesTotal > _currentMatchesReturned)
+            {
+                int countSkipped = Math.Min(_countToSkip, _currentMatchesTotal - _currentMatchesReturned);
+                _countToSkip -= countSkipped;
+                _currentMatchesReturned += countSkipped;
+
+                if (_currentMatchesTotal > _currentMatchesReturned) return NextFromMatch(desiredCount);
+            }
+
             // If we previously retrieved extra rows, return more of those
             if (_currentMatchesTotal > _currentMatchesReturned)
             {
@@ -129,6 +174,22 @@ namespace XForm.Verbs
                 _currentMatchesTotal = _vector.Count;
                 _totalRowsMatched += _currentMatchesTotal;
 
+                // If skipping, drop whole batches by count and seek to the first match after the skipped ones
+                if (_countToSkip > 0)
+                {
+                    if (_currentMatchesTotal > _countToSkip)
+                    {
+                        _currentMatchesReturned = _countToSkip;
+                        _countToSkip = 0;
+                        return NextFromMatch(desiredCount);
+                    }
+
+                    _countToSkip -= _currentMatchesTotal;
+                    _currentMatchesTotal = 0;
+                    countToRequest = CountToRequest(desiredCount);
+                    continue;
+                }
+
                 // If we got matches, return the first set requested, otherwise ask for more
                 if (_currentMatchesTotal > 0)
                 {